@@ -309,4 +309,47 @@ void * DataBuffer::ReAllocate(void *pBuffer, size_t Size)
 }
 
 
+
+
+DataBufferView::~DataBufferView()
+{
+	// 基底クラスのデストラクタで解放されないようにする
+	m_pData = nullptr;
+}
+
+
+void DataBufferView::SetView(uint8_t *pData, size_t Size) noexcept
+{
+	m_pData = pData;
+	m_DataSize = Size;
+	m_BufferSize = Size;
+}
+
+
+void DataBufferView::ResetView() noexcept
+{
+	m_pData = nullptr;
+	m_DataSize = 0;
+	m_BufferSize = 0;
+}
+
+
+void * DataBufferView::Allocate(size_t Size)
+{
+	// 参照しているメモリの拡張はできない
+	return nullptr;
+}
+
+
+void DataBufferView::Free(void *pBuffer) noexcept
+{
+}
+
+
+void * DataBufferView::ReAllocate(void *pBuffer, size_t Size)
+{
+	return nullptr;
+}
+
+
 }	// namespace LibISDB
@@ -98,6 +98,26 @@ namespace LibISDB
 		unsigned long m_TypeID = TypeID;
 	};
 
+	/** 外部メモリ参照データバッファクラス */
+	class DataBufferView
+		: public DataBuffer
+	{
+	public:
+		DataBufferView() = default;
+		~DataBufferView();
+
+		DataBufferView(const DataBufferView &) = delete;
+		DataBufferView & operator = (const DataBufferView &) = delete;
+
+		void SetView(uint8_t *pData, size_t Size) noexcept;
+		void ResetView() noexcept;
+
+	protected:
+		void * Allocate(size_t Size) override;
+		void Free(void *pBuffer) noexcept override;
+		void * ReAllocate(void *pBuffer, size_t Size) override;
+	};
+
 }	// namespace LibISDB
 
 
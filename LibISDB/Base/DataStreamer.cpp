@@ -27,6 +27,7 @@
 #include "../LibISDBPrivate.hpp"
 #include "DataStreamer.hpp"
 #include "../Utilities/Clock.hpp"
+#include <algorithm>
 #include "DebugDef.hpp"
 
 
@@ -136,16 +137,21 @@ bool DataStreamer::InputData(const uint8_t *pData, size_t DataSize)
 	bool Result;
 
 	if (m_InputBuffer) {
-		Result = m_InputBuffer->PushBack(pData, DataSize) == DataSize;
+		const size_t PushSize = m_InputBuffer->PushBack(pData, DataSize);
+		// 出力が滞っている間も使用量を反映する
+		UpdateInputBufferUsed();
+		Result = PushSize == DataSize;
+		if (!Result)
+			m_Statistics.InputDropBytes.fetch_add(DataSize - PushSize, std::memory_order_relaxed);
 	} else if (m_OutputCacheBuffer.GetBufferSize() > 0) {
 		Result = OutputDataWithCache(pData, DataSize);
 	} else if (IsOutputValid()) {
-		Result = OutputData(pData, DataSize) == DataSize;
+		Result = OutputDataWithStatistics(pData, DataSize) == DataSize;
 	} else {
 		return false;
 	}
 
-	m_Statistics.InputBytes += DataSize;
+	m_Statistics.InputBytes.fetch_add(DataSize, std::memory_order_relaxed);
 
 	return Result;
 }
@@ -294,9 +300,7 @@ bool DataStreamer::GetStatistics(Statistics *pStats) const
 	if (pStats == nullptr)
 		return false;
 
-	BlockLock Lock(m_Lock);
-
-	*pStats = m_Statistics;
+	m_Statistics.Get(pStats);
 
 	return true;
 }
@@ -342,15 +346,9 @@ bool DataStreamer::OutputCachedData()
 		return true;
 
 	uint8_t *pData = m_OutputCacheBuffer.GetBuffer();
-	const size_t Written = OutputData(pData, BufferUsed);
-
-	if (Written > 0) {
-		m_Statistics.OutputBytes += Written;
-		m_Statistics.OutputCount++;
-	}
+	const size_t Written = OutputDataWithStatistics(pData, BufferUsed);
 
 	if (Written < BufferUsed) {
-		m_Statistics.OutputErrorCount++;
 		if (Written > 0) {
 			BufferUsed -= Written;
 			std::memmove(pData, pData + Written, BufferUsed);
@@ -365,6 +363,32 @@ bool DataStreamer::OutputCachedData()
 }
 
 
+size_t DataStreamer::OutputDataWithStatistics(const uint8_t *pData, size_t DataSize)
+{
+	const HighPrecisionTickClock::ClockType StartTime = m_OutputClock.Get();
+	const size_t Written = OutputData(pData, DataSize);
+	const std::chrono::microseconds Latency =
+		std::chrono::duration_cast<std::chrono::microseconds>(
+			HighPrecisionTickClock::DurationType(m_OutputClock.Get() - StartTime));
+
+	m_Statistics.OutputLatency.Add(Latency);
+	if (Latency >= OUTPUT_STALL_THRESHOLD) {
+		m_Statistics.OutputStallCount.fetch_add(1, std::memory_order_relaxed);
+		m_Statistics.OutputStallTime.fetch_add(Latency.count(), std::memory_order_relaxed);
+	}
+
+	if (Written > 0) {
+		m_Statistics.OutputBytes.fetch_add(Written, std::memory_order_relaxed);
+		m_Statistics.OutputCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (Written < DataSize)
+		m_Statistics.OutputErrorCount.fetch_add(1, std::memory_order_relaxed);
+
+	return Written;
+}
+
+
 bool DataStreamer::OutputDataWithCache(const uint8_t *pData, size_t DataSize)
 {
 	const size_t BufferSize = m_OutputCacheBuffer.GetBufferSize();
@@ -396,6 +420,8 @@ bool DataStreamer::ProcessStream()
 
 	m_Lock.Lock();
 
+	UpdateInputBufferUsed();
+
 	if (m_StreamReader.IsDataAvailable())
 		IsFilled = FillOutputCache();
 
@@ -405,7 +431,7 @@ bool DataStreamer::ProcessStream()
 		if (OutputCachedData()) {
 			Result = true;
 		} else {
-			if ((m_Statistics.OutputErrorCount > 0) && !m_OutputErrorNotified) {
+			if ((m_Statistics.OutputErrorCount.load(std::memory_order_relaxed) > 0) && !m_OutputErrorNotified) {
 				m_OutputErrorNotified = true;
 				m_EventListenerList.CallEventListener(&DataStreamer::EventListener::OnOutputError, this);
 			}
@@ -416,4 +442,49 @@ bool DataStreamer::ProcessStream()
 }
 
 
+void DataStreamer::UpdateInputBufferUsed()
+{
+	const unsigned long long Used = m_StreamReader.GetAvailableSize();
+
+	m_Statistics.InputBufferUsed.store(Used, std::memory_order_relaxed);
+
+	unsigned long long MaxUsed = m_Statistics.InputBufferMaxUsed.load(std::memory_order_relaxed);
+	while ((Used > MaxUsed)
+			&& !m_Statistics.InputBufferMaxUsed.compare_exchange_weak(MaxUsed, Used, std::memory_order_relaxed)) {
+	}
+}
+
+
+
+
+void DataStreamer::StatisticsCounter::Reset() noexcept
+{
+	InputBytes = 0;
+	InputDropBytes = 0;
+	OutputBytes = 0;
+	OutputCount = 0;
+	OutputErrorCount = 0;
+	InputBufferUsed = 0;
+	InputBufferMaxUsed = 0;
+	OutputStallCount = 0;
+	OutputStallTime = 0;
+	OutputLatency.Reset();
+}
+
+
+void DataStreamer::StatisticsCounter::Get(Statistics *pStats) const noexcept
+{
+	pStats->InputBytes = InputBytes.load(std::memory_order_relaxed);
+	pStats->InputDropBytes = InputDropBytes.load(std::memory_order_relaxed);
+	pStats->OutputBytes = OutputBytes.load(std::memory_order_relaxed);
+	pStats->OutputCount = OutputCount.load(std::memory_order_relaxed);
+	pStats->OutputErrorCount = OutputErrorCount.load(std::memory_order_relaxed);
+	pStats->InputBufferUsed = InputBufferUsed.load(std::memory_order_relaxed);
+	pStats->InputBufferMaxUsed = InputBufferMaxUsed.load(std::memory_order_relaxed);
+	pStats->OutputStallCount = OutputStallCount.load(std::memory_order_relaxed);
+	pStats->OutputStallTime = std::chrono::microseconds(OutputStallTime.load(std::memory_order_relaxed));
+	OutputLatency.Get(&pStats->OutputLatency);
+}
+
+
 }	// namespace LibISDB
@@ -32,6 +32,9 @@
 #include "StreamBuffer.hpp"
 #include "EventListener.hpp"
 #include "StreamingThread.hpp"
+#include "../Utilities/LatencyHistogram.hpp"
+#include "../Utilities/Clock.hpp"
+#include <atomic>
 
 
 namespace LibISDB
@@ -54,13 +57,22 @@ namespace LibISDB
 		/** 統計情報 */
 		struct Statistics {
 			unsigned long long InputBytes = 0;
+			unsigned long long InputDropBytes = 0;
 			unsigned long long OutputBytes = 0;
 			unsigned long long OutputCount = 0;
 			unsigned long OutputErrorCount = 0;
+			unsigned long long InputBufferUsed = 0;
+			unsigned long long InputBufferMaxUsed = 0;
+			unsigned long OutputStallCount = 0;
+			std::chrono::microseconds OutputStallTime{0};
+			LatencyHistogram::Snapshot OutputLatency;
 
 			void Reset() noexcept { *this = Statistics(); }
 		};
 
+		/** 出力の停滞とみなす時間 */
+		static constexpr std::chrono::milliseconds OUTPUT_STALL_THRESHOLD{100};
+
 		DataStreamer() noexcept;
 		~DataStreamer();
 
@@ -104,7 +116,9 @@ namespace LibISDB
 
 		bool FillOutputCache();
 		bool OutputCachedData();
+		size_t OutputDataWithStatistics(const uint8_t *pData, size_t DataSize);
 		bool OutputDataWithCache(const uint8_t *pData, size_t DataSize);
+		void UpdateInputBufferUsed();
 
 	// Thread
 		const CharType * GetThreadName() const noexcept override { return LIBISDB_STR("DataStreamer"); }
@@ -118,7 +132,25 @@ namespace LibISDB
 		DataBuffer m_OutputCacheBuffer;
 		mutable MutexLock m_Lock;
 
-		Statistics m_Statistics;
+		/** 統計情報カウンタ (ロックなしで取得できるようにする) */
+		struct StatisticsCounter {
+			std::atomic<unsigned long long> InputBytes{0};
+			std::atomic<unsigned long long> InputDropBytes{0};
+			std::atomic<unsigned long long> OutputBytes{0};
+			std::atomic<unsigned long long> OutputCount{0};
+			std::atomic<unsigned long> OutputErrorCount{0};
+			std::atomic<unsigned long long> InputBufferUsed{0};
+			std::atomic<unsigned long long> InputBufferMaxUsed{0};
+			std::atomic<unsigned long> OutputStallCount{0};
+			std::atomic<unsigned long long> OutputStallTime{0};
+			LatencyHistogram OutputLatency;
+
+			void Reset() noexcept;
+			void Get(Statistics *pStats) const noexcept;
+		};
+
+		StatisticsCounter m_Statistics;
+		HighPrecisionTickClock m_OutputClock;
 		bool m_OutputErrorNotified;
 
 		EventListenerList<EventListener> m_EventListenerList;
@@ -255,7 +255,9 @@ bool DateTime::OffsetSeconds(long Seconds) noexcept
 	if (::gmtime_r(&Time, &Tm) == nullptr)
 		return false;
 
+	const int Milli = Millisecond;
 	FromTm(Tm);
+	Millisecond = Milli;
 
 	return true;
 
@@ -290,13 +292,25 @@ bool DateTime::OffsetMilliseconds(long long Milliseconds) noexcept
 
 #else	// LIBISDB_WINDOWS
 
-	const long long Seconds = Milliseconds / 1000LL;
+	// ミリ秒の端数も繰り上げ/繰り下げる
+	const long long Total = static_cast<long long>(Millisecond) + Milliseconds;
+	long long Seconds = Total / 1000LL;
+	int Milli = static_cast<int>(Total % 1000LL);
+	if (Milli < 0) {
+		Milli += 1000;
+		Seconds--;
+	}
 
 	if ((Seconds < static_cast<long long>(std::numeric_limits<long>::min()))
 			|| (Seconds > static_cast<long long>(std::numeric_limits<long>::max())))
 		return false;
 
-	return OffsetSeconds(static_cast<long>(Seconds));
+	Millisecond = 0;
+	if (!OffsetSeconds(static_cast<long>(Seconds)))
+		return false;
+	Millisecond = Milli;
+
+	return true;
 
 #endif	// !def LIBISDB_WINDOWS
 }
@@ -234,6 +234,13 @@ bool FileStreamPOSIX::Open(const String &FileName, OpenFlag Flags)
 		return false;
 	}
 
+#ifdef POSIX_FADV_SEQUENTIAL
+	if (!!(Flags & OpenFlag::SequentialRead))
+		::posix_fadvise(m_File, 0, 0, POSIX_FADV_SEQUENTIAL);
+	else if (!!(Flags & OpenFlag::RandomAccess))
+		::posix_fadvise(m_File, 0, 0, POSIX_FADV_RANDOM);
+#endif
+
 #endif	// ndef LIBISDB_WINDOWS
 
 	m_FileName = FileName;
@@ -317,6 +324,20 @@ bool FileStreamPOSIX::Flush()
 }
 
 
+bool FileStreamPOSIX::FlushData()
+{
+	if (m_File < 0) {
+		return false;
+	}
+
+#if !defined(LIBISDB_WINDOWS) && defined(_POSIX_SYNCHRONIZED_IO) && (_POSIX_SYNCHRONIZED_IO > 0)
+	return ::fdatasync(m_File) == 0;
+#else
+	return fsync(m_File) == 0;
+#endif
+}
+
+
 FileStreamPOSIX::SizeType FileStreamPOSIX::GetSize()
 {
 	if (m_File < 0) {
@@ -364,7 +385,7 @@ bool FileStreamPOSIX::SetPos(OffsetType Pos, SetPosType Type)
 
 	m_EOF = false;
 
-	return lseek64(m_File, Pos, Origin) == 0;
+	return lseek64(m_File, Pos, Origin) >= 0;
 }
 
 
@@ -59,6 +59,7 @@ namespace LibISDB
 		size_t Read(void *pBuff, size_t Size) override;
 		size_t Write(const void *pBuff, size_t Size) override;
 		bool Flush() override;
+		bool FlushData() override;
 
 		SizeType GetSize() override;
 		OffsetType GetPos() override;
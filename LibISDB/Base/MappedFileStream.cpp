@@ -0,0 +1,453 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   MappedFileStream.cpp
+ @brief  メモリマップドファイルストリーム
+ @author DBCTRADO
+*/
+
+
+#include "../LibISDBPrivate.hpp"
+#include "MappedFileStream.hpp"
+#include "../Utilities/Utilities.hpp"
+#include <algorithm>
+#include <cstring>
+
+#ifndef LIBISDB_WINDOWS
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "DebugDef.hpp"
+
+
+namespace LibISDB
+{
+
+
+MappedFileStream::MappedFileStream() noexcept
+#ifdef LIBISDB_WINDOWS
+	: m_hFile(INVALID_HANDLE_VALUE)
+	, m_hMapping(nullptr)
+#else
+	: m_File(-1)
+#endif
+	, m_FileSize(0)
+	, m_Pos(0)
+	, m_WindowSize(DEFAULT_WINDOW_SIZE)
+	, m_Granularity(0)
+	, m_pWindow(nullptr)
+	, m_WindowOffset(0)
+	, m_WindowMappedSize(0)
+	, m_Prefetched(false)
+{
+}
+
+
+MappedFileStream::~MappedFileStream()
+{
+	Close();
+}
+
+
+bool MappedFileStream::Open(const String &FileName, OpenFlag Flags)
+{
+	if (IsOpen()) {
+		SetError(std::errc::operation_in_progress);
+		return false;
+	}
+
+	if (FileName.empty()
+			|| !(Flags & OpenFlag::Read)
+			|| !!(Flags & (OpenFlag::Write | OpenFlag::Create | OpenFlag::Append | OpenFlag::Truncate | OpenFlag::New))) {
+		SetError(std::errc::invalid_argument);
+		return false;
+	}
+
+	LIBISDB_TRACE(
+		LIBISDB_STR("MappedFileStream::Open() : Open file \"{}\"\n"),
+		FileName);
+
+#ifdef LIBISDB_WINDOWS
+
+	DWORD Share = 0;
+	if (!!(Flags & OpenFlag::ShareRead))
+		Share |= FILE_SHARE_READ;
+	if (!!(Flags & OpenFlag::ShareWrite))
+		Share |= FILE_SHARE_WRITE;
+	if (!!(Flags & OpenFlag::ShareDelete))
+		Share |= FILE_SHARE_DELETE;
+
+	m_hFile = ::CreateFile(
+		FileName.c_str(), GENERIC_READ, Share, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_hFile == INVALID_HANDLE_VALUE) {
+		SetWin32Error(::GetLastError());
+		return false;
+	}
+
+	if (!UpdateFileSize()) {
+		Close();
+		return false;
+	}
+
+	SYSTEM_INFO SystemInfo;
+	::GetSystemInfo(&SystemInfo);
+	m_Granularity = SystemInfo.dwAllocationGranularity;
+
+#else	// LIBISDB_WINDOWS
+
+	m_File = ::open(FileName.c_str(), O_RDONLY);
+	if (m_File < 0) {
+		SetError(static_cast<std::errc>(errno));
+		return false;
+	}
+
+	struct ::stat Stat;
+	if (::fstat(m_File, &Stat) != 0) {
+		SetError(static_cast<std::errc>(errno));
+		Close();
+		return false;
+	}
+	if (!S_ISREG(Stat.st_mode)) {
+		SetError(std::errc::not_supported);
+		Close();
+		return false;
+	}
+	m_FileSize = Stat.st_size;
+
+	const long PageSize = ::sysconf(_SC_PAGESIZE);
+	m_Granularity = (PageSize > 0) ? static_cast<size_t>(PageSize) : 4096;
+
+#endif	// ndef LIBISDB_WINDOWS
+
+	m_FileName = FileName;
+	m_Pos = 0;
+	m_Prefetched = false;
+
+	ResetError();
+
+	return true;
+}
+
+
+bool MappedFileStream::Close()
+{
+	UnmapWindow();
+
+#ifdef LIBISDB_WINDOWS
+	if (m_hMapping != nullptr) {
+		::CloseHandle(m_hMapping);
+		m_hMapping = nullptr;
+	}
+	if (m_hFile != INVALID_HANDLE_VALUE) {
+		::CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (m_File >= 0) {
+		::close(m_File);
+		m_File = -1;
+	}
+#endif
+
+	m_FileName.clear();
+	m_FileSize = 0;
+	m_Pos = 0;
+
+	return true;
+}
+
+
+bool MappedFileStream::IsOpen() const
+{
+#ifdef LIBISDB_WINDOWS
+	return m_hFile != INVALID_HANDLE_VALUE;
+#else
+	return m_File >= 0;
+#endif
+}
+
+
+size_t MappedFileStream::Read(void *pBuff, size_t Size)
+{
+	if ((pBuff == nullptr) || (Size == 0))
+		return 0;
+
+	uint8_t *pDst = static_cast<uint8_t *>(pBuff);
+	size_t ReadSize = 0;
+
+	while (ReadSize < Size) {
+		uint8_t *pData;
+		const size_t ViewSize = ReadView(&pData, Size - ReadSize);
+		if (ViewSize == 0)
+			break;
+		std::memcpy(pDst + ReadSize, pData, ViewSize);
+		ReadSize += ViewSize;
+	}
+
+	return ReadSize;
+}
+
+
+size_t MappedFileStream::Write(const void *pBuff, size_t Size)
+{
+	SetError(std::errc::operation_not_permitted);
+	return 0;
+}
+
+
+bool MappedFileStream::Flush()
+{
+	return false;
+}
+
+
+MappedFileStream::SizeType MappedFileStream::GetSize()
+{
+	return m_FileSize;
+}
+
+
+MappedFileStream::OffsetType MappedFileStream::GetPos()
+{
+	return static_cast<OffsetType>(m_Pos);
+}
+
+
+bool MappedFileStream::SetPos(OffsetType Pos, SetPosType Type)
+{
+	if (!IsOpen())
+		return false;
+
+	OffsetType NewPos;
+
+	switch (Type) {
+	case SetPosType::Begin:
+		NewPos = Pos;
+		break;
+	case SetPosType::Current:
+		NewPos = static_cast<OffsetType>(m_Pos) + Pos;
+		break;
+	case SetPosType::End:
+		NewPos = static_cast<OffsetType>(m_FileSize) + Pos;
+		break;
+	default:
+		return false;
+	}
+
+	if (NewPos < 0) {
+		SetError(std::errc::invalid_argument);
+		return false;
+	}
+
+	m_Pos = static_cast<SizeType>(NewPos);
+	m_Prefetched = false;
+
+	return true;
+}
+
+
+bool MappedFileStream::IsEnd() const
+{
+	return m_Pos >= m_FileSize;
+}
+
+
+size_t MappedFileStream::ReadView(uint8_t **ppData, size_t Size)
+{
+	if ((ppData == nullptr) || (Size == 0) || !IsOpen())
+		return 0;
+
+	*ppData = nullptr;
+
+#ifdef LIBISDB_WINDOWS
+	if (m_Pos >= m_FileSize) {
+		// 書き込み中のファイルに対応するためサイズを取得し直す
+		if (!UpdateFileSize() || (m_Pos >= m_FileSize))
+			return 0;
+	}
+#else
+	// 書き込み中のファイルに対応するため、
+	// また切り詰められたファイルの末尾を超えた領域にアクセスしないように毎回サイズを取得し直す
+	if (!UpdateFileSize() || (m_Pos >= m_FileSize))
+		return 0;
+
+	// 切り詰められた場合はマップし直す
+	if ((m_pWindow != nullptr) && (m_WindowOffset + m_WindowMappedSize > m_FileSize))
+		UnmapWindow();
+#endif
+
+	if ((m_pWindow == nullptr)
+			|| (m_Pos < m_WindowOffset)
+			|| (m_Pos >= m_WindowOffset + m_WindowMappedSize)) {
+		if (!MapWindow(m_Pos))
+			return 0;
+	}
+
+	const size_t Offset = static_cast<size_t>(m_Pos - m_WindowOffset);
+	const size_t ViewSize = std::min(Size, m_WindowMappedSize - Offset);
+
+	*ppData = m_pWindow + Offset;
+	m_Pos += ViewSize;
+
+	// ウィンドウの後半に入ったら次のウィンドウを先読みさせる
+	if (!m_Prefetched && (Offset + ViewSize >= m_WindowMappedSize / 2))
+		PrefetchNextWindow();
+
+	return ViewSize;
+}
+
+
+bool MappedFileStream::SetWindowSize(size_t Size)
+{
+	if (Size == 0)
+		return false;
+
+	m_WindowSize = Size;
+
+	return true;
+}
+
+
+bool MappedFileStream::MapWindow(SizeType Offset)
+{
+	UnmapWindow();
+
+	const SizeType AlignedOffset = Offset - (Offset % m_Granularity);
+	const size_t WindowSize = RoundUp(std::max(m_WindowSize, m_Granularity), m_Granularity);
+	const size_t MapSize = static_cast<size_t>(std::min<SizeType>(WindowSize, m_FileSize - AlignedOffset));
+
+#ifdef LIBISDB_WINDOWS
+
+	void *pView = ::MapViewOfFile(
+		m_hMapping, FILE_MAP_COPY,
+		static_cast<DWORD>(AlignedOffset >> 32), static_cast<DWORD>(AlignedOffset & 0xFFFFFFFF_u64),
+		MapSize);
+	if (pView == nullptr) {
+		SetWin32Error(::GetLastError());
+		return false;
+	}
+
+#else	// LIBISDB_WINDOWS
+
+	// 下流で書き換えられてもファイルに影響しないようにコピーオンライトでマップする
+	void *pView = ::mmap(nullptr, MapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, m_File, static_cast<off_t>(AlignedOffset));
+	if (pView == MAP_FAILED) {
+		SetError(static_cast<std::errc>(errno));
+		return false;
+	}
+
+#ifdef MADV_SEQUENTIAL
+	::madvise(pView, MapSize, MADV_SEQUENTIAL);
+#endif
+
+#endif	// ndef LIBISDB_WINDOWS
+
+	m_pWindow = static_cast<uint8_t *>(pView);
+	m_WindowOffset = AlignedOffset;
+	m_WindowMappedSize = MapSize;
+	m_Prefetched = false;
+
+	return true;
+}
+
+
+void MappedFileStream::UnmapWindow()
+{
+	if (m_pWindow != nullptr) {
+#ifdef LIBISDB_WINDOWS
+		::UnmapViewOfFile(m_pWindow);
+#else
+		::munmap(m_pWindow, m_WindowMappedSize);
+#endif
+		m_pWindow = nullptr;
+		m_WindowOffset = 0;
+		m_WindowMappedSize = 0;
+	}
+}
+
+
+bool MappedFileStream::UpdateFileSize()
+{
+#ifdef LIBISDB_WINDOWS
+
+	LARGE_INTEGER Size;
+	if (!::GetFileSizeEx(m_hFile, &Size)) {
+		SetWin32Error(::GetLastError());
+		return false;
+	}
+
+	if ((m_hMapping != nullptr) && (static_cast<SizeType>(Size.QuadPart) <= m_FileSize))
+		return true;
+
+	// マッピングはその時点のファイルサイズで作られるため作り直す
+	UnmapWindow();
+	if (m_hMapping != nullptr) {
+		::CloseHandle(m_hMapping);
+		m_hMapping = nullptr;
+	}
+
+	m_FileSize = Size.QuadPart;
+
+	if (m_FileSize > 0) {
+		m_hMapping = ::CreateFileMapping(m_hFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		if (m_hMapping == nullptr) {
+			SetWin32Error(::GetLastError());
+			return false;
+		}
+	}
+
+#else	// LIBISDB_WINDOWS
+
+	struct ::stat Stat;
+	if (::fstat(m_File, &Stat) != 0) {
+		SetError(static_cast<std::errc>(errno));
+		return false;
+	}
+
+	m_FileSize = Stat.st_size;
+
+#endif	// ndef LIBISDB_WINDOWS
+
+	return true;
+}
+
+
+void MappedFileStream::PrefetchNextWindow()
+{
+	m_Prefetched = true;
+
+	const SizeType NextOffset = m_WindowOffset + m_WindowMappedSize;
+	if (NextOffset >= m_FileSize)
+		return;
+
+#if !defined(LIBISDB_WINDOWS) && defined(POSIX_FADV_WILLNEED)
+	const SizeType PrefetchSize = std::min<SizeType>(m_WindowMappedSize, m_FileSize - NextOffset);
+	::posix_fadvise(
+		m_File, static_cast<off_t>(NextOffset), static_cast<off_t>(PrefetchSize), POSIX_FADV_WILLNEED);
+#endif
+}
+
+
+}	// namespace LibISDB
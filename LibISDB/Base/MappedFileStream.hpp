@@ -0,0 +1,100 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   MappedFileStream.hpp
+ @brief  メモリマップドファイルストリーム
+ @author DBCTRADO
+*/
+
+
+#ifndef LIBISDB_MAPPED_FILE_STREAM_H
+#define LIBISDB_MAPPED_FILE_STREAM_H
+
+
+#include "Stream.hpp"
+#ifdef LIBISDB_WINDOWS
+#include "../LibISDBWindows.hpp"
+#endif
+
+
+namespace LibISDB
+{
+
+	/** メモリマップドファイルストリームクラス(読み込み専用) */
+	class MappedFileStream
+		: public FileStreamBase
+	{
+	public:
+		static constexpr size_t DEFAULT_WINDOW_SIZE = 64 * 1024 * 1024;
+
+		MappedFileStream() noexcept;
+		~MappedFileStream();
+
+		bool Open(const String &FileName, OpenFlag Flags) override;
+		bool Close() override;
+		bool IsOpen() const override;
+
+		size_t Read(void *pBuff, size_t Size) override;
+		size_t Write(const void *pBuff, size_t Size) override;
+		bool Flush() override;
+
+		SizeType GetSize() override;
+		OffsetType GetPos() override;
+		bool SetPos(OffsetType Pos, SetPosType Type) override;
+
+		bool IsEnd() const override;
+
+		/*
+			POSIX ではファイルを MAP_PRIVATE でマップする。
+			ReadView() の度にファイルサイズを確認し、切り詰められていればマップし直すが、
+			ReadView() で取得した領域を参照している間に他のプロセスがファイルを切り詰めると、
+			ファイル末尾を超えたページへのアクセスで SIGBUS が発生する。
+			切り詰められる可能性のあるファイルは FileStream で読み込むこと。
+		*/
+		size_t ReadView(uint8_t **ppData, size_t Size);
+		bool SetWindowSize(size_t Size);
+		size_t GetWindowSize() const noexcept { return m_WindowSize; }
+
+	protected:
+		bool MapWindow(SizeType Offset);
+		void UnmapWindow();
+		bool UpdateFileSize();
+		void PrefetchNextWindow();
+
+#ifdef LIBISDB_WINDOWS
+		HANDLE m_hFile;
+		HANDLE m_hMapping;
+#else
+		int m_File;
+#endif
+		SizeType m_FileSize;
+		SizeType m_Pos;
+		size_t m_WindowSize;
+		size_t m_Granularity;
+		uint8_t *m_pWindow;
+		SizeType m_WindowOffset;
+		size_t m_WindowMappedSize;
+		bool m_Prefetched;
+	};
+
+}	// namespace LibISDB
+
+
+#endif	// ifndef LIBISDB_MAPPED_FILE_STREAM_H
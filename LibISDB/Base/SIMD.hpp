@@ -84,6 +84,10 @@ namespace LibISDB
 	bool IsSSE2Enabled() noexcept;
 #endif
 	void SetSSE2Enabled(bool Enabled) noexcept;
+
+	bool IsPCLMULQDQAvailable() noexcept;
+	bool IsPCLMULQDQEnabled() noexcept;
+	void SetPCLMULQDQEnabled(bool Enabled) noexcept;
 #endif
 
 }	// namespace LibISDB
@@ -98,6 +98,8 @@ namespace LibISDB
 
 		virtual bool Open(const String &FileName, OpenFlag Flags) = 0;
 
+		virtual bool FlushData() { return Flush(); }
+
 		virtual bool Preallocate(SizeType Size) { return false; }
 		virtual bool SetPreallocationUnit(SizeType Unit) { return false; }
 		virtual SizeType GetPreallocationUnit() const { return 0; }
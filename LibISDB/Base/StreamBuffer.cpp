@@ -718,6 +718,24 @@ bool StreamBuffer::SequentialReader::IsDataAvailable() const
 }
 
 
+unsigned long long StreamBuffer::SequentialReader::GetAvailableSize() const
+{
+	if (!m_Buffer || (m_Pos == StreamBuffer::POS_INVALID))
+		return 0;
+
+	PosType Begin, End;
+
+	if (!m_Buffer->GetDataRange(&Begin, &End))
+		return 0;
+
+	const PosType Pos = std::max(m_Pos, Begin);
+	if (End <= Pos)
+		return 0;
+
+	return static_cast<unsigned long long>(End - Pos);
+}
+
+
 void StreamBuffer::SequentialReader::ResetPos()
 {
 	if (m_Buffer)
@@ -79,6 +79,7 @@ namespace LibISDB
 			bool SeekToBegin() override;
 			bool SeekToEnd() override;
 			bool IsDataAvailable() const override;
+			unsigned long long GetAvailableSize() const;
 
 		protected:
 			void ResetPos();
@@ -35,6 +35,9 @@ namespace LibISDB
 
 FileStreamWriter::FileStreamWriter() noexcept
 	: m_WriteSize(0)
+	, m_SyncInterval(std::chrono::milliseconds(0))
+	, m_LastSyncTime(0)
+	, m_SyncErrorCount(0)
 {
 }
 
@@ -56,6 +59,11 @@ bool FileStreamWriter::Open(const String &FileName, OpenFlag Flags)
 
 	m_File.reset(pFile);
 	m_WriteSize = 0;
+	m_LastSyncTime = m_Clock.Get();
+
+	m_WriteLatency.Reset();
+	m_SyncLatency.Reset();
+	m_SyncErrorCount = 0;
 
 	ResetError();
 
@@ -73,6 +81,7 @@ bool FileStreamWriter::Reopen(const String &FileName, OpenFlag Flags)
 	Close();
 
 	m_File.reset(pFile);
+	m_LastSyncTime = m_Clock.Get();
 
 	return true;
 }
@@ -99,10 +108,22 @@ size_t FileStreamWriter::Write(const void *pBuffer, size_t Size)
 		return 0;
 	}
 
+	const HighPrecisionTickClock::ClockType StartTime = m_Clock.Get();
 	const size_t Write = m_File->Write(pBuffer, Size);
+	const HighPrecisionTickClock::ClockType EndTime = m_Clock.Get();
+
+	m_WriteLatency.Add(
+		std::chrono::duration_cast<std::chrono::microseconds>(
+			HighPrecisionTickClock::DurationType(EndTime - StartTime)));
 
 	m_WriteSize += Write;
 
+	// 同期間隔は書き出しスレッド外から変更される
+	const std::chrono::milliseconds SyncInterval = m_SyncInterval.load(std::memory_order_relaxed);
+	if ((SyncInterval.count() > 0)
+			&& (HighPrecisionTickClock::DurationType(EndTime - m_LastSyncTime) >= SyncInterval))
+		SyncFile();
+
 	return Write;
 }
 
@@ -144,6 +165,45 @@ bool FileStreamWriter::SetPreallocationUnit(SizeType PreallocationUnit)
 }
 
 
+bool FileStreamWriter::SetSyncInterval(const std::chrono::milliseconds &Interval)
+{
+	m_SyncInterval.store(
+		(Interval.count() > 0) ? Interval : std::chrono::milliseconds(0),
+		std::memory_order_relaxed);
+
+	return true;
+}
+
+
+bool FileStreamWriter::GetWriteStatistics(WriteStatistics *pStatistics) const
+{
+	if (pStatistics == nullptr)
+		return false;
+
+	m_WriteLatency.Get(&pStatistics->WriteLatency);
+	m_SyncLatency.Get(&pStatistics->SyncLatency);
+	pStatistics->SyncErrorCount = m_SyncErrorCount.load(std::memory_order_relaxed);
+
+	return true;
+}
+
+
+void FileStreamWriter::SyncFile()
+{
+	const HighPrecisionTickClock::ClockType StartTime = m_Clock.Get();
+	const bool Result = m_File->FlushData();
+	const HighPrecisionTickClock::ClockType EndTime = m_Clock.Get();
+
+	m_SyncLatency.Add(
+		std::chrono::duration_cast<std::chrono::microseconds>(
+			HighPrecisionTickClock::DurationType(EndTime - StartTime)));
+	if (!Result)
+		m_SyncErrorCount.fetch_add(1, std::memory_order_relaxed);
+
+	m_LastSyncTime = EndTime;
+}
+
+
 FileStream * FileStreamWriter::OpenFile(const String &FileName, OpenFlag Flags)
 {
 	FileStream *pFile = new FileStream;
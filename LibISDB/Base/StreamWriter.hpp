@@ -30,6 +30,8 @@
 
 #include "ErrorHandler.hpp"
 #include "FileStream.hpp"
+#include "../Utilities/LatencyHistogram.hpp"
+#include "../Utilities/Clock.hpp"
 
 
 namespace LibISDB
@@ -49,6 +51,13 @@ namespace LibISDB
 			LIBISDB_ENUM_FLAGS_TRAILER
 		};
 
+		/** 書き出し統計情報 */
+		struct WriteStatistics {
+			LatencyHistogram::Snapshot WriteLatency;
+			LatencyHistogram::Snapshot SyncLatency;
+			unsigned long SyncErrorCount = 0;
+		};
+
 		virtual ~StreamWriter() = default;
 
 		virtual bool Open(const String &FileName, OpenFlag Flags = OpenFlag::None) = 0;
@@ -60,6 +69,8 @@ namespace LibISDB
 		virtual SizeType GetWriteSize() const = 0;
 		virtual bool IsWriteSizeAvailable() const = 0;
 		virtual bool SetPreallocationUnit(SizeType PreallocationUnit) { return false; }
+		virtual bool SetSyncInterval(const std::chrono::milliseconds &Interval) { return false; }
+		virtual bool GetWriteStatistics(WriteStatistics *pStatistics) const { return false; }
 	};
 
 	/** ファイルストリーム書き出しクラス */
@@ -80,12 +91,22 @@ namespace LibISDB
 		SizeType GetWriteSize() const override;
 		bool IsWriteSizeAvailable() const override;
 		bool SetPreallocationUnit(SizeType PreallocationUnit) override;
+		bool SetSyncInterval(const std::chrono::milliseconds &Interval) override;
+		bool GetWriteStatistics(WriteStatistics *pStatistics) const override;
 
 	private:
 		FileStream * OpenFile(const String &FileName, OpenFlag Flags);
+		void SyncFile();
 
 		std::unique_ptr<FileStream> m_File;
 		SizeType m_WriteSize;
+
+		HighPrecisionTickClock m_Clock;
+		std::atomic<std::chrono::milliseconds> m_SyncInterval;
+		HighPrecisionTickClock::ClockType m_LastSyncTime;
+		LatencyHistogram m_WriteLatency;
+		LatencyHistogram m_SyncLatency;
+		std::atomic<unsigned long> m_SyncErrorCount;
 	};
 
 }	// namespace LibISDB
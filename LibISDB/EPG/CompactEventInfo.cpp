@@ -0,0 +1,258 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   CompactEventInfo.cpp
+ @brief  データベース格納用番組情報
+ @author DBCTRADO
+*/
+
+
+#include "../LibISDBPrivate.hpp"
+#include "CompactEventInfo.hpp"
+#include "../Base/DebugDef.hpp"
+
+
+namespace LibISDB
+{
+
+
+CompactEventInfo::CompactEventInfo(const EventInfo &Info)
+{
+	SetEventInfo(Info);
+}
+
+
+void CompactEventInfo::SetEventInfo(const EventInfo &Info)
+{
+	NetworkID         = Info.NetworkID;
+	TransportStreamID = Info.TransportStreamID;
+	ServiceID         = Info.ServiceID;
+	EventID           = Info.EventID;
+	StartTime         = Info.StartTime.IsValid() ? Info.StartTime.GetLinearSeconds() : 0;
+	UpdatedTime       = Info.UpdatedTime;
+	Duration          = Info.Duration;
+	SourceID          = Info.SourceID;
+	Type              = Info.Type;
+	CommonEvent       = Info.CommonEvent;
+	RunningStatus     = Info.RunningStatus;
+	FreeCAMode        = Info.FreeCAMode;
+	IsCommonEvent     = Info.IsCommonEvent;
+	EventName.Assign(Info.EventName);
+	EventText.Assign(Info.EventText);
+	ConvertExtendedTextList(Info.ExtendedText, &ExtendedText);
+
+	// 全て空であれば個別の領域は確保しない
+	if (!Info.VideoList.empty() || !Info.AudioList.empty()
+			|| (Info.ContentNibble.NibbleCount > 0) || !Info.EventGroupList.empty()) {
+		std::shared_ptr<DetailInfo> Dst = std::make_shared<DetailInfo>();
+		ConvertVideoList(Info.VideoList, &Dst->VideoList);
+		ConvertAudioList(Info.AudioList, &Dst->AudioList);
+		Dst->ContentNibble = Info.ContentNibble;
+		Dst->EventGroupList = Info.EventGroupList;
+		Detail = std::move(Dst);
+	} else {
+		Detail.reset();
+	}
+}
+
+
+void CompactEventInfo::GetEventInfo(EventInfo *pInfo) const
+{
+	pInfo->NetworkID         = NetworkID;
+	pInfo->TransportStreamID = TransportStreamID;
+	pInfo->ServiceID         = ServiceID;
+	pInfo->EventID           = EventID;
+	if ((StartTime == 0) || !pInfo->StartTime.FromLinearSeconds(StartTime))
+		pInfo->StartTime.Reset();
+	pInfo->Duration          = Duration;
+	pInfo->RunningStatus     = RunningStatus;
+	pInfo->FreeCAMode        = FreeCAMode;
+	EventName.Get(&pInfo->EventName);
+	EventText.Get(&pInfo->EventText);
+	GetExtendedTextList(ExtendedText, &pInfo->ExtendedText);
+	if (Detail) {
+		GetVideoList(Detail->VideoList, &pInfo->VideoList);
+		GetAudioList(Detail->AudioList, &pInfo->AudioList);
+		pInfo->ContentNibble  = Detail->ContentNibble;
+		pInfo->EventGroupList = Detail->EventGroupList;
+	} else {
+		pInfo->VideoList.clear();
+		pInfo->AudioList.clear();
+		pInfo->ContentNibble  = EventInfo::ContentNibbleInfo();
+		pInfo->EventGroupList.clear();
+	}
+	pInfo->IsCommonEvent     = IsCommonEvent;
+	pInfo->CommonEvent       = CommonEvent;
+	pInfo->Type              = Type;
+	pInfo->UpdatedTime       = UpdatedTime;
+	pInfo->SourceID          = SourceID;
+}
+
+
+bool CompactEventInfo::GetStartTime(ReturnArg<DateTime> Time) const
+{
+	if (!Time)
+		return false;
+
+	if ((StartTime == 0) || !Time->FromLinearSeconds(StartTime)) {
+		Time->Reset();
+		return false;
+	}
+
+	return true;
+}
+
+
+bool CompactEventInfo::GetEndTime(ReturnArg<DateTime> Time) const
+{
+	if (!Time)
+		return false;
+
+	if ((StartTime == 0) || !Time->FromLinearSeconds(StartTime + Duration)) {
+		Time->Reset();
+		return false;
+	}
+
+	return true;
+}
+
+
+CompactEventInfo::DetailInfo & CompactEventInfo::GetDetail()
+{
+	// 他の複製と共有していれば、変更する前に自身の分を複製する
+	std::shared_ptr<DetailInfo> NewDetail;
+
+	if (!Detail)
+		NewDetail = std::make_shared<DetailInfo>();
+	else if (Detail.use_count() > 1)
+		NewDetail = std::make_shared<DetailInfo>(*Detail);
+
+	if (NewDetail) {
+		DetailInfo &Dst = *NewDetail;
+		Detail = std::move(NewDetail);
+		return Dst;
+	}
+
+	// 共有されていなければ自身が確保したものなので変更してよい
+	return const_cast<DetailInfo &>(*Detail);
+}
+
+
+void CompactEventInfo::ConvertExtendedTextList(const EventInfo::ExtendedTextInfoList &Src, ExtendedTextInfoList *pDst)
+{
+	pDst->clear();
+	pDst->reserve(Src.size());
+
+	for (const auto &e : Src) {
+		ExtendedTextInfo &Info = pDst->emplace_back();
+		Info.Description.Assign(e.Description);
+		Info.Text.Assign(e.Text);
+	}
+}
+
+
+void CompactEventInfo::ConvertVideoList(const EventInfo::VideoInfoList &Src, VideoInfoList *pDst)
+{
+	pDst->clear();
+	pDst->reserve(Src.size());
+
+	for (const auto &e : Src) {
+		VideoInfo &Info = pDst->emplace_back();
+		Info.StreamContent = e.StreamContent;
+		Info.ComponentType = e.ComponentType;
+		Info.ComponentTag  = e.ComponentTag;
+		Info.LanguageCode  = e.LanguageCode;
+		Info.Text.Assign(e.Text);
+	}
+}
+
+
+void CompactEventInfo::ConvertAudioList(const EventInfo::AudioInfoList &Src, AudioInfoList *pDst)
+{
+	pDst->clear();
+	pDst->reserve(Src.size());
+
+	for (const auto &e : Src) {
+		AudioInfo &Info = pDst->emplace_back();
+		Info.StreamContent      = e.StreamContent;
+		Info.ComponentType      = e.ComponentType;
+		Info.ComponentTag       = e.ComponentTag;
+		Info.SimulcastGroupTag  = e.SimulcastGroupTag;
+		Info.ESMultiLingualFlag = e.ESMultiLingualFlag;
+		Info.MainComponentFlag  = e.MainComponentFlag;
+		Info.QualityIndicator   = e.QualityIndicator;
+		Info.SamplingRate       = e.SamplingRate;
+		Info.LanguageCode       = e.LanguageCode;
+		Info.LanguageCode2      = e.LanguageCode2;
+		Info.Text.Assign(e.Text);
+	}
+}
+
+
+void CompactEventInfo::GetExtendedTextList(const ExtendedTextInfoList &Src, EventInfo::ExtendedTextInfoList *pDst)
+{
+	pDst->resize(Src.size());
+
+	for (size_t i = 0; i < Src.size(); i++) {
+		Src[i].Description.Get(&(*pDst)[i].Description);
+		Src[i].Text.Get(&(*pDst)[i].Text);
+	}
+}
+
+
+void CompactEventInfo::GetVideoList(const VideoInfoList &Src, EventInfo::VideoInfoList *pDst)
+{
+	pDst->resize(Src.size());
+
+	for (size_t i = 0; i < Src.size(); i++) {
+		const VideoInfo &s = Src[i];
+		EventInfo::VideoInfo &d = (*pDst)[i];
+		d.StreamContent = s.StreamContent;
+		d.ComponentType = s.ComponentType;
+		d.ComponentTag  = s.ComponentTag;
+		d.LanguageCode  = s.LanguageCode;
+		s.Text.Get(&d.Text);
+	}
+}
+
+
+void CompactEventInfo::GetAudioList(const AudioInfoList &Src, EventInfo::AudioInfoList *pDst)
+{
+	pDst->resize(Src.size());
+
+	for (size_t i = 0; i < Src.size(); i++) {
+		const AudioInfo &s = Src[i];
+		EventInfo::AudioInfo &d = (*pDst)[i];
+		d.StreamContent      = s.StreamContent;
+		d.ComponentType      = s.ComponentType;
+		d.ComponentTag       = s.ComponentTag;
+		d.SimulcastGroupTag  = s.SimulcastGroupTag;
+		d.ESMultiLingualFlag = s.ESMultiLingualFlag;
+		d.MainComponentFlag  = s.MainComponentFlag;
+		d.QualityIndicator   = s.QualityIndicator;
+		d.SamplingRate       = s.SamplingRate;
+		d.LanguageCode       = s.LanguageCode;
+		d.LanguageCode2      = s.LanguageCode2;
+		s.Text.Get(&d.Text);
+	}
+}
+
+
+}	// namespace LibISDB
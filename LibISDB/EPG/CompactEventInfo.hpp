@@ -0,0 +1,132 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   CompactEventInfo.hpp
+ @brief  データベース格納用番組情報
+ @author DBCTRADO
+*/
+
+
+#ifndef LIBISDB_COMPACT_EVENT_INFO_H
+#define LIBISDB_COMPACT_EVENT_INFO_H
+
+
+#include "EventInfo.hpp"
+#include "../Utilities/StringPool.hpp"
+#include <memory>
+
+
+namespace LibISDB
+{
+
+	/** データベース格納用のコンパクトな番組情報クラス */
+	class CompactEventInfo
+	{
+	public:
+		struct ExtendedTextInfo {
+			PooledString Description;
+			PooledString Text;
+
+			bool operator == (const ExtendedTextInfo &rhs) const = default;
+		};
+
+		struct VideoInfo {
+			uint8_t StreamContent;
+			uint8_t ComponentType;
+			uint8_t ComponentTag;
+			uint32_t LanguageCode;
+			PooledString Text;
+		};
+
+		struct AudioInfo {
+			uint8_t StreamContent;
+			uint8_t ComponentType;
+			uint8_t ComponentTag;
+			uint8_t SimulcastGroupTag;
+			bool ESMultiLingualFlag;
+			bool MainComponentFlag;
+			uint8_t QualityIndicator;
+			uint8_t SamplingRate;
+			uint32_t LanguageCode;
+			uint32_t LanguageCode2;
+			PooledString Text;
+		};
+
+		typedef std::vector<ExtendedTextInfo> ExtendedTextInfoList;
+		typedef std::vector<VideoInfo> VideoInfoList;
+		typedef std::vector<AudioInfo> AudioInfoList;
+
+		/** 個別に確保する情報 (複製間で共有し、変更時に複製する) */
+		struct DetailInfo {
+			VideoInfoList VideoList;
+			AudioInfoList AudioList;
+			EventInfo::ContentNibbleInfo ContentNibble;
+			EventInfo::EventGroupInfoList EventGroupList;
+		};
+
+		uint16_t NetworkID = NETWORK_ID_INVALID;
+		uint16_t TransportStreamID = TRANSPORT_STREAM_ID_INVALID;
+		uint16_t ServiceID = SERVICE_ID_INVALID;
+		uint16_t EventID = EVENT_ID_INVALID;
+		unsigned long long StartTime = 0; /**< 開始日時 (DateTime::GetLinearSeconds() の値、0 で不明) */
+		unsigned long long UpdatedTime = 0;
+		uint32_t Duration = 0;
+		EventInfo::SourceIDType SourceID = 0;
+		EventInfo::TypeFlag Type = EventInfo::TypeFlag::None;
+		EventInfo::CommonEventInfo CommonEvent;
+		uint8_t RunningStatus = 0;
+		bool FreeCAMode = false;
+		bool IsCommonEvent = false;
+		PooledString EventName;
+		PooledString EventText;
+		ExtendedTextInfoList ExtendedText;
+		std::shared_ptr<const DetailInfo> Detail;
+
+		CompactEventInfo() = default;
+		explicit CompactEventInfo(const EventInfo &Info);
+		CompactEventInfo(const CompactEventInfo &Src) = default;
+		CompactEventInfo(CompactEventInfo &&Src) noexcept = default;
+
+		CompactEventInfo & operator = (const CompactEventInfo &Src) = default;
+		CompactEventInfo & operator = (CompactEventInfo &&Src) noexcept = default;
+
+		void SetEventInfo(const EventInfo &Info);
+		void GetEventInfo(EventInfo *pInfo) const;
+
+		bool IsValid() const { return !EventName.IsEmpty() || IsCommonEvent; }
+		bool HasBasic() const noexcept { return !!(Type & EventInfo::TypeFlag::Basic); }
+		bool HasExtended() const noexcept { return !!(Type & EventInfo::TypeFlag::Extended); }
+		bool GetStartTime(ReturnArg<DateTime> Time) const;
+		bool GetEndTime(ReturnArg<DateTime> Time) const;
+
+		DetailInfo & GetDetail();
+
+		static void ConvertExtendedTextList(const EventInfo::ExtendedTextInfoList &Src, ExtendedTextInfoList *pDst);
+		static void ConvertVideoList(const EventInfo::VideoInfoList &Src, VideoInfoList *pDst);
+		static void ConvertAudioList(const EventInfo::AudioInfoList &Src, AudioInfoList *pDst);
+		static void GetExtendedTextList(const ExtendedTextInfoList &Src, EventInfo::ExtendedTextInfoList *pDst);
+		static void GetVideoList(const VideoInfoList &Src, EventInfo::VideoInfoList *pDst);
+		static void GetAudioList(const AudioInfoList &Src, EventInfo::AudioInfoList *pDst);
+	};
+
+}	// namespace LibISDB
+
+
+#endif	// ifndef LIBISDB_COMPACT_EVENT_INFO_H
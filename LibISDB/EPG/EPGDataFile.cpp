@@ -27,9 +27,25 @@
 #include "../LibISDBPrivate.hpp"
 #include "EPGDataFile.hpp"
 #include "../Base/FileStream.hpp"
+#include "../Base/MappedFileStream.hpp"
 #include "../Utilities/StringUtilities.hpp"
 #include "../Utilities/CRC.hpp"
 #include <new>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <system_error>
+#include <limits>
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include "../Base/DebugDef.hpp"
 
 
@@ -98,6 +114,14 @@ namespace
 	│└───────────────────┘│
 	│ ...                                      │
 	└─────────────────────┘
+
+	バージョン 1 以降では End チャンクの後にサービスディレクトリ(ServiceDirectoryEntry の配列)と
+	FileFooter が続き、各サービスの位置を直接参照できる。
+	End チャンクまではバージョン 0 と同じ構造のため、順に読み込むこともできる。
+
+	ジャーナルファイルは JournalHeader の後に、JournalRecordHeader と
+	変更されたサービスの ServiceInfo チャンクから ServiceEnd チャンクまでの組が続く。
+	読み込み時はベースのファイルを読み込んだ後、各サービスをジャーナルの内容で置き換える。
 */
 
 
@@ -140,7 +164,8 @@ struct FileHeader {
 } LIBISDB_ATTRIBUTE_PACKED;
 
 const char FileHeader_Type[8] = {'E', 'P', 'G', '-', 'D', 'A', 'T', 'A'};
-constexpr uint32_t FileHeader_Version = 0;
+constexpr uint32_t FileHeader_Version = 1;
+constexpr uint32_t FileHeader_IndexedVersion = 1;
 
 struct EPGDateTime {
 	uint16_t Year;
@@ -263,6 +288,39 @@ struct EventGroupInfo {
 	uint16_t TransportStreamID;
 } LIBISDB_ATTRIBUTE_PACKED;
 
+struct ServiceDirectoryEntry {
+	uint16_t NetworkID;
+	uint16_t TransportStreamID;
+	uint16_t ServiceID;
+	uint16_t EventCount;
+	uint64_t Offset;
+	uint32_t Size;
+} LIBISDB_ATTRIBUTE_PACKED;
+
+struct FileFooter {
+	uint64_t DirectoryOffset;
+	uint32_t ServiceCount;
+	uint32_t DirectoryCRC;
+	char Type[8];
+} LIBISDB_ATTRIBUTE_PACKED;
+
+const char FileFooter_Type[8] = {'E', 'P', 'G', '-', 'I', 'N', 'D', 'X'};
+
+struct JournalHeader {
+	char Type[8];
+	uint32_t Version;
+	uint32_t Reserved;
+	uint64_t BaseUpdateCount;
+} LIBISDB_ATTRIBUTE_PACKED;
+
+const char JournalHeader_Type[8] = {'E', 'P', 'G', '-', 'J', 'R', 'N', 'L'};
+constexpr uint32_t JournalHeader_Version = 0;
+
+struct JournalRecordHeader {
+	uint32_t Size;
+	uint32_t CRC;
+} LIBISDB_ATTRIBUTE_PACKED;
+
 
 LIBISDB_PRAGMA_PACK_POP
 
@@ -273,6 +331,254 @@ LIBISDB_PRAGMA_PACK_POP
 constexpr uint16_t MAX_EPG_TEXT_LENGTH = 4096;
 
 
+// メモリ上のデータを読み込むストリーム
+class MemoryReadStream
+	: public Stream
+{
+public:
+	MemoryReadStream(const uint8_t *pData, size_t Size) noexcept
+		: m_pData(pData)
+		, m_Size(Size)
+		, m_Pos(0)
+	{
+	}
+
+	bool Close() override { return true; }
+	bool IsOpen() const override { return true; }
+
+	size_t Read(void *pBuff, size_t Size) override
+	{
+		if (Size > m_Size - m_Pos)
+			Size = m_Size - m_Pos;
+		std::memcpy(pBuff, m_pData + m_Pos, Size);
+		m_Pos += Size;
+		return Size;
+	}
+
+	size_t Write(const void *pBuff, size_t Size) override { return 0; }
+	bool Flush() override { return false; }
+
+	SizeType GetSize() override { return m_Size; }
+	OffsetType GetPos() override { return static_cast<OffsetType>(m_Pos); }
+
+	bool SetPos(OffsetType Pos, SetPosType Type) override
+	{
+		OffsetType NewPos;
+
+		switch (Type) {
+		case SetPosType::Begin:
+			NewPos = Pos;
+			break;
+		case SetPosType::Current:
+			NewPos = static_cast<OffsetType>(m_Pos) + Pos;
+			break;
+		case SetPosType::End:
+			NewPos = static_cast<OffsetType>(m_Size) + Pos;
+			break;
+		default:
+			return false;
+		}
+
+		if ((NewPos < 0) || (static_cast<SizeType>(NewPos) > m_Size))
+			return false;
+
+		m_Pos = static_cast<size_t>(NewPos);
+
+		return true;
+	}
+
+	bool IsEnd() const override { return m_Pos >= m_Size; }
+
+private:
+	const uint8_t *m_pData;
+	size_t m_Size;
+	size_t m_Pos;
+};
+
+
+// メモリに書き出すストリーム
+class MemoryWriteStream
+	: public Stream
+{
+public:
+	MemoryWriteStream(std::vector<uint8_t> *pBuffer) noexcept
+		: m_pBuffer(pBuffer)
+	{
+		m_pBuffer->clear();
+	}
+
+	bool Close() override { return true; }
+	bool IsOpen() const override { return true; }
+
+	size_t Read(void *pBuff, size_t Size) override { return 0; }
+
+	size_t Write(const void *pBuff, size_t Size) override
+	{
+		const uint8_t *pData = static_cast<const uint8_t *>(pBuff);
+		m_pBuffer->insert(m_pBuffer->end(), pData, pData + Size);
+		return Size;
+	}
+
+	bool Flush() override { return true; }
+
+	SizeType GetSize() override { return m_pBuffer->size(); }
+	OffsetType GetPos() override { return static_cast<OffsetType>(m_pBuffer->size()); }
+	bool SetPos(OffsetType Pos, SetPosType Type) override { return false; }
+
+	bool IsEnd() const override { return true; }
+
+private:
+	std::vector<uint8_t> *m_pBuffer;
+};
+
+
+constexpr uint32_t MAX_JOURNAL_RECORD_SIZE = 64 * 1024 * 1024;
+constexpr unsigned long long MIN_JOURNAL_COMPACTION_THRESHOLD = 1024 * 1024;
+
+
+bool ReadFileHeader(const String &FileName, EPGData::FileHeader *pHeader, Stream::SizeType *pFileSize)
+{
+	FileStream File;
+
+	if (!File.Open(FileName, FileStream::OpenFlag::Read | FileStream::OpenFlag::ShareRead))
+		return false;
+	if (File.Read(pHeader, sizeof(EPGData::FileHeader)) != sizeof(EPGData::FileHeader))
+		return false;
+	if ((std::memcmp(pHeader->Type, EPGData::FileHeader_Type, sizeof(pHeader->Type)) != 0)
+			|| (pHeader->Version > EPGData::FileHeader_Version))
+		return false;
+
+	*pFileSize = File.GetSize();
+
+	return true;
+}
+
+
+bool GetFileSize(const String &FileName, Stream::SizeType *pFileSize)
+{
+	FileStream File;
+
+	if (!File.Open(FileName, FileStream::OpenFlag::Read | FileStream::OpenFlag::ShareRead))
+		return false;
+
+	*pFileSize = File.GetSize();
+
+	return true;
+}
+
+
+bool RemoveFile(const String &FileName)
+{
+#ifdef LIBISDB_WINDOWS
+	return ::DeleteFile(FileName.c_str()) != FALSE;
+#else
+	return std::remove(FileName.c_str()) == 0;
+#endif
+}
+
+
+bool ReplaceFile(const String &SrcFileName, const String &DstFileName)
+{
+#ifdef LIBISDB_WINDOWS
+	return ::MoveFileEx(
+		SrcFileName.c_str(), DstFileName.c_str(),
+		MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+#else
+	return std::rename(SrcFileName.c_str(), DstFileName.c_str()) == 0;
+#endif
+}
+
+
+// ジャーナルの有効なレコードを順に列挙する
+template<typename TFunc> bool ScanJournal(
+	const String &FileName, uint64_t BaseUpdateCount,
+	unsigned long long *pValidSize, Stream::SizeType *pFileSize, TFunc &&Func)
+{
+	BufferedFileStream File;
+
+	if (!File.Open(
+				FileName,
+				FileStream::OpenFlag::Read |
+				FileStream::OpenFlag::ShareRead |
+				FileStream::OpenFlag::SequentialRead))
+		return false;
+
+	EPGData::JournalHeader Header;
+
+	if (File.Read(&Header, sizeof(EPGData::JournalHeader)) != sizeof(EPGData::JournalHeader))
+		return false;
+	// ベースのファイルが書き直された後のジャーナルは使わない
+	if ((std::memcmp(Header.Type, EPGData::JournalHeader_Type, sizeof(Header.Type)) != 0)
+			|| (Header.Version != EPGData::JournalHeader_Version)
+			|| (Header.BaseUpdateCount != BaseUpdateCount))
+		return false;
+
+	*pFileSize = File.GetSize();
+	*pValidSize = sizeof(EPGData::JournalHeader);
+
+	std::vector<uint8_t> Buffer;
+
+	// 書き込み途中で中断されたレコード以降は無視する
+	for (;;) {
+		EPGData::JournalRecordHeader RecordHeader;
+
+		if (File.Read(&RecordHeader, sizeof(RecordHeader)) != sizeof(RecordHeader))
+			break;
+		if ((RecordHeader.Size < EPGData::CHUNK_HEADER_SIZE + sizeof(EPGData::ServiceInfo))
+				|| (RecordHeader.Size > MAX_JOURNAL_RECORD_SIZE))
+			break;
+		Buffer.resize(RecordHeader.Size);
+		if (File.Read(Buffer.data(), RecordHeader.Size) != RecordHeader.Size)
+			break;
+		if (CRC32::Calc(Buffer.data(), Buffer.size()) != RecordHeader.CRC)
+			break;
+
+		Func(Buffer.data(), Buffer.size());
+
+		*pValidSize += sizeof(RecordHeader) + RecordHeader.Size;
+	}
+
+	return true;
+}
+
+
+// 保存するイベントの範囲を取得する
+std::span<const CompactEventInfo> GetSaveEvents(
+	const EPGDatabase::CompactEventList &EventList, const DateTime &EarliestTime)
+{
+	return EPGDatabase::FindTimeRange(EventList, &EarliestTime, nullptr);
+}
+
+
+// バックグラウンドでの書き出し用にスレッドの優先度を下げる
+// (Windows と Linux 以外では nice 値がプロセス単位のため変更しない)
+void SetBackgroundThreadPriority(bool Idle)
+{
+#if defined(LIBISDB_WINDOWS)
+	::SetThreadPriority(::GetCurrentThread(), Idle ? THREAD_PRIORITY_IDLE : THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined(__linux__)
+	// Linux では nice 値はスレッド単位で設定される
+	if (Idle) {
+		::sched_param Param = {};
+		if (::pthread_setschedparam(::pthread_self(), SCHED_IDLE, &Param) == 0)
+			return;
+	}
+	::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), Idle ? 19 : 10);
+#endif
+}
+
+
+// ジャーナルのレコードのサービスを取得する
+EPGDatabase::ServiceInfo GetJournalRecordService(const uint8_t *pData)
+{
+	EPGData::ServiceInfo Service;
+
+	std::memcpy(&Service, pData + EPGData::CHUNK_HEADER_SIZE, sizeof(Service));
+
+	return EPGDatabase::ServiceInfo(Service.NetworkID, Service.TransportStreamID, Service.ServiceID);
+}
+
+
 void ReadData(Stream &File, void *pData, size_t DataSize, size_t *pSizeLimit)
 {
 	if (DataSize > *pSizeLimit)
@@ -385,7 +691,25 @@ EPGDataFile::EPGDataFile() noexcept
 	, m_OpenFlags(OpenFlag::None)
 	, m_UpdateCount(0)
 	, m_SourceID()
+	, m_LoadThreadCount(0)
+	, m_SavedRevision(0)
+	, m_JournalSize(0)
+	, m_JournalBaseUpdateCount(0)
+	, m_JournalCompactionThreshold(0)
+	, m_Compacting(false)
+	, m_Saving(false)
+	, m_SaveResult(false)
+	, m_SaveCancelled(false)
+	, m_SavedServiceCount(0)
+	, m_SaveServiceCount(0)
+{
+}
+
+
+EPGDataFile::~EPGDataFile()
 {
+	WaitSave();
+	WaitCompaction();
 }
 
 
@@ -402,6 +726,9 @@ bool EPGDataFile::Open(EPGDatabase *pEPGDatabase, const String &FileName, OpenFl
 	m_FileName = FileName;
 	m_OpenFlags = Flags;
 	m_UpdateCount = 0;
+	m_SavedRevision = 0;
+	m_JournalSize = 0;
+	m_JournalBaseUpdateCount = 0;
 
 	return true;
 }
@@ -409,6 +736,9 @@ bool EPGDataFile::Open(EPGDatabase *pEPGDatabase, const String &FileName, OpenFl
 
 void EPGDataFile::Close()
 {
+	WaitSave();
+	WaitCompaction();
+
 	m_pEPGDatabase = nullptr;
 	m_FileName.clear();
 	m_OpenFlags = OpenFlag::None;
@@ -427,6 +757,39 @@ bool EPGDataFile::Load()
 			(m_pEPGDatabase == nullptr) || m_FileName.empty() || !(m_OpenFlags & OpenFlag::Read)))
 		return false;
 
+	const unsigned long long Revision = m_pEPGDatabase->GetRevision();
+
+	// サービスディレクトリがあれば、ファイル全体をマップしてサービス毎に並列に読み込む
+	{
+		MappedFileStream File;
+		FileStream::OpenFlag FileOpenFlags = FileStream::OpenFlag::Read;
+		if (!!(m_OpenFlags & OpenFlag::ShareRead))
+			FileOpenFlags |= FileStream::OpenFlag::ShareRead;
+
+		if (File.Open(m_FileName, FileOpenFlags)) {
+			ServiceDirectory Directory;
+			uint64_t UpdateCount;
+
+			if (ReadServiceDirectory(File, &UpdateCount, &Directory)) {
+				const Stream::SizeType FileSize = File.GetSize();
+				uint8_t *pData;
+
+				if ((FileSize <= std::numeric_limits<size_t>::max())
+						&& File.SetWindowSize(static_cast<size_t>(FileSize))
+						&& File.SetPos(0, Stream::SetPosType::Begin)
+						&& (File.ReadView(&pData, static_cast<size_t>(FileSize)) == FileSize)) {
+					m_UpdateCount = UpdateCount;
+					if (!LoadIndexed(pData, Directory))
+						return false;
+					EndLoad(Revision);
+					return true;
+				}
+			}
+		}
+
+		// マップできない場合やバージョン 0 のファイルは順に読み込む
+	}
+
 	BufferedFileStream File;
 
 	FileStream::OpenFlag FileOpenFlags =
@@ -472,15 +835,7 @@ bool EPGDataFile::Load()
 				ServiceInfo Service;
 
 				LoadService(File, &Service);
-
-				if (!Service.EventList.empty()) {
-					if (m_SourceID != 0) {
-						for (EventInfo &Event : Service.EventList)
-							Event.SourceID = m_SourceID;
-					}
-
-					m_pEPGDatabase->SetServiceEventList(Service.Info, std::move(Service.EventList));
-				}
+				StoreService(Service);
 			} else {
 				if (ChunkHeader.Size > 0) {
 					if (!File.SetPos(ChunkHeader.Size, Stream::SetPosType::Current))
@@ -496,6 +851,8 @@ bool EPGDataFile::Load()
 		return false;
 	}
 
+	EndLoad(Revision);
+
 	return true;
 }
 
@@ -506,6 +863,7 @@ bool EPGDataFile::LoadMerged()
 			(m_pEPGDatabase == nullptr) || m_FileName.empty() || !(m_OpenFlags & OpenFlag::Read)))
 		return false;
 
+	const unsigned long long Revision = m_pEPGDatabase->GetRevision();
 	EPGDatabase Database;
 	EPGDataFile File;
 
@@ -513,10 +871,16 @@ bool EPGDataFile::LoadMerged()
 		return false;
 	if (!File.Load())
 		return false;
+	m_UpdateCount = File.GetUpdateCount();
 	File.Close();
 
 	m_pEPGDatabase->Merge(&Database, EPGDatabase::MergeFlag::Database, m_SourceID);
 
+	BlockLock Lock(m_Lock);
+
+	if (m_SavedRevision == Revision)
+		m_SavedRevision = m_pEPGDatabase->GetRevision();
+
 	return true;
 }
 
@@ -547,16 +911,208 @@ bool EPGDataFile::LoadHeader()
 }
 
 
+bool EPGDataFile::LoadService(uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID)
+{
+	if (LIBISDB_TRACE_ERROR_IF(
+			(m_pEPGDatabase == nullptr) || m_FileName.empty() || !(m_OpenFlags & OpenFlag::Read)))
+		return false;
+
+	FileStream File;
+	FileStream::OpenFlag FileOpenFlags = FileStream::OpenFlag::Read | FileStream::OpenFlag::RandomAccess;
+	if (!!(m_OpenFlags & OpenFlag::ShareRead))
+		FileOpenFlags |= FileStream::OpenFlag::ShareRead;
+
+	if (!File.Open(m_FileName, FileOpenFlags)) {
+		Log(Logger::LogType::Error, LIBISDB_STR("EPGファイルを開けません。"));
+		return false;
+	}
+
+	ServiceDirectory Directory;
+	uint64_t UpdateCount;
+
+	if (!ReadServiceDirectory(File, &UpdateCount, &Directory)) {
+		Log(Logger::LogType::Error, LIBISDB_STR("EPGファイルにサービスの索引がありません。"));
+		return false;
+	}
+
+	const EPGDatabase::ServiceInfo Info(NetworkID, TransportStreamID, ServiceID);
+	const auto itRange = std::ranges::find(Directory, Info, &ServiceRange::Info);
+	if (itRange == Directory.end())
+		return false;
+
+	try {
+		std::vector<uint8_t> Buffer(itRange->Size);
+
+		if (!File.SetPos(itRange->Offset, Stream::SetPosType::Begin))
+			throw Exception::Seek;
+		if (File.Read(Buffer.data(), Buffer.size()) != Buffer.size())
+			throw Exception::Read;
+
+		ServiceInfo Service;
+
+		LoadServiceData(Buffer.data(), ServiceRange{itRange->Info, 0, itRange->Size}, &Service);
+		StoreService(Service);
+
+		// ジャーナルに新しい内容があれば置き換える
+		LoadJournal(UpdateCount, Info);
+	} catch (const Exception Code) {
+		ExceptionLog(Code);
+		return false;
+	} catch (std::bad_alloc) {
+		ExceptionLog(Exception::MemoryAllocate);
+		return false;
+	}
+
+	m_UpdateCount = UpdateCount;
+
+	return true;
+}
+
+
 bool EPGDataFile::Save()
 {
 	if (LIBISDB_TRACE_ERROR_IF(
 			(m_pEPGDatabase == nullptr) || m_FileName.empty() || !(m_OpenFlags & OpenFlag::Write)))
 		return false;
 
+	WaitSave();
+
+	EPGDatabase::Snapshot Snapshot;
+	unsigned long long Revision;
+
+	GetSnapshot(&Snapshot, &Revision);
+
+	m_SaveCancelled.store(false, std::memory_order_release);
+
+	return SaveSnapshot(Snapshot, Revision);
+}
+
+
+bool EPGDataFile::SaveAsync()
+{
+	if (LIBISDB_TRACE_ERROR_IF(
+			(m_pEPGDatabase == nullptr) || m_FileName.empty() || !(m_OpenFlags & OpenFlag::Write)))
+		return false;
+
+	WaitSave();
+
+	// スナップショットは呼び出し時点の内容で取得し、書き出しのみをバックグラウンドで行う
+	std::shared_ptr<EPGDatabase::Snapshot> Snapshot = std::make_shared<EPGDatabase::Snapshot>();
+	unsigned long long Revision;
+
+	GetSnapshot(Snapshot.get(), &Revision);
+
+	m_SaveCancelled.store(false, std::memory_order_release);
+	m_SavedServiceCount.store(0, std::memory_order_release);
+	m_SaveServiceCount.store(0, std::memory_order_release);
+	m_Saving.store(true, std::memory_order_release);
+
+	try {
+		m_SaveThread = std::thread(
+			[this, Snapshot, Revision]() {
+				SetBackgroundThreadPriority(!!(m_OpenFlags & OpenFlag::PriorityIdle));
+				m_SaveResult = SaveSnapshot(*Snapshot, Revision);
+				m_Saving.store(false, std::memory_order_release);
+			});
+	} catch (const std::system_error &) {
+		m_Saving.store(false, std::memory_order_release);
+		return false;
+	}
+
+	return true;
+}
+
+
+bool EPGDataFile::WaitSave()
+{
+	if (!m_SaveThread.joinable())
+		return true;
+
+	m_SaveThread.join();
+
+	return m_SaveResult;
+}
+
+
+void EPGDataFile::CancelSave()
+{
+	m_SaveCancelled.store(true, std::memory_order_release);
+}
+
+
+bool EPGDataFile::GetSaveProgress(size_t *pSavedCount, size_t *pTotalCount) const
+{
+	if (pSavedCount != nullptr)
+		*pSavedCount = m_SavedServiceCount.load(std::memory_order_acquire);
+	if (pTotalCount != nullptr)
+		*pTotalCount = m_SaveServiceCount.load(std::memory_order_acquire);
+
+	return IsSaving();
+}
+
+
+bool EPGDataFile::Compact()
+{
+	if (LIBISDB_TRACE_ERROR_IF(
+			(m_pEPGDatabase == nullptr) || m_FileName.empty() || !(m_OpenFlags & OpenFlag::Write)))
+		return false;
+
+	WaitSave();
+	WaitCompaction();
+
+	BlockLock CompactionLock(m_CompactionLock);
+
+	EPGDatabase::Snapshot Snapshot;
+	unsigned long long Revision;
+
+	GetSnapshot(&Snapshot, &Revision);
+
+	m_SaveCancelled.store(false, std::memory_order_release);
+
+	return CompactInternal(Snapshot, Revision);
+}
+
+
+void EPGDataFile::WaitCompaction()
+{
+	BlockLock Lock(m_ThreadLock);
+
+	if (m_CompactionThread.joinable())
+		m_CompactionThread.join();
+}
+
+
+String EPGDataFile::GetJournalFileName() const
+{
+	if (m_FileName.empty())
+		return String();
+	return m_FileName + LIBISDB_STR(".journal");
+}
+
+
+void EPGDataFile::GetSnapshot(EPGDatabase::Snapshot *pSnapshot, unsigned long long *pRevision) const
+{
+	// スナップショットより後の変更は次回の保存の対象にする
+	*pRevision = m_pEPGDatabase->GetRevision();
+	m_pEPGDatabase->GetSnapshot(pSnapshot);
+}
+
+
+bool EPGDataFile::SaveSnapshot(const EPGDatabase::Snapshot &Snapshot, unsigned long long Revision)
+{
+	if (!!(m_OpenFlags & OpenFlag::Journal))
+		return SaveJournal(Snapshot, Revision);
+
+	return CompactInternal(Snapshot, Revision);
+}
+
+
+bool EPGDataFile::SaveBase(const String &FileName, uint64_t UpdateCount, const EPGDatabase::Snapshot &Snapshot)
+{
 	BufferedFileStream File;
 
 	if (!File.Open(
-				m_FileName,
+				FileName,
 				FileStream::OpenFlag::Write |
 				FileStream::OpenFlag::Create |
 				FileStream::OpenFlag::Truncate)) {
@@ -564,55 +1120,25 @@ bool EPGDataFile::Save()
 		return false;
 	}
 
-	BlockLock Lock(m_pEPGDatabase->GetLock());
-
 	DateTime EarliestTime;
 	if (!!(m_OpenFlags & OpenFlag::DiscardOld)) {
 		GetCurrentEPGTime(&EarliestTime);
 		EarliestTime.OffsetHours(-1);
 	}
 
-	EPGDatabase::ServiceList ServiceList;
-	m_pEPGDatabase->GetServiceList(&ServiceList);
-
-	std::vector<uint16_t> EventCountList;
-	EventCountList.reserve(ServiceList.size());
-
 	uint32_t ValidServiceCount = 0;
 
-	for (auto &Service : ServiceList) {
-		uint16_t EventCount = 0;
-
-		if (!!(m_OpenFlags & OpenFlag::DiscardOld)) {
-			m_pEPGDatabase->EnumEventsSortedByTime(
-				Service.NetworkID, Service.TransportStreamID, Service.ServiceID,
-				&EarliestTime, nullptr,
-				[&EventCount](const EventInfo &Event) -> bool {
-					EventCount++;
-					return true;
-				});
-		} else {
-			m_pEPGDatabase->EnumEventsUnsorted(
-				Service.NetworkID, Service.TransportStreamID, Service.ServiceID,
-				[&EventCount](const EventInfo &Event) -> bool {
-					EventCount++;
-					return true;
-				});
-		}
-
-		EventCountList.push_back(EventCount);
-		if (EventCount > 0)
+	for (const EPGDatabase::ServiceSnapshot &Service : Snapshot) {
+		if (!GetSaveEvents(*Service.EventList, EarliestTime).empty())
 			ValidServiceCount++;
 	}
 
+	m_SavedServiceCount.store(0, std::memory_order_release);
+	m_SaveServiceCount.store(ValidServiceCount, std::memory_order_release);
+
 	const auto ErrorCleanup = [&]() {
 		File.Close();
-
-#ifdef LIBISDB_WINDOWS
-		::DeleteFile(m_FileName.c_str());
-#else
-		std::remove(m_FileName.c_str());
-#endif
+		RemoveFile(FileName);
 	};
 
 	try {
@@ -621,17 +1147,59 @@ bool EPGDataFile::Save()
 		std::memcpy(FileHeader.Type, EPGData::FileHeader_Type, sizeof(FileHeader.Type));
 		FileHeader.Version = EPGData::FileHeader_Version;
 		FileHeader.ServiceCount = ValidServiceCount;
-		FileHeader.UpdateCount = ++m_UpdateCount;
+		FileHeader.UpdateCount = UpdateCount;
 
 		WriteData(File, FileHeader);
 
-		for (size_t ServiceIndex = 0; ServiceIndex < ServiceList.size(); ServiceIndex++) {
-			if (EventCountList[ServiceIndex] > 0)
-				SaveService(File, ServiceList[ServiceIndex], EventCountList[ServiceIndex], EarliestTime);
+		std::vector<EPGData::ServiceDirectoryEntry> Directory;
+		Directory.reserve(ValidServiceCount);
+
+		for (const EPGDatabase::ServiceSnapshot &Service : Snapshot) {
+			const std::span<const CompactEventInfo> EventList = GetSaveEvents(*Service.EventList, EarliestTime);
+			if (EventList.empty())
+				continue;
+
+			if (m_SaveCancelled.load(std::memory_order_acquire))
+				throw Exception::Cancelled;
+
+			const Stream::OffsetType Offset = File.GetPos();
+			if (Offset < 0)
+				throw Exception::Seek;
+
+			SaveService(File, Service.Info, EventList);
+
+			const Stream::OffsetType EndPos = File.GetPos();
+			if ((EndPos < Offset) || (static_cast<unsigned long long>(EndPos - Offset) > 0xFFFFFFFF_u32))
+				throw Exception::Seek;
+
+			EPGData::ServiceDirectoryEntry &Entry = Directory.emplace_back();
+			Entry.NetworkID         = Service.Info.NetworkID;
+			Entry.TransportStreamID = Service.Info.TransportStreamID;
+			Entry.ServiceID         = Service.Info.ServiceID;
+			Entry.EventCount        = static_cast<uint16_t>(EventList.size());
+			Entry.Offset            = Offset;
+			Entry.Size              = static_cast<uint32_t>(EndPos - Offset);
+
+			m_SavedServiceCount.fetch_add(1, std::memory_order_acq_rel);
 		}
 
 		WriteChunkHeader(File, EPGData::Tag::End);
 
+		EPGData::FileFooter Footer;
+		const Stream::OffsetType DirectoryOffset = File.GetPos();
+		if (DirectoryOffset < 0)
+			throw Exception::Seek;
+		Footer.DirectoryOffset = DirectoryOffset;
+		Footer.ServiceCount = static_cast<uint32_t>(Directory.size());
+		Footer.DirectoryCRC = CRC32::Calc(
+			reinterpret_cast<const uint8_t *>(Directory.data()),
+			Directory.size() * sizeof(EPGData::ServiceDirectoryEntry));
+		std::memcpy(Footer.Type, EPGData::FileFooter_Type, sizeof(Footer.Type));
+
+		if (!Directory.empty())
+			WriteData(File, Directory.data(), Directory.size() * sizeof(EPGData::ServiceDirectoryEntry));
+		WriteData(File, Footer);
+
 		if (!!(m_OpenFlags & OpenFlag::Flush))
 			File.Flush();
 	} catch (const Exception Code) {
@@ -648,6 +1216,470 @@ bool EPGDataFile::Save()
 }
 
 
+bool EPGDataFile::SaveJournal(const EPGDatabase::Snapshot &Snapshot, unsigned long long Revision)
+{
+	// 統合中に追記したレコードが統合後に削除されないよう、統合が終わるまで待つ
+	LockGuard CompactionLock(m_CompactionLock);
+	LockGuard Lock(m_Lock);
+
+	EPGData::FileHeader BaseHeader;
+	Stream::SizeType BaseSize;
+
+	// ベースのファイルが無いか、前回の保存以降に消去されていればベースを書き直す
+	if (!ReadFileHeader(m_FileName, &BaseHeader, &BaseSize)
+			|| (m_pEPGDatabase->GetClearRevision() > m_SavedRevision)) {
+		Lock.Unlock();
+		return CompactInternal(Snapshot, Revision);
+	}
+
+	std::vector<const EPGDatabase::ServiceSnapshot *> ServiceList;
+	for (const EPGDatabase::ServiceSnapshot &Service : Snapshot) {
+		if (Service.Revision > m_SavedRevision)
+			ServiceList.push_back(&Service);
+	}
+
+	m_SavedServiceCount.store(0, std::memory_order_release);
+	m_SaveServiceCount.store(ServiceList.size(), std::memory_order_release);
+
+	if (ServiceList.empty())
+		return true;
+
+	const String JournalFileName = GetJournalFileName();
+	bool Append = false;
+
+	if (m_JournalSize > 0) {
+		Stream::SizeType FileSize;
+		if ((m_JournalBaseUpdateCount == BaseHeader.UpdateCount)
+				&& GetFileSize(JournalFileName, &FileSize)
+				&& (FileSize == m_JournalSize))
+			Append = true;
+	}
+
+	if (!Append) {
+		unsigned long long ValidSize;
+		Stream::SizeType FileSize;
+
+		if (ScanJournal(
+					JournalFileName, BaseHeader.UpdateCount, &ValidSize, &FileSize,
+					[](const uint8_t *pData, size_t Size) {})) {
+			// 末尾が壊れていれば全体を書き直す
+			if (ValidSize != FileSize) {
+				Lock.Unlock();
+				return CompactInternal(Snapshot, Revision);
+			}
+			m_JournalSize = ValidSize;
+			m_JournalBaseUpdateCount = BaseHeader.UpdateCount;
+			Append = true;
+		}
+	}
+
+	DateTime EarliestTime;
+	if (!!(m_OpenFlags & OpenFlag::DiscardOld)) {
+		GetCurrentEPGTime(&EarliestTime);
+		EarliestTime.OffsetHours(-1);
+	}
+
+	BufferedFileStream File;
+
+	if (!File.Open(
+				JournalFileName,
+				Append ?
+					(FileStream::OpenFlag::Write | FileStream::OpenFlag::Append) :
+					(FileStream::OpenFlag::Write | FileStream::OpenFlag::Create | FileStream::OpenFlag::Truncate))) {
+		Log(Logger::LogType::Error, LIBISDB_STR("EPGジャーナルファイルが開けません。"));
+		return false;
+	}
+
+	unsigned long long JournalSize = Append ? m_JournalSize : 0;
+	bool Cancelled = false;
+
+	try {
+		if (!Append) {
+			EPGData::JournalHeader Header;
+
+			std::memcpy(Header.Type, EPGData::JournalHeader_Type, sizeof(Header.Type));
+			Header.Version = EPGData::JournalHeader_Version;
+			Header.BaseUpdateCount = BaseHeader.UpdateCount;
+
+			WriteData(File, Header);
+			JournalSize = sizeof(EPGData::JournalHeader);
+		}
+
+		std::vector<uint8_t> Buffer;
+
+		// 変更されたサービスを丸ごと1レコードとして追記する
+		for (const EPGDatabase::ServiceSnapshot *pService : ServiceList) {
+			// 中止された場合も書き出し済みのレコードは有効
+			if (m_SaveCancelled.load(std::memory_order_acquire)) {
+				Cancelled = true;
+				break;
+			}
+
+			Buffer.clear();
+
+			MemoryWriteStream Record(&Buffer);
+			SaveService(Record, pService->Info, GetSaveEvents(*pService->EventList, EarliestTime));
+			if (Buffer.size() > MAX_JOURNAL_RECORD_SIZE)
+				throw Exception::FormatError;
+
+			EPGData::JournalRecordHeader RecordHeader;
+			RecordHeader.Size = static_cast<uint32_t>(Buffer.size());
+			RecordHeader.CRC = CRC32::Calc(Buffer.data(), Buffer.size());
+
+			WriteData(File, RecordHeader);
+			WriteData(File, Buffer.data(), Buffer.size());
+			JournalSize += sizeof(RecordHeader) + Buffer.size();
+
+			m_SavedServiceCount.fetch_add(1, std::memory_order_acq_rel);
+		}
+
+		if (!!(m_OpenFlags & OpenFlag::Flush))
+			File.Flush();
+	} catch (const Exception Code) {
+		ExceptionLog(Code);
+		m_JournalSize = 0;
+		return false;
+	} catch (std::bad_alloc) {
+		ExceptionLog(Exception::MemoryAllocate);
+		m_JournalSize = 0;
+		return false;
+	}
+
+	File.Close();
+
+	m_JournalSize = JournalSize;
+	m_JournalBaseUpdateCount = BaseHeader.UpdateCount;
+
+	if (Cancelled) {
+		ExceptionLog(Exception::Cancelled);
+		return false;
+	}
+
+	m_SavedRevision = Revision;
+
+	// ジャーナルが大きくなったらバックグラウンドでベースに統合する
+	const unsigned long long Threshold =
+		(m_JournalCompactionThreshold > 0) ?
+			m_JournalCompactionThreshold :
+			std::max<unsigned long long>(BaseSize, MIN_JOURNAL_COMPACTION_THRESHOLD);
+	if (m_JournalSize > Threshold) {
+		Lock.Unlock();
+		CompactionLock.Unlock();
+		StartCompaction();
+	}
+
+	return true;
+}
+
+
+void EPGDataFile::StartCompaction()
+{
+	BlockLock Lock(m_ThreadLock);
+
+	if (m_Compacting.load(std::memory_order_acquire))
+		return;
+
+	if (m_CompactionThread.joinable())
+		m_CompactionThread.join();
+
+	m_Compacting.store(true, std::memory_order_release);
+
+	try {
+		m_CompactionThread = std::thread(
+			[this]() {
+				SetBackgroundThreadPriority(!!(m_OpenFlags & OpenFlag::PriorityIdle));
+
+				{
+					// スナップショットより前のジャーナルのみが削除されるよう、ロックしてから取得する
+					BlockLock CompactionLock(m_CompactionLock);
+
+					EPGDatabase::Snapshot Snapshot;
+					unsigned long long Revision;
+
+					GetSnapshot(&Snapshot, &Revision);
+					CompactInternal(Snapshot, Revision);
+				}
+
+				m_Compacting.store(false, std::memory_order_release);
+			});
+	} catch (const std::system_error &) {
+		m_Compacting.store(false, std::memory_order_release);
+	}
+}
+
+
+bool EPGDataFile::CompactInternal(const EPGDatabase::Snapshot &Snapshot, unsigned long long Revision)
+{
+	// 一時ファイルは共有されるため、書き出しは同時に1つのみ行う
+	BlockLock CompactionLock(m_CompactionLock);
+
+	uint64_t UpdateCount;
+
+	{
+		BlockLock Lock(m_Lock);
+
+		UpdateCount = m_UpdateCount + 1;
+	}
+
+	// 書き出しは一時ファイルに行い、完了してから置き換える
+	const String TempFileName = m_FileName + LIBISDB_STR(".tmp");
+
+	if (!SaveBase(TempFileName, UpdateCount, Snapshot))
+		return false;
+
+	BlockLock Lock(m_Lock);
+
+	if (!ReplaceFile(TempFileName, m_FileName)) {
+		Log(Logger::LogType::Error, LIBISDB_STR("EPGファイルを置き換えられません。"));
+		RemoveFile(TempFileName);
+		return false;
+	}
+
+	m_UpdateCount = UpdateCount;
+	// ジャーナルへの追記は統合と排他されるので、全てスナップショットに含まれている
+	RemoveFile(GetJournalFileName());
+	m_JournalSize = 0;
+	m_JournalBaseUpdateCount = 0;
+	m_SavedRevision = Revision;
+
+	return true;
+}
+
+
+bool EPGDataFile::SetLoadThreadCount(int Count)
+{
+	if (Count < 0)
+		return false;
+
+	m_LoadThreadCount = Count;
+
+	return true;
+}
+
+
+bool EPGDataFile::ReadServiceDirectory(Stream &File, uint64_t *pUpdateCount, ServiceDirectory *pDirectory)
+{
+	EPGData::FileHeader FileHeader;
+
+	if (!File.SetPos(0, Stream::SetPosType::Begin))
+		return false;
+	if (File.Read(&FileHeader, sizeof(EPGData::FileHeader)) != sizeof(EPGData::FileHeader))
+		return false;
+	if ((std::memcmp(FileHeader.Type, EPGData::FileHeader_Type, sizeof(FileHeader.Type)) != 0)
+			|| (FileHeader.Version < EPGData::FileHeader_IndexedVersion)
+			|| (FileHeader.Version > EPGData::FileHeader_Version))
+		return false;
+
+	const Stream::SizeType FileSize = File.GetSize();
+	if (FileSize < sizeof(EPGData::FileHeader) + sizeof(EPGData::FileFooter))
+		return false;
+
+	EPGData::FileFooter Footer;
+
+	if (!File.SetPos(FileSize - sizeof(EPGData::FileFooter), Stream::SetPosType::Begin))
+		return false;
+	if (File.Read(&Footer, sizeof(EPGData::FileFooter)) != sizeof(EPGData::FileFooter))
+		return false;
+	if ((std::memcmp(Footer.Type, EPGData::FileFooter_Type, sizeof(Footer.Type)) != 0)
+			|| (Footer.DirectoryOffset < sizeof(EPGData::FileHeader))
+			|| (Footer.DirectoryOffset > FileSize)
+			|| ((FileSize - Footer.DirectoryOffset - sizeof(EPGData::FileFooter)) !=
+					static_cast<Stream::SizeType>(Footer.ServiceCount) * sizeof(EPGData::ServiceDirectoryEntry)))
+		return false;
+
+	std::vector<EPGData::ServiceDirectoryEntry> EntryList(Footer.ServiceCount);
+
+	if (!EntryList.empty()) {
+		const size_t Size = EntryList.size() * sizeof(EPGData::ServiceDirectoryEntry);
+		if (!File.SetPos(Footer.DirectoryOffset, Stream::SetPosType::Begin))
+			return false;
+		if (File.Read(EntryList.data(), Size) != Size)
+			return false;
+	}
+
+	if (CRC32::Calc(
+				reinterpret_cast<const uint8_t *>(EntryList.data()),
+				EntryList.size() * sizeof(EPGData::ServiceDirectoryEntry)) != Footer.DirectoryCRC)
+		return false;
+
+	pDirectory->clear();
+	pDirectory->reserve(EntryList.size());
+
+	for (const EPGData::ServiceDirectoryEntry &Entry : EntryList) {
+		if ((Entry.Offset < sizeof(EPGData::FileHeader))
+				|| (Entry.Offset > Footer.DirectoryOffset)
+				|| (Entry.Size > Footer.DirectoryOffset - Entry.Offset)
+				|| (Entry.Size < EPGData::CHUNK_HEADER_SIZE + sizeof(EPGData::ServiceInfo)))
+			return false;
+
+		ServiceRange &Range = pDirectory->emplace_back();
+		Range.Info.NetworkID = Entry.NetworkID;
+		Range.Info.TransportStreamID = Entry.TransportStreamID;
+		Range.Info.ServiceID = Entry.ServiceID;
+		Range.Offset = Entry.Offset;
+		Range.Size = Entry.Size;
+	}
+
+	*pUpdateCount = FileHeader.UpdateCount;
+
+	return true;
+}
+
+
+bool EPGDataFile::LoadIndexed(const uint8_t *pData, const ServiceDirectory &Directory)
+{
+	unsigned int ThreadCount = m_LoadThreadCount;
+	if (ThreadCount == 0) {
+		ThreadCount = std::thread::hardware_concurrency();
+		if (ThreadCount == 0)
+			ThreadCount = 1;
+	}
+	ThreadCount = static_cast<unsigned int>(
+		std::clamp<size_t>(Directory.size(), 1, ThreadCount));
+
+	std::atomic<size_t> NextIndex(0);
+	std::atomic<bool> Failed(false);
+	Exception ErrorCode = Exception::Internal;
+
+	// 各スレッドが未処理のサービスを順に取って読み込む
+	const auto Worker = [&]() {
+		try {
+			while (!Failed.load(std::memory_order_relaxed)) {
+				const size_t Index = NextIndex.fetch_add(1, std::memory_order_relaxed);
+				if (Index >= Directory.size())
+					break;
+
+				const ServiceRange &Range = Directory[Index];
+				ServiceInfo Service;
+
+				LoadServiceData(pData + Range.Offset, Range, &Service);
+				StoreService(Service);
+			}
+		} catch (const Exception Code) {
+			if (!Failed.exchange(true))
+				ErrorCode = Code;
+		} catch (const std::bad_alloc &) {
+			if (!Failed.exchange(true))
+				ErrorCode = Exception::MemoryAllocate;
+		}
+	};
+
+	std::vector<std::thread> ThreadList;
+
+	try {
+		ThreadList.reserve(ThreadCount - 1);
+		for (unsigned int i = 1; i < ThreadCount; i++)
+			ThreadList.emplace_back(Worker);
+	} catch (const std::system_error &) {
+		// スレッドを作成できなかった分は残りのスレッドで処理する
+	} catch (const std::bad_alloc &) {
+	}
+
+	Worker();
+
+	for (std::thread &Thread : ThreadList)
+		Thread.join();
+
+	if (Failed.load()) {
+		ExceptionLog(ErrorCode);
+		return false;
+	}
+
+	return true;
+}
+
+
+void EPGDataFile::LoadServiceData(const uint8_t *pData, const ServiceRange &Range, ServiceInfo *pServiceInfo)
+{
+	MemoryReadStream File(pData, Range.Size);
+	EPGData::ChunkHeader ChunkHeader;
+	size_t Size = EPGData::CHUNK_HEADER_SIZE;
+
+	ReadChunkHeader(File, &ChunkHeader, &Size);
+	if ((ChunkHeader.Tag != EPGData::Tag::Service) || (ChunkHeader.Size != sizeof(EPGData::ServiceInfo)))
+		throw Exception::FormatError;
+
+	LoadService(File, pServiceInfo);
+
+	// ディレクトリと内容が一致しなければ壊れている
+	if (pServiceInfo->Info != Range.Info)
+		throw Exception::FormatError;
+}
+
+
+bool EPGDataFile::LoadJournal(uint64_t BaseUpdateCount, std::optional<EPGDatabase::ServiceInfo> Service)
+{
+	std::vector<uint8_t> Record;
+	unsigned long long ValidSize = 0;
+	Stream::SizeType FileSize = 0;
+	bool Result;
+
+	try {
+		// 後のレコードほど新しいので、順に置き換えていく
+		Result = ScanJournal(
+			GetJournalFileName(), BaseUpdateCount, &ValidSize, &FileSize,
+			[&](const uint8_t *pData, size_t Size) {
+				if (Service) {
+					if (GetJournalRecordService(pData) == *Service)
+						Record.assign(pData, pData + Size);
+				} else {
+					ServiceInfo Info;
+					LoadServiceData(pData, ServiceRange{GetJournalRecordService(pData), 0, Size}, &Info);
+					StoreService(Info, true);
+				}
+			});
+
+		if (Service && !Record.empty()) {
+			ServiceInfo Info;
+			LoadServiceData(Record.data(), ServiceRange{*Service, 0, Record.size()}, &Info);
+			StoreService(Info, true);
+		}
+	} catch (const Exception Code) {
+		ExceptionLog(Code);
+		Result = false;
+	} catch (std::bad_alloc) {
+		ExceptionLog(Exception::MemoryAllocate);
+		Result = false;
+	}
+
+	BlockLock Lock(m_Lock);
+
+	if (Result && (ValidSize == FileSize)) {
+		m_JournalSize = ValidSize;
+		m_JournalBaseUpdateCount = BaseUpdateCount;
+	} else {
+		m_JournalSize = 0;
+	}
+
+	return Result;
+}
+
+
+void EPGDataFile::EndLoad(unsigned long long Revision)
+{
+	LoadJournal(m_UpdateCount, std::nullopt);
+
+	// 読み込んだ内容はファイルと同じなので保存済みとする
+	BlockLock Lock(m_Lock);
+
+	if (m_SavedRevision == Revision)
+		m_SavedRevision = m_pEPGDatabase->GetRevision();
+}
+
+
+void EPGDataFile::StoreService(ServiceInfo &Service, bool Replace)
+{
+	if (Replace || !Service.EventList.empty()) {
+		if (m_SourceID != 0) {
+			for (EventInfo &Event : Service.EventList)
+				Event.SourceID = m_SourceID;
+		}
+
+		m_pEPGDatabase->SetServiceEventList(Service.Info, std::move(Service.EventList));
+	}
+}
+
+
 void EPGDataFile::LoadService(Stream &File, ServiceInfo *pServiceInfo)
 {
 	EPGData::ServiceInfo ServiceHeader;
@@ -864,22 +1896,21 @@ void EPGDataFile::LoadEvent(Stream &File, const ServiceInfo *pServiceInfo, Event
 
 void EPGDataFile::SaveService(
 	Stream &File, const EPGDatabase::ServiceInfo &ServiceInfo,
-	uint16_t EventCount, const DateTime &EarliestTime)
+	std::span<const CompactEventInfo> EventList)
 {
 	EPGData::ServiceInfo ServiceHeader;
 	ServiceHeader.NetworkID         = ServiceInfo.NetworkID;
 	ServiceHeader.TransportStreamID = ServiceInfo.TransportStreamID;
 	ServiceHeader.ServiceID         = ServiceInfo.ServiceID;
-	ServiceHeader.EventCount        = EventCount;
+	ServiceHeader.EventCount        = static_cast<uint16_t>(EventList.size());
 	WriteChunk(File, EPGData::Tag::Service, ServiceHeader);
 
-	m_pEPGDatabase->EnumEventsSortedByTime(
-		ServiceInfo.NetworkID, ServiceInfo.TransportStreamID, ServiceInfo.ServiceID,
-		!!(m_OpenFlags & OpenFlag::DiscardOld) ? &EarliestTime : nullptr, nullptr,
-		[&](const EventInfo &Event) -> bool {
-			SaveEvent(File, Event);
-			return true;
-		});
+	EventInfo Info;
+
+	for (const CompactEventInfo &Event : EventList) {
+		Event.GetEventInfo(&Info);
+		SaveEvent(File, Info);
+	}
 
 	WriteChunkHeader(File, EPGData::Tag::ServiceEnd);
 }
@@ -1075,6 +2106,9 @@ void EPGDataFile::ExceptionLog(Exception Code)
 	case Exception::Internal:
 		pText = LIBISDB_STR("内部エラーが発生しました。");
 		break;
+	case Exception::Cancelled:
+		Log(Logger::LogType::Information, LIBISDB_STR("EPGファイルの書き出しが中止されました。"));
+		return;
 	default:
 		return;
 	}
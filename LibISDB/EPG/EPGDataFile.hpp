@@ -30,7 +30,11 @@
 
 #include "../Base/ObjectBase.hpp"
 #include "../Base/Stream.hpp"
+#include "../Utilities/Lock.hpp"
 #include "EPGDatabase.hpp"
+#include <thread>
+#include <atomic>
+#include <span>
 
 
 namespace LibISDB
@@ -51,6 +55,7 @@ namespace LibISDB
 			PriorityIdle = 0x0020U, /**< 最低優先度 */
 			DiscardOld   = 0x0040U, /**< 古い情報を破棄 */
 			Flush        = 0x0080U, /**< 書き出し時にフラッシュする */
+			Journal      = 0x0100U, /**< 変更をジャーナルに追記する */
 			LIBISDB_ENUM_FLAGS_TRAILER
 		};
 
@@ -61,9 +66,11 @@ namespace LibISDB
 			MemoryAllocate,
 			FormatError,
 			Internal,
+			Cancelled,
 		};
 
 		EPGDataFile() noexcept;
+		~EPGDataFile();
 
 	// LibISDB::ObjectBase
 		const CharType * GetObjectName() const noexcept override { return LIBISDB_STR("EPGDataFile"); }
@@ -74,7 +81,16 @@ namespace LibISDB
 		bool Load();
 		bool LoadMerged();
 		bool LoadHeader();
+		bool LoadService(uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID);
 		bool Save();
+		bool SaveAsync();
+		bool WaitSave();
+		void CancelSave();
+		bool IsSaving() const noexcept { return m_Saving.load(std::memory_order_acquire); }
+		bool GetSaveProgress(size_t *pSavedCount, size_t *pTotalCount) const;
+		bool Compact();
+		void WaitCompaction();
+		bool IsCompacting() const noexcept { return m_Compacting.load(std::memory_order_acquire); }
 
 		EPGDatabase * GetEPGDatabase() const noexcept { return m_pEPGDatabase; }
 		const String & GetFileName() const noexcept { return m_FileName; }
@@ -82,6 +98,11 @@ namespace LibISDB
 		uint64_t GetUpdateCount() const noexcept { return m_UpdateCount; }
 		void SetSourceID(EventInfo::SourceIDType ID) noexcept { m_SourceID = ID; }
 		EventInfo::SourceIDType GetSourceID() const noexcept { return m_SourceID; }
+		bool SetLoadThreadCount(int Count);
+		int GetLoadThreadCount() const noexcept { return m_LoadThreadCount; }
+		void SetJournalCompactionThreshold(unsigned long long Size) noexcept { m_JournalCompactionThreshold = Size; }
+		unsigned long long GetJournalCompactionThreshold() const noexcept { return m_JournalCompactionThreshold; }
+		String GetJournalFileName() const;
 
 	protected:
 		struct ServiceInfo {
@@ -89,11 +110,32 @@ namespace LibISDB
 			EPGDatabase::EventList EventList;
 		};
 
+		/** サービスディレクトリの項目 */
+		struct ServiceRange {
+			EPGDatabase::ServiceInfo Info;
+			unsigned long long Offset;
+			size_t Size;
+		};
+
+		typedef std::vector<ServiceRange> ServiceDirectory;
+
+		bool ReadServiceDirectory(Stream &File, uint64_t *pUpdateCount, ServiceDirectory *pDirectory);
+		bool LoadIndexed(const uint8_t *pData, const ServiceDirectory &Directory);
+		void LoadServiceData(const uint8_t *pData, const ServiceRange &Range, ServiceInfo *pServiceInfo);
+		void StoreService(ServiceInfo &Service, bool Replace = false);
 		void LoadService(Stream &File, ServiceInfo *pServiceInfo);
 		void LoadEvent(Stream &File, const ServiceInfo *pServiceInfo, EventInfo *pEvent);
+		bool LoadJournal(uint64_t BaseUpdateCount, std::optional<EPGDatabase::ServiceInfo> Service);
+		void EndLoad(unsigned long long Revision);
+		void GetSnapshot(EPGDatabase::Snapshot *pSnapshot, unsigned long long *pRevision) const;
+		bool SaveSnapshot(const EPGDatabase::Snapshot &Snapshot, unsigned long long Revision);
+		bool SaveBase(const String &FileName, uint64_t UpdateCount, const EPGDatabase::Snapshot &Snapshot);
+		bool SaveJournal(const EPGDatabase::Snapshot &Snapshot, unsigned long long Revision);
+		void StartCompaction();
+		bool CompactInternal(const EPGDatabase::Snapshot &Snapshot, unsigned long long Revision);
 		void SaveService(
 			Stream &File, const EPGDatabase::ServiceInfo &ServiceInfo,
-			uint16_t EventCount, const DateTime &EarliestTime);
+			std::span<const CompactEventInfo> EventList);
 		void SaveEvent(Stream &File, const EventInfo &Event);
 		void ExceptionLog(Exception Code);
 
@@ -102,6 +144,32 @@ namespace LibISDB
 		OpenFlag m_OpenFlags;
 		uint64_t m_UpdateCount;
 		EventInfo::SourceIDType m_SourceID;
+		int m_LoadThreadCount;
+
+		/*
+			m_Lock は m_UpdateCount とジャーナルの状態を保護し、
+			バックグラウンドでの圧縮とジャーナルへの追記を排他する。
+			m_CompactionLock はベースのファイルの書き直しとジャーナルへの追記を排他し、
+			統合するスナップショットはこれをロックしてから取得する。
+			m_ThreadLock は m_CompactionThread を保護する。
+			m_Lock をロックした状態で他のロックは取得しない。
+		*/
+		mutable MutexLock m_Lock;
+		MutexLock m_CompactionLock;
+		MutexLock m_ThreadLock;
+		unsigned long long m_SavedRevision;
+		unsigned long long m_JournalSize;
+		uint64_t m_JournalBaseUpdateCount;
+		unsigned long long m_JournalCompactionThreshold;
+		std::thread m_CompactionThread;
+		std::atomic<bool> m_Compacting;
+
+		std::thread m_SaveThread;
+		std::atomic<bool> m_Saving;
+		bool m_SaveResult;
+		std::atomic<bool> m_SaveCancelled;
+		std::atomic<size_t> m_SavedServiceCount;
+		std::atomic<size_t> m_SaveServiceCount;
 	};
 
 }	// namespace LibISDB
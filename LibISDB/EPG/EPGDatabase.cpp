@@ -27,6 +27,9 @@
 #include "../LibISDBPrivate.hpp"
 #include "EPGDatabase.hpp"
 #include <algorithm>
+#include <thread>
+#include <new>
+#include <system_error>
 #include "../Base/ARIBTime.hpp"
 #include "../Utilities/Utilities.hpp"
 #include "../Base/DebugDef.hpp"
@@ -39,9 +42,24 @@ namespace
 {
 
 
-bool IsEventValid(const EventInfo &Event)
+// 遅延デコードされる文字列のデコード
+void DecodeEventString(const uint8_t *pData, size_t Size, uint32_t Param, String *pStr)
 {
-	return !Event.EventName.empty() || Event.IsCommonEvent;
+	ARIBStringDecoder StringDecoder;
+
+	StringDecoder.Decode(pData, Size, pStr, static_cast<ARIBStringDecoder::DecodeFlag>(Param));
+}
+
+
+// 遅延デコードされる拡張形式イベントの本文のデコード
+void DecodeExtendedEventText(const uint8_t *pData, size_t Size, uint32_t Param, String *pStr)
+{
+	ARIBStringDecoder StringDecoder;
+	String Buffer;
+
+	pStr->clear();
+	if (StringDecoder.Decode(pData, Size, &Buffer, static_cast<ARIBStringDecoder::DecodeFlag>(Param)))
+		CanonicalizeExtendedText(Buffer, pStr);
 }
 
 
@@ -56,6 +74,27 @@ unsigned long long GetScheduleTime(unsigned long long CurTime, uint16_t TableID,
 }
 
 
+// ジャンルが一致するか
+bool MatchContentNibble(const CompactEventInfo &Event, int Level1, int Level2)
+{
+	if (Level1 < 0)
+		return true;
+	if (!Event.Detail)
+		return false;
+
+	const EventInfo::ContentNibbleInfo &ContentNibble = Event.Detail->ContentNibble;
+
+	for (int i = 0; i < ContentNibble.NibbleCount; i++) {
+		const ContentDescriptor::NibbleInfo &Nibble = ContentNibble.NibbleList[i];
+		if ((Nibble.ContentNibbleLevel1 == Level1)
+				&& ((Level2 < 0) || (Nibble.ContentNibbleLevel2 == Level2)))
+			return true;
+	}
+
+	return false;
+}
+
+
 }
 
 
@@ -63,9 +102,14 @@ unsigned long long GetScheduleTime(unsigned long long CurTime, uint16_t TableID,
 
 EPGDatabase::EPGDatabase() noexcept
 	: m_IsUpdated(false)
+	, m_Revision(0)
+	, m_ClearRevision(0)
 	, m_ScheduleOnly(false)
 	, m_NoPastEvents(true)
 	, m_StringDecodeFlags(ARIBStringDecoder::DecodeFlag::UseCharSize)
+	, m_DeferStringDecode(false)
+	, m_TextIndex(false)
+	, m_MergeThreadCount(0)
 	, m_CurTOTSeconds(0)
 {
 }
@@ -77,12 +121,15 @@ void EPGDatabase::Clear()
 
 	m_ServiceMap.clear();
 	m_PendingServiceMap.clear();
+
+	// 削除はサービス毎の差分では表せないため、消去した時点を記録しておく
+	m_ClearRevision.store(NextRevision(), std::memory_order_release);
 }
 
 
 int EPGDatabase::GetServiceCount() const
 {
-	BlockLock Lock(m_Lock);
+	SharedBlockLock Lock(m_Lock);
 
 	return static_cast<int>(m_ServiceMap.size());
 }
@@ -93,7 +140,7 @@ bool EPGDatabase::GetServiceList(ServiceList *pList) const
 	if (LIBISDB_TRACE_ERROR_IF(pList == nullptr))
 		return false;
 
-	BlockLock Lock(m_Lock);
+	SharedBlockLock Lock(m_Lock);
 
 	pList->resize(m_ServiceMap.size());
 
@@ -109,29 +156,215 @@ bool EPGDatabase::GetServiceList(ServiceList *pList) const
 
 bool EPGDatabase::IsServiceUpdated(uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID) const
 {
-	BlockLock Lock(m_Lock);
+	SharedBlockLock Lock(m_Lock);
 
-	const ServiceEventMap *pService = FindServiceEventMap(NetworkID, TransportStreamID, ServiceID);
-	if (pService == nullptr)
+	const ServiceShard *pShard = FindServiceShard(NetworkID, TransportStreamID, ServiceID);
+	if (pShard == nullptr)
 		return false;
 
-	return pService->IsUpdated;
+	SharedBlockLock ServiceLock(pShard->Lock);
+
+	return pShard->Data.IsUpdated;
 }
 
 
 bool EPGDatabase::ResetServiceUpdated(uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID)
 {
-	BlockLock Lock(m_Lock);
+	SharedBlockLock Lock(m_Lock);
 
 	auto it = m_ServiceMap.find(ServiceInfo(NetworkID, TransportStreamID, ServiceID));
 	if (it == m_ServiceMap.end())
 		return false;
-	it->second.IsUpdated = false;
+
+	BlockLock ServiceLock(it->second.Lock);
+
+	it->second.Data.IsUpdated = false;
 
 	return true;
 }
 
 
+bool EPGDatabase::GetUpdatedServiceList(unsigned long long Revision, ServiceList *pList) const
+{
+	if (LIBISDB_TRACE_ERROR_IF(pList == nullptr))
+		return false;
+
+	pList->clear();
+
+	SharedBlockLock Lock(m_Lock);
+
+	// 指定されたリビジョンより後に内容が変わったサービスを列挙する
+	for (auto &e : m_ServiceMap) {
+		SharedBlockLock ServiceLock(e.second.Lock);
+		if (e.second.Data.Revision > Revision)
+			pList->push_back(e.first);
+	}
+
+	return true;
+}
+
+
+bool EPGDatabase::GetSnapshot(Snapshot *pSnapshot) const
+{
+	if (LIBISDB_TRACE_ERROR_IF(pSnapshot == nullptr))
+		return false;
+
+	pSnapshot->clear();
+
+	SharedBlockLock Lock(m_Lock);
+
+	pSnapshot->reserve(m_ServiceMap.size());
+
+	for (auto &e : m_ServiceMap) {
+		const ServiceShard &Shard = e.second;
+		SharedBlockLock ServiceLock(Shard.Lock);
+
+		ServiceSnapshot &Service = pSnapshot->emplace_back();
+		Service.Info = e.first;
+		Service.Revision = Shard.Data.Revision;
+		Service.EventList = GetSnapshotEventList(Shard);
+	}
+
+	return true;
+}
+
+
+bool EPGDatabase::QueryTimeRange(
+	const DateTime *pEarliest, const DateTime *pLatest,
+	TimeRangeResult *pResult, const ServiceList *pServiceList) const
+{
+	if (LIBISDB_TRACE_ERROR_IF(pResult == nullptr))
+		return false;
+
+	pResult->clear();
+
+	const auto AddService =
+		[&](const ServiceInfo &Info, const ServiceShard &Shard) {
+			std::shared_ptr<const CompactEventList> EventList;
+
+			{
+				SharedBlockLock ServiceLock(Shard.Lock);
+				EventList = GetSnapshotEventList(Shard);
+			}
+
+			// 範囲の検索はスナップショットに対して行うためロックは不要
+			const std::span<const CompactEventInfo> Events = FindTimeRange(*EventList, pEarliest, pLatest);
+			if (!Events.empty()) {
+				EventListView &Result = pResult->emplace_back();
+				Result.Info = Info;
+				Result.EventList = std::move(EventList);
+				Result.Events = Events;
+			}
+		};
+
+	SharedBlockLock Lock(m_Lock);
+
+	if (pServiceList != nullptr) {
+		pResult->reserve(pServiceList->size());
+
+		for (const ServiceInfo &Info : *pServiceList) {
+			auto it = m_ServiceMap.find(Info);
+			if (it != m_ServiceMap.end())
+				AddService(it->first, it->second);
+		}
+	} else {
+		pResult->reserve(m_ServiceMap.size());
+
+		for (auto &e : m_ServiceMap)
+			AddService(e.first, e.second);
+	}
+
+	return true;
+}
+
+
+bool EPGDatabase::SearchEvents(const SearchCondition &Condition, SearchResult *pResult) const
+{
+	if (LIBISDB_TRACE_ERROR_IF(pResult == nullptr))
+		return false;
+
+	pResult->clear();
+
+	EventTextIndex::Keyword Keyword;
+	EventTextIndex::MakeKeyword(Condition.Keyword, &Keyword);
+
+	const bool UseIndex = !Keyword.empty() && GetTextIndex();
+	std::vector<uint32_t> IndexList;
+	std::u32string Buffer;
+
+	const auto CheckEvent =
+		[&](const CompactEventInfo &Event) {
+			if (MatchContentNibble(Event, Condition.ContentNibbleLevel1, Condition.ContentNibbleLevel2)
+					&& (Keyword.empty() || EventTextIndex::Match(Event, Keyword, Condition.Target, &Buffer))) {
+				SearchResultInfo &Result = pResult->emplace_back();
+				Result.NetworkID = Event.NetworkID;
+				Result.TransportStreamID = Event.TransportStreamID;
+				Result.ServiceID = Event.ServiceID;
+				Result.EventID = Event.EventID;
+			}
+		};
+
+	SharedBlockLock Lock(m_Lock);
+
+	for (auto &e : m_ServiceMap) {
+		const ServiceShard &Shard = e.second;
+		std::shared_ptr<const CompactEventList> EventList;
+
+		{
+			SharedBlockLock ServiceLock(Shard.Lock);
+			EventList = GetSnapshotEventList(Shard);
+		}
+
+		// 時間の条件は開始時刻順のリスト上の範囲になる
+		const std::span<const CompactEventInfo> Range =
+			FindTimeRange(*EventList, &Condition.Earliest, &Condition.Latest);
+		if (Range.empty())
+			continue;
+
+		if (UseIndex) {
+			const size_t First = Range.data() - EventList->data();
+			const size_t Last = First + Range.size();
+
+			GetServiceTextIndex(Shard, EventList)->FindCandidates(Keyword, &IndexList);
+
+			for (auto it = std::ranges::lower_bound(IndexList, First);
+					(it != IndexList.end()) && (*it < Last); ++it)
+				CheckEvent((*EventList)[*it]);
+		} else {
+			for (const CompactEventInfo &Event : Range)
+				CheckEvent(Event);
+		}
+	}
+
+	return true;
+}
+
+
+std::span<const CompactEventInfo> EPGDatabase::FindTimeRange(
+	const CompactEventList &EventList, const DateTime *pEarliest, const DateTime *pLatest)
+{
+	auto itBegin = EventList.begin(), itEnd = EventList.end();
+
+	// EnumEventsSortedByTime() と同じく、開始時刻に放送中のイベントも含める
+	if ((pEarliest != nullptr) && pEarliest->IsValid()) {
+		const unsigned long long Time = pEarliest->GetLinearSeconds();
+		itBegin = std::ranges::upper_bound(EventList, Time, {}, &CompactEventInfo::StartTime);
+		if (itBegin != EventList.begin()) {
+			auto itPrev = std::prev(itBegin);
+			if (itPrev->StartTime + itPrev->Duration > Time)
+				itBegin = itPrev;
+		}
+	}
+
+	if ((pLatest != nullptr) && pLatest->IsValid()) {
+		itEnd = std::ranges::lower_bound(
+			itBegin, EventList.end(), pLatest->GetLinearSeconds(), {}, &CompactEventInfo::StartTime);
+	}
+
+	return std::span<const CompactEventInfo>(itBegin, itEnd);
+}
+
+
 bool EPGDatabase::GetEventList(
 	uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID,
 	ReturnArg<EventList> List, OptionalReturnArg<TimeEventMap> TimeMap) const
@@ -141,12 +374,15 @@ bool EPGDatabase::GetEventList(
 
 	List->clear();
 
-	BlockLock Lock(m_Lock);
+	SharedBlockLock Lock(m_Lock);
 
-	const ServiceEventMap *pService = FindServiceEventMap(NetworkID, TransportStreamID, ServiceID);
-	if (pService == nullptr)
+	const ServiceShard *pShard = FindServiceShard(NetworkID, TransportStreamID, ServiceID);
+	if (pShard == nullptr)
 		return false;
 
+	SharedBlockLock ServiceLock(pShard->Lock);
+	const ServiceEventMap *pService = &pShard->Data;
+
 	List->reserve(pService->EventMap.size());
 
 	if (TimeMap) {
@@ -154,15 +390,15 @@ bool EPGDatabase::GetEventList(
 		for (auto &Time : pService->TimeMap) {
 			auto itEvent = pService->EventMap.find(Time.EventID);
 			if ((itEvent != pService->EventMap.end())
-					&& IsEventValid(itEvent->second)) {
-				List->push_back(itEvent->second);
+					&& itEvent->second.IsValid()) {
+				itEvent->second.GetEventInfo(&List->emplace_back());
 				TimeMap->insert(Time);
 			}
 		}
 	} else {
 		for (auto &Event : pService->EventMap) {
-			if (IsEventValid(Event.second))
-				List->push_back(Event.second);
+			if (Event.second.IsValid())
+				Event.second.GetEventInfo(&List->emplace_back());
 		}
 	}
 
@@ -179,19 +415,22 @@ bool EPGDatabase::GetEventListSortedByTime(
 
 	List->clear();
 
-	BlockLock Lock(m_Lock);
+	SharedBlockLock Lock(m_Lock);
 
-	const ServiceEventMap *pService = FindServiceEventMap(NetworkID, TransportStreamID, ServiceID);
-	if (pService == nullptr)
+	const ServiceShard *pShard = FindServiceShard(NetworkID, TransportStreamID, ServiceID);
+	if (pShard == nullptr)
 		return false;
 
+	SharedBlockLock ServiceLock(pShard->Lock);
+	const ServiceEventMap *pService = &pShard->Data;
+
 	List->reserve(pService->EventMap.size());
 
 	for (auto &Time : pService->TimeMap) {
 		auto itEvent = pService->EventMap.find(Time.EventID);
 		if ((itEvent != pService->EventMap.end())
-				&& IsEventValid(itEvent->second)) {
-			List->push_back(itEvent->second);
+				&& itEvent->second.IsValid()) {
+			itEvent->second.GetEventInfo(&List->emplace_back());
 		}
 	}
 
@@ -199,6 +438,67 @@ bool EPGDatabase::GetEventListSortedByTime(
 }
 
 
+bool EPGDatabase::GetEventListView(
+	uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID,
+	EventListView *pView) const
+{
+	if (LIBISDB_TRACE_ERROR_IF(pView == nullptr))
+		return false;
+
+	SharedBlockLock Lock(m_Lock);
+
+	const ServiceShard *pShard = FindServiceShard(NetworkID, TransportStreamID, ServiceID);
+	if (pShard == nullptr) {
+		*pView = EventListView();
+		return false;
+	}
+
+	SharedBlockLock ServiceLock(pShard->Lock);
+
+	pView->Info = ServiceInfo(NetworkID, TransportStreamID, ServiceID);
+	pView->EventList = GetSnapshotEventList(*pShard);
+	pView->Events = *pView->EventList;
+
+	return true;
+}
+
+
+bool EPGDatabase::GetEventRef(
+	uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID,
+	uint16_t EventID, EventRef *pRef) const
+{
+	if (LIBISDB_TRACE_ERROR_IF(pRef == nullptr))
+		return false;
+
+	pRef->reset();
+
+	SharedBlockLock Lock(m_Lock);
+
+	const ServiceShard *pShard = FindServiceShard(NetworkID, TransportStreamID, ServiceID);
+	if (pShard == nullptr)
+		return false;
+
+	SharedBlockLock ServiceLock(pShard->Lock);
+	const ServiceEventMap *pService = &pShard->Data;
+
+	auto itEvent = pService->EventMap.find(EventID);
+	if ((itEvent == pService->EventMap.end()) || !itEvent->second.IsValid())
+		return false;
+
+	// スナップショットのリストは開始時刻順なので、開始時刻から探す
+	std::shared_ptr<const CompactEventList> List = GetSnapshotEventList(*pShard);
+	const auto Range = std::ranges::equal_range(*List, itEvent->second.StartTime, {}, &CompactEventInfo::StartTime);
+	const auto it = std::ranges::find(Range, EventID, &CompactEventInfo::EventID);
+	if (it == Range.end())
+		return false;
+
+	// リストを保持したままイベントを参照する
+	*pRef = EventRef(std::move(List), &*it);
+
+	return true;
+}
+
+
 bool EPGDatabase::GetEventInfo(
 	uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID,
 	uint16_t EventID, ReturnArg<EventInfo> Info) const
@@ -206,20 +506,27 @@ bool EPGDatabase::GetEventInfo(
 	if (!Info)
 		return false;
 
-	BlockLock Lock(m_Lock);
+	SharedBlockLock Lock(m_Lock);
+
+	const ServiceShard *pShard = FindServiceShard(NetworkID, TransportStreamID, ServiceID);
+	if (pShard == nullptr)
+		return false;
+
+	{
+		SharedBlockLock ServiceLock(pShard->Lock);
+		const ServiceEventMap *pService = &pShard->Data;
 
-	const ServiceEventMap *pService = FindServiceEventMap(NetworkID, TransportStreamID, ServiceID);
-	if (pService != nullptr) {
 		auto itEvent = pService->EventMap.find(EventID);
-		if ((itEvent != pService->EventMap.end())
-				&& IsEventValid(itEvent->second)) {
-			*Info = itEvent->second;
-			SetCommonEventInfo(&*Info);
-			return true;
-		}
+		if ((itEvent == pService->EventMap.end())
+				|| !itEvent->second.IsValid())
+			return false;
+
+		itEvent->second.GetEventInfo(&*Info);
 	}
 
-	return false;
+	SetCommonEventInfo(&*Info);
+
+	return true;
 }
 
 
@@ -230,11 +537,14 @@ bool EPGDatabase::GetEventInfo(
 	if (!Info)
 		return false;
 
-	BlockLock Lock(m_Lock);
+	SharedBlockLock Lock(m_Lock);
 
 	bool Found = false;
-	const ServiceEventMap *pService = FindServiceEventMap(NetworkID, TransportStreamID, ServiceID);
-	if (pService != nullptr) {
+	const ServiceShard *pShard = FindServiceShard(NetworkID, TransportStreamID, ServiceID);
+	if (pShard != nullptr) {
+		SharedBlockLock ServiceLock(pShard->Lock);
+		const ServiceEventMap *pService = &pShard->Data;
+
 		const TimeEventInfo Key(Time);
 		auto itTime = pService->TimeMap.upper_bound(Key);
 		if (itTime != pService->TimeMap.begin()) {
@@ -242,15 +552,17 @@ bool EPGDatabase::GetEventInfo(
 			if (itTime->StartTime + itTime->Duration > Key.StartTime) {
 				auto itEvent = pService->EventMap.find(itTime->EventID);
 				if ((itEvent != pService->EventMap.end())
-						&& IsEventValid(itEvent->second)) {
-					*Info = itEvent->second;
-					SetCommonEventInfo(&*Info);
+						&& itEvent->second.IsValid()) {
+					itEvent->second.GetEventInfo(&*Info);
 					Found = true;
 				}
 			}
 		}
 	}
 
+	if (Found)
+		SetCommonEventInfo(&*Info);
+
 	return Found;
 }
 
@@ -262,24 +574,29 @@ bool EPGDatabase::GetNextEventInfo(
 	if (!Info)
 		return false;
 
-	BlockLock Lock(m_Lock);
+	SharedBlockLock Lock(m_Lock);
 
 	bool Found = false;
-	const ServiceEventMap *pService = FindServiceEventMap(NetworkID, TransportStreamID, ServiceID);
-	if (pService != nullptr) {
+	const ServiceShard *pShard = FindServiceShard(NetworkID, TransportStreamID, ServiceID);
+	if (pShard != nullptr) {
+		SharedBlockLock ServiceLock(pShard->Lock);
+		const ServiceEventMap *pService = &pShard->Data;
+
 		const TimeEventInfo Key(Time);
 		auto itTime = pService->TimeMap.upper_bound(Key);
 		if (itTime != pService->TimeMap.end()) {
 			auto itEvent = pService->EventMap.find(itTime->EventID);
 			if ((itEvent != pService->EventMap.end())
-					&& IsEventValid(itEvent->second)) {
-				*Info = itEvent->second;
-				SetCommonEventInfo(&*Info);
+					&& itEvent->second.IsValid()) {
+				itEvent->second.GetEventInfo(&*Info);
 				Found = true;
 			}
 		}
 	}
 
+	if (Found)
+		SetCommonEventInfo(&*Info);
+
 	return Found;
 }
 
@@ -288,21 +605,8 @@ bool EPGDatabase::EnumEventsUnsorted(
 	uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID,
 	const std::function<bool(const EventInfo &Event)> &Callback) const
 {
-	if (!Callback)
-		return false;
-
-	BlockLock Lock(m_Lock);
-
-	const ServiceEventMap *pService = FindServiceEventMap(NetworkID, TransportStreamID, ServiceID);
-	if (pService == nullptr)
-		return false;
-
-	for (auto &Event : pService->EventMap) {
-		if (!Callback(Event.second))
-			break;
-	}
-
-	return true;
+	// 順序の指定が無いだけなので、開始時刻順に列挙しても問題ない
+	return EnumEventsSortedByTime(NetworkID, TransportStreamID, ServiceID, nullptr, nullptr, Callback);
 }
 
 
@@ -310,24 +614,7 @@ bool EPGDatabase::EnumEventsSortedByTime(
 	uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID,
 	const std::function<bool(const EventInfo &Event)> &Callback) const
 {
-	if (!Callback)
-		return false;
-
-	BlockLock Lock(m_Lock);
-
-	const ServiceEventMap *pService = FindServiceEventMap(NetworkID, TransportStreamID, ServiceID);
-	if (pService == nullptr)
-		return false;
-
-	for (auto &Time : pService->TimeMap) {
-		auto itEvent = pService->EventMap.find(Time.EventID);
-		if (itEvent != pService->EventMap.end()) {
-			if (!Callback(itEvent->second))
-				break;
-		}
-	}
-
-	return true;
+	return EnumEventsSortedByTime(NetworkID, TransportStreamID, ServiceID, nullptr, nullptr, Callback);
 }
 
 
@@ -339,39 +626,27 @@ bool EPGDatabase::EnumEventsSortedByTime(
 	if (!Callback)
 		return false;
 
-	BlockLock Lock(m_Lock);
+	std::shared_ptr<const CompactEventList> EventList;
 
-	const ServiceEventMap *pService = FindServiceEventMap(NetworkID, TransportStreamID, ServiceID);
-	if (pService == nullptr)
-		return false;
+	{
+		SharedBlockLock Lock(m_Lock);
 
-	TimeEventMap::const_iterator itTime, itEnd;
+		const ServiceShard *pShard = FindServiceShard(NetworkID, TransportStreamID, ServiceID);
+		if (pShard == nullptr)
+			return false;
 
-	if ((pEarliest != nullptr) && pEarliest->IsValid()) {
-		const TimeEventInfo Key(*pEarliest);
-		itTime = pService->TimeMap.upper_bound(Key);
-		if (itTime != pService->TimeMap.begin()) {
-			auto itPrev = itTime;
-			--itPrev;
-			if (itPrev->StartTime + itPrev->Duration > Key.StartTime)
-				itTime = itPrev;
-		}
-	} else {
-		itTime = pService->TimeMap.begin();
-	}
+		SharedBlockLock ServiceLock(pShard->Lock);
 
-	if ((pLatest != nullptr) && pLatest->IsValid()) {
-		itEnd = pService->TimeMap.lower_bound(TimeEventInfo(*pLatest));
-	} else {
-		itEnd = pService->TimeMap.end();
+		EventList = GetSnapshotEventList(*pShard);
 	}
 
-	for (;itTime != itEnd; ++itTime) {
-		auto itEvent = pService->EventMap.find(itTime->EventID);
-		if (itEvent != pService->EventMap.end()) {
-			if (!Callback(itEvent->second))
-				break;
-		}
+	// コールバックから再びデータベースを操作できるように、ロックを解放してから呼び出す
+	EventInfo Info;
+
+	for (const CompactEventInfo &Event : FindTimeRange(*EventList, pEarliest, pLatest)) {
+		Event.GetEventInfo(&Info);
+		if (!Callback(Info))
+			break;
 	}
 
 	return true;
@@ -380,24 +655,22 @@ bool EPGDatabase::EnumEventsSortedByTime(
 
 bool EPGDatabase::SetServiceEventList(const ServiceInfo &Info, EventList &&List)
 {
-	BlockLock Lock(m_Lock);
-
-	auto it = m_ServiceMap.find(Info);
-	if (it != m_ServiceMap.end())
-		m_ServiceMap.erase(it);
-
-	ServiceEventMap &Service = m_ServiceMap.emplace(
-		std::piecewise_construct,
-		std::forward_as_tuple(Info),
-		std::forward_as_tuple()).first->second;
+	// イベントマップの構築はロック外で行う
+	ServiceEventMap Service;
 
 	Service.EventMap.rehash(300);
 
-	for (EventInfo &Event : List) {
-		Service.EventMap.emplace(Event.EventID, std::move(Event));
+	for (const EventInfo &Event : List) {
 		Service.TimeMap.emplace(Event);
+		Service.EventMap.emplace(Event.EventID, Event);
 	}
 
+	Service.Revision = NextRevision();
+
+	BlockLock Lock(m_Lock);
+
+	m_ServiceMap[Info].Data = std::move(Service);
+
 	return true;
 }
 
@@ -409,13 +682,70 @@ bool EPGDatabase::Merge(
 	if (LIBISDB_TRACE_ERROR_IF(pSrcDatabase == nullptr))
 		return false;
 
-	BlockLock Lock(m_Lock);
+	// 各サービスのマージは互いに独立しているので、サービス単位で並列に処理する
+	std::vector<std::pair<const ServiceInfo *, ServiceEventMap *>> ExistingList;
+	unsigned int ThreadCount;
+
+	{
+		BlockLock Lock(m_Lock);
 
-	for (auto &SrcService : pSrcDatabase->m_ServiceMap) {
-		MergeEventMap(SrcService.first, SrcService.second, Flags, SourceID);
+		ThreadCount = m_MergeThreadCount;
+
+		// 新規サービスはここで追加し、既存のサービスを後でマージする
+		for (auto &SrcService : pSrcDatabase->m_ServiceMap) {
+			ServiceEventMap &Map = SrcService.second.Data;
+			if (Map.EventMap.empty())
+				continue;
+
+			auto [itService, Inserted] = m_ServiceMap.try_emplace(SrcService.first);
+			if (Inserted) {
+				if (SourceID) {
+					for (auto &Event : Map.EventMap)
+						Event.second.SourceID = *SourceID;
+				}
+				itService->second.Data = std::move(Map);
+				itService->second.Data.Revision = NextRevision();
+				m_IsUpdated.store(true, std::memory_order_release);
+			} else {
+				ExistingList.emplace_back(&SrcService.first, &Map);
+			}
+		}
 	}
 
-	return true;
+	if (ExistingList.empty())
+		return true;
+
+	if (ThreadCount == 0) {
+		ThreadCount = std::thread::hardware_concurrency();
+		if (ThreadCount == 0)
+			ThreadCount = 1;
+	}
+
+	std::vector<std::pair<ServiceShard *, ServiceEventMap *>> MergeList;
+	std::vector<std::pair<const ServiceInfo *, ServiceEventMap *>> RemovedList;
+	bool Result;
+
+	MergeList.reserve(ExistingList.size());
+
+	{
+		SharedBlockLock Lock(m_Lock);
+
+		for (const auto &Service : ExistingList) {
+			auto itService = m_ServiceMap.find(*Service.first);
+			if (itService != m_ServiceMap.end())
+				MergeList.emplace_back(&itService->second, Service.second);
+			else
+				RemovedList.push_back(Service);
+		}
+
+		Result = MergeServiceEventMapParallel(MergeList, ThreadCount, Flags, SourceID);
+	}
+
+	// 途中で削除されたサービスは改めて追加する
+	for (const auto &Service : RemovedList)
+		MergeServiceEventMap(*Service.first, *Service.second, Flags, SourceID);
+
+	return Result;
 }
 
 
@@ -432,9 +762,7 @@ bool EPGDatabase::MergeService(
 	if (itSrcService == pSrcDatabase->m_ServiceMap.end())
 		return false;
 
-	BlockLock Lock(m_Lock);
-
-	MergeEventMap(itSrcService->first, itSrcService->second, Flags, SourceID);
+	MergeServiceEventMap(itSrcService->first, itSrcService->second.Data, Flags, SourceID);
 
 	return true;
 }
@@ -442,25 +770,29 @@ bool EPGDatabase::MergeService(
 
 bool EPGDatabase::IsScheduleComplete(uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID, bool Extended) const
 {
-	BlockLock Lock(m_Lock);
+	SharedBlockLock Lock(m_Lock);
 
 	auto itService = m_ServiceMap.find(ServiceInfo(NetworkID, TransportStreamID, ServiceID));
 	if (itService == m_ServiceMap.end())
 		return false;
 
-	return itService->second.Schedule.IsComplete(m_CurTOTTime.Hour, Extended);
+	SharedBlockLock ServiceLock(itService->second.Lock);
+
+	return itService->second.Data.Schedule.IsComplete(m_CurTOTTime.Hour, Extended);
 }
 
 
 bool EPGDatabase::HasSchedule(uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID, bool Extended) const
 {
-	BlockLock Lock(m_Lock);
+	SharedBlockLock Lock(m_Lock);
 
 	auto itService = m_ServiceMap.find(ServiceInfo(NetworkID, TransportStreamID, ServiceID));
 	if (itService == m_ServiceMap.end())
 		return false;
 
-	return itService->second.Schedule.HasSchedule(Extended);
+	SharedBlockLock ServiceLock(itService->second.Lock);
+
+	return itService->second.Data.Schedule.HasSchedule(Extended);
 }
 
 
@@ -471,7 +803,7 @@ void EPGDatabase::ResetScheduleStatus()
 	BlockLock Lock(m_Lock);
 
 	for (auto &e : m_ServiceMap)
-		e.second.Schedule.Reset();
+		e.second.Data.Schedule.Reset();
 }
 
 
@@ -499,6 +831,43 @@ void EPGDatabase::SetStringDecodeFlags(ARIBStringDecoder::DecodeFlag Flags)
 }
 
 
+void EPGDatabase::SetDeferStringDecode(bool Defer)
+{
+	BlockLock Lock(m_Lock);
+
+	m_DeferStringDecode = Defer;
+}
+
+
+bool EPGDatabase::SetMergeThreadCount(int Count)
+{
+	if (Count < 0)
+		return false;
+
+	BlockLock Lock(m_Lock);
+
+	m_MergeThreadCount = Count;
+
+	return true;
+}
+
+
+void EPGDatabase::SetTextIndex(bool Enable)
+{
+	BlockLock Lock(m_Lock);
+
+	m_TextIndex.store(Enable, std::memory_order_release);
+
+	// 無効にした場合は構築済みのインデックスを破棄する
+	if (!Enable) {
+		for (auto &e : m_ServiceMap) {
+			BlockLock SnapshotLock(e.second.SnapshotLock);
+			e.second.TextIndex.reset();
+		}
+	}
+}
+
+
 bool EPGDatabase::AddEventListener(EventListener *pEventListener)
 {
 	return m_EventListenerList.AddEventListener(pEventListener);
@@ -522,57 +891,262 @@ bool EPGDatabase::UpdateSection(
 	if ((TableID < 0x4E) || (TableID > 0x6F))
 		return false;
 
-	BlockLock Lock(m_Lock);
-
 	const bool IsSchedule = (TableID >= 0x50);
 	const bool IsExtended = (IsSchedule && ((TableID & 0x08) != 0));
-	if (m_ScheduleOnly && !IsSchedule)
-		return false;
+
+	ARIBStringDecoder::DecodeFlag DecodeFlags;
+	bool NoPastEvents;
+	bool DeferDecode;
+
+	{
+		SharedBlockLock Lock(m_Lock);
+
+		if (m_ScheduleOnly && !IsSchedule)
+			return false;
+
+		DecodeFlags = m_StringDecodeFlags;
+		NoPastEvents = m_NoPastEvents;
+		DeferDecode = m_DeferStringDecode;
+	}
+
+	// 文字列のデコードなど時間のかかる処理はロックせずに行う
+	DecodedEventList EventList;
+	DecodeEvents(pEITTable, DecodeFlags, NoPastEvents, DeferDecode, &EventList);
 
 	const ServiceInfo Key(
 		pEITTable->GetOriginalNetworkID(),
 		pEITTable->GetTransportStreamID(),
 		pEITTable->GetServiceID());
-	const auto [itService, ServiceInserted] = m_ServiceMap.emplace(
-		std::piecewise_construct,
-		std::forward_as_tuple(Key),
-		std::forward_as_tuple());
-	ServiceEventMap &Service = itService->second;
-	if (ServiceInserted) {
-		Service.EventMap.rehash(300);
-		Service.ScheduleUpdatedTime = m_CurTOTTime;
+	ScheduleNotifyInfo Notify;
+	bool Exclusive = true;
+
+	{
+		SharedBlockLock Lock(m_Lock);
+
+		// TOT 受信前は保留中のサービスを更新するため、全体を排他ロックする
+		if (m_CurTOTSeconds != 0) {
+			auto itService = m_ServiceMap.find(Key);
+			if (itService != m_ServiceMap.end()) {
+				BlockLock ServiceLock(itService->second.Lock);
+				CommitEvents(Key, itService->second.Data, false, pEITTable, EventList, SourceID, &Notify);
+				Exclusive = false;
+			}
+		}
+	}
+
+	if (Exclusive) {
+		BlockLock Lock(m_Lock);
+
+		const auto [itService, ServiceInserted] = m_ServiceMap.try_emplace(Key);
+		CommitEvents(Key, itService->second.Data, ServiceInserted, pEITTable, EventList, SourceID, &Notify);
+	}
+
+	// ロックを解除してから通知する
+	if (Notify.StatusReset) {
+		m_EventListenerList.CallEventListener(
+			&EventListener::OnScheduleStatusReset,
+			this,
+			Key.NetworkID,
+			Key.TransportStreamID,
+			Key.ServiceID);
+	}
+
+	if (Notify.Completed) {
+		m_EventListenerList.CallEventListener(
+			&EventListener::OnServiceCompleted,
+			this,
+			Key.NetworkID,
+			Key.TransportStreamID,
+			Key.ServiceID,
+			IsExtended);
 	}
 
+	return true;
+}
+
+
+void EPGDatabase::DecodeEvents(
+	const EITTable *pEITTable, ARIBStringDecoder::DecodeFlag DecodeFlags, bool NoPastEvents,
+	bool DeferDecode, DecodedEventList *pEventList) const
+{
+	const int EventCount = pEITTable->GetEventCount();
+	if (EventCount <= 0)
+		return;
+
 	DateTime CurSysTime;
-	if (m_NoPastEvents)
+	if (NoPastEvents)
 		GetCurrentEPGTime(&CurSysTime);
 
-	bool IsUpdated = false;
+	ARIBString StrBuf;
+	String Buffer;
 
-	const int EventCount = pEITTable->GetEventCount();
+	// 文字列はプールに登録し、同じ内容の文字列を共有する
+	// DeferDecode が指定されている場合はデコードせずに登録し、最初に参照された時にデコードする
+	auto MakeString =
+		[&](const ARIBString &Src, ARIBStringDecoder::DecodeFlag Flags,
+				StringPool::DecodeFunc pDecode = DecodeEventString) -> PooledString {
+			if (DeferDecode)
+				return PooledString(Src.data(), Src.length(), pDecode, static_cast<uint32_t>(Flags));
+			pDecode(Src.data(), Src.length(), static_cast<uint32_t>(Flags), &Buffer);
+			return PooledString(Buffer);
+		};
 
-	if (EventCount > 0) {
-		const uint16_t NetworkID = pEITTable->GetOriginalNetworkID();
-		const uint16_t TransportStreamID = pEITTable->GetTransportStreamID();
-		const uint16_t ServiceID = pEITTable->GetServiceID();
-		ARIBString StrBuf;
+	pEventList->reserve(EventCount);
 
-		for (int i = 0; i < EventCount; i++) {
-			const EITTable::EventInfo *pEventInfo = pEITTable->GetEventInfo(i);
+	for (int i = 0; i < EventCount; i++) {
+		const EITTable::EventInfo *pEventInfo = pEITTable->GetEventInfo(i);
 
-			// 開始/終了時刻が未定義のものは除外する
-			if (!pEventInfo->StartTime.IsValid() || (pEventInfo->Duration == 0))
+		// 開始/終了時刻が未定義のものは除外する
+		if (!pEventInfo->StartTime.IsValid() || (pEventInfo->Duration == 0))
+			continue;
+
+		if (NoPastEvents) {
+			// 既に終了しているものは除外する
+			// (時計のずれを考えて5分マージンをとっている)
+			DateTime EndTime(pEventInfo->StartTime);
+			if (!EndTime.OffsetSeconds(pEventInfo->Duration))
+				continue;
+			if (EndTime.DiffSeconds(CurSysTime) <= -5 * 60)
 				continue;
+		}
 
-			if (m_NoPastEvents) {
-				// 既に終了しているものは除外する
-				// (時計のずれを考えて5分マージンをとっている)
-				DateTime EndTime(pEventInfo->StartTime);
-				if (!EndTime.OffsetSeconds(pEventInfo->Duration))
-					continue;
-				if (EndTime.DiffSeconds(CurSysTime) <= -5 * 60)
-					continue;
+		DecodedEventInfo &Event = pEventList->emplace_back();
+		Event.pEventInfo = pEventInfo;
+
+		const DescriptorBlock *pDescBlock = &pEventInfo->Descriptors;
+
+		// 短形式イベント記述子
+		const ShortEventDescriptor *pShortEvent =
+			pDescBlock->GetDescriptor<ShortEventDescriptor>();
+		if (pShortEvent != nullptr) {
+			if (pShortEvent->GetEventName(&StrBuf))
+				Event.EventName.emplace(MakeString(StrBuf, DecodeFlags));
+			if (pShortEvent->GetEventDescription(&StrBuf))
+				Event.EventText.emplace(MakeString(StrBuf, DecodeFlags));
+		}
+
+		// 拡張形式イベント記述子
+		EventExtendedTextList ExtendedTextList;
+		if (GetEventExtendedTextList(pDescBlock, &ExtendedTextList)) {
+			CompactEventInfo::ExtendedTextInfoList &ExtendedText = Event.ExtendedText.emplace();
+			ExtendedText.reserve(ExtendedTextList.size());
+			for (const EventExtendedTextItem &e : ExtendedTextList) {
+				CompactEventInfo::ExtendedTextInfo &Text = ExtendedText.emplace_back();
+				Text.Description = MakeString(e.Description, DecodeFlags);
+				Text.Text = MakeString(e.Text, DecodeFlags, DecodeExtendedEventText);
 			}
+		}
+
+		// コンポーネント記述子
+		if (pDescBlock->GetDescriptorByTag(ComponentDescriptor::TAG) != nullptr) {
+			CompactEventInfo::VideoInfoList &VideoList = Event.VideoList.emplace();
+			pDescBlock->EnumDescriptors<ComponentDescriptor>(
+				[&](const ComponentDescriptor *pComponentDesc) {
+					CompactEventInfo::VideoInfo &Info = VideoList.emplace_back();
+
+					Info.StreamContent = pComponentDesc->GetStreamContent();
+					Info.ComponentType = pComponentDesc->GetComponentType();
+					Info.ComponentTag = pComponentDesc->GetComponentTag();
+					Info.LanguageCode = pComponentDesc->GetLanguageCode();
+					if (pComponentDesc->GetText(&StrBuf))
+						Info.Text = MakeString(StrBuf, DecodeFlags);
+				});
+		}
+
+		// 音声コンポーネント記述子
+		if (pDescBlock->GetDescriptorByTag(AudioComponentDescriptor::TAG) != nullptr) {
+			CompactEventInfo::AudioInfoList &AudioList = Event.AudioList.emplace();
+			pDescBlock->EnumDescriptors<AudioComponentDescriptor>(
+				[&](const AudioComponentDescriptor *pAudioDesc) {
+					CompactEventInfo::AudioInfo &Info = AudioList.emplace_back();
+
+					Info.StreamContent = pAudioDesc->GetStreamContent();
+					Info.ComponentType = pAudioDesc->GetComponentType();
+					Info.ComponentTag = pAudioDesc->GetComponentTag();
+					Info.SimulcastGroupTag = pAudioDesc->GetSimulcastGroupTag();
+					Info.ESMultiLingualFlag = pAudioDesc->GetESMultiLingualFlag();
+					Info.MainComponentFlag = pAudioDesc->GetMainComponentFlag();
+					Info.QualityIndicator = pAudioDesc->GetQualityIndicator();
+					Info.SamplingRate = pAudioDesc->GetSamplingRate();
+					Info.LanguageCode = pAudioDesc->GetLanguageCode();
+					Info.LanguageCode2 = pAudioDesc->GetLanguageCode2();
+					if (pAudioDesc->GetText(&StrBuf))
+						Info.Text = MakeString(StrBuf, ARIBStringDecoder::DecodeFlag::UseCharSize);
+				});
+		}
+
+		// コンテント記述子
+		const ContentDescriptor *pContentDesc = pDescBlock->GetDescriptor<ContentDescriptor>();
+		if (pContentDesc != nullptr) {
+			EventInfo::ContentNibbleInfo &ContentNibble = Event.ContentNibble.emplace();
+			int NibbleCount = pContentDesc->GetNibbleCount();
+			if (NibbleCount > 7)
+				NibbleCount = 7;
+			ContentNibble.NibbleCount = NibbleCount;
+			for (int j = 0; j < NibbleCount; j++)
+				pContentDesc->GetNibble(j, &ContentNibble.NibbleList[j]);
+		}
+
+		// イベントグループ記述子
+		if (pDescBlock->GetDescriptorByTag(EventGroupDescriptor::TAG) != nullptr) {
+			EventInfo::EventGroupInfoList &GroupList = Event.EventGroupList.emplace();
+
+			pDescBlock->EnumDescriptors<EventGroupDescriptor>(
+				[&](const EventGroupDescriptor *pGroupDesc) {
+					EventInfo::EventGroupInfo GroupInfo;
+					GroupInfo.GroupType = pGroupDesc->GetGroupType();
+					const int EventCount = pGroupDesc->GetEventCount();
+					GroupInfo.EventList.resize(EventCount);
+					for (int j = 0; j < EventCount; j++)
+						pGroupDesc->GetEventInfo(j, &GroupInfo.EventList[j]);
+
+					auto it = std::ranges::find(GroupList, GroupInfo);
+					if (it == GroupList.end()) {
+						GroupList.push_back(GroupInfo);
+
+						if ((GroupInfo.GroupType == EventGroupDescriptor::GROUP_TYPE_COMMON)
+								&& (EventCount == 1)) {
+							const EventGroupDescriptor::EventInfo &Info = GroupInfo.EventList.front();
+							if (Info.ServiceID != pEITTable->GetServiceID()) {
+								EventInfo::CommonEventInfo &CommonEvent = Event.CommonEvent.emplace();
+								CommonEvent.ServiceID = Info.ServiceID;
+								CommonEvent.EventID = Info.EventID;
+							}
+						}
+					}
+				});
+		}
+	}
+}
+
+
+bool EPGDatabase::CommitEvents(
+	const ServiceInfo &Key, ServiceEventMap &Service, bool ServiceInserted,
+	const EITTable *pEITTable, const DecodedEventList &EventList,
+	EventInfo::SourceIDType SourceID, ScheduleNotifyInfo *pNotify)
+{
+	// m_Lock が排他ロックされているか、Service のロックが排他ロックされた状態で呼ばれる
+	// (m_CurTOTSeconds が 0 の場合は m_Lock が排他ロックされている)
+
+	const uint16_t TableID = pEITTable->GetTableID();
+	const bool IsSchedule = (TableID >= 0x50);
+	const bool IsExtended = (IsSchedule && ((TableID & 0x08) != 0));
+
+	if (ServiceInserted) {
+		Service.EventMap.rehash(300);
+		Service.ScheduleUpdatedTime = m_CurTOTTime;
+	}
+
+	bool IsUpdated = false;
+
+	if (pEITTable->GetEventCount() > 0) {
+		const uint16_t NetworkID = Key.NetworkID;
+		const uint16_t TransportStreamID = Key.TransportStreamID;
+		const uint16_t ServiceID = Key.ServiceID;
+
+		for (const DecodedEventInfo &Decoded : EventList) {
+			const EITTable::EventInfo *pEventInfo = Decoded.pEventInfo;
+			const unsigned long long StartTime = pEventInfo->StartTime.GetLinearSeconds();
 
 			bool IsPending = false, IsExtendedOnly = false;
 
@@ -623,7 +1197,7 @@ bool EPGDatabase::UpdateSection(
 			EventMapType &EventMap = IsExtendedOnly ? pService->EventExtendedMap : pService->EventMap;
 
 			if (!IsExtendedOnly) {
-				TimeEventInfo TimeEvent(pEventInfo->StartTime);
+				TimeEventInfo TimeEvent(StartTime);
 				TimeEvent.Duration = pEventInfo->Duration;
 				TimeEvent.EventID = pEventInfo->EventID;
 				TimeEvent.UpdatedTime = m_CurTOTSeconds;
@@ -640,13 +1214,13 @@ bool EPGDatabase::UpdateSection(
 				std::piecewise_construct,
 				std::forward_as_tuple(pEventInfo->EventID),
 				std::forward_as_tuple());
-			EventInfo *pEvent = &EventResult.first->second;
+			CompactEventInfo *pEvent = &EventResult.first->second;
 			if (!EventResult.second) {
 				// 既に番組情報がある場合
 
 				bool IsReset = false;
 
-				if (pEvent->StartTime != pEventInfo->StartTime) {
+				if (pEvent->StartTime != StartTime) {
 					// 開始時刻が変わった
 					if (!IsExtendedOnly) {
 						auto it = pService->TimeMap.find(TimeEventInfo(pEvent->StartTime));
@@ -662,7 +1236,7 @@ bool EPGDatabase::UpdateSection(
 					IsReset = true;
 
 				if (IsReset)
-					*pEvent = EventInfo();
+					*pEvent = CompactEventInfo();
 			}
 
 			pEvent->UpdatedTime       = m_CurTOTSeconds;
@@ -671,7 +1245,7 @@ bool EPGDatabase::UpdateSection(
 			pEvent->TransportStreamID = TransportStreamID;
 			pEvent->ServiceID         = ServiceID;
 			pEvent->EventID           = pEventInfo->EventID;
-			pEvent->StartTime         = pEventInfo->StartTime;
+			pEvent->StartTime         = StartTime;
 			pEvent->Duration          = pEventInfo->Duration;
 			pEvent->RunningStatus     = pEventInfo->RunningStatus;
 			pEvent->FreeCAMode        = pEventInfo->FreeCAMode;
@@ -694,108 +1268,39 @@ bool EPGDatabase::UpdateSection(
 			// extended のみが ServiceEventMap::EventMap に追加されることは無い
 			LIBISDB_ASSERT(!!(pEvent->Type & EventInfo::TypeFlag::Basic) || &EventMap == &pService->EventExtendedMap);
 
-			const DescriptorBlock *pDescBlock = &pEventInfo->Descriptors;
-
-			// 短形式イベント記述子
-			const ShortEventDescriptor *pShortEvent =
-				pDescBlock->GetDescriptor<ShortEventDescriptor>();
-			if (pShortEvent != nullptr) {
-				if (pShortEvent->GetEventName(&StrBuf))
-					m_StringDecoder.Decode(StrBuf, &pEvent->EventName, m_StringDecodeFlags);
-				if (pShortEvent->GetEventDescription(&StrBuf))
-					m_StringDecoder.Decode(StrBuf, &pEvent->EventText, m_StringDecodeFlags);
-			}
+			// デコード済みの情報を反映する
+			if (Decoded.EventName)
+				pEvent->EventName = *Decoded.EventName;
+			if (Decoded.EventText)
+				pEvent->EventText = *Decoded.EventText;
 
-			// 拡張形式イベント記述子
-			if (!GetEventExtendedTextList(pDescBlock, m_StringDecoder, m_StringDecodeFlags, &pEvent->ExtendedText)) {
+			if (Decoded.ExtendedText) {
+				pEvent->ExtendedText = *Decoded.ExtendedText;
+			} else {
 				if (!IsExtended)
 					MergeEventExtendedInfo(*pService, pEvent);
 			}
 
-			// コンポーネント記述子
-			if (pDescBlock->GetDescriptorByTag(ComponentDescriptor::TAG) != nullptr) {
-				pEvent->VideoList.clear();
-				pDescBlock->EnumDescriptors<ComponentDescriptor>(
-					[&](const ComponentDescriptor *pComponentDesc) {
-						EventInfo::VideoInfo &Info = pEvent->VideoList.emplace_back();
-
-						Info.StreamContent = pComponentDesc->GetStreamContent();
-						Info.ComponentType = pComponentDesc->GetComponentType();
-						Info.ComponentTag = pComponentDesc->GetComponentTag();
-						Info.LanguageCode = pComponentDesc->GetLanguageCode();
-						if (pComponentDesc->GetText(&StrBuf))
-							m_StringDecoder.Decode(StrBuf, &Info.Text, m_StringDecodeFlags);
-					});
-			}
-
-			// 音声コンポーネント記述子
-			if (pDescBlock->GetDescriptorByTag(AudioComponentDescriptor::TAG) != nullptr) {
-				pEvent->AudioList.clear();
-				pDescBlock->EnumDescriptors<AudioComponentDescriptor>(
-					[&](const AudioComponentDescriptor *pAudioDesc) {
-						EventInfo::AudioInfo &Info = pEvent->AudioList.emplace_back();
-
-						Info.StreamContent = pAudioDesc->GetStreamContent();
-						Info.ComponentType = pAudioDesc->GetComponentType();
-						Info.ComponentTag = pAudioDesc->GetComponentTag();
-						Info.SimulcastGroupTag = pAudioDesc->GetSimulcastGroupTag();
-						Info.ESMultiLingualFlag = pAudioDesc->GetESMultiLingualFlag();
-						Info.MainComponentFlag = pAudioDesc->GetMainComponentFlag();
-						Info.QualityIndicator = pAudioDesc->GetQualityIndicator();
-						Info.SamplingRate = pAudioDesc->GetSamplingRate();
-						Info.LanguageCode = pAudioDesc->GetLanguageCode();
-						Info.LanguageCode2 = pAudioDesc->GetLanguageCode2();
-						if (pAudioDesc->GetText(&StrBuf))
-							m_StringDecoder.Decode(StrBuf, &Info.Text);
-					});
-			}
-
-			// コンテント記述子
-			const ContentDescriptor *pContentDesc = pDescBlock->GetDescriptor<ContentDescriptor>();
-			if (pContentDesc != nullptr) {
-				int NibbleCount = pContentDesc->GetNibbleCount();
-				if (NibbleCount > 7)
-					NibbleCount = 7;
-				pEvent->ContentNibble.NibbleCount = NibbleCount;
-				for (int j = 0; j < NibbleCount; j++)
-					pContentDesc->GetNibble(j, &pEvent->ContentNibble.NibbleList[j]);
-			}
-
-			// イベントグループ記述子
-			if (pDescBlock->GetDescriptorByTag(EventGroupDescriptor::TAG) != nullptr) {
-				pEvent->EventGroupList.clear();
-
-				pDescBlock->EnumDescriptors<EventGroupDescriptor>(
-					[&](const EventGroupDescriptor *pGroupDesc) {
-						EventInfo::EventGroupInfo GroupInfo;
-						GroupInfo.GroupType = pGroupDesc->GetGroupType();
-						const int EventCount = pGroupDesc->GetEventCount();
-						GroupInfo.EventList.resize(EventCount);
-						for (int j = 0; j < EventCount; j++)
-							pGroupDesc->GetEventInfo(j, &GroupInfo.EventList[j]);
-
-						auto it = std::ranges::find(pEvent->EventGroupList, GroupInfo);
-						if (it == pEvent->EventGroupList.end()) {
-							pEvent->EventGroupList.push_back(GroupInfo);
-
-							if ((GroupInfo.GroupType == EventGroupDescriptor::GROUP_TYPE_COMMON)
-									&& (EventCount == 1)) {
-								const EventGroupDescriptor::EventInfo &Info = GroupInfo.EventList.front();
-								if (Info.ServiceID != pEITTable->GetServiceID()) {
-									pEvent->IsCommonEvent = true;
-									pEvent->CommonEvent.ServiceID = Info.ServiceID;
-									pEvent->CommonEvent.EventID = Info.EventID;
-								}
-							}
-						}
-					});
+			if (Decoded.VideoList)
+				pEvent->GetDetail().VideoList = *Decoded.VideoList;
+			if (Decoded.AudioList)
+				pEvent->GetDetail().AudioList = *Decoded.AudioList;
+			if (Decoded.ContentNibble)
+				pEvent->GetDetail().ContentNibble = *Decoded.ContentNibble;
+
+			if (Decoded.EventGroupList) {
+				pEvent->GetDetail().EventGroupList = *Decoded.EventGroupList;
+				if (Decoded.CommonEvent) {
+					pEvent->IsCommonEvent = true;
+					pEvent->CommonEvent = *Decoded.CommonEvent;
+				}
 			}
 
 			if (!IsPending && !IsExtendedOnly) {
 				IsUpdated = true;
 
 				if (pPendingService != nullptr)
-					MergeEventMapEvent(*pPendingService, EventInfo(*pEvent), MergeFlag::MergeBasicExtended);
+					MergeEventMapEvent(*pPendingService, CompactEventInfo(*pEvent), MergeFlag::MergeBasicExtended);
 			}
 		}
 	} else {
@@ -822,7 +1327,8 @@ bool EPGDatabase::UpdateSection(
 
 	if (IsUpdated) {
 		Service.IsUpdated = true;
-		m_IsUpdated = true;
+		Service.Revision = NextRevision();
+		m_IsUpdated.store(true, std::memory_order_release);
 	}
 
 	if (IsSchedule) {
@@ -833,17 +1339,12 @@ bool EPGDatabase::UpdateSection(
 						|| (Service.ScheduleUpdatedTime.Day != m_CurTOTTime.Day))) {
 				LIBISDB_TRACE(
 					LIBISDB_STR("Reset EPG schedule : NID {:x} / TSID {:x} / SID {:x}\n"),
-					itService->first.NetworkID,
-					itService->first.TransportStreamID,
-					itService->first.ServiceID);
+					Key.NetworkID,
+					Key.TransportStreamID,
+					Key.ServiceID);
 				Service.Schedule.Reset();
 
-				m_EventListenerList.CallEventListener(
-					&EventListener::OnScheduleStatusReset,
-					this,
-					itService->first.NetworkID,
-					itService->first.TransportStreamID,
-					itService->first.ServiceID);
+				pNotify->StatusReset = true;
 			}
 		}
 
@@ -858,17 +1359,11 @@ bool EPGDatabase::UpdateSection(
 				LIBISDB_TRACE(
 					LIBISDB_STR("EPG schedule {} completed : NID {:x} / TSID {:x} / SID {:x}\n"),
 					IsExtended ? LIBISDB_STR("extended") : LIBISDB_STR("basic"),
-					itService->first.NetworkID,
-					itService->first.TransportStreamID,
-					itService->first.ServiceID);
-
-				m_EventListenerList.CallEventListener(
-					&EventListener::OnServiceCompleted,
-					this,
-					itService->first.NetworkID,
-					itService->first.TransportStreamID,
-					itService->first.ServiceID,
-					IsExtended);
+					Key.NetworkID,
+					Key.TransportStreamID,
+					Key.ServiceID);
+
+				pNotify->Completed = true;
 			}
 		}
 	}
@@ -903,7 +1398,16 @@ bool EPGDatabase::UpdateTOT(const TOTTable *pTOTTable)
 				Event.second.UpdatedTime = m_CurTOTSeconds;
 			Service.second.ScheduleUpdatedTime = m_CurTOTTime;
 
-			MergeEventMap(Service.first, Service.second, MergeFlag::MergeBasicExtended | MergeFlag::SetServiceUpdated);
+			auto [itService, Inserted] = m_ServiceMap.try_emplace(Service.first);
+			if (Inserted) {
+				itService->second.Data = std::move(Service.second);
+				itService->second.Data.Revision = NextRevision();
+				m_IsUpdated.store(true, std::memory_order_release);
+			} else {
+				MergeEventMap(
+					itService->second.Data, Service.second,
+					MergeFlag::MergeBasicExtended | MergeFlag::SetServiceUpdated);
+			}
 		}
 
 		m_PendingServiceMap.clear();
@@ -915,13 +1419,16 @@ bool EPGDatabase::UpdateTOT(const TOTTable *pTOTTable)
 
 void EPGDatabase::ResetTOTTime()
 {
+	BlockLock Lock(m_Lock);
+
 	m_CurTOTTime.Reset();
 	m_CurTOTSeconds = 0;
 }
 
 
-const EPGDatabase::ServiceEventMap * EPGDatabase::FindServiceEventMap(const ServiceInfo &Info) const
+const EPGDatabase::ServiceShard * EPGDatabase::FindServiceShard(const ServiceInfo &Info) const
 {
+	// m_Lock がロックされた状態で呼ばれる
 	if (Info.TransportStreamID != TRANSPORT_STREAM_ID_INVALID) {
 		auto it = m_ServiceMap.find(Info);
 		if (it != m_ServiceMap.end())
@@ -941,7 +1448,7 @@ const EPGDatabase::ServiceEventMap * EPGDatabase::FindServiceEventMap(const Serv
 }
 
 
-bool EPGDatabase::MergeEventMap(
+bool EPGDatabase::MergeServiceEventMap(
 	const ServiceInfo &Info, ServiceEventMap &Map,
 	MergeFlag Flags, std::optional<EventInfo::SourceIDType> SourceID)
 {
@@ -953,20 +1460,98 @@ bool EPGDatabase::MergeEventMap(
 			Event.second.SourceID = *SourceID;
 	}
 
-	auto itService = m_ServiceMap.find(Info);
-	if (itService == m_ServiceMap.end()) {
+	{
+		SharedBlockLock Lock(m_Lock);
+
+		auto itService = m_ServiceMap.find(Info);
+		if (itService != m_ServiceMap.end()) {
+			BlockLock ServiceLock(itService->second.Lock);
+			return MergeEventMap(itService->second.Data, Map, Flags);
+		}
+	}
+
+	BlockLock Lock(m_Lock);
+
+	auto [itService, Inserted] = m_ServiceMap.try_emplace(Info);
+	if (Inserted) {
 		// 新規サービスの追加
-		m_ServiceMap.emplace(Info, std::move(Map));
-		m_IsUpdated = true;
+		itService->second.Data = std::move(Map);
+		itService->second.Data.Revision = NextRevision();
+		m_IsUpdated.store(true, std::memory_order_release);
 		return true;
 	}
 
-	ServiceEventMap &Service = itService->second;
+	return MergeEventMap(itService->second.Data, Map, Flags);
+}
+
+
+bool EPGDatabase::MergeServiceEventMapParallel(
+	std::vector<std::pair<ServiceShard *, ServiceEventMap *>> &List,
+	unsigned int ThreadCount, MergeFlag Flags, std::optional<EventInfo::SourceIDType> SourceID)
+{
+	// (m_Lock を共有ロックした状態で呼ばれる)
+	ThreadCount = static_cast<unsigned int>(
+		std::clamp<size_t>(List.size(), 1, ThreadCount));
+
+	std::atomic<size_t> NextIndex(0);
+	std::atomic<bool> Failed(false);
+
+	// 各スレッドが未処理のサービスを順に取ってマージする
+	const auto Worker = [&]() {
+		try {
+			while (!Failed.load(std::memory_order_relaxed)) {
+				const size_t Index = NextIndex.fetch_add(1, std::memory_order_relaxed);
+				if (Index >= List.size())
+					break;
+
+				ServiceShard &Shard = *List[Index].first;
+				BlockLock ServiceLock(Shard.Lock);
+				MergeEventMap(Shard.Data, *List[Index].second, Flags, SourceID);
+			}
+		} catch (const std::bad_alloc &) {
+			Failed.store(true);
+		}
+	};
+
+	std::vector<std::thread> ThreadList;
+
+	if (ThreadCount > 1) {
+		try {
+			ThreadList.reserve(ThreadCount - 1);
+			for (unsigned int i = 1; i < ThreadCount; i++)
+				ThreadList.emplace_back(Worker);
+		} catch (const std::system_error &) {
+			// スレッドを作成できなかった分は残りのスレッドで処理する
+		} catch (const std::bad_alloc &) {
+		}
+	}
+
+	Worker();
+
+	for (std::thread &Thread : ThreadList)
+		Thread.join();
+
+	return !Failed.load();
+}
+
+
+bool EPGDatabase::MergeEventMap(
+	ServiceEventMap &Service, ServiceEventMap &Map,
+	MergeFlag Flags, std::optional<EventInfo::SourceIDType> SourceID)
+{
+	if (Map.EventMap.empty())
+		return false;
+
+	if (SourceID) {
+		for (auto &Event : Map.EventMap)
+			Event.second.SourceID = *SourceID;
+	}
 
 	if (!!(Flags & MergeFlag::DiscardOldEvents)) {
 		// 古い番組情報を破棄する場合
 		Service = std::move(Map);
-		m_IsUpdated = true;
+		Service.Revision = NextRevision();
+		m_IsUpdated.store(true, std::memory_order_release);
 		return true;
 	}
 
@@ -974,13 +1559,14 @@ bool EPGDatabase::MergeEventMap(
 	// 更新される範囲をトレース出力
 	{
 		DateTime OldestTime, NewestTime;
+		const CompactEventInfo &OldestEvent = Map.EventMap.find(Map.TimeMap.begin()->EventID)->second;
 
-		Map.EventMap.find(Map.TimeMap.begin()->EventID)->second.GetStartTime(&OldestTime);
+		OldestEvent.GetStartTime(&OldestTime);
 		Map.EventMap.find(Map.TimeMap.rbegin()->EventID)->second.GetEndTime(&NewestTime);
 
 		LIBISDB_TRACE(
 			LIBISDB_STR("EPGDatabase::MergeEventMap() : [{:x} {:x} {:x}] {}/{} {}:{:02} - {}/{} {}:{:02} {} Events\n"),
-			Info.NetworkID, Info.TransportStreamID, Info.ServiceID,
+			OldestEvent.NetworkID, OldestEvent.TransportStreamID, OldestEvent.ServiceID,
 			OldestTime.Month, OldestTime.Day, OldestTime.Hour, OldestTime.Minute,
 			NewestTime.Month, NewestTime.Day, NewestTime.Hour, NewestTime.Minute,
 			Map.EventMap.size());
@@ -1021,7 +1607,8 @@ bool EPGDatabase::MergeEventMap(
 	}
 
 	if (IsUpdated) {
-		m_IsUpdated = true;
+		Service.Revision = NextRevision();
+		m_IsUpdated.store(true, std::memory_order_release);
 
 		if (!!(Flags & MergeFlag::SetServiceUpdated))
 			Service.IsUpdated = true;
@@ -1031,7 +1618,7 @@ bool EPGDatabase::MergeEventMap(
 }
 
 
-bool EPGDatabase::MergeEventMapEvent(ServiceEventMap &Service, EventInfo &&NewEvent, MergeFlag Flags)
+bool EPGDatabase::MergeEventMapEvent(ServiceEventMap &Service, CompactEventInfo &&NewEvent, MergeFlag Flags)
 {
 	bool IsUpdated = false;
 
@@ -1043,7 +1630,7 @@ bool EPGDatabase::MergeEventMapEvent(ServiceEventMap &Service, EventInfo &&NewEv
 		std::piecewise_construct,
 		std::forward_as_tuple(NewEvent.EventID),
 		std::forward_as_tuple());
-	EventInfo &CurEvent = EventResult.first->second;
+	CompactEventInfo &CurEvent = EventResult.first->second;
 	bool Overwrite = true;
 	bool DatabaseFlag = !!(Flags & MergeFlag::Database);
 
@@ -1184,39 +1771,100 @@ bool EPGDatabase::UpdateTimeMap(ServiceEventMap &Service, const TimeEventInfo &T
 }
 
 
-const EventInfo * EPGDatabase::GetEventInfoByIDs(
-	uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID, uint16_t EventID) const
+const CompactEventInfo * EPGDatabase::GetEventInfoByIDs(const ServiceShard &Shard, uint16_t EventID) const
 {
-	auto itService = m_ServiceMap.find(ServiceInfo(NetworkID, TransportStreamID, ServiceID));
-	if (itService == m_ServiceMap.end())
-		return nullptr;
-
-	auto itEvent = itService->second.EventMap.find(EventID);
-	if (itEvent == itService->second.EventMap.end())
+	// Shard のロックを取得した状態で呼ばれる
+	auto itEvent = Shard.Data.EventMap.find(EventID);
+	if (itEvent == Shard.Data.EventMap.end())
 		return nullptr;
 
 	return &itEvent->second;
 }
 
 
+std::shared_ptr<const EPGDatabase::CompactEventList> EPGDatabase::GetSnapshotEventList(const ServiceShard &Shard) const
+{
+	// (Shard.Lock を取得した状態で呼ばれる)
+	BlockLock SnapshotLock(Shard.SnapshotLock);
+
+	// 前回から変更が無く、まだ参照されていればイベントリストを共有する
+	std::shared_ptr<const CompactEventList> EventList;
+	if (Shard.SnapshotRevision == Shard.Data.Revision)
+		EventList = Shard.Snapshot.lock();
+
+	if (!EventList) {
+		std::shared_ptr<CompactEventList> List = std::make_shared<CompactEventList>();
+
+		List->reserve(Shard.Data.TimeMap.size());
+
+		for (auto &Time : Shard.Data.TimeMap) {
+			auto itEvent = Shard.Data.EventMap.find(Time.EventID);
+			if (itEvent != Shard.Data.EventMap.end())
+				List->push_back(itEvent->second);
+		}
+
+		EventList = std::move(List);
+		Shard.Snapshot = EventList;
+		Shard.SnapshotRevision = Shard.Data.Revision;
+	}
+
+	return EventList;
+}
+
+
+std::shared_ptr<const EventTextIndex> EPGDatabase::GetServiceTextIndex(
+	const ServiceShard &Shard, const std::shared_ptr<const CompactEventList> &EventList) const
+{
+	// (m_Lock を取得した状態で呼ばれる)
+	{
+		BlockLock SnapshotLock(Shard.SnapshotLock);
+
+		// サービスの内容が変わっていなければ前回のインデックスを使う
+		if (Shard.TextIndex && (Shard.TextIndex->GetEventList() == EventList))
+			return Shard.TextIndex;
+	}
+
+	// インデックスの構築はサービスのロック外で行う
+	std::shared_ptr<const EventTextIndex> Index = std::make_shared<const EventTextIndex>(EventList);
+
+	BlockLock SnapshotLock(Shard.SnapshotLock);
+
+	if (Shard.Snapshot.lock() == EventList)
+		Shard.TextIndex = Index;
+
+	return Index;
+}
+
+
 bool EPGDatabase::SetCommonEventInfo(EventInfo *pInfo) const
 {
 	// イベント共有の参照先から情報を取得する
+	// (m_Lock のみを取得した状態で呼ばれ、サービスのロックを同時に二つ取得しないようにする)
 	if (pInfo->IsCommonEvent) {
-		const EventInfo *pCommonEvent = GetEventInfoByIDs(
-			pInfo->NetworkID,
-			pInfo->TransportStreamID,
-			pInfo->CommonEvent.ServiceID,
-			pInfo->CommonEvent.EventID);
+		auto itService = m_ServiceMap.find(
+			ServiceInfo(pInfo->NetworkID, pInfo->TransportStreamID, pInfo->CommonEvent.ServiceID));
+		if (itService == m_ServiceMap.end())
+			return false;
+
+		const ServiceShard &Shard = itService->second;
+		SharedBlockLock ServiceLock(Shard.Lock);
+
+		const CompactEventInfo *pCommonEvent = GetEventInfoByIDs(Shard, pInfo->CommonEvent.EventID);
 
 		if (pCommonEvent != nullptr) {
-			pInfo->EventName     = pCommonEvent->EventName;
-			pInfo->EventText     = pCommonEvent->EventText;
-			pInfo->ExtendedText  = pCommonEvent->ExtendedText;
-			pInfo->FreeCAMode    = pCommonEvent->FreeCAMode;
-			pInfo->VideoList     = pCommonEvent->VideoList;
-			pInfo->AudioList     = pCommonEvent->AudioList;
-			pInfo->ContentNibble = pCommonEvent->ContentNibble;
+			pCommonEvent->EventName.Get(&pInfo->EventName);
+			pCommonEvent->EventText.Get(&pInfo->EventText);
+			CompactEventInfo::GetExtendedTextList(pCommonEvent->ExtendedText, &pInfo->ExtendedText);
+			pInfo->FreeCAMode = pCommonEvent->FreeCAMode;
+			if (pCommonEvent->Detail) {
+				CompactEventInfo::GetVideoList(pCommonEvent->Detail->VideoList, &pInfo->VideoList);
+				CompactEventInfo::GetAudioList(pCommonEvent->Detail->AudioList, &pInfo->AudioList);
+				pInfo->ContentNibble = pCommonEvent->Detail->ContentNibble;
+			} else {
+				pInfo->VideoList.clear();
+				pInfo->AudioList.clear();
+				pInfo->ContentNibble = EventInfo::ContentNibbleInfo();
+			}
 
 			return true;
 		}
@@ -1226,11 +1874,18 @@ bool EPGDatabase::SetCommonEventInfo(EventInfo *pInfo) const
 }
 
 
-bool EPGDatabase::CopyEventExtendedText(EventInfo *pDstInfo, const EventInfo &SrcInfo) const
+bool EPGDatabase::CopyEventExtendedText(CompactEventInfo *pDstInfo, const CompactEventInfo &SrcInfo) const
 {
-	if (pDstInfo->ExtendedText.empty()
-			&& !SrcInfo.ExtendedText.empty()
-			&& (pDstInfo->EventName == SrcInfo.EventName)) {
+	if (!pDstInfo->ExtendedText.empty() || SrcInfo.ExtendedText.empty())
+		return false;
+
+	// ロック中にデコードしないよう、未デコード同士はバイト列のみで比較する
+	const bool IsSameName =
+		(pDstInfo->EventName.IsRaw() && SrcInfo.EventName.IsRaw()) ?
+			pDstInfo->EventName.IsSameRaw(SrcInfo.EventName) :
+			(pDstInfo->EventName == SrcInfo.EventName);
+
+	if (IsSameName) {
 		pDstInfo->ExtendedText = SrcInfo.ExtendedText;
 		return true;
 	}
@@ -1239,13 +1894,13 @@ bool EPGDatabase::CopyEventExtendedText(EventInfo *pDstInfo, const EventInfo &Sr
 }
 
 
-bool EPGDatabase::MergeEventExtendedInfo(ServiceEventMap &Service, EventInfo *pEvent)
+bool EPGDatabase::MergeEventExtendedInfo(ServiceEventMap &Service, CompactEventInfo *pEvent)
 {
 	auto itEvent = Service.EventExtendedMap.find(pEvent->EventID);
 	if (itEvent == Service.EventExtendedMap.end())
 		return false;
 
-	EventInfo &ExtendedInfo = itEvent->second;
+	CompactEventInfo &ExtendedInfo = itEvent->second;
 
 	if ((pEvent->SourceID != ExtendedInfo.SourceID)
 			|| (pEvent->StartTime != ExtendedInfo.StartTime))
@@ -1256,11 +1911,17 @@ bool EPGDatabase::MergeEventExtendedInfo(ServiceEventMap &Service, EventInfo *pE
 		return false;
 	}
 
-	LIBISDB_TRACE(
-		LIBISDB_STR("Merge extended info : [{:04x}] {}/{}/{} {}:{:02}:{:02}\n"),
-		pEvent->EventID,
-		pEvent->StartTime.Year, pEvent->StartTime.Month, pEvent->StartTime.Day,
-		pEvent->StartTime.Hour, pEvent->StartTime.Minute, pEvent->StartTime.Second);
+#ifdef LIBISDB_DEBUG
+	{
+		DateTime StartTime;
+		pEvent->GetStartTime(&StartTime);
+		LIBISDB_TRACE(
+			LIBISDB_STR("Merge extended info : [{:04x}] {}/{}/{} {}:{:02}:{:02}\n"),
+			pEvent->EventID,
+			StartTime.Year, StartTime.Month, StartTime.Day,
+			StartTime.Hour, StartTime.Minute, StartTime.Second);
+	}
+#endif
 
 	pEvent->ExtendedText = std::move(ExtendedInfo.ExtendedText);
 	pEvent->Type |= EventInfo::TypeFlag::Extended;
@@ -1279,12 +1940,17 @@ bool EPGDatabase::RemoveEvent(EventMapType &Map, uint16_t EventID)
 	if (it == Map.end())
 		return false;
 
-	LIBISDB_TRACE(
-		LIBISDB_STR("EPGDatabase::RemoveEvent() : [{:04x}] {}/{}/{} {}:{:02}:{:02} {}\n"),
-		EventID,
-		it->second.StartTime.Year, it->second.StartTime.Month, it->second.StartTime.Day,
-		it->second.StartTime.Hour, it->second.StartTime.Minute, it->second.StartTime.Second,
-		it->second.EventName);
+#ifdef LIBISDB_DEBUG
+	{
+		DateTime StartTime;
+		it->second.GetStartTime(&StartTime);
+		LIBISDB_TRACE(
+			LIBISDB_STR("EPGDatabase::RemoveEvent() : [{:04x}] {}/{}/{} {}:{:02}:{:02}\n"),
+			EventID,
+			StartTime.Year, StartTime.Month, StartTime.Day,
+			StartTime.Hour, StartTime.Minute, StartTime.Second);
+	}
+#endif
 
 	Map.erase(it);
 
@@ -1315,6 +1981,15 @@ EPGDatabase::TimeEventInfo::TimeEventInfo(const EventInfo &Info)
 }
 
 
+EPGDatabase::TimeEventInfo::TimeEventInfo(const CompactEventInfo &Info)
+	: StartTime(Info.StartTime)
+	, Duration(Info.Duration)
+	, EventID(Info.EventID)
+	, UpdatedTime(Info.UpdatedTime)
+{
+}
+
+
 
 
 void EPGDatabase::ScheduleInfo::Reset()
@@ -29,6 +29,8 @@
 
 
 #include "EventInfo.hpp"
+#include "CompactEventInfo.hpp"
+#include "EventTextIndex.hpp"
 #include "../Base/EventListener.hpp"
 #include "../Utilities/Lock.hpp"
 #include "../TS/Tables.hpp"
@@ -37,6 +39,10 @@
 #include <set>
 #include <vector>
 #include <functional>
+#include <optional>
+#include <memory>
+#include <span>
+#include <atomic>
 
 
 namespace LibISDB
@@ -107,6 +113,7 @@ namespace LibISDB
 			TimeEventInfo(unsigned long long Time);
 			TimeEventInfo(const DateTime &StartTime);
 			TimeEventInfo(const EventInfo &Info);
+			TimeEventInfo(const CompactEventInfo &Info);
 
 			bool operator < (const TimeEventInfo &Obj) const noexcept
 			{
@@ -116,6 +123,51 @@ namespace LibISDB
 
 		typedef std::set<TimeEventInfo> TimeEventMap;
 
+		typedef std::vector<CompactEventInfo> CompactEventList;
+
+		/** サービスのスナップショット */
+		struct ServiceSnapshot {
+			ServiceInfo Info;
+			unsigned long long Revision;
+			std::shared_ptr<const CompactEventList> EventList; /**< 開始時刻順のイベント */
+		};
+
+		typedef std::vector<ServiceSnapshot> Snapshot;
+
+		/** スナップショットのイベントリストのビュー */
+		struct EventListView {
+			ServiceInfo Info;
+			std::shared_ptr<const CompactEventList> EventList; /**< Events の参照先を保持する */
+			std::span<const CompactEventInfo> Events;          /**< 範囲内のイベント(開始時刻順) */
+		};
+
+		typedef std::vector<EventListView> TimeRangeResult;
+
+		/** スナップショットのイベントへの参照 */
+		typedef std::shared_ptr<const CompactEventInfo> EventRef;
+
+		/** 番組の検索条件 */
+		struct SearchCondition {
+			String Keyword;                                /**< キーワード(空白区切りで AND) */
+			EventTextIndex::TargetFlag Target =
+				EventTextIndex::TargetFlag::EventName |
+				EventTextIndex::TargetFlag::EventText;     /**< 検索対象 */
+			int ContentNibbleLevel1 = -1;                  /**< ジャンル(大分類、-1 で指定なし) */
+			int ContentNibbleLevel2 = -1;                  /**< ジャンル(中分類、-1 で指定なし) */
+			DateTime Earliest;                             /**< この時刻以降に放送される番組 */
+			DateTime Latest;                               /**< この時刻より前に開始する番組 */
+		};
+
+		/** 番組の検索結果 */
+		struct SearchResultInfo {
+			uint16_t NetworkID;
+			uint16_t TransportStreamID;
+			uint16_t ServiceID;
+			uint16_t EventID;
+		};
+
+		typedef std::vector<SearchResultInfo> SearchResult;
+
 		enum class MergeFlag : unsigned int {
 			None               = 0x0000U,
 			DiscardOldEvents   = 0x0001U,
@@ -133,6 +185,16 @@ namespace LibISDB
 		bool GetServiceList(ServiceList *pList) const;
 		bool IsServiceUpdated(uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID) const;
 		bool ResetServiceUpdated(uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID);
+		unsigned long long GetRevision() const noexcept { return m_Revision.load(std::memory_order_acquire); }
+		unsigned long long GetClearRevision() const noexcept { return m_ClearRevision.load(std::memory_order_acquire); }
+		bool GetUpdatedServiceList(unsigned long long Revision, ServiceList *pList) const;
+		bool GetSnapshot(Snapshot *pSnapshot) const;
+		bool QueryTimeRange(
+			const DateTime *pEarliest, const DateTime *pLatest,
+			TimeRangeResult *pResult, const ServiceList *pServiceList = nullptr) const;
+		static std::span<const CompactEventInfo> FindTimeRange(
+			const CompactEventList &EventList, const DateTime *pEarliest, const DateTime *pLatest);
+		bool SearchEvents(const SearchCondition &Condition, SearchResult *pResult) const;
 
 		bool GetEventList(
 			uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID,
@@ -141,6 +203,13 @@ namespace LibISDB
 			uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID,
 			ReturnArg<EventList> List) const;
 
+		bool GetEventListView(
+			uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID,
+			EventListView *pView) const;
+		bool GetEventRef(
+			uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID,
+			uint16_t EventID, EventRef *pRef) const;
+
 		bool GetEventInfo(
 			uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID,
 			uint16_t EventID, ReturnArg<EventInfo> Info) const;
@@ -182,8 +251,8 @@ namespace LibISDB
 			bool Extended = false) const;
 		void ResetScheduleStatus();
 
-		bool IsUpdated() const noexcept { return m_IsUpdated; }
-		void SetUpdated(bool Updated) { m_IsUpdated = Updated; }
+		bool IsUpdated() const noexcept { return m_IsUpdated.load(std::memory_order_acquire); }
+		void SetUpdated(bool Updated) { m_IsUpdated.store(Updated, std::memory_order_release); }
 
 		void SetScheduleOnly(bool ScheduleOnly);
 		bool GetScheduleOnly() const noexcept { return m_ScheduleOnly; }
@@ -191,6 +260,12 @@ namespace LibISDB
 		bool GetNoPastEvents() const noexcept { return m_NoPastEvents; }
 		void SetStringDecodeFlags(ARIBStringDecoder::DecodeFlag Flags);
 		ARIBStringDecoder::DecodeFlag GetStringDecodeFlags() const noexcept { return m_StringDecodeFlags; }
+		void SetDeferStringDecode(bool Defer);
+		bool GetDeferStringDecode() const noexcept { return m_DeferStringDecode; }
+		void SetTextIndex(bool Enable);
+		bool GetTextIndex() const noexcept { return m_TextIndex.load(std::memory_order_acquire); }
+		bool SetMergeThreadCount(int Count);
+		int GetMergeThreadCount() const noexcept { return m_MergeThreadCount; }
 
 		bool AddEventListener(EventListener *pEventListener);
 		bool RemoveEventListener(EventListener *pEventListener);
@@ -201,8 +276,6 @@ namespace LibISDB
 		bool UpdateTOT(const TOTTable *pTOTTable);
 		void ResetTOTTime();
 
-		MutexLock & GetLock() noexcept { return m_Lock; }
-
 	protected:
 		class ScheduleInfo
 		{
@@ -234,50 +307,115 @@ namespace LibISDB
 			TableList m_Extended;
 		};
 
-		typedef std::unordered_map<uint16_t, EventInfo> EventMapType;
+		typedef std::unordered_map<uint16_t, CompactEventInfo> EventMapType;
 
 		struct ServiceEventMap {
 			EventMapType EventMap;
 			EventMapType EventExtendedMap;
 			TimeEventMap TimeMap;
 			bool IsUpdated = false;
+			unsigned long long Revision = 0;
 			ScheduleInfo Schedule;
 			DateTime ScheduleUpdatedTime;
 		};
 
-		typedef std::map<ServiceInfo, ServiceEventMap> ServiceMap;
+		/** サービス毎のシャード */
+		struct ServiceShard {
+			ServiceEventMap Data;
+			mutable SharedLock Lock;
+
+			/*
+				スナップショットのイベントリストは変更されるまで共有する。
+				参照されている間のみ保持し、保存等が終われば解放される。
+				共有ロック中に更新されるため SnapshotLock で保護する。
+			*/
+			mutable std::weak_ptr<const CompactEventList> Snapshot;
+			mutable unsigned long long SnapshotRevision = 0;
+			mutable std::shared_ptr<const EventTextIndex> TextIndex;
+			mutable MutexLock SnapshotLock;
+		};
+
+		typedef std::map<ServiceInfo, ServiceShard> ServiceMap;
+		typedef std::map<ServiceInfo, ServiceEventMap> PendingServiceMap;
+
+		/** ロック外でデコードされた番組情報 */
+		struct DecodedEventInfo {
+			const EITTable::EventInfo *pEventInfo;
+			std::optional<PooledString> EventName;
+			std::optional<PooledString> EventText;
+			std::optional<CompactEventInfo::ExtendedTextInfoList> ExtendedText;
+			std::optional<CompactEventInfo::VideoInfoList> VideoList;
+			std::optional<CompactEventInfo::AudioInfoList> AudioList;
+			std::optional<EventInfo::ContentNibbleInfo> ContentNibble;
+			std::optional<EventInfo::EventGroupInfoList> EventGroupList;
+			std::optional<EventInfo::CommonEventInfo> CommonEvent;
+		};
+
+		typedef std::vector<DecodedEventInfo> DecodedEventList;
+
+		struct ScheduleNotifyInfo {
+			bool StatusReset = false;
+			bool Completed = false;
+		};
 
+		/*
+			m_Lock はサービスの追加/削除と全体の設定を保護し、
+			各サービスの内容は ServiceShard::Lock で保護する。
+			ServiceShard::Lock は m_Lock をロックした状態でのみロックする。
+			m_Lock が排他ロックされている場合は ServiceShard::Lock のロックは不要。
+		*/
 		ServiceMap m_ServiceMap;
-		ServiceMap m_PendingServiceMap;
-		mutable MutexLock m_Lock;
-		bool m_IsUpdated;
+		PendingServiceMap m_PendingServiceMap;
+		mutable SharedLock m_Lock;
+		std::atomic<bool> m_IsUpdated;
+		std::atomic<unsigned long long> m_Revision;
+		std::atomic<unsigned long long> m_ClearRevision;
 		bool m_ScheduleOnly;
 		bool m_NoPastEvents;
-		ARIBStringDecoder m_StringDecoder;
 		ARIBStringDecoder::DecodeFlag m_StringDecodeFlags;
+		bool m_DeferStringDecode;
+		std::atomic<bool> m_TextIndex;
+		int m_MergeThreadCount;
 		DateTime m_CurTOTTime;
 		unsigned long long m_CurTOTSeconds;
 		EventListenerList<EventListener> m_EventListenerList;
 
-		const ServiceEventMap * FindServiceEventMap(const ServiceInfo &Info) const;
-		const ServiceEventMap * FindServiceEventMap(
+		const ServiceShard * FindServiceShard(const ServiceInfo &Info) const;
+		const ServiceShard * FindServiceShard(
 			uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID) const
 		{
-			return FindServiceEventMap(ServiceInfo(NetworkID, TransportStreamID, ServiceID));
+			return FindServiceShard(ServiceInfo(NetworkID, TransportStreamID, ServiceID));
 		}
-		bool MergeEventMap(
+		bool MergeServiceEventMap(
 			const ServiceInfo &Info, ServiceEventMap &Map,
+			MergeFlag Flags, std::optional<EventInfo::SourceIDType> SourceID);
+		bool MergeServiceEventMapParallel(
+			std::vector<std::pair<ServiceShard *, ServiceEventMap *>> &List,
+			unsigned int ThreadCount, MergeFlag Flags, std::optional<EventInfo::SourceIDType> SourceID);
+		bool MergeEventMap(
+			ServiceEventMap &Service, ServiceEventMap &Map,
 			MergeFlag Flags = MergeFlag::None,
 			std::optional<EventInfo::SourceIDType> SourceID = std::nullopt);
 		bool MergeEventMapEvent(
-			ServiceEventMap &Service, EventInfo &&NewEvent,
+			ServiceEventMap &Service, CompactEventInfo &&NewEvent,
 			MergeFlag Flags = MergeFlag::None);
 		bool UpdateTimeMap(ServiceEventMap &Service, const TimeEventInfo &Time, bool *pIsUpdated);
-		const EventInfo * GetEventInfoByIDs(
-			uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID, uint16_t EventID) const;
+		void DecodeEvents(
+			const EITTable *pEITTable, ARIBStringDecoder::DecodeFlag DecodeFlags, bool NoPastEvents,
+			bool DeferDecode, DecodedEventList *pEventList) const;
+		bool CommitEvents(
+			const ServiceInfo &Key, ServiceEventMap &Service, bool ServiceInserted,
+			const EITTable *pEITTable, const DecodedEventList &EventList,
+			EventInfo::SourceIDType SourceID, ScheduleNotifyInfo *pNotify);
+		const CompactEventInfo * GetEventInfoByIDs(const ServiceShard &Shard, uint16_t EventID) const;
+		std::shared_ptr<const CompactEventList> GetSnapshotEventList(const ServiceShard &Shard) const;
+		std::shared_ptr<const EventTextIndex> GetServiceTextIndex(
+			const ServiceShard &Shard, const std::shared_ptr<const CompactEventList> &EventList) const;
 		bool SetCommonEventInfo(EventInfo *pInfo) const;
-		bool CopyEventExtendedText(EventInfo *pDstInfo, const EventInfo &SrcInfo) const;
-		bool MergeEventExtendedInfo(ServiceEventMap &Service, EventInfo *pEvent);
+		bool CopyEventExtendedText(CompactEventInfo *pDstInfo, const CompactEventInfo &SrcInfo) const;
+		bool MergeEventExtendedInfo(ServiceEventMap &Service, CompactEventInfo *pEvent);
+
+		unsigned long long NextRevision() noexcept { return m_Revision.fetch_add(1, std::memory_order_acq_rel) + 1; }
 
 		static bool RemoveEvent(EventMapType &Map, uint16_t EventID);
 	};
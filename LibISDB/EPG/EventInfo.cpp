@@ -401,7 +401,7 @@ bool GetEventExtendedTextList(const DescriptorBlock *pDescBlock, ReturnArg<Event
 }
 
 
-static void CanonicalizeExtendedText(const String &Src, ReturnArg<String> Dst)
+void CanonicalizeExtendedText(const String &Src, ReturnArg<String> Dst)
 {
 	for (auto it = Src.begin(); it != Src.end();) {
 		if (*it == LIBISDB_CHAR('\r')) {
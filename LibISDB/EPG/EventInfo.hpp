@@ -199,6 +199,7 @@ namespace LibISDB
 	bool GetEventExtendedText(
 		const DescriptorBlock *pDescBlock, ARIBStringDecoder &StringDecoder,
 		ARIBStringDecoder::DecodeFlag DecodeFlags, ReturnArg<String> Text);
+	void CanonicalizeExtendedText(const String &Src, ReturnArg<String> Dst);
 
 }	// namespace LibISDB
 
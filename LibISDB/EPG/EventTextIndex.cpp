@@ -0,0 +1,221 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   EventTextIndex.cpp
+ @brief  番組情報の全文検索用インデックス
+ @author DBCTRADO
+*/
+
+
+#include "../LibISDBPrivate.hpp"
+#include "EventTextIndex.hpp"
+#include <algorithm>
+#include "../Base/DebugDef.hpp"
+
+
+namespace LibISDB
+{
+
+
+EventTextIndex::EventTextIndex(std::shared_ptr<const EventList> List)
+	: m_EventList(std::move(List))
+{
+	std::u32string Text, EventText;
+
+	// 番組名と番組情報の bigram からイベントのインデックスを引けるようにする
+	for (uint32_t Index = 0; Index < m_EventList->size(); Index++) {
+		const CompactEventInfo &Event = (*m_EventList)[Index];
+
+		Normalize(Event.EventName.GetView(), &Text);
+		Normalize(Event.EventText.GetView(), &EventText);
+		// 番組名と番組情報を跨ぐ bigram ができないように区切る
+		Text.push_back(U'\0');
+		Text.append(EventText);
+
+		for (size_t i = 1; i < Text.length(); i++) {
+			if ((Text[i - 1] == U'\0') || (Text[i] == U'\0') || (Text[i - 1] == U' ') || (Text[i] == U' '))
+				continue;
+
+			PostingList &List = m_BigramMap[MakeBigramKey(Text[i - 1], Text[i])];
+			if (List.empty() || (List.back() != Index))
+				List.push_back(Index);
+		}
+	}
+}
+
+
+bool EventTextIndex::FindCandidates(const Keyword &Key, std::vector<uint32_t> *pIndexList) const
+{
+	pIndexList->clear();
+
+	std::vector<const PostingList *> Lists;
+
+	for (const std::u32string &Word : Key) {
+		for (size_t i = 1; i < Word.length(); i++) {
+			auto it = m_BigramMap.find(MakeBigramKey(Word[i - 1], Word[i]));
+			if (it == m_BigramMap.end())
+				return true;
+			Lists.push_back(&it->second);
+		}
+	}
+
+	// 1文字の語のみの場合は絞り込めないので全てのイベントが候補になる
+	if (Lists.empty()) {
+		pIndexList->resize(m_EventList->size());
+		for (uint32_t i = 0; i < pIndexList->size(); i++)
+			(*pIndexList)[i] = i;
+		return true;
+	}
+
+	// 短いリストから順に共通部分を取る
+	std::ranges::sort(Lists, {}, [](const PostingList *pList) { return pList->size(); });
+
+	*pIndexList = *Lists.front();
+
+	std::vector<uint32_t> Intersection;
+
+	for (size_t i = 1; (i < Lists.size()) && !pIndexList->empty(); i++) {
+		if (Lists[i] == Lists[i - 1])
+			continue;
+		Intersection.clear();
+		std::ranges::set_intersection(*pIndexList, *Lists[i], std::back_inserter(Intersection));
+		pIndexList->swap(Intersection);
+	}
+
+	return true;
+}
+
+
+void EventTextIndex::Normalize(StringView Text, std::u32string *pNormalized)
+{
+	pNormalized->clear();
+	pNormalized->reserve(Text.length());
+
+	for (size_t i = 0; i < Text.length();) {
+		char32_t c;
+
+		// String の文字コードから UTF-32 に変換する
+		if constexpr (sizeof(CharType) == 1) {
+			const uint8_t c1 = static_cast<uint8_t>(Text[i]);
+			size_t Length;
+
+			if (c1 < 0x80) {
+				c = c1;
+				Length = 1;
+			} else if ((c1 & 0xE0) == 0xC0) {
+				c = c1 & 0x1F;
+				Length = 2;
+			} else if ((c1 & 0xF0) == 0xE0) {
+				c = c1 & 0x0F;
+				Length = 3;
+			} else if ((c1 & 0xF8) == 0xF0) {
+				c = c1 & 0x07;
+				Length = 4;
+			} else {
+				c = U'\uFFFD';
+				Length = 1;
+			}
+
+			if (i + Length > Text.length()) {
+				c = U'\uFFFD';
+				Length = Text.length() - i;
+			} else {
+				for (size_t j = 1; j < Length; j++)
+					c = (c << 6) | (static_cast<uint8_t>(Text[i + j]) & 0x3F);
+			}
+
+			i += Length;
+		} else if constexpr (sizeof(CharType) == 2) {
+			c = static_cast<char16_t>(Text[i++]);
+			if ((c >= 0xD800) && (c < 0xDC00) && (i < Text.length())) {
+				const char32_t c2 = static_cast<char16_t>(Text[i]);
+				if ((c2 >= 0xDC00) && (c2 < 0xE000)) {
+					c = 0x10000 + ((c - 0xD800) << 10) + (c2 - 0xDC00);
+					i++;
+				}
+			}
+		} else {
+			c = static_cast<char32_t>(Text[i++]);
+		}
+
+		// 全角英数記号は半角に、英大文字は小文字に揃える
+		if ((c >= 0xFF01) && (c <= 0xFF5E))
+			c -= 0xFEE0;
+		else if ((c == 0x3000) || (c == U'\t') || (c == U'\r') || (c == U'\n'))
+			c = U' ';
+		if ((c >= U'A') && (c <= U'Z'))
+			c += U'a' - U'A';
+
+		pNormalized->push_back(c);
+	}
+}
+
+
+void EventTextIndex::MakeKeyword(StringView Text, Keyword *pKeyword)
+{
+	pKeyword->clear();
+
+	std::u32string Normalized;
+	Normalize(Text, &Normalized);
+
+	// 空白で区切られた語を AND 条件とする
+	for (size_t Pos = 0; Pos < Normalized.length();) {
+		const size_t Next = Normalized.find(U' ', Pos);
+		const size_t End = (Next != std::u32string::npos) ? Next : Normalized.length();
+
+		if (End > Pos)
+			pKeyword->emplace_back(Normalized, Pos, End - Pos);
+
+		Pos = End + 1;
+	}
+}
+
+
+bool EventTextIndex::Match(
+	const CompactEventInfo &Event, const Keyword &Key, TargetFlag Target,
+	std::u32string *pBuffer)
+{
+	if (Key.empty())
+		return false;
+
+	pBuffer->clear();
+
+	std::u32string Text;
+
+	if (!!(Target & TargetFlag::EventName)) {
+		Normalize(Event.EventName.GetView(), &Text);
+		pBuffer->append(Text);
+	}
+	if (!!(Target & TargetFlag::EventText)) {
+		Normalize(Event.EventText.GetView(), &Text);
+		pBuffer->push_back(U'\0');
+		pBuffer->append(Text);
+	}
+
+	for (const std::u32string &Word : Key) {
+		if (pBuffer->find(Word) == std::u32string::npos)
+			return false;
+	}
+
+	return true;
+}
+
+
+}	// namespace LibISDB
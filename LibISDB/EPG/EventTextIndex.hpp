@@ -0,0 +1,84 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   EventTextIndex.hpp
+ @brief  番組情報の全文検索用インデックス
+ @author DBCTRADO
+*/
+
+
+#ifndef LIBISDB_EVENT_TEXT_INDEX_H
+#define LIBISDB_EVENT_TEXT_INDEX_H
+
+
+#include "CompactEventInfo.hpp"
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <memory>
+
+
+namespace LibISDB
+{
+
+	/** 番組情報の全文検索用インデックスクラス */
+	class EventTextIndex
+	{
+	public:
+		typedef std::vector<CompactEventInfo> EventList;
+
+		/** 検索対象 */
+		enum class TargetFlag : unsigned int {
+			None      = 0x0000U,
+			EventName = 0x0001U, /**< 番組名 */
+			EventText = 0x0002U, /**< 番組情報 */
+			LIBISDB_ENUM_FLAGS_TRAILER
+		};
+
+		/** 正規化されたキーワード */
+		typedef std::vector<std::u32string> Keyword;
+
+		EventTextIndex(std::shared_ptr<const EventList> List);
+
+		const std::shared_ptr<const EventList> & GetEventList() const noexcept { return m_EventList; }
+		bool FindCandidates(const Keyword &Key, std::vector<uint32_t> *pIndexList) const;
+
+		static void Normalize(StringView Text, std::u32string *pNormalized);
+		static void MakeKeyword(StringView Text, Keyword *pKeyword);
+		static bool Match(
+			const CompactEventInfo &Event, const Keyword &Key, TargetFlag Target,
+			std::u32string *pBuffer);
+
+	private:
+		typedef std::vector<uint32_t> PostingList;
+
+		static uint64_t MakeBigramKey(char32_t c1, char32_t c2) noexcept
+		{
+			return (static_cast<uint64_t>(c1) << 32) | static_cast<uint64_t>(c2);
+		}
+
+		std::shared_ptr<const EventList> m_EventList;
+		std::unordered_map<uint64_t, PostingList> m_BigramMap;
+	};
+
+}	// namespace LibISDB
+
+
+#endif	// ifndef LIBISDB_EVENT_TEXT_INDEX_H
@@ -0,0 +1,549 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   ParallelTSFileAnalyzer.cpp
+ @brief  TS ファイルの並列解析
+ @author DBCTRADO
+*/
+
+
+#include "../LibISDBPrivate.hpp"
+#include "ParallelTSFileAnalyzer.hpp"
+#include "../Base/MappedFileStream.hpp"
+#include "../Base/StandardStream.hpp"
+#include <algorithm>
+#include <array>
+#include <thread>
+#include "../Base/DebugDef.hpp"
+
+
+namespace LibISDB
+{
+
+
+ParallelTSFileAnalyzer::ParallelTSFileAnalyzer() noexcept
+	: m_ThreadCount(0)
+	, m_MinRangeSize(DEFAULT_MIN_RANGE_SIZE)
+	, m_EPGDatabaseEnabled(false)
+	, m_TotalInputBytes(0)
+{
+}
+
+
+ParallelTSFileAnalyzer::~ParallelTSFileAnalyzer()
+{
+	Clear();
+}
+
+
+bool ParallelTSFileAnalyzer::Analyze(const String &FileName)
+{
+	Clear();
+
+	if (FileName.empty()) {
+		SetError(std::errc::invalid_argument);
+		return false;
+	}
+
+	try {
+		if (!SplitRanges(FileName))
+			return false;
+
+		for (size_t i = 0; i < m_RangeList.size(); i++) {
+			RangeContext &Context = m_RangeList[i];
+
+			Context.Parser = std::make_unique<TSPacketParserFilter>();
+			Context.Analyzer = std::make_unique<AnalyzerFilter>();
+			Context.Parser->SetLogger(m_pLogger);
+			Context.Analyzer->SetLogger(m_pLogger);
+			Context.Parser->SetOutputFilter(Context.Analyzer.get(), Context.Analyzer.get());
+			Context.Analyzer->AddEventListener(&Context.Collector);
+
+			if (m_EPGDatabaseEnabled) {
+				Context.Database = std::make_unique<EPGDatabase>();
+				Context.EPGFilter = std::make_unique<EPGDatabaseFilter>();
+				Context.EPGFilter->SetLogger(m_pLogger);
+				Context.EPGFilter->SetEPGDatabase(Context.Database.get());
+				Context.Analyzer->SetOutputFilter(Context.EPGFilter.get(), Context.EPGFilter.get());
+			}
+
+			if (m_AnalyzerEventListenerFactory) {
+				Context.Listener = m_AnalyzerEventListenerFactory(i);
+				if (Context.Listener)
+					Context.Analyzer->AddEventListener(Context.Listener.get());
+			}
+		}
+
+		std::vector<std::thread> ThreadList;
+		ThreadList.reserve(m_RangeList.size());
+
+		try {
+			for (RangeContext &Context : m_RangeList)
+				ThreadList.emplace_back([this, &FileName, &Context]() { AnalyzeRange(FileName, Context); });
+		} catch (...) {
+			// 作成済みのスレッドの終了を待ってから失敗とする
+			for (std::thread &Thread : ThreadList)
+				Thread.join();
+			throw;
+		}
+
+		for (std::thread &Thread : ThreadList)
+			Thread.join();
+	} catch (const std::bad_alloc &) {
+		SetError(std::errc::not_enough_memory);
+		Clear();
+		return false;
+	} catch (const std::system_error &Error) {
+		SetError(Error.code());
+		Clear();
+		return false;
+	}
+
+	for (const RangeContext &Context : m_RangeList) {
+		if (!Context.Succeeded) {
+			SetError(std::errc::io_error);
+			return false;
+		}
+	}
+
+	MergeResults();
+
+	ResetError();
+
+	return true;
+}
+
+
+void ParallelTSFileAnalyzer::Clear()
+{
+	m_RangeList.clear();
+	m_TotalInputBytes = 0;
+	m_TotalPacketCount.Reset();
+	m_PIDPacketCount.clear();
+	m_MergedServiceList.clear();
+	m_MergedEMMPIDList.clear();
+}
+
+
+bool ParallelTSFileAnalyzer::SetThreadCount(int Count)
+{
+	if (Count < 0)
+		return false;
+
+	m_ThreadCount = Count;
+
+	return true;
+}
+
+
+bool ParallelTSFileAnalyzer::SetMinRangeSize(unsigned long long Size)
+{
+	if (Size < TS_PACKET_SIZE)
+		return false;
+
+	m_MinRangeSize = Size;
+
+	return true;
+}
+
+
+void ParallelTSFileAnalyzer::SetEPGDatabaseEnabled(bool Enable)
+{
+	m_EPGDatabaseEnabled = Enable;
+}
+
+
+void ParallelTSFileAnalyzer::SetAnalyzerEventListenerFactory(const AnalyzerEventListenerFactory &Factory)
+{
+	m_AnalyzerEventListenerFactory = Factory;
+}
+
+
+bool ParallelTSFileAnalyzer::GetRangeInfo(size_t Index, RangeInfo *pInfo) const
+{
+	if ((Index >= m_RangeList.size()) || (pInfo == nullptr))
+		return false;
+
+	*pInfo = m_RangeList[Index].Range;
+
+	return true;
+}
+
+
+AnalyzerFilter * ParallelTSFileAnalyzer::GetAnalyzer(size_t Index) const
+{
+	if (Index >= m_RangeList.size())
+		return nullptr;
+
+	return m_RangeList[Index].Analyzer.get();
+}
+
+
+AnalyzerFilter::EventListener * ParallelTSFileAnalyzer::GetAnalyzerEventListener(size_t Index) const
+{
+	if (Index >= m_RangeList.size())
+		return nullptr;
+
+	return m_RangeList[Index].Listener.get();
+}
+
+
+EPGDatabase * ParallelTSFileAnalyzer::GetEPGDatabase(size_t Index) const
+{
+	if (Index >= m_RangeList.size())
+		return nullptr;
+
+	return m_RangeList[Index].Database.get();
+}
+
+
+bool ParallelTSFileAnalyzer::MergeEPGDatabase(EPGDatabase *pDatabase) const
+{
+	if (pDatabase == nullptr)
+		return false;
+
+	// 結果が実行ごとに変わらないように、ファイルの先頭側から順にマージする
+	for (const RangeContext &Context : m_RangeList) {
+		if (Context.Database) {
+			if (!pDatabase->Merge(Context.Database.get()))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+
+ParallelTSFileAnalyzer::PacketCountInfo ParallelTSFileAnalyzer::GetTotalPacketCount(uint16_t PID) const
+{
+	if ((PID > PID_MAX) || m_PIDPacketCount.empty())
+		return PacketCountInfo();
+
+	return m_PIDPacketCount[PID];
+}
+
+
+bool ParallelTSFileAnalyzer::SplitRanges(const String &FileName)
+{
+	std::unique_ptr<FileStreamBase> File(OpenStream(FileName));
+
+	if (!File) {
+		SetError(std::errc::no_such_file_or_directory);
+		return false;
+	}
+
+	const unsigned long long FileSize = File->GetSize();
+
+	unsigned int ThreadCount = m_ThreadCount;
+	if (ThreadCount == 0) {
+		ThreadCount = std::thread::hardware_concurrency();
+		if (ThreadCount == 0)
+			ThreadCount = 1;
+	}
+
+	const unsigned long long RangeCount =
+		std::clamp<unsigned long long>(FileSize / m_MinRangeSize, 1, ThreadCount);
+
+	std::vector<unsigned long long> BoundaryList;
+	BoundaryList.push_back(0);
+
+	for (unsigned long long i = 1; i < RangeCount; i++) {
+		unsigned long long Pos = FileSize / RangeCount * i;
+		Pos -= Pos % TS_PACKET_SIZE;
+		Pos = FindPacketBoundary(File.get(), Pos);
+		if (Pos > BoundaryList.back())
+			BoundaryList.push_back(Pos);
+	}
+
+	BoundaryList.push_back(FileSize);
+
+	m_RangeList.resize(BoundaryList.size() - 1);
+	for (size_t i = 0; i < m_RangeList.size(); i++) {
+		m_RangeList[i].Range.Begin = BoundaryList[i];
+		m_RangeList[i].Range.End = BoundaryList[i + 1];
+	}
+
+	return true;
+}
+
+
+unsigned long long ParallelTSFileAnalyzer::FindPacketBoundary(Stream *pStream, unsigned long long Pos)
+{
+	// 同期バイトが 3 パケット続けて現れる位置をパケットの境界とする
+	constexpr size_t SyncCount = 3;
+
+	uint8_t Buffer[RESYNC_SEARCH_SIZE + TS_PACKET_SIZE * (SyncCount - 1) + 1];
+
+	if (!pStream->SetPos(Pos, Stream::SetPosType::Begin))
+		return Pos;
+
+	const size_t ReadSize = pStream->Read(Buffer, sizeof(Buffer));
+	if (ReadSize < TS_PACKET_SIZE * (SyncCount - 1) + 1)
+		return Pos;
+
+	for (size_t i = 0; i + TS_PACKET_SIZE * (SyncCount - 1) < ReadSize; i++) {
+		size_t j;
+		for (j = 0; j < SyncCount; j++) {
+			if (Buffer[i + j * TS_PACKET_SIZE] != 0x47)
+				break;
+		}
+		if (j == SyncCount)
+			return Pos + i;
+	}
+
+	return Pos;
+}
+
+
+void ParallelTSFileAnalyzer::AnalyzeRange(const String &FileName, RangeContext &Context)
+{
+	try {
+		std::unique_ptr<FileStreamBase> File(OpenStream(FileName));
+		if (!File)
+			return;
+
+		if (!File->SetPos(Context.Range.Begin, Stream::SetPosType::Begin))
+			return;
+
+		MappedFileStream *pMappedStream = dynamic_cast<MappedFileStream *>(File.get());
+		DataBuffer Buffer;
+		DataBufferView View;
+
+		if ((pMappedStream == nullptr) && (Buffer.AllocateBuffer(READ_SIZE) < READ_SIZE))
+			return;
+
+		Context.Parser->Initialize();
+		Context.Analyzer->Initialize();
+		if (Context.EPGFilter)
+			Context.EPGFilter->Initialize();
+		Context.Parser->StartStreaming();
+
+		unsigned long long Remain = Context.Range.End - Context.Range.Begin;
+
+		while (Remain > 0) {
+			const size_t Size = static_cast<size_t>(std::min<unsigned long long>(Remain, READ_SIZE));
+			DataBuffer *pData;
+			size_t ReadSize;
+
+			if (pMappedStream != nullptr) {
+				uint8_t *pView;
+				ReadSize = pMappedStream->ReadView(&pView, Size);
+				View.SetView(pView, ReadSize);
+				pData = &View;
+			} else {
+				ReadSize = File->Read(Buffer.GetBuffer(), Size);
+				Buffer.SetSize(ReadSize);
+				pData = &Buffer;
+			}
+
+			if (ReadSize == 0)
+				break;
+
+			SingleDataStream<DataBuffer> Data(pData);
+			Context.Parser->ReceiveData(&Data);
+
+			Remain -= ReadSize;
+		}
+
+		Context.Parser->StopStreaming();
+
+		Context.Succeeded = (Remain == 0);
+	} catch (...) {
+		Log(Logger::LogType::Error, LIBISDB_STR("TS ファイルの解析中に例外が発生しました。"));
+	}
+}
+
+
+void ParallelTSFileAnalyzer::MergeResults()
+{
+	m_PIDPacketCount.resize(PID_MAX + 1);
+
+	for (const RangeContext &Context : m_RangeList) {
+		m_TotalInputBytes += Context.Parser->GetTotalInputBytes();
+		m_TotalPacketCount += Context.Parser->GetTotalPacketCount();
+		for (uint16_t PID = 0; PID <= PID_MAX; PID++)
+			m_PIDPacketCount[PID] += Context.Parser->GetTotalPacketCount(PID);
+	}
+
+	// 範囲の境界をまたぐ巡回カウンタの連続性をチェックする
+	std::array<uint8_t, PID_MAX> Counter;
+	Counter.fill(0x10);
+
+	for (const RangeContext &Context : m_RangeList) {
+		for (uint16_t PID = 0; PID < PID_MAX; PID++) {
+			const TSPacketParserFilter::ContinuityState State = Context.Parser->GetContinuityState(PID);
+
+			if (State.FirstCounter == 0xFF)
+				continue;
+
+			if (!State.FirstDiscontinuity
+					&& (Counter[PID] < 0x10) && (State.FirstCounter < 0x10)
+					&& (((Counter[PID] + 1) & 0x0F) != State.FirstCounter)) {
+				++m_TotalPacketCount.ContinuityError;
+				++m_PIDPacketCount[PID].ContinuityError;
+			}
+
+			Counter[PID] = State.LastCounter;
+		}
+	}
+
+	// PSI/SI の情報は、結果が実行ごとに変わらないようにファイルの先頭側から順に統合する
+	for (const RangeContext &Context : m_RangeList) {
+		for (const MergedServiceInfo &Service : Context.Collector.ServiceList)
+			MergeService(MapService(m_MergedServiceList, Service.ServiceID), Service);
+		for (const uint16_t PID : Context.Collector.EMMPIDList)
+			MergeUnique(m_MergedEMMPIDList, PID);
+	}
+}
+
+
+FileStreamBase * ParallelTSFileAnalyzer::OpenStream(const String &FileName)
+{
+	constexpr FileStreamBase::OpenFlag OpenFlags =
+		FileStreamBase::OpenFlag::Read |
+		FileStreamBase::OpenFlag::ShareRead |
+		FileStreamBase::OpenFlag::ShareWrite |
+		FileStreamBase::OpenFlag::SequentialRead;
+
+	MappedFileStream *pMappedStream = new MappedFileStream;
+	if (pMappedStream->Open(FileName, OpenFlags))
+		return pMappedStream;
+	delete pMappedStream;
+
+	FileStreamBase *pStream = OpenFileStream(FileName, OpenFlags);
+	if ((pStream != nullptr) && !pStream->IsOpen()) {
+		delete pStream;
+		pStream = nullptr;
+	}
+
+	return pStream;
+}
+
+
+ParallelTSFileAnalyzer::MergedServiceInfo & ParallelTSFileAnalyzer::MapService(
+	MergedServiceList &List, uint16_t ServiceID)
+{
+	// service_id 順に並べる
+	auto it = std::ranges::lower_bound(List, ServiceID, {}, &MergedServiceInfo::ServiceID);
+	if ((it == List.end()) || (it->ServiceID != ServiceID)) {
+		it = List.emplace(it);
+		it->ServiceID = ServiceID;
+	}
+
+	return *it;
+}
+
+
+void ParallelTSFileAnalyzer::MergeService(MergedServiceInfo &Dst, const MergedServiceInfo &Src)
+{
+	for (const uint16_t PID : Src.PMTPIDList)
+		MergeUnique(Dst.PMTPIDList, PID);
+	for (const uint16_t PID : Src.PCRPIDList)
+		MergeUnique(Dst.PCRPIDList, PID);
+	for (const AnalyzerFilter::ECMInfo &ECM : Src.ECMList)
+		MergeUnique(Dst.ECMList, ECM);
+	for (const AnalyzerFilter::ESInfo &ES : Src.ESList)
+		MergeES(Dst.ESList, ES);
+
+	// 名前等は後に取得されたものを優先する
+	if (!Src.ProviderName.empty())
+		Dst.ProviderName = Src.ProviderName;
+	if (!Src.ServiceName.empty())
+		Dst.ServiceName = Src.ServiceName;
+	if (Src.ServiceType != SERVICE_TYPE_INVALID)
+		Dst.ServiceType = Src.ServiceType;
+}
+
+
+void ParallelTSFileAnalyzer::MergeES(AnalyzerFilter::ESInfoList &List, const AnalyzerFilter::ESInfo &ES)
+{
+	// PID と stream_type が同じものは同じ ES とし、他の情報は後のもので置き換える
+	auto it = std::ranges::find_if(
+		List,
+		[&](const AnalyzerFilter::ESInfo &Info) { return (Info.PID == ES.PID) && (Info.StreamType == ES.StreamType); });
+	if (it != List.end())
+		*it = ES;
+	else
+		List.push_back(ES);
+}
+
+
+template<typename T> void ParallelTSFileAnalyzer::MergeUnique(std::vector<T> &List, const T &Value)
+{
+	if (std::ranges::find(List, Value) == List.end())
+		List.push_back(Value);
+}
+
+
+
+
+void ParallelTSFileAnalyzer::PSICollector::OnPMTUpdated(AnalyzerFilter *pAnalyzer, uint16_t ServiceID)
+{
+	AnalyzerFilter::ServiceInfo Info;
+
+	if (!pAnalyzer->GetServiceInfoByID(ServiceID, &Info))
+		return;
+
+	MergedServiceInfo &Service = MapService(ServiceList, ServiceID);
+
+	MergeUnique(Service.PMTPIDList, Info.PMTPID);
+	if (Info.PCRPID != PID_INVALID)
+		MergeUnique(Service.PCRPIDList, Info.PCRPID);
+	for (const AnalyzerFilter::ECMInfo &ECM : Info.ECMList)
+		MergeUnique(Service.ECMList, ECM);
+	for (const AnalyzerFilter::ESInfo &ES : Info.ESList)
+		MergeES(Service.ESList, ES);
+}
+
+
+void ParallelTSFileAnalyzer::PSICollector::OnSDTUpdated(AnalyzerFilter *pAnalyzer)
+{
+	const int ServiceCount = pAnalyzer->GetServiceCount();
+
+	for (int i = 0; i < ServiceCount; i++) {
+		AnalyzerFilter::ServiceInfo Info;
+
+		if (!pAnalyzer->GetServiceInfo(i, &Info))
+			continue;
+
+		MergedServiceInfo &Service = MapService(ServiceList, Info.ServiceID);
+
+		if (!Info.ProviderName.empty())
+			Service.ProviderName = Info.ProviderName;
+		if (!Info.ServiceName.empty())
+			Service.ServiceName = Info.ServiceName;
+		if (Info.ServiceType != SERVICE_TYPE_INVALID)
+			Service.ServiceType = Info.ServiceType;
+	}
+}
+
+
+void ParallelTSFileAnalyzer::PSICollector::OnCATUpdated(AnalyzerFilter *pAnalyzer)
+{
+	AnalyzerFilter::EMMPIDList List;
+
+	if (pAnalyzer->GetEMMPIDList(&List)) {
+		for (const uint16_t PID : List)
+			MergeUnique(EMMPIDList, PID);
+	}
+}
+
+
+}	// namespace LibISDB
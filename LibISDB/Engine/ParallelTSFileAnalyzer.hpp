@@ -0,0 +1,164 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   ParallelTSFileAnalyzer.hpp
+ @brief  TS ファイルの並列解析
+ @author DBCTRADO
+*/
+
+
+#ifndef LIBISDB_PARALLEL_TS_FILE_ANALYZER_H
+#define LIBISDB_PARALLEL_TS_FILE_ANALYZER_H
+
+
+#include "../Base/ObjectBase.hpp"
+#include "../Base/Stream.hpp"
+#include "../Filters/TSPacketParserFilter.hpp"
+#include "../Filters/AnalyzerFilter.hpp"
+#include "../Filters/EPGDatabaseFilter.hpp"
+#include "../EPG/EPGDatabase.hpp"
+#include <vector>
+#include <memory>
+#include <functional>
+
+
+namespace LibISDB
+{
+
+	/**
+		TS ファイル並列解析クラス
+
+		ファイルをバイト範囲に分割し、範囲毎に独立して解析する。
+		範囲の境界をまたぐ PSI/SI のセクションは、どちらの範囲でも取得されない。
+	*/
+	class ParallelTSFileAnalyzer
+		: public ObjectBase
+	{
+	public:
+		typedef TSPacketParserFilter::PacketCountInfo PacketCountInfo;
+		typedef std::function<std::unique_ptr<AnalyzerFilter::EventListener>(size_t RangeIndex)> AnalyzerEventListenerFactory;
+
+		static constexpr unsigned long long DEFAULT_MIN_RANGE_SIZE = 64 * 1024 * 1024;
+		static constexpr size_t READ_SIZE = 1024 * TS_PACKET_SIZE;
+		static constexpr size_t RESYNC_SEARCH_SIZE = 64 * TS_PACKET_SIZE;
+
+		struct RangeInfo {
+			unsigned long long Begin;
+			unsigned long long End;
+		};
+
+		/** 全範囲を統合したサービスの情報 */
+		struct MergedServiceInfo {
+			uint16_t ServiceID = SERVICE_ID_INVALID;
+			std::vector<uint16_t> PMTPIDList;                 /**< 全ての PMT の PID */
+			std::vector<uint16_t> PCRPIDList;                 /**< 全ての PCR の PID */
+			std::vector<AnalyzerFilter::ECMInfo> ECMList;    /**< 全ての ECM */
+			AnalyzerFilter::ESInfoList ESList;                /**< 全ての ES (PID と stream_type の組毎) */
+			String ProviderName;                              /**< 最後に取得された事業者名 */
+			String ServiceName;                               /**< 最後に取得されたサービス名 */
+			uint8_t ServiceType = SERVICE_TYPE_INVALID;       /**< 最後に取得されたサービス形式種別 */
+		};
+
+		typedef std::vector<MergedServiceInfo> MergedServiceList;
+
+		ParallelTSFileAnalyzer() noexcept;
+		~ParallelTSFileAnalyzer();
+
+	// ObjectBase
+		const CharType * GetObjectName() const noexcept override { return LIBISDB_STR("ParallelTSFileAnalyzer"); }
+
+	// ParallelTSFileAnalyzer
+		bool Analyze(const String &FileName);
+		void Clear();
+
+		bool SetThreadCount(int Count);
+		int GetThreadCount() const noexcept { return m_ThreadCount; }
+		bool SetMinRangeSize(unsigned long long Size);
+		unsigned long long GetMinRangeSize() const noexcept { return m_MinRangeSize; }
+		void SetEPGDatabaseEnabled(bool Enable);
+		bool GetEPGDatabaseEnabled() const noexcept { return m_EPGDatabaseEnabled; }
+		void SetAnalyzerEventListenerFactory(const AnalyzerEventListenerFactory &Factory);
+
+		size_t GetRangeCount() const noexcept { return m_RangeList.size(); }
+		bool GetRangeInfo(size_t Index, RangeInfo *pInfo) const;
+		AnalyzerFilter * GetAnalyzer(size_t Index) const;
+		AnalyzerFilter::EventListener * GetAnalyzerEventListener(size_t Index) const;
+		EPGDatabase * GetEPGDatabase(size_t Index) const;
+		bool MergeEPGDatabase(EPGDatabase *pDatabase) const;
+		const MergedServiceList & GetMergedServiceList() const noexcept { return m_MergedServiceList; }
+		const AnalyzerFilter::EMMPIDList & GetMergedEMMPIDList() const noexcept { return m_MergedEMMPIDList; }
+
+		unsigned long long GetTotalInputBytes() const noexcept { return m_TotalInputBytes; }
+		PacketCountInfo GetTotalPacketCount() const noexcept { return m_TotalPacketCount; }
+		PacketCountInfo GetTotalPacketCount(uint16_t PID) const;
+
+	private:
+		/** 範囲内で取得された PSI/SI の情報を蓄積する */
+		class PSICollector
+			: public AnalyzerFilter::EventListener
+		{
+		public:
+			MergedServiceList ServiceList;
+			AnalyzerFilter::EMMPIDList EMMPIDList;
+
+		private:
+			void OnPMTUpdated(AnalyzerFilter *pAnalyzer, uint16_t ServiceID) override;
+			void OnSDTUpdated(AnalyzerFilter *pAnalyzer) override;
+			void OnCATUpdated(AnalyzerFilter *pAnalyzer) override;
+		};
+
+		struct RangeContext {
+			RangeInfo Range;
+			std::unique_ptr<TSPacketParserFilter> Parser;
+			std::unique_ptr<AnalyzerFilter> Analyzer;
+			std::unique_ptr<EPGDatabase> Database;
+			std::unique_ptr<EPGDatabaseFilter> EPGFilter;
+			std::unique_ptr<AnalyzerFilter::EventListener> Listener;
+			PSICollector Collector;
+			bool Succeeded = false;
+		};
+
+		bool SplitRanges(const String &FileName);
+		unsigned long long FindPacketBoundary(Stream *pStream, unsigned long long Pos);
+		void AnalyzeRange(const String &FileName, RangeContext &Context);
+		void MergeResults();
+		static FileStreamBase * OpenStream(const String &FileName);
+		static MergedServiceInfo & MapService(MergedServiceList &List, uint16_t ServiceID);
+		static void MergeService(MergedServiceInfo &Dst, const MergedServiceInfo &Src);
+		static void MergeES(AnalyzerFilter::ESInfoList &List, const AnalyzerFilter::ESInfo &ES);
+		template<typename T> static void MergeUnique(std::vector<T> &List, const T &Value);
+
+		int m_ThreadCount;
+		unsigned long long m_MinRangeSize;
+		bool m_EPGDatabaseEnabled;
+		AnalyzerEventListenerFactory m_AnalyzerEventListenerFactory;
+
+		std::vector<RangeContext> m_RangeList;
+		unsigned long long m_TotalInputBytes;
+		PacketCountInfo m_TotalPacketCount;
+		std::vector<PacketCountInfo> m_PIDPacketCount;
+		MergedServiceList m_MergedServiceList;
+		AnalyzerFilter::EMMPIDList m_MergedEMMPIDList;
+	};
+
+}	// namespace LibISDB
+
+
+#endif	// ifndef LIBISDB_PARALLEL_TS_FILE_ANALYZER_H
@@ -26,6 +26,7 @@
 
 #include "../LibISDBPrivate.hpp"
 #include "TSEngine.hpp"
+#include <algorithm>
 #include "../Base/DebugDef.hpp"
 
 
@@ -41,6 +42,7 @@ TSEngine::TSEngine() noexcept
 
 	, m_CurTransportStreamID(TRANSPORT_STREAM_ID_INVALID)
 	, m_CurServiceID(SERVICE_ID_INVALID)
+	, m_PATSnapshotVersion(0)
 
 	, m_VideoStreamType(STREAM_TYPE_UNINITIALIZED)
 	, m_AudioStreamType(STREAM_TYPE_UNINITIALIZED)
@@ -603,6 +605,9 @@ void TSEngine::SetLogger(Logger *pLogger)
 void TSEngine::OnGraphReset(SourceFilter *pSource)
 {
 	ResetStatus();
+
+	// チャンネル変更後のリセットで、PAT を待たずにキャッシュからサービス情報を構築する
+	LoadSICache();
 }
 
 
@@ -622,6 +627,9 @@ void TSEngine::OnPATUpdated(AnalyzerFilter *pAnalyzer)
 	BlockLock Lock(m_EngineLock);
 	const uint16_t TransportStreamID = pAnalyzer->GetTransportStreamID();
 
+	// 続けて通知される PAT による変更ではサービスを選択し直さない
+	m_PATSnapshotVersion = pAnalyzer->GetSnapshotVersion();
+
 	if (m_CurTransportStreamID != TransportStreamID) {
 		// ストリームIDが変わっているなら初期化
 		LIBISDB_TRACE(LIBISDB_STR("Stream changed ({:04X} <- {:04X})\n"), TransportStreamID, m_CurTransportStreamID);
@@ -662,82 +670,158 @@ void TSEngine::OnPATUpdated(AnalyzerFilter *pAnalyzer)
 			SetAudioPID(PID_INVALID, true);
 		}
 	} else {
-		bool SetService = true, OneSeg = false;
-		uint16_t ServiceID = SERVICE_ID_INVALID;
+		ReselectService(pAnalyzer);
+	}
+}
 
-		if (m_ServiceSel.OneSegSelect == OneSegSelectType::HighPriority) {
-			// ワンセグ優先
-			uint16_t SID;
-			if (m_ServiceSel.PreferredServiceIndex >= 0) {
-				SID = pAnalyzer->Get1SegServiceIDByIndex(m_ServiceSel.PreferredServiceIndex);
-				if (SID != SERVICE_ID_INVALID) {
-					OneSeg = true;
-					if (pAnalyzer->IsServicePMTAcquired(pAnalyzer->GetServiceIndexByID(SID))) {
-						ServiceID = SID;
-					}
-				}
-			}
-			if ((ServiceID == SERVICE_ID_INVALID)
-					&& ((SID = pAnalyzer->GetFirst1SegServiceID()) != SERVICE_ID_INVALID)) {
+
+void TSEngine::OnServiceListChanged(AnalyzerFilter *pAnalyzer, const AnalyzerFilter::ServiceChangeList &ChangeList)
+{
+	// サービスの選択に影響する変更
+	constexpr AnalyzerFilter::ServiceChangeFlag SelectionFlags =
+		AnalyzerFilter::ServiceChangeFlag::Added
+		| AnalyzerFilter::ServiceChangeFlag::Removed
+		| AnalyzerFilter::ServiceChangeFlag::PMTPID
+		| AnalyzerFilter::ServiceChangeFlag::PMTAcquired
+		| AnalyzerFilter::ServiceChangeFlag::ES
+		| AnalyzerFilter::ServiceChangeFlag::PCRPID;
+	// 選択中のサービスでは ECM の変更も各フィルタに反映させる
+	constexpr AnalyzerFilter::ServiceChangeFlag CurServiceFlags =
+		SelectionFlags | AnalyzerFilter::ServiceChangeFlag::ECM;
+
+	if (std::none_of(
+			ChangeList.begin(), ChangeList.end(),
+			[](const AnalyzerFilter::ServiceChangeInfo &Change) -> bool {
+				return !!(Change.Flags & CurServiceFlags);
+			}))
+		return;
+
+	BlockLock Lock(m_EngineLock);
+
+	// PAT による変更は OnPATUpdated() で処理済み
+	if (pAnalyzer->GetSnapshotVersion() == m_PATSnapshotVersion)
+		return;
+
+	const bool IsCurServiceChanged = std::any_of(
+		ChangeList.begin(), ChangeList.end(),
+		[this](const AnalyzerFilter::ServiceChangeInfo &Change) -> bool {
+			return (Change.ServiceID == m_CurServiceID) && !!(Change.Flags & CurServiceFlags);
+		});
+
+	// 選択中のサービスが確定していて、そのサービスに変更がなければ選択し直す必要はない
+	if ((m_ServiceSel.OneSegSelect != OneSegSelectType::HighPriority)
+			&& (m_CurServiceID != SERVICE_ID_INVALID)
+			&& ((m_ServiceSel.ServiceID == SERVICE_ID_INVALID) || (m_ServiceSel.ServiceID == m_CurServiceID))
+			&& !IsCurServiceChanged)
+		return;
+
+	if (!IsCurServiceChanged
+			&& std::none_of(
+				ChangeList.begin(), ChangeList.end(),
+				[](const AnalyzerFilter::ServiceChangeInfo &Change) -> bool {
+					return !!(Change.Flags & SelectionFlags);
+				}))
+		return;
+
+	ReselectService(pAnalyzer);
+}
+
+
+void TSEngine::ReselectService(AnalyzerFilter *pAnalyzer)
+{
+	// m_EngineLock がロックされた状態で呼ばれる
+
+	bool SetService = true, OneSeg = false;
+	uint16_t ServiceID = SERVICE_ID_INVALID;
+
+	if (m_ServiceSel.OneSegSelect == OneSegSelectType::HighPriority) {
+		// ワンセグ優先
+		uint16_t SID;
+		if (m_ServiceSel.PreferredServiceIndex >= 0) {
+			SID = pAnalyzer->Get1SegServiceIDByIndex(m_ServiceSel.PreferredServiceIndex);
+			if (SID != SERVICE_ID_INVALID) {
 				OneSeg = true;
 				if (pAnalyzer->IsServicePMTAcquired(pAnalyzer->GetServiceIndexByID(SID))) {
 					ServiceID = SID;
-				} else {
-					SetService = false;
 				}
 			}
 		}
-
-		if (!OneSeg && (m_ServiceSel.ServiceID != SERVICE_ID_INVALID)) {
-			const int ServiceIndex = pAnalyzer->GetServiceIndexByID(m_ServiceSel.ServiceID);
-			if (ServiceIndex < 0) {
-				LIBISDB_TRACE(LIBISDB_STR("Specified service_id {:04X} not found in PAT\n"), m_ServiceSel.ServiceID);
-				if (((m_CurServiceID == SERVICE_ID_INVALID) && !m_ServiceSel.FollowViewableService)
-						|| (GetSelectableServiceCount() == 0)) {
-					SetService = false;
-				}
+		if ((ServiceID == SERVICE_ID_INVALID)
+				&& ((SID = pAnalyzer->GetFirst1SegServiceID()) != SERVICE_ID_INVALID)) {
+			OneSeg = true;
+			if (pAnalyzer->IsServicePMTAcquired(pAnalyzer->GetServiceIndexByID(SID))) {
+				ServiceID = SID;
 			} else {
-				if (GetSelectableServiceIndexByID(m_ServiceSel.ServiceID) >= 0) {
-					ServiceID = m_ServiceSel.ServiceID;
-				} else if (((m_CurServiceID == SERVICE_ID_INVALID) && !m_ServiceSel.FollowViewableService)
-						|| !pAnalyzer->IsServicePMTAcquired(ServiceIndex)) {
-					// サービスはPATにあるが、まだPMTが来ていない
-					SetService = false;
-				}
+				SetService = false;
 			}
 		}
+	}
 
-		if (SetService && (ServiceID == SERVICE_ID_INVALID) && (m_CurServiceID != SERVICE_ID_INVALID)) {
-			const int ServiceIndex = pAnalyzer->GetServiceIndexByID(m_CurServiceID);
-			if (ServiceIndex < 0) {
-				// サービスがPATにない
-				LIBISDB_TRACE(LIBISDB_STR("Current service_id {:04X} not found in PAT\n"), m_CurServiceID);
-				if (m_ServiceSel.FollowViewableService
-						&& (GetSelectableServiceCount() > 0)) {
-					m_CurServiceID = SERVICE_ID_INVALID;
-				} else {
-					// まだ視聴可能なサービスのPMTが一つも来ていない場合は保留
-					SetService = false;
-				}
-			} else {
-				if (GetSelectableServiceIndexByID(m_CurServiceID) >= 0) {
-					ServiceID = m_CurServiceID;
-				} else if (!m_ServiceSel.FollowViewableService
-						|| !pAnalyzer->IsServicePMTAcquired(ServiceIndex)) {
-					SetService = false;
-				}
+	if (!OneSeg && (m_ServiceSel.ServiceID != SERVICE_ID_INVALID)) {
+		const int ServiceIndex = pAnalyzer->GetServiceIndexByID(m_ServiceSel.ServiceID);
+		if (ServiceIndex < 0) {
+			LIBISDB_TRACE(LIBISDB_STR("Specified service_id {:04X} not found in PAT\n"), m_ServiceSel.ServiceID);
+			if (((m_CurServiceID == SERVICE_ID_INVALID) && !m_ServiceSel.FollowViewableService)
+					|| (GetSelectableServiceCount() == 0)) {
+				SetService = false;
+			}
+		} else {
+			if (GetSelectableServiceIndexByID(m_ServiceSel.ServiceID) >= 0) {
+				ServiceID = m_ServiceSel.ServiceID;
+			} else if (((m_CurServiceID == SERVICE_ID_INVALID) && !m_ServiceSel.FollowViewableService)
+					|| !pAnalyzer->IsServicePMTAcquired(ServiceIndex)) {
+				// サービスはPATにあるが、まだPMTが来ていない
+				SetService = false;
 			}
 		}
+	}
 
-		if (SetService)
-			SelectService(ServiceID, m_ServiceSel.OneSegSelect == OneSegSelectType::Refuse);
+	if (SetService && (ServiceID == SERVICE_ID_INVALID) && (m_CurServiceID != SERVICE_ID_INVALID)) {
+		const int ServiceIndex = pAnalyzer->GetServiceIndexByID(m_CurServiceID);
+		if (ServiceIndex < 0) {
+			// サービスがPATにない
+			LIBISDB_TRACE(LIBISDB_STR("Current service_id {:04X} not found in PAT\n"), m_CurServiceID);
+			if (m_ServiceSel.FollowViewableService
+					&& (GetSelectableServiceCount() > 0)) {
+				m_CurServiceID = SERVICE_ID_INVALID;
+			} else {
+				// まだ視聴可能なサービスのPMTが一つも来ていない場合は保留
+				SetService = false;
+			}
+		} else {
+			if (GetSelectableServiceIndexByID(m_CurServiceID) >= 0) {
+				ServiceID = m_CurServiceID;
+			} else if (!m_ServiceSel.FollowViewableService
+					|| !pAnalyzer->IsServicePMTAcquired(ServiceIndex)) {
+				SetService = false;
+			}
+		}
 	}
+
+	if (SetService)
+		SelectService(ServiceID, m_ServiceSel.OneSegSelect == OneSegSelectType::Refuse);
 }
 
 
-void TSEngine::OnPMTUpdated(AnalyzerFilter *pAnalyzer, uint16_t ServiceID)
+bool TSEngine::LoadSICache()
 {
-	OnPATUpdated(pAnalyzer);
+	uint16_t NetworkID, TransportStreamID;
+
+	{
+		BlockLock Lock(m_EngineLock);
+
+		if ((m_pAnalyzer == nullptr) || (m_pAnalyzer->GetSICache() == nullptr))
+			return false;
+
+		NetworkID = m_ServiceSel.NetworkID;
+		TransportStreamID = m_ServiceSel.TransportStreamID;
+	}
+
+	if ((NetworkID == NETWORK_ID_INVALID) || (TransportStreamID == TRANSPORT_STREAM_ID_INVALID))
+		return false;
+
+	// 読み込み中に OnPATUpdated() などが呼ばれるので、m_EngineLock をロックせずに呼ぶ
+	return m_pAnalyzer->LoadSICache(NetworkID, TransportStreamID);
 }
 
 
@@ -756,6 +840,7 @@ void TSEngine::ResetStatus()
 {
 	m_CurTransportStreamID = TRANSPORT_STREAM_ID_INVALID;
 	m_CurServiceID = SERVICE_ID_INVALID;
+	m_PATSnapshotVersion = 0;
 }
 
 
@@ -55,6 +55,8 @@ namespace LibISDB
 			bool FollowViewableService = false;
 			OneSegSelectType OneSegSelect = OneSegSelectType::LowPriority;
 			int PreferredServiceIndex = -1;
+			uint16_t NetworkID = NETWORK_ID_INVALID;                 /**< SI キャッシュから読み込むストリームの network_id */
+			uint16_t TransportStreamID = TRANSPORT_STREAM_ID_INVALID; /**< SI キャッシュから読み込むストリームの transport_stream_id */
 
 			void Reset() noexcept { *this = ServiceSelectInfo(); }
 		};
@@ -117,12 +119,14 @@ namespace LibISDB
 
 	// AnalyzerFilter::EventListener
 		void OnPATUpdated(AnalyzerFilter *pAnalyzer) override;
-		void OnPMTUpdated(AnalyzerFilter *pAnalyzer, uint16_t ServiceID) override;
+		void OnServiceListChanged(AnalyzerFilter *pAnalyzer, const AnalyzerFilter::ServiceChangeList &ChangeList) override;
 		void OnEITUpdated(AnalyzerFilter *pAnalyzer) override;
 
 	// TSEngine
 		bool SelectService(uint16_t ServiceID, bool No1Seg = false);
+		void ReselectService(AnalyzerFilter *pAnalyzer);
 		void ResetStatus();
+		bool LoadSICache();
 		void SetVideoPID(uint16_t PID, bool ServiceChanged);
 		void SetAudioPID(uint16_t PID, bool ServiceChanged);
 
@@ -143,6 +147,7 @@ namespace LibISDB
 
 		uint16_t m_CurTransportStreamID;
 		uint16_t m_CurServiceID;
+		uint64_t m_PATSnapshotVersion;
 
 		ServiceSelectInfo m_ServiceSel;
 		ServiceSelectInfo m_SetChannelServiceSel;
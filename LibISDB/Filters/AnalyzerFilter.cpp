@@ -27,6 +27,8 @@
 #include "../LibISDBPrivate.hpp"
 #include "AnalyzerFilter.hpp"
 #include "../Utilities/Sort.hpp"
+#include <algorithm>
+#include <functional>
 #include "../Base/DebugDef.hpp"
 
 
@@ -35,6 +37,8 @@ namespace LibISDB
 
 
 AnalyzerFilter::AnalyzerFilter()
+	: m_SnapshotVersion(0)
+	, m_pSICache(nullptr)
 {
 	Reset();
 }
@@ -67,6 +71,17 @@ void AnalyzerFilter::Reset()
 	m_NITInfo.Reset();
 	m_EMMPIDList.clear();
 
+	m_SICacheSections.clear();
+	m_SICacheLoaded = false;
+	m_IsLoadingSICache = false;
+
+	// 実行中のスキャンは継続し、それまでの取得状況のみ破棄する
+	const ScanTable ScanTables = m_ScanCompleted ? ScanTable::None : m_ScanResult.RequiredTables;
+	m_ScanResult = ScanResult();
+	m_ScanResult.RequiredTables = ScanTables;
+	m_ScanCompleted = false;
+	m_ScanStartTime = m_ScanClock.Get();
+
 	// PATテーブルPIDマップ追加
 	m_PIDMapManager.MapTarget(PID_PAT, PSITableBase::CreateWithHandler<PATTable>(&AnalyzerFilter::OnPATSection, this));
 	// NITテーブルPIDマップ追加
@@ -87,6 +102,9 @@ void AnalyzerFilter::Reset()
 	m_PIDMapManager.MapTarget(PID_CAT, PSITableBase::CreateWithHandler<CATTable>(&AnalyzerFilter::OnCATSection, this));
 	// TOTテーブルPIDマップ追加
 	m_PIDMapManager.MapTarget(PID_TOT, PSITableBase::CreateWithHandler<TOTTable>(&AnalyzerFilter::OnTOTSection, this));
+
+	PublishSnapshot(SnapshotPart::All);
+	m_ServiceChangeList.clear();
 }
 
 
@@ -666,9 +684,7 @@ bool AnalyzerFilter::GetNetworkName(ReturnArg<String> Name) const
 	if (!Name)
 		return false;
 
-	BlockLock Lock(m_FilterLock);
-
-	*Name = m_NITInfo.NetworkName;
+	*Name = GetSnapshot()->NetworkName;
 
 	return true;
 }
@@ -676,9 +692,7 @@ bool AnalyzerFilter::GetNetworkName(ReturnArg<String> Name) const
 
 uint8_t AnalyzerFilter::GetRemoteControlKeyID() const
 {
-	BlockLock Lock(m_FilterLock);
-
-	return m_NITInfo.RemoteControlKeyID;
+	return GetSnapshot()->RemoteControlKeyID;
 }
 
 
@@ -687,9 +701,7 @@ bool AnalyzerFilter::GetTSName(ReturnArg<String> Name) const
 	if (!Name)
 		return false;
 
-	BlockLock Lock(m_FilterLock);
-
-	*Name = m_NITInfo.TSName;
+	*Name = GetSnapshot()->TSName;
 
 	return true;
 }
@@ -700,9 +712,8 @@ bool AnalyzerFilter::GetServiceList(ReturnArg<ServiceList> List) const
 	if (!List)
 		return false;
 
-	BlockLock Lock(m_FilterLock);
-
-	*List = m_ServiceList;
+	// ストリームの処理を止めないように、スナップショットからコピーする
+	*List = *GetSnapshot()->Services;
 
 	return true;
 }
@@ -713,9 +724,7 @@ bool AnalyzerFilter::GetSDTServiceList(ReturnArg<SDTServiceList> List) const
 	if (!List)
 		return false;
 
-	BlockLock Lock(m_FilterLock);
-
-	*List = m_SDTServiceList;
+	*List = *GetSnapshot()->SDTServices;
 
 	return true;
 }
@@ -726,12 +735,12 @@ bool AnalyzerFilter::GetSDTStreamList(ReturnArg<SDTStreamList> List) const
 	if (!List)
 		return false;
 
-	BlockLock Lock(m_FilterLock);
+	const SnapshotPtr Snap = GetSnapshot();
 
 	List->clear();
-	List->reserve(m_SDTStreamMap.size());
+	List->reserve(Snap->SDTStreams->size());
 
-	for (auto const &e : m_SDTStreamMap)
+	for (auto const &e : *Snap->SDTStreams)
 		List->push_back(e.second);
 
 	return true;
@@ -743,9 +752,7 @@ bool AnalyzerFilter::GetNetworkStreamList(ReturnArg<NetworkStreamList> List) con
 	if (!List)
 		return false;
 
-	BlockLock Lock(m_FilterLock);
-
-	*List = m_NetworkStreamList;
+	*List = *GetSnapshot()->NetworkStreams;
 
 	return true;
 }
@@ -1489,41 +1496,25 @@ const DescriptorBlock *AnalyzerFilter::GetLEITItemDesc(int ServiceIndex, bool Ne
 
 const ComponentDescriptor *AnalyzerFilter::GetComponentDescByComponentTag(const DescriptorBlock *pDescBlock, uint8_t ComponentTag) const
 {
-	if (pDescBlock != nullptr) {
-		for (int i = 0; i < pDescBlock->GetDescriptorCount(); i++) {
-			const DescriptorBase *pDesc = pDescBlock->GetDescriptorByIndex(i);
-
-			if (pDesc->GetTag() == ComponentDescriptor::TAG) {
-				const ComponentDescriptor *pComponentDesc = dynamic_cast<const ComponentDescriptor *>(pDesc);
-
-				if ((pComponentDesc != nullptr)
-						&& (pComponentDesc->GetComponentTag() == ComponentTag))
-					return pComponentDesc;
-			}
-		}
-	}
+	if (pDescBlock == nullptr)
+		return nullptr;
 
-	return nullptr;
+	return pDescBlock->FindDescriptor<ComponentDescriptor>(
+		[ComponentTag](const ComponentDescriptor *pDesc) -> bool {
+			return pDesc->GetComponentTag() == ComponentTag;
+		});
 }
 
 
 const AudioComponentDescriptor *AnalyzerFilter::GetAudioComponentDescByComponentTag(const DescriptorBlock *pDescBlock, uint8_t ComponentTag) const
 {
-	if (pDescBlock != nullptr) {
-		for (int i = 0; i < pDescBlock->GetDescriptorCount(); i++) {
-			const DescriptorBase *pDesc = pDescBlock->GetDescriptorByIndex(i);
-
-			if (pDesc->GetTag() == AudioComponentDescriptor::TAG) {
-				const AudioComponentDescriptor *pAudioDesc = dynamic_cast<const AudioComponentDescriptor *>(pDesc);
-
-				if ((pAudioDesc != nullptr)
-						&& (pAudioDesc->GetComponentTag() == ComponentTag))
-					return pAudioDesc;
-			}
-		}
-	}
+	if (pDescBlock == nullptr)
+		return nullptr;
 
-	return nullptr;
+	return pDescBlock->FindDescriptor<AudioComponentDescriptor>(
+		[ComponentTag](const AudioComponentDescriptor *pDesc) -> bool {
+			return pDesc->GetComponentTag() == ComponentTag;
+		});
 }
 
 
@@ -1832,9 +1823,163 @@ bool AnalyzerFilter::GetEMMPIDList(ReturnArg<EMMPIDList> List) const
 	if (!List)
 		return false;
 
+	*List = *GetSnapshot()->EMMPIDs;
+
+	return true;
+}
+
+
+AnalyzerFilter::SnapshotPtr AnalyzerFilter::GetSnapshot() const
+{
+	return m_Snapshot.load(std::memory_order_acquire);
+}
+
+
+uint64_t AnalyzerFilter::GetSnapshotVersion() const noexcept
+{
+	return m_SnapshotVersion.load(std::memory_order_acquire);
+}
+
+
+void AnalyzerFilter::SetSICache(SICache *pCache)
+{
+	BlockLock Lock(m_FilterLock);
+
+	m_pSICache = pCache;
+}
+
+
+bool AnalyzerFilter::LoadSICache(uint16_t NetworkID, uint16_t TransportStreamID)
+{
+	BlockLock Lock(m_FilterLock);
+
+	// 既に PAT を受信している場合はキャッシュを使わない
+	if ((m_pSICache == nullptr) || m_PATUpdated)
+		return false;
+
+	SICache::SectionList SectionList;
+	if (!m_pSICache->GetSections(NetworkID, TransportStreamID, &SectionList))
+		return false;
+	if (std::none_of(
+			SectionList.begin(), SectionList.end(),
+			[](const SICache::SectionData &Data) -> bool { return Data.PID == PID_PAT; }))
+		return false;
+
+	LIBISDB_TRACE(
+		LIBISDB_STR("AnalyzerFilter::LoadSICache() : network_id {:04X} / transport_stream_id {:04X}\n"),
+		NetworkID, TransportStreamID);
+
+	// 通常の受信時と同じハンドラにセクションを渡して各情報を構築する
+	PATTable PAT;
+	SDTTableSet SDT;
+	NITMultiTable NIT;
+
+	PAT.SetSectionHandler(PSITableBase::BindHandler(&AnalyzerFilter::OnPATSection, this));
+	SDT.SetSectionHandler(PSITableBase::BindHandler(&AnalyzerFilter::OnSDTSection, this));
+	NIT.SetSectionHandler(PSITableBase::BindHandler(&AnalyzerFilter::OnNITSection, this));
+
+	PSISection Section;
+
+	const auto StoreSection =
+		[&Section](PSITableBase *pTable, const SICache::SectionData &Data) {
+			Section.SetData(Data.Data.data(), Data.Data.size());
+			if (Section.ParseHeader())
+				pTable->StoreSection(&Section);
+		};
+
+	m_IsLoadingSICache = true;
+	m_SICacheLoaded = true;
+
+	// PAT -> PMT -> SDT -> NIT の順に処理する
+	for (const SICache::SectionData &Data : SectionList) {
+		if (Data.PID == PID_PAT)
+			StoreSection(&PAT, Data);
+	}
+
+	for (const SICache::SectionData &Data : SectionList) {
+		if ((Data.PID != PID_PAT) && (Data.PID != PID_SDT) && (Data.PID != PID_NIT)) {
+			PMTTable PMT;
+			PMT.SetSectionHandler(PSITableBase::BindHandler(&AnalyzerFilter::OnPMTSection, this));
+			StoreSection(&PMT, Data);
+		}
+	}
+
+	for (const SICache::SectionData &Data : SectionList) {
+		if (Data.PID == PID_SDT)
+			StoreSection(&SDT, Data);
+	}
+
+	for (const SICache::SectionData &Data : SectionList) {
+		if (Data.PID == PID_NIT)
+			StoreSection(&NIT, Data);
+	}
+
+	m_IsLoadingSICache = false;
+
+	return true;
+}
+
+
+bool AnalyzerFilter::IsSICacheLoaded() const
+{
+	return GetSnapshot()->SICacheLoaded;
+}
+
+
+bool AnalyzerFilter::StartScan(ScanTable Tables)
+{
+	if (Tables == ScanTable::None)
+		return false;
+
+	BlockLock Lock(m_FilterLock);
+
+	// 他 TS の SDT が揃ったかは NIT が無いと判定できない
+	if (!!(Tables & ScanTable::SDTOther))
+		Tables |= ScanTable::NITActual;
+
+	m_ScanStartTime = m_ScanClock.Get();
+	m_ScanResult = ScanResult();
+	m_ScanResult.RequiredTables = Tables;
+	m_ScanCompleted = false;
+
+	LIBISDB_TRACE(LIBISDB_STR("AnalyzerFilter::StartScan() : {:#x}\n"), static_cast<unsigned int>(Tables));
+
+	return true;
+}
+
+
+void AnalyzerFilter::StopScan()
+{
+	BlockLock Lock(m_FilterLock);
+
+	m_ScanResult.RequiredTables = ScanTable::None;
+}
+
+
+bool AnalyzerFilter::IsScanning() const
+{
+	BlockLock Lock(m_FilterLock);
+
+	return (m_ScanResult.RequiredTables != ScanTable::None) && !m_ScanCompleted;
+}
+
+
+bool AnalyzerFilter::IsScanCompleted() const
+{
+	BlockLock Lock(m_FilterLock);
+
+	return m_ScanCompleted;
+}
+
+
+bool AnalyzerFilter::GetScanResult(ReturnArg<ScanResult> Result) const
+{
+	if (!Result)
+		return false;
+
 	BlockLock Lock(m_FilterLock);
 
-	*List = m_EMMPIDList;
+	*Result = m_ScanResult;
 
 	return true;
 }
@@ -1862,11 +2007,15 @@ void AnalyzerFilter::OnPATSection(const PSITableBase *pTable, const PSISection *
 		return;
 
 	// ここで引っ掛かる場合、SDT と PAT で transport_stream_id が違っている
-	LIBISDB_ASSERT((m_TransportStreamID == TRANSPORT_STREAM_ID_INVALID) || (m_TransportStreamID == pPATTable->GetTransportStreamID()));
+	LIBISDB_ASSERT(m_SICacheLoaded || (m_TransportStreamID == TRANSPORT_STREAM_ID_INVALID) || (m_TransportStreamID == pPATTable->GetTransportStreamID()));
+
+	const bool IsSameStream = (m_TransportStreamID == pPATTable->GetTransportStreamID());
 
 	// トランスポートストリームID更新
 	m_TransportStreamID = pPATTable->GetTransportStreamID();
 
+	StoreSICacheSection(PID_PAT, pSection);
+
 	// 現 PMT/PCR の PID をアンマップする
 	for (auto const &e : m_ServiceList) {
 		m_PIDMapManager.UnmapTarget(e.PMTPID);
@@ -1875,29 +2024,47 @@ void AnalyzerFilter::OnPATSection(const PSITableBase *pTable, const PSISection *
 
 	// 新 PMT をストアする
 	const int ServiceCount = pPATTable->GetProgramCount();
+	ServiceList OldServiceList;
+	OldServiceList.swap(m_ServiceList);
 	m_ServiceList.resize(ServiceCount);
 
 	for (int i = 0; i < ServiceCount; i++) {
 		// サービスリスト更新
 		ServiceInfo &Info = m_ServiceList[i];
+		const uint16_t ServiceID = pPATTable->GetProgramNumber(i);
+		const uint16_t PMTPID = pPATTable->GetPMTPID(i);
+
+		// キャッシュから読み込まれた情報は PMT を受信するまで維持する
+		auto itOld = std::find_if(
+			OldServiceList.begin(), OldServiceList.end(),
+			[=](const ServiceInfo &Old) -> bool {
+				return Old.IsCached && (Old.ServiceID == ServiceID) && (Old.PMTPID == PMTPID);
+			});
 
-		Info.IsPMTAcquired = false;
-		Info.ServiceID = pPATTable->GetProgramNumber(i);
-		Info.PMTPID = pPATTable->GetPMTPID(i);
-		Info.ESList.clear();
-		Info.VideoESList.clear();
-		Info.AudioESList.clear();
-		Info.CaptionESList.clear();
-		Info.DataCarrouselESList.clear();
-		Info.OtherESList.clear();
-		Info.PCRPID = PID_INVALID;
-		Info.ECMList.clear();
-		Info.RunningStatus = 0xFF;
-		Info.FreeCAMode = false;
-		Info.ProviderName.clear();
-		Info.ServiceName.clear();
-		Info.ServiceType = SERVICE_TYPE_INVALID;
-		Info.LogoID = LOGO_ID_INVALID;
+		if (IsSameStream && (itOld != OldServiceList.end())) {
+			Info = std::move(*itOld);
+			if ((Info.PCRPID < 0x1FFF) && (m_PIDMapManager.GetMapTarget(Info.PCRPID) == nullptr))
+				m_PIDMapManager.MapTarget(Info.PCRPID, new PCRTable);
+		} else {
+			Info.IsPMTAcquired = false;
+			Info.ServiceID = ServiceID;
+			Info.PMTPID = PMTPID;
+			Info.ESList.clear();
+			Info.VideoESList.clear();
+			Info.AudioESList.clear();
+			Info.CaptionESList.clear();
+			Info.DataCarrouselESList.clear();
+			Info.OtherESList.clear();
+			Info.PCRPID = PID_INVALID;
+			Info.ECMList.clear();
+			Info.RunningStatus = 0xFF;
+			Info.FreeCAMode = false;
+			Info.ProviderName.clear();
+			Info.ServiceName.clear();
+			Info.ServiceType = SERVICE_TYPE_INVALID;
+			Info.LogoID = LOGO_ID_INVALID;
+			Info.IsCached = m_IsLoadingSICache;
+		}
 
 		// PMT の PID をマップ
 		m_PIDMapManager.MapTarget(
@@ -1905,6 +2072,8 @@ void AnalyzerFilter::OnPATSection(const PSITableBase *pTable, const PSISection *
 			PSITableBase::CreateWithHandler<PMTTable>(&AnalyzerFilter::OnPMTSection, this));
 	}
 
+	RemoveStaleSICacheSections();
+
 #ifdef LIBISDB_ENABLE_TRACE
 	LIBISDB_TRACE(LIBISDB_STR("transport_stream_id : {:04X}\n"), m_TransportStreamID);
 	for (size_t i = 0; i < m_ServiceList.size(); i++) {
@@ -1923,9 +2092,16 @@ void AnalyzerFilter::OnPATSection(const PSITableBase *pTable, const PSISection *
 
 	m_PATUpdated = true;
 
+	CommitSICache();
+
+	PublishSnapshot(SnapshotPart::Service | SnapshotPart::Event);
+
 	m_FilterLock.Unlock();
 	m_EventListenerList.CallEventListener(&EventListener::OnPATUpdated, this);
 	m_FilterLock.Lock();
+
+	NotifyServiceListChanged();
+	UpdateScanStatus(ScanTable::PAT);
 }
 
 
@@ -1980,6 +2156,8 @@ void AnalyzerFilter::OnPMTSection(const PSITableBase *pTable, const PSISection *
 		return;
 	ServiceInfo &Info = m_ServiceList[ServiceIndex];
 
+	StoreSICacheSection(Info.PMTPID, pSection);
+
 	// ESのPIDをストア
 	Info.ESList.clear();
 	Info.VideoESList.clear();
@@ -2061,6 +2239,7 @@ void AnalyzerFilter::OnPMTSection(const PSITableBase *pTable, const PSISection *
 	}
 
 	// ECM
+	Info.ECMList.clear();
 	if (const DescriptorBlock *pPMTDesc = pPMTTable->GetPMTDescriptorBlock(); pPMTDesc != nullptr) {
 		pPMTDesc->EnumDescriptors<CADescriptor>(
 			[&Info](const CADescriptor *pCADesc) {
@@ -2075,6 +2254,7 @@ void AnalyzerFilter::OnPMTSection(const PSITableBase *pTable, const PSISection *
 
 	// 更新済みマーク
 	Info.IsPMTAcquired = true;
+	Info.IsCached = m_IsLoadingSICache;
 
 	// SDTからサービス情報を取得
 	const SDTTableSet *pSDTTableSet = dynamic_cast<const SDTTableSet *>(m_PIDMapManager.GetMapTarget(PID_SDT));
@@ -2095,9 +2275,305 @@ void AnalyzerFilter::OnPMTSection(const PSITableBase *pTable, const PSISection *
 	}
 #endif
 
+	CommitSICache();
+
+	PublishSnapshot(SnapshotPart::Service);
+
 	m_FilterLock.Unlock();
 	m_EventListenerList.CallEventListener(&EventListener::OnPMTUpdated, this, ServiceID);
 	m_FilterLock.Lock();
+
+	NotifyServiceListChanged();
+	UpdateScanStatus(ScanTable::None);
+}
+
+
+void AnalyzerFilter::PublishSnapshot(SnapshotPart Parts, uint16_t EventServiceID)
+{
+	// 更新された部分のみ複製し、それ以外は前回のスナップショットと共有する
+	const SnapshotPtr Current = m_Snapshot.load(std::memory_order_relaxed);
+	std::shared_ptr<Snapshot> New = Current ? std::make_shared<Snapshot>(*Current) : std::make_shared<Snapshot>();
+
+	New->Version = m_SnapshotVersion.load(std::memory_order_relaxed) + 1;
+	New->TransportStreamID = m_TransportStreamID;
+	New->NetworkID = m_NetworkID;
+	New->PATUpdated = m_PATUpdated;
+	New->SDTUpdated = m_SDTUpdated;
+	New->NITUpdated = m_NITUpdated;
+	New->SICacheLoaded = m_SICacheLoaded;
+
+	if (!!(Parts & SnapshotPart::Service) || !New->Services) {
+		if (New->Services)
+			AddServiceChanges(*New->Services, m_ServiceList);
+		New->Services = std::make_shared<const ServiceList>(m_ServiceList);
+	}
+	if (!!(Parts & SnapshotPart::SDT) || !New->SDTServices) {
+		New->SDTServices = std::make_shared<const SDTServiceList>(m_SDTServiceList);
+		New->SDTStreams = std::make_shared<const SDTStreamMap>(m_SDTStreamMap);
+	}
+	if (!!(Parts & SnapshotPart::NIT) || !New->NetworkStreams) {
+		New->NetworkStreams = std::make_shared<const NetworkStreamList>(m_NetworkStreamList);
+		New->BroadcastingID = m_NITInfo.BroadcastingID;
+		New->RemoteControlKeyID = m_NITInfo.RemoteControlKeyID;
+		New->NetworkName = m_NITInfo.NetworkName;
+		New->TSName = m_NITInfo.TSName;
+	}
+	if (!!(Parts & SnapshotPart::EMM) || !New->EMMPIDs)
+		New->EMMPIDs = std::make_shared<const EMMPIDList>(m_EMMPIDList);
+
+#ifdef LIBISDB_ANALYZER_FILTER_EIT_SUPPORT
+	if (!!(Parts & SnapshotPart::Event) || !New->Events) {
+		std::shared_ptr<ServiceEventList> Events;
+
+		if ((EventServiceID != SERVICE_ID_INVALID)
+				&& New->Events && (New->Events->size() == m_ServiceList.size())) {
+			// 更新されたサービスの番組情報のみ取得し直し、それ以外は共有する
+			Events = std::make_shared<ServiceEventList>(*New->Events);
+			const int ServiceIndex = GetServiceIndexByID(EventServiceID);
+			if (ServiceIndex >= 0) {
+				std::shared_ptr<ServiceEventInfo> Info = std::make_shared<ServiceEventInfo>();
+				GetServiceEventInfo(ServiceIndex, Info.get());
+				(*Events)[ServiceIndex] = std::move(Info);
+			}
+		} else {
+			Events = std::make_shared<ServiceEventList>();
+			Events->reserve(m_ServiceList.size());
+			for (size_t i = 0; i < m_ServiceList.size(); i++) {
+				std::shared_ptr<ServiceEventInfo> Info = std::make_shared<ServiceEventInfo>();
+				GetServiceEventInfo(static_cast<int>(i), Info.get());
+				Events->push_back(std::move(Info));
+			}
+		}
+
+		New->Events = std::move(Events);
+	}
+#endif
+
+	const uint64_t Version = New->Version;
+	m_Snapshot.store(std::move(New), std::memory_order_release);
+	m_SnapshotVersion.store(Version, std::memory_order_release);
+}
+
+
+void AnalyzerFilter::AddServiceChanges(const ServiceList &OldList, const ServiceList &NewList)
+{
+	auto AddChange = [this](uint16_t ServiceID, ServiceChangeFlag Flags) {
+		for (ServiceChangeInfo &Change : m_ServiceChangeList) {
+			if (Change.ServiceID == ServiceID) {
+				Change.Flags |= Flags;
+				return;
+			}
+		}
+		m_ServiceChangeList.push_back(ServiceChangeInfo{ServiceID, Flags});
+	};
+
+	for (const ServiceInfo &NewInfo : NewList) {
+		auto it = std::find_if(
+			OldList.begin(), OldList.end(),
+			[&](const ServiceInfo &Info) -> bool { return Info.ServiceID == NewInfo.ServiceID; });
+		const ServiceChangeFlag Flags =
+			(it != OldList.end()) ? CompareServiceInfo(*it, NewInfo) : ServiceChangeFlag::Added;
+		if (Flags != ServiceChangeFlag::None)
+			AddChange(NewInfo.ServiceID, Flags);
+	}
+
+	for (const ServiceInfo &OldInfo : OldList) {
+		if (std::none_of(
+				NewList.begin(), NewList.end(),
+				[&](const ServiceInfo &Info) -> bool { return Info.ServiceID == OldInfo.ServiceID; }))
+			AddChange(OldInfo.ServiceID, ServiceChangeFlag::Removed);
+	}
+}
+
+
+void AnalyzerFilter::NotifyServiceListChanged()
+{
+	// m_FilterLock がロックされた状態で呼ばれる
+	if (m_ServiceChangeList.empty())
+		return;
+
+	ServiceChangeList ChangeList;
+	ChangeList.swap(m_ServiceChangeList);
+
+	m_FilterLock.Unlock();
+	m_EventListenerList.CallEventListener(&EventListener::OnServiceListChanged, this, std::cref(ChangeList));
+	m_FilterLock.Lock();
+}
+
+
+AnalyzerFilter::ServiceChangeFlag AnalyzerFilter::CompareServiceInfo(const ServiceInfo &OldInfo, const ServiceInfo &NewInfo)
+{
+	ServiceChangeFlag Flags = ServiceChangeFlag::None;
+
+	if (OldInfo.PMTPID != NewInfo.PMTPID)
+		Flags |= ServiceChangeFlag::PMTPID;
+	if (OldInfo.IsPMTAcquired != NewInfo.IsPMTAcquired)
+		Flags |= ServiceChangeFlag::PMTAcquired;
+	if (OldInfo.ESList != NewInfo.ESList)
+		Flags |= ServiceChangeFlag::ES;
+	if (OldInfo.PCRPID != NewInfo.PCRPID)
+		Flags |= ServiceChangeFlag::PCRPID;
+	if (OldInfo.ECMList != NewInfo.ECMList)
+		Flags |= ServiceChangeFlag::ECM;
+	if ((OldInfo.ServiceName != NewInfo.ServiceName) || (OldInfo.ProviderName != NewInfo.ProviderName))
+		Flags |= ServiceChangeFlag::Name;
+	if (OldInfo.ServiceType != NewInfo.ServiceType)
+		Flags |= ServiceChangeFlag::ServiceType;
+	if (OldInfo.LogoID != NewInfo.LogoID)
+		Flags |= ServiceChangeFlag::LogoID;
+	if ((OldInfo.RunningStatus != NewInfo.RunningStatus) || (OldInfo.FreeCAMode != NewInfo.FreeCAMode))
+		Flags |= ServiceChangeFlag::Status;
+
+	// キャッシュの内容が実際の内容と異なっていた
+	if (OldInfo.IsCached && !NewInfo.IsCached && (Flags != ServiceChangeFlag::None))
+		Flags |= ServiceChangeFlag::CacheMismatch;
+
+	return Flags;
+}
+
+
+#ifdef LIBISDB_ANALYZER_FILTER_EIT_SUPPORT
+void AnalyzerFilter::GetServiceEventInfo(int ServiceIndex, ServiceEventInfo *pInfo) const
+{
+	EventInfo Info;
+
+	pInfo->ServiceID = m_ServiceList[ServiceIndex].ServiceID;
+
+	if (GetEventInfo(ServiceIndex, &Info, true, false))
+		pInfo->Present = std::move(Info);
+	else
+		pInfo->Present.reset();
+
+	if (GetEventInfo(ServiceIndex, &Info, true, true))
+		pInfo->Following = std::move(Info);
+	else
+		pInfo->Following.reset();
+}
+#endif
+
+
+void AnalyzerFilter::StoreSICacheSection(uint16_t PID, const PSISection *pSection)
+{
+	if ((m_pSICache == nullptr) || (pSection == nullptr))
+		return;
+
+	const uint8_t *pData = pSection->GetData();
+	const size_t Size = pSection->GetSize();
+	if ((pData == nullptr) || (Size < 8))
+		return;
+
+	const uint8_t TableID = pSection->GetTableID();
+	const uint16_t Extension = pSection->GetTableIDExtension();
+	const uint8_t SectionNumber = pSection->GetSectionNumber();
+	const uint8_t VersionNumber = pSection->GetVersionNumber();
+
+	// 同じセクションを置き換え、バージョンの異なるセクションは削除する
+	SICache::SectionData *pEntry = nullptr;
+
+	for (auto it = m_SICacheSections.begin(); it != m_SICacheSections.end();) {
+		const std::vector<uint8_t> &Data = it->Data;
+
+		if ((it->PID == PID) && (Data[0] == TableID)
+				&& (Load16(&Data[3]) == Extension)) {
+			if (((Data[5] >> 1) & 0x1F) != VersionNumber) {
+				it = m_SICacheSections.erase(it);
+				continue;
+			}
+			if (Data[6] == SectionNumber)
+				pEntry = &*it;
+		}
+
+		++it;
+	}
+
+	if (pEntry == nullptr) {
+		pEntry = &m_SICacheSections.emplace_back();
+		pEntry->PID = PID;
+	}
+
+	pEntry->Data.assign(pData, pData + Size);
+}
+
+
+void AnalyzerFilter::RemoveStaleSICacheSections()
+{
+	// 現在の PAT に含まれない PMT と、他の TS の PAT を削除する
+	std::erase_if(
+		m_SICacheSections,
+		[this](const SICache::SectionData &Data) -> bool {
+			if (Data.PID == PID_PAT)
+				return Load16(&Data.Data[3]) != m_TransportStreamID;
+			if ((Data.PID == PID_SDT) || (Data.PID == PID_NIT))
+				return false;
+			return std::none_of(
+				m_ServiceList.begin(), m_ServiceList.end(),
+				[&Data](const ServiceInfo &Info) -> bool { return Info.PMTPID == Data.PID; });
+		});
+}
+
+
+void AnalyzerFilter::UpdateScanStatus(ScanTable Acquired)
+{
+	// m_FilterLock がロックされた状態で呼ばれる
+	// (キャッシュから読み込まれた情報は取得済みとして扱わない)
+	if ((m_ScanResult.RequiredTables == ScanTable::None) || m_ScanCompleted || m_IsLoadingSICache)
+		return;
+
+	// 全サービスの PMT
+	if (!!(m_ScanResult.RequiredTables & ScanTable::PMT) && m_PATUpdated
+			&& std::all_of(
+				m_ServiceList.begin(), m_ServiceList.end(),
+				[](const ServiceInfo &Info) -> bool { return Info.IsPMTAcquired && !Info.IsCached; }))
+		Acquired |= ScanTable::PMT;
+
+	// NIT に含まれる全 TS の SDT
+	if (!!(m_ScanResult.RequiredTables & ScanTable::SDTOther)
+			&& !!((m_ScanResult.AcquiredTables | Acquired) & ScanTable::NITActual)
+			&& std::all_of(
+				m_NetworkStreamList.begin(), m_NetworkStreamList.end(),
+				[this](const NetworkStreamInfo &Stream) -> bool {
+					return m_SDTStreamMap.find(SDTStreamMapKey(Stream.OriginalNetworkID, Stream.TransportStreamID)) != m_SDTStreamMap.end();
+				}))
+		Acquired |= ScanTable::SDTOther;
+
+	Acquired &= m_ScanResult.RequiredTables;
+	Acquired &= ~m_ScanResult.AcquiredTables;
+	if (Acquired == ScanTable::None)
+		return;
+
+	const std::chrono::milliseconds Time(
+		(m_ScanClock.Get() - m_ScanStartTime) * 1000 / TickClock::ClocksPerSec);
+
+	for (unsigned int Bit = 1; Bit <= static_cast<unsigned int>(ScanTable::BIT); Bit <<= 1) {
+		if (!!(Acquired & static_cast<ScanTable>(Bit)))
+			m_ScanResult.TableTimeList.push_back(ScanTableTime{static_cast<ScanTable>(Bit), Time});
+	}
+
+	m_ScanResult.AcquiredTables |= Acquired;
+	m_ScanResult.ElapsedTime = Time;
+
+	if (m_ScanResult.AcquiredTables != m_ScanResult.RequiredTables)
+		return;
+
+	LIBISDB_TRACE(LIBISDB_STR("AnalyzerFilter : Scan completed ({} ms)\n"), Time.count());
+
+	m_ScanCompleted = true;
+
+	const ScanResult Result = m_ScanResult;
+
+	m_FilterLock.Unlock();
+	m_EventListenerList.CallEventListener(&EventListener::OnScanCompleted, this, std::cref(Result));
+	m_FilterLock.Lock();
+}
+
+
+void AnalyzerFilter::CommitSICache()
+{
+	if ((m_pSICache == nullptr) || m_IsLoadingSICache || !m_PATUpdated
+			|| (m_NetworkID == NETWORK_ID_INVALID) || (m_TransportStreamID == TRANSPORT_STREAM_ID_INVALID))
+		return;
+
+	m_pSICache->StoreSections(m_NetworkID, m_TransportStreamID, m_SICacheSections);
 }
 
 
@@ -2170,6 +2646,8 @@ void AnalyzerFilter::OnSDTSection(const PSITableBase *pTable, const PSISection *
 	const uint8_t TableID = pTableSet->GetLastUpdatedTableID();
 
 	if (TableID == SDTTable::TABLE_ID_ACTUAL) {
+		StoreSICacheSection(PID_SDT, pSection);
+
 		// 現在の TS の SDT
 		const SDTTable *pSDTTable = pTableSet->GetActualSDTTable();
 		if (pSDTTable == nullptr)
@@ -2199,9 +2677,16 @@ void AnalyzerFilter::OnSDTSection(const PSITableBase *pTable, const PSISection *
 
 		m_SDTUpdated = true;
 
+		CommitSICache();
+
+		PublishSnapshot(SnapshotPart::Service | SnapshotPart::SDT);
+
 		m_FilterLock.Unlock();
 		m_EventListenerList.CallEventListener(&EventListener::OnSDTUpdated, this);
 		m_FilterLock.Lock();
+
+		NotifyServiceListChanged();
+		UpdateScanStatus(ScanTable::SDTActual);
 	} else if (TableID == SDTTable::TABLE_ID_OTHER) {
 		// 他のTSのSDT
 		const SDTOtherTable *pSDTOtherTable = pTableSet->GetOtherSDTTable();
@@ -2219,6 +2704,10 @@ void AnalyzerFilter::OnSDTSection(const PSITableBase *pTable, const PSISection *
 					UpdateSDTStreamMap(pSDTTable, &m_SDTStreamMap);
 			}
 		}
+
+		PublishSnapshot(SnapshotPart::SDT);
+
+		UpdateScanStatus(ScanTable::None);
 	}
 }
 
@@ -2229,8 +2718,13 @@ void AnalyzerFilter::OnNITSection(const PSITableBase *pTable, const PSISection *
 	LIBISDB_TRACE(LIBISDB_STR("AnalyzerFilter::OnNITSection()\n"));
 
 	const NITMultiTable *pNITMultiTable = dynamic_cast<const NITMultiTable *>(pTable);
-	if (LIBISDB_TRACE_ERROR_IF(pNITMultiTable == nullptr)
-			|| !pNITMultiTable->IsNITComplete())
+	if (LIBISDB_TRACE_ERROR_IF(pNITMultiTable == nullptr))
+		return;
+
+	if (pSection->GetTableID() == NITTable::TABLE_ID)
+		StoreSICacheSection(PID_NIT, pSection);
+
+	if (!pNITMultiTable->IsNITComplete())
 		return;
 
 	const NITTable *pNITTable = pNITMultiTable->GetNITTable(0);
@@ -2318,9 +2812,16 @@ void AnalyzerFilter::OnNITSection(const PSITableBase *pTable, const PSISection *
 
 	m_NITUpdated = true;
 
+	CommitSICache();
+
+	PublishSnapshot(SnapshotPart::Service | SnapshotPart::NIT);
+
 	m_FilterLock.Unlock();
 	m_EventListenerList.CallEventListener(&EventListener::OnNITUpdated, this);
 	m_FilterLock.Lock();
+
+	NotifyServiceListChanged();
+	UpdateScanStatus(ScanTable::NITActual);
 }
 
 
@@ -2332,6 +2833,10 @@ void AnalyzerFilter::OnBITSection(const PSITableBase *pTable, const PSISection *
 	m_FilterLock.Unlock();
 	m_EventListenerList.CallEventListener(&EventListener::OnBITUpdated, this);
 	m_FilterLock.Lock();
+
+	const BITMultiTable *pBITMultiTable = dynamic_cast<const BITMultiTable *>(pTable);
+	if ((pBITMultiTable != nullptr) && pBITMultiTable->IsBITComplete())
+		UpdateScanStatus(ScanTable::BIT);
 }
 
 
@@ -2343,6 +2848,10 @@ void AnalyzerFilter::OnEITSection(const PSITableBase *pTable, const PSISection *
 
 	m_EITUpdated = true;
 
+	PublishSnapshot(
+		SnapshotPart::Event,
+		pSection != nullptr ? pSection->GetTableIDExtension() : SERVICE_ID_INVALID);
+
 	// 通知イベント設定
 	// (PATがまだ来ていない場合は番組情報の取得関数が失敗するため保留にする)
 	if (m_PATUpdated) {
@@ -2372,6 +2881,8 @@ void AnalyzerFilter::OnCATSection(const PSITableBase *pTable, const PSISection *
 				m_EMMPIDList.push_back(pCADesc->GetCAPID());
 		});
 
+	PublishSnapshot(SnapshotPart::EMM);
+
 	m_FilterLock.Unlock();
 	m_EventListenerList.CallEventListener(&EventListener::OnCATUpdated, this);
 	m_FilterLock.Lock();
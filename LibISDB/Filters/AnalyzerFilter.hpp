@@ -32,10 +32,15 @@
 #include "../TS/PIDMap.hpp"
 #include "../TS/Descriptors.hpp"
 #include "../TS/Tables.hpp"
+#include "../TS/SICache.hpp"
 #include "../EPG/EventInfo.hpp"
 #include "../Base/EventListener.hpp"
+#include "../Utilities/Clock.hpp"
 #include <vector>
 #include <map>
+#include <memory>
+#include <atomic>
+#include <optional>
 
 
 #ifndef LIBISDB_ANALYZER_FILTER_NO_EIT
@@ -56,6 +61,55 @@ namespace LibISDB
 	public:
 		static constexpr uint16_t LOGO_ID_INVALID = LogoTransmissionDescriptor::LOGO_ID_INVALID;
 
+		/** サービスの変更内容 */
+		enum class ServiceChangeFlag : unsigned int {
+			None          = 0x0000U,
+			Added         = 0x0001U, /**< 追加された */
+			Removed       = 0x0002U, /**< 削除された */
+			PMTPID        = 0x0004U, /**< PMT の PID が変わった */
+			PMTAcquired   = 0x0008U, /**< PMT の取得状態が変わった */
+			ES            = 0x0010U, /**< ES の構成が変わった */
+			PCRPID        = 0x0020U, /**< PCR の PID が変わった */
+			ECM           = 0x0040U, /**< ECM が変わった */
+			Name          = 0x0080U, /**< サービス名か事業者名が変わった */
+			ServiceType   = 0x0100U, /**< サービス形式種別が変わった */
+			LogoID        = 0x0200U, /**< ロゴIDが変わった */
+			Status        = 0x0400U, /**< running_status か free_CA_mode が変わった */
+			CacheMismatch = 0x0800U, /**< キャッシュの内容と実際の内容が異なっていた */
+			LIBISDB_ENUM_FLAGS_TRAILER
+		};
+
+		struct ServiceChangeInfo {
+			uint16_t ServiceID;
+			ServiceChangeFlag Flags;
+		};
+
+		typedef std::vector<ServiceChangeInfo> ServiceChangeList;
+
+		/** スキャンで取得を待つテーブル */
+		enum class ScanTable : unsigned int {
+			None      = 0x0000U,
+			PAT       = 0x0001U, /**< PAT */
+			PMT       = 0x0002U, /**< 全サービスの PMT */
+			SDTActual = 0x0004U, /**< 自 TS の SDT */
+			SDTOther  = 0x0008U, /**< NIT に含まれる全 TS の SDT */
+			NITActual = 0x0010U, /**< 自ネットワークの NIT */
+			BIT       = 0x0020U, /**< BIT */
+			LIBISDB_ENUM_FLAGS_TRAILER
+		};
+
+		struct ScanTableTime {
+			ScanTable Table;
+			std::chrono::milliseconds Time; /**< スキャン開始から取得までの時間 */
+		};
+
+		struct ScanResult {
+			ScanTable RequiredTables = ScanTable::None;
+			ScanTable AcquiredTables = ScanTable::None;
+			std::chrono::milliseconds ElapsedTime{0};
+			std::vector<ScanTableTime> TableTimeList;
+		};
+
 		class EventListener
 			: public LibISDB::EventListener
 		{
@@ -68,6 +122,8 @@ namespace LibISDB
 			virtual void OnEITUpdated(AnalyzerFilter *pAnalyzer) {}
 			virtual void OnCATUpdated(AnalyzerFilter *pAnalyzer) {}
 			virtual void OnTOTUpdated(AnalyzerFilter *pAnalyzer) {}
+			virtual void OnServiceListChanged(AnalyzerFilter *pAnalyzer, const ServiceChangeList &ChangeList) {}
+			virtual void OnScanCompleted(AnalyzerFilter *pAnalyzer, const ScanResult &Result) {}
 		};
 
 		struct ESInfo {
@@ -76,6 +132,8 @@ namespace LibISDB
 			uint8_t ComponentTag = COMPONENT_TAG_INVALID;
 			uint8_t QualityLevel = 0xFF_u8;
 			uint16_t HierarchicalReferencePID = PID_INVALID;
+
+			bool operator == (const ESInfo &rhs) const noexcept = default;
 		};
 
 		typedef std::vector<ESInfo> ESInfoList;
@@ -83,6 +141,8 @@ namespace LibISDB
 		struct ECMInfo {
 			uint16_t CASystemID;
 			uint16_t PID;
+
+			bool operator == (const ECMInfo &rhs) const noexcept = default;
 		};
 
 		struct ServiceInfo {
@@ -103,6 +163,7 @@ namespace LibISDB
 			String ServiceName;
 			uint8_t ServiceType;
 			uint16_t LogoID;
+			bool IsCached;
 		};
 
 		typedef std::vector<ServiceInfo> ServiceList;
@@ -198,6 +259,42 @@ namespace LibISDB
 
 		typedef std::vector<uint16_t> EMMPIDList;
 
+#ifdef LIBISDB_ANALYZER_FILTER_EIT_SUPPORT
+		struct ServiceEventInfo {
+			uint16_t ServiceID;
+			std::optional<EventInfo> Present;
+			std::optional<EventInfo> Following;
+		};
+
+		// 更新されていないサービスの情報はスナップショット間で共有する
+		typedef std::vector<std::shared_ptr<const ServiceEventInfo>> ServiceEventList;
+#endif
+
+		/** 解析結果のスナップショット */
+		struct Snapshot {
+			uint64_t Version = 0;
+			uint16_t TransportStreamID = TRANSPORT_STREAM_ID_INVALID;
+			uint16_t NetworkID = NETWORK_ID_INVALID;
+			bool PATUpdated = false;
+			bool SDTUpdated = false;
+			bool NITUpdated = false;
+			bool SICacheLoaded = false;
+			uint8_t BroadcastingID = 0;
+			uint8_t RemoteControlKeyID = 0;
+			String NetworkName;
+			String TSName;
+			std::shared_ptr<const ServiceList> Services;
+			std::shared_ptr<const SDTServiceList> SDTServices;
+			std::shared_ptr<const SDTStreamMap> SDTStreams;
+			std::shared_ptr<const NetworkStreamList> NetworkStreams;
+			std::shared_ptr<const EMMPIDList> EMMPIDs;
+#ifdef LIBISDB_ANALYZER_FILTER_EIT_SUPPORT
+			std::shared_ptr<const ServiceEventList> Events;
+#endif
+		};
+
+		typedef std::shared_ptr<const Snapshot> SnapshotPtr;
+
 		AnalyzerFilter();
 
 	// ObjectBase
@@ -332,6 +429,20 @@ namespace LibISDB
 
 		bool GetEMMPIDList(ReturnArg<EMMPIDList> List) const;
 
+		SnapshotPtr GetSnapshot() const;
+		uint64_t GetSnapshotVersion() const noexcept;
+
+		void SetSICache(SICache *pCache);
+		SICache * GetSICache() const noexcept { return m_pSICache; }
+		bool LoadSICache(uint16_t NetworkID, uint16_t TransportStreamID);
+		bool IsSICacheLoaded() const;
+
+		bool StartScan(ScanTable Tables);
+		void StopScan();
+		bool IsScanning() const;
+		bool IsScanCompleted() const;
+		bool GetScanResult(ReturnArg<ScanResult> Result) const;
+
 		bool AddEventListener(EventListener *pEventListener);
 		bool RemoveEventListener(EventListener *pEventListener);
 
@@ -353,6 +464,29 @@ namespace LibISDB
 		void UpdateSDTServiceList(const SDTTable *pSDTTable, ReturnArg<SDTServiceList> List);
 		void UpdateSDTStreamMap(const SDTTable *pSDTTable, SDTStreamMap *pStreamMap);
 
+		enum class SnapshotPart : unsigned int {
+			None    = 0x0000U,
+			Service = 0x0001U,
+			SDT     = 0x0002U,
+			NIT     = 0x0004U,
+			EMM     = 0x0008U,
+			Event   = 0x0010U,
+			All     = 0x001FU,
+			LIBISDB_ENUM_FLAGS_TRAILER
+		};
+
+		void PublishSnapshot(SnapshotPart Parts, uint16_t EventServiceID = SERVICE_ID_INVALID);
+		void AddServiceChanges(const ServiceList &OldList, const ServiceList &NewList);
+		void NotifyServiceListChanged();
+		static ServiceChangeFlag CompareServiceInfo(const ServiceInfo &OldInfo, const ServiceInfo &NewInfo);
+#ifdef LIBISDB_ANALYZER_FILTER_EIT_SUPPORT
+		void GetServiceEventInfo(int ServiceIndex, ServiceEventInfo *pInfo) const;
+#endif
+		void StoreSICacheSection(uint16_t PID, const PSISection *pSection);
+		void RemoveStaleSICacheSections();
+		void CommitSICache();
+		void UpdateScanStatus(ScanTable Acquired);
+
 		struct NITInfo {
 			uint8_t BroadcastingFlag = 0;
 			uint8_t BroadcastingID = 0;
@@ -394,6 +528,20 @@ namespace LibISDB
 
 		TOTInterpolationInfo m_TOTInterpolation;
 
+		std::atomic<SnapshotPtr> m_Snapshot;
+		std::atomic<uint64_t> m_SnapshotVersion;
+		ServiceChangeList m_ServiceChangeList;
+
+		SICache *m_pSICache;
+		SICache::SectionList m_SICacheSections;
+		bool m_SICacheLoaded;
+		bool m_IsLoadingSICache;
+
+		TickClock m_ScanClock;
+		TickClock::ClockType m_ScanStartTime;
+		ScanResult m_ScanResult;
+		bool m_ScanCompleted;
+
 	private:
 		void OnPATSection(const PSITableBase *pTable, const PSISection *pSection);
 		void OnPMTSection(const PSITableBase *pTable, const PSISection *pSection);
@@ -58,6 +58,8 @@ void EPGDatabaseFilter::Reset()
 	// TOT
 	m_PIDMapManager.MapTarget(PID_TOT, PSITableBase::CreateWithHandler<TOTTable>(&EPGDatabaseFilter::OnTOTSection, this));
 
+	ApplyServiceFilter();
+
 	if (m_pEPGDatabase != nullptr)
 		m_pEPGDatabase->ResetTOTTime();
 }
@@ -106,6 +108,42 @@ EventInfo::SourceIDType EPGDatabaseFilter::GetSourceID() const
 }
 
 
+void EPGDatabaseFilter::SetServiceFilter(const std::vector<uint16_t> &ServiceList)
+{
+	BlockLock Lock(m_FilterLock);
+
+	m_ServiceFilter = ServiceList;
+	ApplyServiceFilter();
+}
+
+
+void EPGDatabaseFilter::ClearServiceFilter()
+{
+	BlockLock Lock(m_FilterLock);
+
+	m_ServiceFilter.clear();
+	ApplyServiceFilter();
+}
+
+
+void EPGDatabaseFilter::ApplyServiceFilter()
+{
+	// EIT の table_id_extension は service_id
+	for (const uint16_t PID : {PID_HEIT, PID_LEIT}) {
+		EITPfScheduleTable *pTable = m_PIDMapManager.GetMapTarget<EITPfScheduleTable>(PID);
+
+		if (pTable != nullptr) {
+			PSISectionFilter Filter = pTable->GetSectionFilter();
+
+			Filter.ClearTableIDExtensions();
+			for (const uint16_t ServiceID : m_ServiceFilter)
+				Filter.AddTableIDExtension(ServiceID);
+			pTable->SetSectionFilter(Filter);
+		}
+	}
+}
+
+
 void EPGDatabaseFilter::OnScheduleStatusReset(
 	EPGDatabase *pEPGDatabase,
 	uint16_t NetworkID, uint16_t TransportStreamID, uint16_t ServiceID)
@@ -33,6 +33,7 @@
 #include "../TS/PIDMap.hpp"
 #include "../TS/Tables.hpp"
 #include <memory>
+#include <vector>
 
 
 namespace LibISDB
@@ -60,12 +61,17 @@ namespace LibISDB
 		EPGDatabase * GetEPGDatabase() const;
 		void SetSourceID(EventInfo::SourceIDType ID);
 		EventInfo::SourceIDType GetSourceID() const;
+		void SetServiceFilter(const std::vector<uint16_t> &ServiceList);
+		void ClearServiceFilter();
 
 	protected:
+		void ApplyServiceFilter();
+
 		PIDMapManager m_PIDMapManager;
 		EPGDatabase *m_pEPGDatabase;
 		bool m_ResetTable;
 		EventInfo::SourceIDType m_SourceID;
+		std::vector<uint16_t> m_ServiceFilter;
 
 	private:
 	// EPGDatabase::EventListener
@@ -422,25 +422,19 @@ void LogoDownloaderFilter::OnSDTTSection(const PSITableBase *pTable, const PSISe
 
 		const SDTTTable::ContentInfo *pInfo;
 		for (uint8_t i = 0; (pInfo = pSDTTTable->GetContentInfo(i)) != nullptr; i++) {
-			const DescriptorBase *pDesc;
-			for (int j = 0; (pDesc = pInfo->Descriptors.GetDescriptorByIndex(j)) != nullptr; j++) {
-				if (pDesc->GetTag() == DownloadContentDescriptor::TAG) {
-					const DownloadContentDescriptor *pDownloadContentDesc =
-						dynamic_cast<const DownloadContentDescriptor *>(pDesc);
-					if (pDownloadContentDesc != nullptr) {
-						const uint32_t DownloadID = pDownloadContentDesc->GetDownloadID();
-						LIBISDB_TRACE(
-							LIBISDB_STR("Download version {:#x} = {:#03x}\n"),
-							DownloadID, pInfo->NewVersion);
-						std::map<uint32_t, uint16_t>::iterator itVersion = m_VersionMap.find(DownloadID);
-						if ((itVersion == m_VersionMap.end())
-								|| (itVersion->second != pInfo->NewVersion)) {
-							m_VersionMap[DownloadID] = pInfo->NewVersion;
-							UpdatedDownloadIDList.push_back(DownloadID);
-						}
+			pInfo->Descriptors.EnumDescriptors<DownloadContentDescriptor>(
+				[&](const DownloadContentDescriptor *pDownloadContentDesc) {
+					const uint32_t DownloadID = pDownloadContentDesc->GetDownloadID();
+					LIBISDB_TRACE(
+						LIBISDB_STR("Download version {:#x} = {:#03x}\n"),
+						DownloadID, pInfo->NewVersion);
+					std::map<uint32_t, uint16_t>::iterator itVersion = m_VersionMap.find(DownloadID);
+					if ((itVersion == m_VersionMap.end())
+							|| (itVersion->second != pInfo->NewVersion)) {
+						m_VersionMap[DownloadID] = pInfo->NewVersion;
+						UpdatedDownloadIDList.push_back(DownloadID);
 					}
-				}
-			}
+				});
 		}
 
 		if (!UpdatedDownloadIDList.empty()) {
@@ -28,6 +28,7 @@
 #include "RecorderFilter.hpp"
 #include "../Utilities/Utilities.hpp"
 #include <algorithm>
+#include <cstring>
 #include "../Base/DebugDef.hpp"
 
 
@@ -53,6 +54,14 @@ void RecorderFilter::Finalize()
 }
 
 
+void RecorderFilter::Reset()
+{
+	BlockLock Lock(m_FilterLock);
+
+	m_PreRollBuffer.Clear();
+}
+
+
 void RecorderFilter::SetActiveServiceID(uint16_t ServiceID)
 {
 	BlockLock Lock(m_FilterLock);
@@ -67,6 +76,8 @@ bool RecorderFilter::ProcessData(DataStream *pData)
 	if (pData->Is<TSPacket>()) {
 		do {
 			TSPacket *pPacket = pData->Get<TSPacket>();
+			if (m_PreRollBuffer.IsAllocated())
+				m_PreRollBuffer.InputPacket(pPacket);
 			for (auto &Task : m_TaskList)
 				Task->InputPacket(pPacket);
 		} while (pData->Next());
@@ -125,6 +136,9 @@ std::shared_ptr<RecorderFilter::RecordingTask> RecorderFilter::CreateTask(
 
 	BlockLock Lock(m_FilterLock);
 
+	if ((pOptions != nullptr) && (pOptions->PreRollDuration.count() > 0))
+		InputPreRoll(Task.get(), pOptions->PreRollDuration);
+
 	m_TaskList.emplace_back(Task);
 
 	ResetError();
@@ -209,6 +223,245 @@ bool RecorderFilter::RemoveEventListener(EventListener *pEventListener)
 }
 
 
+bool RecorderFilter::SetPreRollBufferSize(size_t Size)
+{
+	BlockLock Lock(m_FilterLock);
+
+	if (Size == 0) {
+		m_PreRollBuffer.Free();
+		return true;
+	}
+
+	if (Size == m_PreRollBuffer.GetSize())
+		return true;
+
+	if (!m_PreRollBuffer.Allocate(Size)) {
+		SetError(std::errc::not_enough_memory);
+		return false;
+	}
+
+	return true;
+}
+
+
+size_t RecorderFilter::GetPreRollBufferSize() const
+{
+	BlockLock Lock(m_FilterLock);
+
+	return m_PreRollBuffer.GetSize();
+}
+
+
+std::chrono::milliseconds RecorderFilter::GetPreRollBufferDuration() const
+{
+	BlockLock Lock(m_FilterLock);
+
+	return m_PreRollBuffer.GetDuration();
+}
+
+
+void RecorderFilter::InputPreRoll(RecordingTaskImpl *pTask, const std::chrono::milliseconds &Duration)
+{
+	if (!m_PreRollBuffer.IsAllocated())
+		return;
+
+	const PreRollBuffer::PacketPos BeginPos = m_PreRollBuffer.GetBeginPos();
+	const PreRollBuffer::PacketPos EndPos = m_PreRollBuffer.GetEndPos();
+	TSPacket Packet;
+
+	// 録画するサービスの映像の PID を、バッファ内の PAT/PMT から取得する
+	const RecordingOptions &Options = pTask->GetOptions();
+	StreamSelector Selector;
+	Selector.SetTarget(Options.ServiceID, Options.StreamFlags);
+	for (PreRollBuffer::PacketPos Pos = BeginPos; Pos < EndPos; Pos++) {
+		Packet.SetData(m_PreRollBuffer.GetPacketData(Pos), TS_PACKET_SIZE);
+		if (Packet.ParsePacket() == TSPacket::ParseResult::OK)
+			Selector.InputPacket(&Packet);
+	}
+	std::vector<uint16_t> VideoPIDList;
+	Selector.GetTargetVideoPIDList(&VideoPIDList);
+
+	const PreRollBuffer::PacketPos StartPos = m_PreRollBuffer.GetStartPos(Duration, VideoPIDList);
+	if (StartPos >= EndPos)
+		return;
+
+	LIBISDB_TRACE(
+		LIBISDB_STR("RecorderFilter::InputPreRoll() : {} packets\n"),
+		EndPos - StartPos);
+
+	// 開始位置より前のパケットは、ストリーム選択に PAT/PMT を取得させるためだけに入力する
+	for (PreRollBuffer::PacketPos Pos = BeginPos; Pos < EndPos; Pos++) {
+		Packet.SetData(m_PreRollBuffer.GetPacketData(Pos), TS_PACKET_SIZE);
+		Packet.ParsePacket();
+		pTask->InputPreRollPacket(&Packet, Pos >= StartPos);
+	}
+}
+
+
+
+
+RecorderFilter::PreRollBuffer::PreRollBuffer() noexcept
+	: m_PacketCount(0)
+	, m_EndPos(0)
+	, m_PCRPID(PID_INVALID)
+	, m_CurPCR(PCR_INVALID)
+{
+}
+
+
+bool RecorderFilter::PreRollBuffer::Allocate(size_t Size)
+{
+	const size_t PacketCount = Size / TS_PACKET_SIZE;
+	if (PacketCount == 0)
+		return false;
+
+	Free();
+
+	try {
+		m_Buffer.resize(PacketCount * TS_PACKET_SIZE);
+	} catch (const std::bad_alloc &) {
+		return false;
+	}
+
+	m_PacketCount = PacketCount;
+
+	return true;
+}
+
+
+void RecorderFilter::PreRollBuffer::Free()
+{
+	Clear();
+	m_Buffer.clear();
+	m_Buffer.shrink_to_fit();
+	m_PacketCount = 0;
+}
+
+
+void RecorderFilter::PreRollBuffer::Clear()
+{
+	m_EndPos = 0;
+	m_Index.clear();
+	m_PCRPID = PID_INVALID;
+	m_CurPCR = PCR_INVALID;
+}
+
+
+void RecorderFilter::PreRollBuffer::InputPacket(const TSPacket *pPacket)
+{
+	if (m_PacketCount == 0)
+		return;
+
+	const PacketPos Pos = m_EndPos;
+
+	std::memcpy(
+		&m_Buffer[static_cast<size_t>(Pos % m_PacketCount) * TS_PACKET_SIZE],
+		pPacket->GetData(), TS_PACKET_SIZE);
+	m_EndPos++;
+
+	// 最初に見つかった PCR の PID を時刻の基準にする
+	const uint16_t PID = pPacket->GetPID();
+	bool HasPCR = false;
+
+	if (pPacket->GetPCRFlag() && ((m_PCRPID == PID_INVALID) || (m_PCRPID == PID))) {
+		const uint64_t PCR = pPacket->GetPCR();
+
+		if (PCR != PCR_INVALID) {
+			if ((m_CurPCR != PCR_INVALID)
+					&& (pPacket->GetDiscontinuityIndicator()
+						|| (PCRDiff(m_CurPCR, PCR) > 10 * 90000))) {
+				// PCR が不連続になった場合はそれ以前の時刻情報を破棄する
+				m_Index.clear();
+			}
+			m_PCRPID = PID;
+			m_CurPCR = PCR;
+			HasPCR = true;
+		}
+	}
+
+	if (m_CurPCR != PCR_INVALID) {
+		// ランダムアクセスポイントは PID 毎に記録し、開始位置を求める際に映像の PID のものを選ぶ
+		// (PCR は映像とは別の PID で送られることがある)
+		const bool RandomAccess =
+			pPacket->GetRandomAccessIndicator() && pPacket->GetPayloadUnitStartIndicator();
+
+		if (HasPCR || RandomAccess) {
+			IndexInfo &Info = m_Index.emplace_back();
+			Info.Pos = Pos;
+			Info.PCR = m_CurPCR;
+			Info.PID = PID;
+			Info.RandomAccess = RandomAccess;
+		}
+	}
+
+	const PacketPos BeginPos = GetBeginPos();
+	while (!m_Index.empty() && (m_Index.front().Pos < BeginPos))
+		m_Index.pop_front();
+}
+
+
+std::chrono::milliseconds RecorderFilter::PreRollBuffer::GetDuration() const
+{
+	if (m_Index.empty())
+		return std::chrono::milliseconds(0);
+
+	return std::chrono::milliseconds(PCRDiff(m_Index.front().PCR, m_CurPCR) / 90);
+}
+
+
+RecorderFilter::PreRollBuffer::PacketPos RecorderFilter::PreRollBuffer::GetBeginPos() const noexcept
+{
+	return (m_EndPos > m_PacketCount) ? (m_EndPos - m_PacketCount) : 0;
+}
+
+
+RecorderFilter::PreRollBuffer::PacketPos RecorderFilter::PreRollBuffer::GetStartPos(
+	const std::chrono::milliseconds &Duration,
+	const std::vector<uint16_t> &RandomAccessPIDList) const
+{
+	if (m_Index.empty())
+		return m_EndPos;
+
+	const uint64_t Time = static_cast<uint64_t>(Duration.count()) * 90;
+
+	// 指定時間以上遡れる、指定 PID のランダムアクセスポイントのうち最も新しいものから開始する
+	// ランダムアクセスポイントが無い場合は PCR の位置で切る
+	for (const bool RandomAccess : {true, false}) {
+		PacketPos StartPos = m_EndPos;
+
+		for (auto it = m_Index.rbegin(); it != m_Index.rend(); ++it) {
+			if (RandomAccess ?
+					(it->RandomAccess && (std::ranges::find(RandomAccessPIDList, it->PID) != RandomAccessPIDList.end())) :
+					(it->PID == m_PCRPID)) {
+				StartPos = it->Pos;
+				if (PCRDiff(it->PCR, m_CurPCR) >= Time)
+					break;
+			}
+		}
+
+		if (StartPos < m_EndPos)
+			return StartPos;
+	}
+
+	return m_EndPos;
+}
+
+
+const uint8_t * RecorderFilter::PreRollBuffer::GetPacketData(PacketPos Pos) const
+{
+	if ((Pos < GetBeginPos()) || (Pos >= m_EndPos))
+		return nullptr;
+
+	return &m_Buffer[static_cast<size_t>(Pos % m_PacketCount) * TS_PACKET_SIZE];
+}
+
+
+uint64_t RecorderFilter::PreRollBuffer::PCRDiff(uint64_t Begin, uint64_t End) noexcept
+{
+	return (End - Begin) & 0x1FFFFFFFF_u64;
+}
+
+
 
 
 RecorderFilter::RecordingDataStreamer::RecordingDataStreamer(StreamWriter *pWriter)
@@ -297,6 +550,14 @@ bool RecorderFilter::RecordingDataStreamer::GetRecordingStatistics(RecordingStat
 	else
 		pStatistics->WriteBytes = RecordingStatistics::INVALID_SIZE;
 	pStatistics->WriteErrorCount = Stats.OutputErrorCount;
+	pStatistics->InputDropBytes = Stats.InputDropBytes;
+	pStatistics->BufferUsed = Stats.InputBufferUsed;
+	pStatistics->BufferMaxUsed = Stats.InputBufferMaxUsed;
+	pStatistics->StallCount = Stats.OutputStallCount;
+	pStatistics->StallTime = Stats.OutputStallTime;
+	pStatistics->OutputLatency = Stats.OutputLatency;
+	pStatistics->WriteStatisticsAvailable =
+		m_Writer && m_Writer->GetWriteStatistics(&pStatistics->WriteStatistics);
 
 	return true;
 }
@@ -481,6 +742,19 @@ void RecorderFilter::RecordingTaskImpl::InputPacket(TSPacket *pPacket)
 }
 
 
+void RecorderFilter::RecordingTaskImpl::InputPreRollPacket(TSPacket *pPacket, bool Output)
+{
+	BlockLock Lock(m_Lock);
+
+	if (!m_Paused.load(std::memory_order_acquire)) {
+		TSPacket *pDstPacket = m_StreamSelector.InputPacket(pPacket);
+
+		if (Output && (pDstPacket != nullptr))
+			m_DataStreamer.InputData(pDstPacket->GetData(), pDstPacket->GetSize());
+	}
+}
+
+
 void RecorderFilter::RecordingTaskImpl::InputData(const DataBuffer *pData)
 {
 	BlockLock Lock(m_Lock);
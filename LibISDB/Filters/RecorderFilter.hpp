@@ -57,6 +57,7 @@ namespace LibISDB
 			size_t WriteCacheSize = 0;
 			size_t MaxPendingSize = 0;
 			bool ClearPendingBufferOnServiceChanged = true;
+			std::chrono::milliseconds PreRollDuration = std::chrono::milliseconds(0);
 		};
 
 		/** 録画統計情報 */
@@ -68,6 +69,14 @@ namespace LibISDB
 			unsigned long long OutputCount = 0;
 			unsigned long long WriteBytes = INVALID_SIZE;
 			unsigned long WriteErrorCount = 0;
+			unsigned long long InputDropBytes = 0;
+			unsigned long long BufferUsed = 0;
+			unsigned long long BufferMaxUsed = 0;
+			unsigned long StallCount = 0;
+			std::chrono::microseconds StallTime{0};
+			LatencyHistogram::Snapshot OutputLatency;
+			bool WriteStatisticsAvailable = false;
+			StreamWriter::WriteStatistics WriteStatistics;
 		};
 
 		/** 録画タスク */
@@ -115,6 +124,7 @@ namespace LibISDB
 
 	// FilterBase
 		void Finalize() override;
+		void Reset() override;
 		void SetActiveServiceID(uint16_t ServiceID) override;
 
 	// SingleIOFilter
@@ -135,7 +145,50 @@ namespace LibISDB
 		bool AddEventListener(EventListener *pEventListener);
 		bool RemoveEventListener(EventListener *pEventListener);
 
+		bool SetPreRollBufferSize(size_t Size);
+		size_t GetPreRollBufferSize() const;
+		std::chrono::milliseconds GetPreRollBufferDuration() const;
+
 	protected:
+		class PreRollBuffer
+		{
+		public:
+			typedef unsigned long long PacketPos;
+
+			PreRollBuffer() noexcept;
+
+			bool Allocate(size_t Size);
+			void Free();
+			bool IsAllocated() const noexcept { return m_PacketCount > 0; }
+			size_t GetSize() const noexcept { return m_Buffer.size(); }
+			void Clear();
+			void InputPacket(const TSPacket *pPacket);
+			std::chrono::milliseconds GetDuration() const;
+			PacketPos GetBeginPos() const noexcept;
+			PacketPos GetEndPos() const noexcept { return m_EndPos; }
+			PacketPos GetStartPos(
+				const std::chrono::milliseconds &Duration,
+				const std::vector<uint16_t> &RandomAccessPIDList) const;
+			const uint8_t * GetPacketData(PacketPos Pos) const;
+
+		private:
+			struct IndexInfo {
+				PacketPos Pos;
+				uint64_t PCR;
+				uint16_t PID;
+				bool RandomAccess;
+			};
+
+			static uint64_t PCRDiff(uint64_t Begin, uint64_t End) noexcept;
+
+			std::vector<uint8_t> m_Buffer;
+			size_t m_PacketCount;
+			PacketPos m_EndPos;
+			std::deque<IndexInfo> m_Index;
+			uint16_t m_PCRPID;
+			uint64_t m_CurPCR;
+		};
+
 		class RecordingDataStreamer
 			: public StreamBufferDataStreamer
 		{
@@ -190,6 +243,7 @@ namespace LibISDB
 
 		// RecordingTaskImpl
 			void InputPacket(TSPacket *pPacket);
+			void InputPreRollPacket(TSPacket *pPacket, bool Output);
 			void InputData(const DataBuffer *pData);
 			void OnActiveServiceChanged(uint16_t ServiceID);
 
@@ -231,6 +285,7 @@ namespace LibISDB
 
 		TaskList::iterator FindTask(const RecordingTask *pTask);
 		TaskList::const_iterator FindTask(const RecordingTask *pTask) const;
+		void InputPreRoll(RecordingTaskImpl *pTask, const std::chrono::milliseconds &Duration);
 
 		class TaskEventListener
 			: public RecordingTaskImpl::EventListener
@@ -248,6 +303,8 @@ namespace LibISDB
 
 		EventListenerList<EventListener> m_EventListenerList;
 		TaskEventListener m_TaskEventListener;
+
+		PreRollBuffer m_PreRollBuffer;
 	};
 
 }	// namespace LibISDB
@@ -27,6 +27,9 @@
 #include "../LibISDBPrivate.hpp"
 #include "StreamSourceFilter.hpp"
 #include "../Base/StandardStream.hpp"
+#include "../TS/Tables.hpp"
+#include <algorithm>
+#include <limits>
 #include "../Base/DebugDef.hpp"
 
 
@@ -36,7 +39,11 @@ namespace LibISDB
 
 StreamSourceFilter::StreamSourceFilter()
 	: SourceFilter(SourceMode::Push)
+	, m_pMappedStream(nullptr)
 	, m_OutputBufferSize(256 * TS_PACKET_SIZE)
+	, m_MemoryMappedInput(false)
+	, m_SeekPCRPID(PID_INVALID)
+	, m_CurSeekPCRPID(PID_INVALID)
 	, m_RequestTimeout(5 * 1000)
 	, m_InputBytes(0)
 	, m_IsStreaming(false)
@@ -83,7 +90,8 @@ bool StreamSourceFilter::StartStreaming()
 	if (m_IsStreaming)
 		return true;
 
-	m_OutputBuffer.AllocateBuffer(m_OutputBufferSize);
+	if (m_pMappedStream == nullptr)
+		m_OutputBuffer.AllocateBuffer(GetReadSize());
 
 	if (IsStarted()) {
 		AddRequest(RequestType::Reset);
@@ -122,6 +130,7 @@ bool StreamSourceFilter::StopStreaming()
 	}
 
 	m_OutputBuffer.FreeBuffer();
+	m_OutputView.ResetView();
 
 	ResetError();
 
@@ -138,13 +147,29 @@ bool StreamSourceFilter::OpenSource(const String &Name)
 		return false;
 	}
 
-	FileStreamBase *pStream = OpenFileStream(
-		Name,
+	constexpr FileStreamBase::OpenFlag OpenFlags =
 		FileStreamBase::OpenFlag::Read |
 		FileStreamBase::OpenFlag::ShareRead |
 		FileStreamBase::OpenFlag::ShareWrite |
 		FileStreamBase::OpenFlag::ShareDelete |
-		FileStreamBase::OpenFlag::SequentialRead);
+		FileStreamBase::OpenFlag::SequentialRead;
+
+	if (m_MemoryMappedInput) {
+		std::unique_ptr<MappedFileStream> MappedStream(new MappedFileStream);
+
+		if (MappedStream->Open(Name, OpenFlags)) {
+			if (!OpenSource(MappedStream.get()))
+				return false;
+			MappedStream.release();
+			return true;
+		}
+
+		// マップできない場合は通常の読み込みにフォールバックする
+		Log(Logger::LogType::Warning,
+			LIBISDB_STR("ファイルをメモリマップできないため通常の読み込みを行います。"));
+	}
+
+	FileStreamBase *pStream = OpenFileStream(Name, OpenFlags);
 
 	if (pStream == nullptr) {
 		SetError(std::errc::invalid_argument);
@@ -179,6 +204,8 @@ bool StreamSourceFilter::OpenSource(Stream *pStream)
 	}
 
 	m_Stream.reset(pStream);
+	m_pMappedStream = dynamic_cast<MappedFileStream *>(pStream);
+	m_CurSeekPCRPID = PID_INVALID;
 
 	m_IsStreaming = false;
 
@@ -186,6 +213,7 @@ bool StreamSourceFilter::OpenSource(Stream *pStream)
 		if (!Start()) {
 			SetError(std::errc::resource_unavailable_try_again);
 			m_Stream.release();
+			m_pMappedStream = nullptr;
 			return false;
 		}
 	}
@@ -215,7 +243,11 @@ bool StreamSourceFilter::CloseSource()
 		}
 	}
 
+	m_OutputView.ResetView();
+	m_pMappedStream = nullptr;
 	m_Stream.reset();
+	m_SeekBuffer.clear();
+	m_SeekBuffer.shrink_to_fit();
 
 	m_EventListenerList.CallEventListener(&EventListener::OnSourceClosed, this);
 
@@ -234,13 +266,16 @@ bool StreamSourceFilter::FetchSource(size_t RequestSize)
 	if (!m_IsStreaming || !m_Stream || !(m_SourceMode & SourceMode::Pull))
 		return false;
 
-	if (RequestSize > m_OutputBuffer.GetBufferSize())
-		RequestSize = m_OutputBuffer.GetBufferSize();
+	if (RequestSize > GetReadSize())
+		RequestSize = GetReadSize();
 
-	const size_t ReadSize = m_Stream->Read(m_OutputBuffer.GetBuffer(), RequestSize);
+	BlockLock Lock(m_StreamLock);
+
+	DataBuffer *pData;
+	const size_t ReadSize = ReadStream(RequestSize, &pData);
 	if (ReadSize > 0) {
-		m_OutputBuffer.SetSize(ReadSize);
-		OutputData(&m_OutputBuffer);
+		m_InputBytes += ReadSize;
+		OutputData(pData);
 	}
 
 	if ((ReadSize < RequestSize) && m_Stream->IsEnd())
@@ -270,6 +305,122 @@ bool StreamSourceFilter::SetOutputBufferSize(size_t Size)
 }
 
 
+bool StreamSourceFilter::SetMemoryMappedInput(bool Enable)
+{
+	if (m_Stream)
+		return false;
+
+	m_MemoryMappedInput = Enable;
+
+	return true;
+}
+
+
+bool StreamSourceFilter::SeekToPCR(uint64_t PCR)
+{
+	BlockLock Lock(m_StreamLock);
+
+	if (!m_Stream) {
+		SetError(std::errc::operation_not_permitted);
+		return false;
+	}
+
+	const Stream::OffsetType OldPos = m_Stream->GetPos();
+	SeekPoint First, Last, Point;
+	SeekResult Result = SeekResult::Error;
+
+	if ((FindSeekPCRPID() != PID_INVALID)
+			&& FindPCR(0, SEEK_PSI_SEARCH_SIZE, &First)
+			&& FindLastPCR(&Last)) {
+		Result = SearchPCR(First, Last, (PCR - First.PCR) & 0x1FFFFFFFF_u64, &Point);
+	}
+
+	if (Result != SeekResult::OK) {
+		m_Stream->SetPos(OldPos, Stream::SetPosType::Begin);
+		SetError((Result == SeekResult::OutOfRange) ? std::errc::result_out_of_range : std::errc::invalid_seek);
+		return false;
+	}
+
+	return SetSeekPos(Point.Pos);
+}
+
+
+bool StreamSourceFilter::SeekToTime(const std::chrono::milliseconds &Time)
+{
+	BlockLock Lock(m_StreamLock);
+
+	if (!m_Stream) {
+		SetError(std::errc::operation_not_permitted);
+		return false;
+	}
+
+	if (Time.count() < 0) {
+		SetError(std::errc::invalid_argument);
+		return false;
+	}
+
+	const Stream::OffsetType OldPos = m_Stream->GetPos();
+	SeekPoint First, Last;
+	SeekResult Result = SeekResult::Error;
+
+	if ((FindSeekPCRPID() != PID_INVALID)
+			&& FindPCR(0, SEEK_PSI_SEARCH_SIZE, &First)
+			&& FindLastPCR(&Last)) {
+		SeekPoint Point;
+
+		Result = SearchPCR(First, Last, static_cast<uint64_t>(Time.count()) * 90, &Point);
+		if (Result == SeekResult::OK)
+			return SetSeekPos(Point.Pos);
+
+		// PCR が不連続な場合は TOT の時刻から位置を求める
+		TOTPoint TOT;
+		if (FindTOT(First.Pos, SEEK_TOT_SEARCH_SIZE, &TOT)) {
+			DateTime TargetTime = TOT.Time;
+			TargetTime.OffsetMilliseconds(
+				Time.count() - static_cast<long long>(((TOT.PCR.PCR - First.PCR) & 0x1FFFFFFFF_u64) / 90));
+			if (SeekToTimeByTOT(TargetTime))
+				return true;
+		}
+	}
+
+	m_Stream->SetPos(OldPos, Stream::SetPosType::Begin);
+	SetError((Result == SeekResult::OutOfRange) ? std::errc::result_out_of_range : std::errc::invalid_seek);
+
+	return false;
+}
+
+
+bool StreamSourceFilter::SeekToTime(const DateTime &Time)
+{
+	BlockLock Lock(m_StreamLock);
+
+	if (!m_Stream) {
+		SetError(std::errc::operation_not_permitted);
+		return false;
+	}
+
+	const Stream::OffsetType OldPos = m_Stream->GetPos();
+
+	if ((FindSeekPCRPID() == PID_INVALID) || !SeekToTimeByTOT(Time)) {
+		m_Stream->SetPos(OldPos, Stream::SetPosType::Begin);
+		SetError(std::errc::invalid_seek);
+		return false;
+	}
+
+	return true;
+}
+
+
+void StreamSourceFilter::SetSeekPCRPID(uint16_t PID)
+{
+	BlockLock Lock(m_StreamLock);
+
+	m_SeekPCRPID = PID;
+	// PID_INVALID の場合は次回のシーク時に改めて検出する
+	m_CurSeekPCRPID = PID;
+}
+
+
 void StreamSourceFilter::ThreadMain()
 {
 	LIBISDB_TRACE(LIBISDB_STR("StreamSourceFilter::ThreadMain() begin\n"));
@@ -337,21 +488,32 @@ void StreamSourceFilter::StreamingMain()
 
 			Lock.Unlock();
 
-			const size_t ReadSize = m_Stream->Read(m_OutputBuffer.GetBuffer(), m_OutputBuffer.GetBufferSize());
-			if (ReadSize > 0) {
-				m_InputBytes += ReadSize;
+			const size_t RequestSize = GetReadSize();
+			size_t ReadSize;
+			bool IsEnd;
+
+			{
+				// シーク中は読み込まない
+				BlockLock StreamLock(m_StreamLock);
 
-				if (m_IsStreaming) {
-					m_OutputBuffer.SetSize(ReadSize);
-					OutputData(&m_OutputBuffer);
+				DataBuffer *pData;
+				ReadSize = ReadStream(RequestSize, &pData);
+				if (ReadSize > 0) {
+					m_InputBytes += ReadSize;
+
+					if (m_IsStreaming)
+						OutputData(pData);
 				}
 
+				IsEnd = (ReadSize < RequestSize) && m_Stream->IsEnd();
+			}
+
+			if (ReadSize > 0)
 				Wait = std::chrono::milliseconds(0);
-			} else {
+			else
 				Wait = std::chrono::milliseconds(10);
-			}
 
-			if ((ReadSize < m_OutputBuffer.GetBufferSize()) && m_Stream->IsEnd()) {
+			if (IsEnd) {
 				m_EventListenerList.CallEventListener(&EventListener::OnSourceEnd, this);
 				Wait = std::chrono::milliseconds(100);
 			}
@@ -393,4 +555,366 @@ bool StreamSourceFilter::HasPendingRequest()
 }
 
 
+size_t StreamSourceFilter::ReadStream(size_t Size, DataBuffer **ppData)
+{
+	if (m_pMappedStream != nullptr) {
+		// マップされた領域をコピーせずにそのまま出力する
+		uint8_t *pView;
+		const size_t ViewSize = m_pMappedStream->ReadView(&pView, Size);
+		m_OutputView.SetView(pView, ViewSize);
+		*ppData = &m_OutputView;
+		return ViewSize;
+	}
+
+	if (Size > m_OutputBuffer.GetBufferSize())
+		Size = m_OutputBuffer.GetBufferSize();
+
+	const size_t ReadSize = m_Stream->Read(m_OutputBuffer.GetBuffer(), Size);
+	m_OutputBuffer.SetSize(ReadSize);
+	*ppData = &m_OutputBuffer;
+	return ReadSize;
+}
+
+
+size_t StreamSourceFilter::GetReadSize() const noexcept
+{
+	if (m_pMappedStream != nullptr)
+		return m_OutputBufferSize;
+
+	// メモリマップを要求されたがフォールバックした場合は大きなブロック単位で読み込む
+	if (m_MemoryMappedInput)
+		return std::max(m_OutputBufferSize, LARGE_READ_BUFFER_SIZE);
+
+	return m_OutputBufferSize;
+}
+
+
+template<typename TPred> bool StreamSourceFilter::ScanPackets(Stream::SizeType Pos, Stream::SizeType Size, TPred Pred)
+{
+	// Pos から Size バイトの範囲にあるパケットを順に Pred に渡す
+	const Stream::SizeType End = Pos + Size;
+	Stream::SizeType CurPos = Pos;
+	bool Synced = false;
+
+	m_SeekBuffer.resize(SEEK_SAMPLE_SIZE);
+
+	while (CurPos < End) {
+		if (!m_Stream->SetPos(CurPos, Stream::SetPosType::Begin))
+			return false;
+
+		const size_t ReadSize = m_Stream->Read(m_SeekBuffer.data(), m_SeekBuffer.size());
+		if (ReadSize < TS_PACKET_SIZE)
+			return false;
+
+		const uint8_t *pData = m_SeekBuffer.data();
+		size_t i = 0;
+
+		if (!Synced) {
+			// 同期バイトが続けて現れる位置を探す
+			for (; i + TS_PACKET_SIZE * 2 < ReadSize; i++) {
+				if ((pData[i] == 0x47) && (pData[i + TS_PACKET_SIZE] == 0x47) && (pData[i + TS_PACKET_SIZE * 2] == 0x47))
+					break;
+			}
+			if (i + TS_PACKET_SIZE * 2 >= ReadSize) {
+				if (ReadSize < m_SeekBuffer.size())
+					return false;
+				CurPos += i;
+				continue;
+			}
+			Synced = true;
+		}
+
+		for (; i + TS_PACKET_SIZE <= ReadSize; i += TS_PACKET_SIZE) {
+			if (pData[i] != 0x47) {
+				Synced = false;
+				break;
+			}
+			if (CurPos + i >= End)
+				return false;
+
+			m_SeekPacket.SetData(&pData[i], TS_PACKET_SIZE);
+			if ((m_SeekPacket.ParsePacket() == TSPacket::ParseResult::OK)
+					&& Pred(static_cast<const TSPacket &>(m_SeekPacket), CurPos + i))
+				return true;
+		}
+
+		if (!Synced)
+			i++;
+		CurPos += i;
+	}
+
+	return false;
+}
+
+
+uint16_t StreamSourceFilter::FindSeekPCRPID()
+{
+	if (m_SeekPCRPID != PID_INVALID)
+		m_CurSeekPCRPID = m_SeekPCRPID;
+	if (m_CurSeekPCRPID != PID_INVALID)
+		return m_CurSeekPCRPID;
+
+	// 先頭の PAT と PMT から最初のサービスの PCR_PID を取得する
+	PATTable PAT;
+	PMTTable PMT;
+	uint16_t PMTPID = PID_INVALID;
+	uint16_t FirstPCRPID = PID_INVALID;
+
+	ScanPackets(
+		0, SEEK_PSI_SEARCH_SIZE,
+		[&](const TSPacket &Packet, Stream::SizeType Pos) -> bool {
+			const uint16_t PID = Packet.GetPID();
+
+			if ((FirstPCRPID == PID_INVALID) && (Packet.GetPCR() != PCR_INVALID))
+				FirstPCRPID = PID;
+
+			if (PID == PID_PAT) {
+				PAT.StorePacket(&Packet);
+				if ((PMTPID == PID_INVALID) && (PAT.GetProgramCount() > 0))
+					PMTPID = PAT.GetPMTPID(0);
+			} else if ((PID == PMTPID) && PMT.StorePacket(&Packet)) {
+				const uint16_t PCRPID = PMT.GetPCRPID();
+				if (PCRPID < PID_NULL) {
+					m_CurSeekPCRPID = PCRPID;
+					return true;
+				}
+			}
+
+			return false;
+		});
+
+	if (m_CurSeekPCRPID == PID_INVALID)
+		m_CurSeekPCRPID = FirstPCRPID;
+
+	return m_CurSeekPCRPID;
+}
+
+
+bool StreamSourceFilter::FindPCR(Stream::SizeType Pos, Stream::SizeType Size, SeekPoint *pPoint)
+{
+	return ScanPackets(
+		Pos, Size,
+		[&](const TSPacket &Packet, Stream::SizeType PacketPos) -> bool {
+			if (Packet.GetPID() == m_CurSeekPCRPID) {
+				const uint64_t PCR = Packet.GetPCR();
+				if (PCR != PCR_INVALID) {
+					pPoint->Pos = PacketPos;
+					pPoint->PCR = PCR;
+					return true;
+				}
+			}
+			return false;
+		});
+}
+
+
+bool StreamSourceFilter::FindLastPCR(SeekPoint *pPoint)
+{
+	const Stream::SizeType FileSize = m_Stream->GetSize();
+
+	for (Stream::SizeType Size = SEEK_SAMPLE_SIZE;; Size *= 2) {
+		const Stream::SizeType Pos = (FileSize > Size) ? FileSize - Size : 0;
+		SeekPoint Point;
+
+		ScanPackets(
+			Pos, FileSize - Pos,
+			[&](const TSPacket &Packet, Stream::SizeType PacketPos) -> bool {
+				if (Packet.GetPID() == m_CurSeekPCRPID) {
+					const uint64_t PCR = Packet.GetPCR();
+					if (PCR != PCR_INVALID) {
+						Point.Pos = PacketPos;
+						Point.PCR = PCR;
+					}
+				}
+				return false;
+			});
+
+		if (Point.PCR != PCR_INVALID) {
+			*pPoint = Point;
+			return true;
+		}
+
+		if (Pos == 0)
+			break;
+	}
+
+	return false;
+}
+
+
+bool StreamSourceFilter::FindTOT(Stream::SizeType Pos, Stream::SizeType Size, TOTPoint *pPoint)
+{
+	TOTTable TOT;
+	SeekPoint LastPCR;
+	bool Found = false;
+
+	// TOT と、その直後(無ければ直前)の PCR を探す
+	ScanPackets(
+		Pos, Size,
+		[&](const TSPacket &Packet, Stream::SizeType PacketPos) -> bool {
+			const uint16_t PID = Packet.GetPID();
+
+			if (PID == m_CurSeekPCRPID) {
+				const uint64_t PCR = Packet.GetPCR();
+				if (PCR != PCR_INVALID) {
+					LastPCR.Pos = PacketPos;
+					LastPCR.PCR = PCR;
+					if (Found)
+						return true;
+				}
+			} else if (!Found && (PID == PID_TOT)) {
+				TOT.StorePacket(&Packet);
+				if (TOT.GetDateTime(&pPoint->Time)) {
+					pPoint->Pos = PacketPos;
+					Found = true;
+				}
+			}
+
+			return false;
+		});
+
+	if (!Found || (LastPCR.PCR == PCR_INVALID))
+		return false;
+
+	pPoint->PCR = LastPCR;
+
+	return true;
+}
+
+
+StreamSourceFilter::SeekResult StreamSourceFilter::SearchPCR(
+	const SeekPoint &Begin, const SeekPoint &End, uint64_t Target, SeekPoint *pPoint)
+{
+	// PCR の折り返しに対応するため、Begin からの相対値で比較する
+	const uint64_t EndRel =
+		(End.PCR != PCR_INVALID) ? ((End.PCR - Begin.PCR) & 0x1FFFFFFFF_u64) : std::numeric_limits<uint64_t>::max();
+
+	if (Target > EndRel)
+		return SeekResult::OutOfRange;
+
+	SeekPoint Lo = Begin;
+	uint64_t LoRel = 0;
+	Stream::SizeType HiPos = End.Pos;
+	uint64_t HiRel = EndRel;
+
+	while (HiPos > Lo.Pos + SEEK_SAMPLE_SIZE) {
+		const Stream::SizeType Mid = Lo.Pos + (HiPos - Lo.Pos) / 2;
+		SeekPoint Point;
+
+		if (!FindPCR(Mid, HiPos - Mid, &Point)) {
+			HiPos = Mid;
+			continue;
+		}
+
+		const uint64_t Rel = (Point.PCR - Begin.PCR) & 0x1FFFFFFFF_u64;
+		if ((Rel < LoRel) || (Rel > HiRel))
+			return SeekResult::Discontinuity;
+
+		if (Rel <= Target) {
+			Lo = Point;
+			LoRel = Rel;
+		} else {
+			HiPos = Mid;
+			HiRel = Rel;
+		}
+	}
+
+	// 残りの範囲から Target 以前の最後の PCR と、その次の PCR を探す
+	SeekPoint Next;
+
+	ScanPackets(
+		Lo.Pos, HiPos - Lo.Pos + SEEK_SAMPLE_SIZE,
+		[&](const TSPacket &Packet, Stream::SizeType PacketPos) -> bool {
+			if (Packet.GetPID() == m_CurSeekPCRPID) {
+				const uint64_t PCR = Packet.GetPCR();
+				if (PCR != PCR_INVALID) {
+					const uint64_t Rel = (PCR - Begin.PCR) & 0x1FFFFFFFF_u64;
+					if ((Rel >= LoRel) && (Rel <= Target)) {
+						Lo.Pos = PacketPos;
+						Lo.PCR = PCR;
+						LoRel = Rel;
+					} else {
+						Next.Pos = PacketPos;
+						Next.PCR = PCR;
+						return true;
+					}
+				}
+			}
+			return false;
+		});
+
+	if (Next.PCR != PCR_INVALID) {
+		// Target を挟む PCR の間隔が開きすぎている場合は不連続とみなす
+		if (((Next.PCR - Begin.PCR) & 0x1FFFFFFFF_u64) - LoRel > SEEK_PCR_GAP_MAX)
+			return SeekResult::Discontinuity;
+	} else {
+		// 終端の PCR より後
+		if (Target - LoRel > SEEK_PCR_GAP_MAX)
+			return SeekResult::OutOfRange;
+	}
+
+	*pPoint = Lo;
+
+	return SeekResult::OK;
+}
+
+
+bool StreamSourceFilter::SeekToTimeByTOT(const DateTime &Time)
+{
+	TOTPoint Lo;
+
+	if (!FindTOT(0, SEEK_TOT_SEARCH_SIZE, &Lo))
+		return false;
+	if (Time < Lo.Time)
+		return SetSeekPos(0);
+
+	// TOT の時刻で範囲を絞り込む
+	Stream::SizeType HiPos = m_Stream->GetSize();
+
+	while (HiPos > Lo.Pos + SEEK_SAMPLE_SIZE) {
+		const Stream::SizeType Mid = Lo.Pos + (HiPos - Lo.Pos) / 2;
+		TOTPoint Point;
+
+		if (!FindTOT(Mid, std::min<Stream::SizeType>(HiPos - Mid, SEEK_TOT_SEARCH_SIZE), &Point))
+			break;
+
+		if (Point.Time <= Time)
+			Lo = Point;
+		else
+			HiPos = Point.Pos;
+	}
+
+	// 最後の TOT から PCR で位置を求める
+	SeekPoint End, Point;
+	End.Pos = HiPos;
+
+	const SeekResult Result =
+		SearchPCR(Lo.PCR, End, static_cast<uint64_t>(Time.DiffMilliseconds(Lo.Time)) * 90, &Point);
+	if (Result == SeekResult::OutOfRange)
+		return false;
+	if (Result != SeekResult::OK)
+		Point = Lo.PCR;
+
+	return SetSeekPos(Point.Pos);
+}
+
+
+bool StreamSourceFilter::SetSeekPos(Stream::SizeType Pos)
+{
+	LIBISDB_TRACE(LIBISDB_STR("StreamSourceFilter::SetSeekPos() : {}\n"), Pos);
+
+	if (!m_Stream->SetPos(static_cast<Stream::OffsetType>(Pos), Stream::SetPosType::Begin)) {
+		SetError(m_Stream->GetLastErrorDescription());
+		return false;
+	}
+
+	ResetDownstreamFilters();
+	m_EventListenerList.CallEventListener(&EventListener::OnGraphReset, this);
+
+	ResetError();
+
+	return true;
+}
+
+
 }	// namespace LibISDB
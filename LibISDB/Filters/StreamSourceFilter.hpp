@@ -32,7 +32,11 @@
 #include "../Utilities/Thread.hpp"
 #include "../Utilities/ConditionVariable.hpp"
 #include "../Base/Stream.hpp"
+#include "../Base/MappedFileStream.hpp"
+#include "../Base/DateTime.hpp"
+#include "../TS/TSPacket.hpp"
 #include <deque>
+#include <vector>
 #include <memory>
 #include <atomic>
 
@@ -46,6 +50,12 @@ namespace LibISDB
 		, protected Thread
 	{
 	public:
+		static constexpr size_t LARGE_READ_BUFFER_SIZE = 8192 * TS_PACKET_SIZE;
+		static constexpr size_t SEEK_SAMPLE_SIZE = 1024 * TS_PACKET_SIZE;
+		static constexpr size_t SEEK_PSI_SEARCH_SIZE = 16 * 1024 * 1024;
+		static constexpr size_t SEEK_TOT_SEARCH_SIZE = 32 * 1024 * 1024;
+		static constexpr uint64_t SEEK_PCR_GAP_MAX = 90000; // 1秒
+
 		StreamSourceFilter();
 		~StreamSourceFilter();
 
@@ -71,6 +81,14 @@ namespace LibISDB
 		bool SetOutputBufferSize(size_t Size);
 		size_t GetOutputBufferSize() const noexcept { return m_OutputBufferSize; }
 		unsigned long long GetInputBytes() const noexcept { return m_InputBytes; }
+		bool SetMemoryMappedInput(bool Enable);
+		bool GetMemoryMappedInput() const noexcept { return m_MemoryMappedInput; }
+		bool IsMemoryMapped() const noexcept { return m_pMappedStream != nullptr; }
+		bool SeekToPCR(uint64_t PCR);
+		bool SeekToTime(const std::chrono::milliseconds &Time);
+		bool SeekToTime(const DateTime &Time);
+		void SetSeekPCRPID(uint16_t PID);
+		uint16_t GetSeekPCRPID() const noexcept { return m_SeekPCRPID; }
 
 	protected:
 		enum class RequestType {
@@ -85,6 +103,24 @@ namespace LibISDB
 			bool IsProcessing;
 		};
 
+		struct SeekPoint {
+			Stream::SizeType Pos = 0;
+			uint64_t PCR = PCR_INVALID;
+		};
+
+		struct TOTPoint {
+			Stream::SizeType Pos = 0;
+			DateTime Time;
+			SeekPoint PCR;
+		};
+
+		enum class SeekResult {
+			OK,
+			Error,
+			OutOfRange,
+			Discontinuity,
+		};
+
 	// Thread
 		const CharType * GetThreadName() const noexcept override { return LIBISDB_STR("StreamSource"); }
 		void ThreadMain() override;
@@ -93,10 +129,29 @@ namespace LibISDB
 		void AddRequest(RequestType Type);
 		bool WaitAllRequests(const std::chrono::milliseconds &Timeout);
 		bool HasPendingRequest();
+		size_t ReadStream(size_t Size, DataBuffer **ppData);
+		size_t GetReadSize() const noexcept;
+
+		template<typename TPred> bool ScanPackets(Stream::SizeType Pos, Stream::SizeType Size, TPred Pred);
+		uint16_t FindSeekPCRPID();
+		bool FindPCR(Stream::SizeType Pos, Stream::SizeType Size, SeekPoint *pPoint);
+		bool FindLastPCR(SeekPoint *pPoint);
+		bool FindTOT(Stream::SizeType Pos, Stream::SizeType Size, TOTPoint *pPoint);
+		SeekResult SearchPCR(const SeekPoint &Begin, const SeekPoint &End, uint64_t Target, SeekPoint *pPoint);
+		bool SeekToTimeByTOT(const DateTime &Time);
+		bool SetSeekPos(Stream::SizeType Pos);
 
 		std::unique_ptr<Stream> m_Stream;
+		MutexLock m_StreamLock;
+		MappedFileStream *m_pMappedStream;
 		DataBuffer m_OutputBuffer;
+		DataBufferView m_OutputView;
 		size_t m_OutputBufferSize;
+		bool m_MemoryMappedInput;
+		uint16_t m_SeekPCRPID;
+		uint16_t m_CurSeekPCRPID;
+		std::vector<uint8_t> m_SeekBuffer;
+		TSPacket m_SeekPacket;
 
 		std::deque<StreamingRequest> m_RequestQueue;
 		MutexLock m_RequestLock;
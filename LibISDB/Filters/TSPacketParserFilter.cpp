@@ -46,6 +46,7 @@ TSPacketParserFilter::TSPacketParserFilter()
 	, m_TotalInputBytes(0)
 {
 	m_ContinuityCounter.fill(0x10);
+	m_FirstContinuityCounter.fill(0xFF);
 }
 
 
@@ -65,6 +66,7 @@ void TSPacketParserFilter::Reset()
 	m_InputBytes = 0;
 
 	m_ContinuityCounter.fill(0x10);
+	m_FirstContinuityCounter.fill(0xFF);
 
 	m_Packet.ClearSize();
 	m_PacketSequence.SetDataCount(0);
@@ -208,6 +210,26 @@ unsigned long long TSPacketParserFilter::GetTotalInputBytes() const
 }
 
 
+TSPacketParserFilter::ContinuityState TSPacketParserFilter::GetContinuityState(uint16_t PID) const
+{
+	ContinuityState State;
+
+	if (LIBISDB_TRACE_ERROR_IF(PID >= PID_MAX))
+		return State;
+
+	BlockLock Lock(m_FilterLock);
+
+	const uint8_t First = m_FirstContinuityCounter[PID];
+	if (First != 0xFF) {
+		State.FirstCounter = First & 0x7F;
+		State.FirstDiscontinuity = (First & 0x80) != 0;
+	}
+	State.LastCounter = m_ContinuityCounter[PID];
+
+	return State;
+}
+
+
 void TSPacketParserFilter::SetGenerate1SegPAT(bool Enable)
 {
 	BlockLock Lock(m_FilterLock);
@@ -299,6 +321,12 @@ void TSPacketParserFilter::ProcessPacket(TSPacket::ParseResult Result)
 		{
 			++m_PIDPacketCount[PID].Input;
 
+			// 分割して解析した結果を繋ぎ合わせる時のため、最初のパケットの巡回カウンタを記録する
+			if ((PID != PID_NULL) && (m_FirstContinuityCounter[PID] == 0xFF)) {
+				m_FirstContinuityCounter[PID] = static_cast<uint8_t>(
+					m_ContinuityCounter[PID] | (m_Packet.GetDiscontinuityIndicator() ? 0x80 : 0x00));
+			}
+
 			if (m_Packet.IsScrambled()) {
 				++m_PacketCount.Scrambled;
 				++m_PIDPacketCount[PID].Scrambled;
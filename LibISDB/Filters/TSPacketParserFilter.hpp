@@ -72,6 +72,12 @@ namespace LibISDB
 			}
 		};
 
+		struct ContinuityState {
+			uint8_t FirstCounter = 0xFF_u8;   /**< 最初のパケットの巡回カウンタ(0x10 はペイロード無し、0xFF はパケット無し) */
+			bool FirstDiscontinuity = false;  /**< 最初のパケットの不連続インジケータ */
+			uint8_t LastCounter = 0x10_u8;    /**< 最後のパケットの巡回カウンタ */
+		};
+
 		TSPacketParserFilter();
 
 	// ObjectBase
@@ -101,6 +107,7 @@ namespace LibISDB
 		void ResetErrorPacketCount();
 		unsigned long long GetInputBytes() const;
 		unsigned long long GetTotalInputBytes() const;
+		ContinuityState GetContinuityState(uint16_t PID) const;
 
 		void SetGenerate1SegPAT(bool Enable);
 		bool GetGenerate1SegPAT() const noexcept { return m_Generate1SegPAT; }
@@ -125,6 +132,7 @@ namespace LibISDB
 		std::array<PacketCountInfo, PID_MAX + 1> m_PIDPacketCount;
 		std::array<PacketCountInfo, PID_MAX + 1> m_PIDTotalPacketCount;
 		std::array<uint8_t, PID_MAX> m_ContinuityCounter;
+		std::array<uint8_t, PID_MAX> m_FirstContinuityCounter;
 		unsigned long long m_InputBytes;
 		unsigned long long m_TotalInputBytes;
 
@@ -37,6 +37,8 @@
 // CRC calculation algorithm
 #define LIBISDB_CRC_SLICING_BY_4
 //#define LIBISDB_CRC_SLICING_BY_8
+// Use PCLMULQDQ for CRC calculation when available
+#define LIBISDB_CRC_PCLMULQDQ
 
 //#define LIBISDB_H264_STRICT_1SEG
 
@@ -26,7 +26,6 @@
 
 #include "../LibISDBPrivate.hpp"
 #include "DescriptorBlock.hpp"
-#include "Descriptors.hpp"
 #include "../Base/DebugDef.hpp"
 
 
@@ -48,14 +47,8 @@ DescriptorBlock::DescriptorBlock(DescriptorBlock &&Src) noexcept
 
 DescriptorBlock & DescriptorBlock::operator = (const DescriptorBlock &Src)
 {
-	if (&Src != this) {
-		Reset();
-		m_DescriptorList.reserve(Src.m_DescriptorList.size());
-
-		for (auto &e : Src.m_DescriptorList) {
-			m_DescriptorList.push_back(std::unique_ptr<DescriptorBase>(e->Clone()));
-		}
-	}
+	// データは共有し、記述子は必要になった時に解析する
+	m_Block = Src.m_Block;
 
 	return *this;
 }
@@ -64,8 +57,7 @@ DescriptorBlock & DescriptorBlock::operator = (const DescriptorBlock &Src)
 DescriptorBlock & DescriptorBlock::operator = (DescriptorBlock &&Src) noexcept
 {
 	if (&Src != this) {
-		Reset();
-		m_DescriptorList.swap(Src.m_DescriptorList);
+		m_Block = std::move(Src.m_Block);
 	}
 
 	return *this;
@@ -79,20 +71,41 @@ int DescriptorBlock::ParseBlock(const uint8_t *pData, size_t DataLength)
 	if ((pData == nullptr) || (DataLength < 2) || (DataLength > 0xFFFF))
 		return 0;
 
+	// 記述子の数を数える
+	size_t Count = 0;
 	size_t Pos = 0;
 
 	do {
-		std::unique_ptr<DescriptorBase> Descriptor(ParseDescriptor(&pData[Pos], static_cast<uint16_t>(DataLength - Pos)));
-
-		if (!Descriptor)
+		const size_t Length = pData[Pos + 1] + 2;
+		if (Pos + Length > DataLength)
 			break;
+		Count++;
+		Pos += Length;
+	} while (Pos + 2 <= DataLength);
 
-		Pos += Descriptor->GetLength() + 2;
+	if (Count == 0)
+		return 0;
 
-		m_DescriptorList.push_back(std::move(Descriptor));
-	} while (Pos + 2 <= DataLength);
+	// タグと位置のみを記録する
+	std::shared_ptr<BlockData> Block = std::make_shared<BlockData>();
+
+	Block->DataLength = Pos;
+	Block->Data.reset(new uint8_t[Pos]);
+	std::memcpy(Block->Data.get(), pData, Pos);
+	Block->EntryCount = Count;
+	Block->EntryList.reset(new DescriptorEntry[Count]);
+
+	Pos = 0;
+	for (size_t i = 0; i < Count; i++) {
+		DescriptorEntry &Entry = Block->EntryList[i];
+		Entry.Tag = pData[Pos];
+		Entry.Offset = static_cast<uint16_t>(Pos);
+		Pos += pData[Pos + 1] + 2;
+	}
+
+	m_Block = std::move(Block);
 
-	return static_cast<int>(m_DescriptorList.size());
+	return static_cast<int>(Count);
 }
 
 
@@ -107,93 +120,62 @@ const DescriptorBase * DescriptorBlock::ParseBlock(const uint8_t *pData, size_t
 
 void DescriptorBlock::Reset() noexcept
 {
-	m_DescriptorList.clear();
+	m_Block.reset();
 }
 
 
 int DescriptorBlock::GetDescriptorCount() const
 {
-	return static_cast<int>(m_DescriptorList.size());
+	if (!m_Block)
+		return 0;
+	return static_cast<int>(m_Block->EntryCount);
 }
 
 
 const DescriptorBase * DescriptorBlock::GetDescriptorByIndex(int Index) const
 {
-	if (static_cast<unsigned int>(Index) >= m_DescriptorList.size())
+	if (!m_Block || (static_cast<unsigned int>(Index) >= m_Block->EntryCount))
 		return nullptr;
-	return m_DescriptorList[Index].get();
+	return GetParsedDescriptor(m_Block->EntryList[Index]);
 }
 
 
 const DescriptorBase * DescriptorBlock::GetDescriptorByTag(uint8_t Tag) const
 {
-	for (auto &e : m_DescriptorList){
-		if (e->GetTag() == Tag)
-			return e.get();
+	if (!m_Block)
+		return nullptr;
+
+	for (size_t i = 0; i < m_Block->EntryCount; i++) {
+		const DescriptorEntry &Entry = m_Block->EntryList[i];
+		if (Entry.Tag == Tag) {
+			const DescriptorBase *pDescriptor = GetParsedDescriptor(Entry);
+			if (pDescriptor != nullptr)
+				return pDescriptor;
+		}
 	}
 
 	return nullptr;
 }
 
 
-std::unique_ptr<DescriptorBase> DescriptorBlock::ParseDescriptor(const uint8_t *pData, uint16_t DataLength)
+const DescriptorBase * DescriptorBlock::GetParsedDescriptor(const DescriptorEntry &Entry) const
 {
-	if ((pData == nullptr) || (DataLength < 2))
-		return nullptr;
+	DescriptorBase *pDescriptor = Entry.Descriptor.load(std::memory_order_acquire);
 
-	std::unique_ptr<DescriptorBase> Descriptor(CreateDescriptorInstance(pData[0]));
+	if (pDescriptor == nullptr) {
+		// 初めて参照された時に解析する
+		std::unique_ptr<DescriptorBase> Descriptor(DescriptorRegistry::CreateInstance(Entry.Tag));
+		const uint8_t *pData = &m_Block->Data[Entry.Offset];
 
-	if (!Descriptor->Parse(pData, DataLength))
-		return nullptr;
-
-	return Descriptor;
-}
+		Descriptor->Parse(pData, static_cast<uint16_t>(m_Block->DataLength - Entry.Offset));
 
-
-DescriptorBase * DescriptorBlock::CreateDescriptorInstance(uint8_t Tag)
-{
-	switch (Tag) {
-	case CADescriptor::TAG                        : return new CADescriptor;
-	case NetworkNameDescriptor::TAG               : return new NetworkNameDescriptor;
-	case ServiceListDescriptor::TAG               : return new ServiceListDescriptor;
-	case SatelliteDeliverySystemDescriptor::TAG   : return new SatelliteDeliverySystemDescriptor;
-	case CableDeliverySystemDescriptor::TAG       : return new CableDeliverySystemDescriptor;
-	case ServiceDescriptor::TAG                   : return new ServiceDescriptor;
-	case LinkageDescriptor::TAG                   : return new LinkageDescriptor;
-	case ShortEventDescriptor::TAG                : return new ShortEventDescriptor;
-	case ExtendedEventDescriptor::TAG             : return new ExtendedEventDescriptor;
-	case ComponentDescriptor::TAG                 : return new ComponentDescriptor;
-	case StreamIDDescriptor::TAG                  : return new StreamIDDescriptor;
-	case ContentDescriptor::TAG                   : return new ContentDescriptor;
-	case LocalTimeOffsetDescriptor::TAG           : return new LocalTimeOffsetDescriptor;
-	case HierarchicalTransmissionDescriptor::TAG  : return new HierarchicalTransmissionDescriptor;
-	case DigitalCopyControlDescriptor::TAG        : return new DigitalCopyControlDescriptor;
-	case AudioComponentDescriptor::TAG            : return new AudioComponentDescriptor;
-	case HyperLinkDescriptor::TAG                 : return new HyperLinkDescriptor;
-	case TargetRegionDescriptor::TAG              : return new TargetRegionDescriptor;
-	case VideoDecodeControlDescriptor::TAG        : return new VideoDecodeControlDescriptor;
-	case DownloadContentDescriptor::TAG           : return new DownloadContentDescriptor;
-	case CAEMMTSDescriptor::TAG                   : return new CAEMMTSDescriptor;
-	case CAContractInfoDescriptor::TAG            : return new CAContractInfoDescriptor;
-	case CAServiceDescriptor::TAG                 : return new CAServiceDescriptor;
-	case TSInformationDescriptor::TAG             : return new TSInformationDescriptor;
-	case ExtendedBroadcasterDescriptor::TAG       : return new ExtendedBroadcasterDescriptor;
-	case LogoTransmissionDescriptor::TAG          : return new LogoTransmissionDescriptor;
-	case SeriesDescriptor::TAG                    : return new SeriesDescriptor;
-	case EventGroupDescriptor::TAG                : return new EventGroupDescriptor;
-	case SIParameterDescriptor::TAG               : return new SIParameterDescriptor;
-	case BroadcasterNameDescriptor::TAG           : return new BroadcasterNameDescriptor;
-	case ComponentGroupDescriptor::TAG            : return new ComponentGroupDescriptor;
-	case LDTLinkageDescriptor::TAG                : return new LDTLinkageDescriptor;
-	case AccessControlDescriptor::TAG             : return new AccessControlDescriptor;
-	case TerrestrialDeliverySystemDescriptor::TAG : return new TerrestrialDeliverySystemDescriptor;
-	case PartialReceptionDescriptor::TAG          : return new PartialReceptionDescriptor;
-	case EmergencyInformationDescriptor::TAG      : return new EmergencyInformationDescriptor;
-	case DataComponentDescriptor::TAG             : return new DataComponentDescriptor;
-	case SystemManagementDescriptor::TAG          : return new SystemManagementDescriptor;
+		// 他のスレッドが先に解析した場合はそちらを使う
+		if (Entry.Descriptor.compare_exchange_strong(
+				pDescriptor, Descriptor.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+			pDescriptor = Descriptor.release();
 	}
 
-	return new DescriptorBase;
+	return pDescriptor->IsValid() ? pDescriptor : nullptr;
 }
 
 
@@ -29,8 +29,10 @@
 
 
 #include "DescriptorBase.hpp"
+#include "DescriptorRegistry.hpp"
 #include <vector>
 #include <memory>
+#include <atomic>
 
 
 namespace LibISDB
@@ -56,25 +58,68 @@ namespace LibISDB
 		const DescriptorBase * GetDescriptorByIndex(int Index) const;
 		const DescriptorBase * GetDescriptorByTag(uint8_t Tag) const;
 		template<typename T> const T * GetDescriptor() const {
-			return dynamic_cast<const T *>(GetDescriptorByTag(T::TAG));
+			static_assert(DescriptorRegistry::IsRegistered<T>());
+			// タグに対応する型は登録により決まるため、dynamic_cast は不要
+			return static_cast<const T *>(GetDescriptorByTag(T::TAG));
 		}
 
 		template<typename TDesc, typename TPred> void EnumDescriptors(TPred Pred) const
 		{
-			for (auto &e : m_DescriptorList) {
-				if (e->GetTag() == TDesc::TAG) {
-					const TDesc *pDesc = dynamic_cast<const TDesc *>(e.get());
+			static_assert(DescriptorRegistry::IsRegistered<TDesc>());
+
+			if (!m_Block)
+				return;
+
+			for (size_t i = 0; i < m_Block->EntryCount; i++) {
+				const DescriptorEntry &Entry = m_Block->EntryList[i];
+				if (Entry.Tag == TDesc::TAG) {
+					const TDesc *pDesc = static_cast<const TDesc *>(GetParsedDescriptor(Entry));
 					if (pDesc != nullptr)
 						Pred(pDesc);
 				}
 			}
 		}
 
-	protected:
-		std::unique_ptr<DescriptorBase> ParseDescriptor(const uint8_t *pData, uint16_t DataLength);
-		static DescriptorBase * CreateDescriptorInstance(uint8_t Tag);
+		template<typename TDesc, typename TPred> const TDesc * FindDescriptor(TPred Pred) const
+		{
+			static_assert(DescriptorRegistry::IsRegistered<TDesc>());
+
+			if (!m_Block)
+				return nullptr;
 
-		std::vector<std::unique_ptr<DescriptorBase>> m_DescriptorList;
+			for (size_t i = 0; i < m_Block->EntryCount; i++) {
+				const DescriptorEntry &Entry = m_Block->EntryList[i];
+				if (Entry.Tag == TDesc::TAG) {
+					const TDesc *pDesc = static_cast<const TDesc *>(GetParsedDescriptor(Entry));
+					if ((pDesc != nullptr) && Pred(pDesc))
+						return pDesc;
+				}
+			}
+
+			return nullptr;
+		}
+
+	protected:
+		/** 記述子の位置 */
+		struct DescriptorEntry {
+			uint8_t Tag = 0;
+			uint16_t Offset = 0;
+			mutable std::atomic<DescriptorBase *> Descriptor {nullptr}; /**< 解析済みの記述子 */
+
+			~DescriptorEntry() { delete Descriptor.load(std::memory_order_relaxed); }
+		};
+
+		/** 記述子ブロックのデータ(複製間で共有される) */
+		struct BlockData {
+			std::unique_ptr<uint8_t[]> Data;
+			size_t DataLength = 0;
+			std::unique_ptr<DescriptorEntry[]> EntryList;
+			size_t EntryCount = 0;
+		};
+
+		const DescriptorBase * GetParsedDescriptor(const DescriptorEntry &Entry) const;
+
+		std::shared_ptr<const BlockData> m_Block;
 	};
 
 }	// namespace LibISDB
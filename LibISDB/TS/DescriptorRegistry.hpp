@@ -0,0 +1,136 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   DescriptorRegistry.hpp
+ @brief  記述子の登録
+ @author DBCTRADO
+*/
+
+
+#ifndef LIBISDB_DESCRIPTOR_REGISTRY_H
+#define LIBISDB_DESCRIPTOR_REGISTRY_H
+
+
+#include "Descriptors.hpp"
+#include <array>
+#include <type_traits>
+
+
+namespace LibISDB
+{
+
+	/** 記述子登録テンプレートクラス */
+	template<typename... TDescriptors> class DescriptorRegistryTemplate
+	{
+	public:
+		template<typename T> static constexpr bool IsRegistered() noexcept
+		{
+			return (std::is_same_v<T, TDescriptors> || ...);
+		}
+
+		static constexpr bool IsTagRegistered(uint8_t Tag) noexcept
+		{
+			return ((TDescriptors::TAG == Tag) || ...);
+		}
+
+		static DescriptorBase * CreateInstance(uint8_t Tag)
+		{
+			const FactoryFunc Func = m_FactoryTable[Tag];
+			if (Func == nullptr)
+				return new DescriptorBase;
+			return Func();
+		}
+
+	private:
+		typedef DescriptorBase * (*FactoryFunc)();
+
+		template<typename T> static DescriptorBase * Create() { return new T; }
+
+		static constexpr bool IsTagUnique() noexcept
+		{
+			constexpr uint8_t TagList[] = {TDescriptors::TAG...};
+			for (size_t i = 0; i < sizeof...(TDescriptors); i++) {
+				for (size_t j = i + 1; j < sizeof...(TDescriptors); j++) {
+					if (TagList[i] == TagList[j])
+						return false;
+				}
+			}
+			return true;
+		}
+
+		static constexpr std::array<FactoryFunc, 256> MakeFactoryTable() noexcept
+		{
+			std::array<FactoryFunc, 256> Table {};
+			((Table[TDescriptors::TAG] = &Create<TDescriptors>), ...);
+			return Table;
+		}
+
+		static_assert(IsTagUnique(), "Descriptor tag is duplicated");
+		static_assert((std::is_base_of_v<DescriptorTemplate<TDescriptors, TDescriptors::TAG>, TDescriptors> && ...));
+
+		static constexpr std::array<FactoryFunc, 256> m_FactoryTable = MakeFactoryTable();
+	};
+
+	/** 記述子の登録 */
+	typedef DescriptorRegistryTemplate<
+		CADescriptor,
+		NetworkNameDescriptor,
+		ServiceListDescriptor,
+		SatelliteDeliverySystemDescriptor,
+		CableDeliverySystemDescriptor,
+		ServiceDescriptor,
+		LinkageDescriptor,
+		ShortEventDescriptor,
+		ExtendedEventDescriptor,
+		ComponentDescriptor,
+		StreamIDDescriptor,
+		ContentDescriptor,
+		LocalTimeOffsetDescriptor,
+		HierarchicalTransmissionDescriptor,
+		DigitalCopyControlDescriptor,
+		AudioComponentDescriptor,
+		HyperLinkDescriptor,
+		TargetRegionDescriptor,
+		VideoDecodeControlDescriptor,
+		DownloadContentDescriptor,
+		CAEMMTSDescriptor,
+		CAContractInfoDescriptor,
+		CAServiceDescriptor,
+		TSInformationDescriptor,
+		ExtendedBroadcasterDescriptor,
+		LogoTransmissionDescriptor,
+		SeriesDescriptor,
+		EventGroupDescriptor,
+		SIParameterDescriptor,
+		BroadcasterNameDescriptor,
+		ComponentGroupDescriptor,
+		LDTLinkageDescriptor,
+		AccessControlDescriptor,
+		TerrestrialDeliverySystemDescriptor,
+		PartialReceptionDescriptor,
+		EmergencyInformationDescriptor,
+		DataComponentDescriptor,
+		SystemManagementDescriptor
+	> DescriptorRegistry;
+
+}	// namespace LibISDB
+
+
+#endif	// ifndef LIBISDB_DESCRIPTOR_REGISTRY_H
@@ -37,6 +37,7 @@ PIDMapManager::PIDMapManager() noexcept
 	: m_MapCount(0)
 {
 	m_PIDMap.fill(nullptr);
+	m_TypeIDMap.fill(nullptr);
 }
 
 
@@ -87,6 +88,12 @@ bool PIDMapManager::StorePacketStream(DataStream *pPacketStream)
 
 
 bool PIDMapManager::MapTarget(uint16_t PID, PIDMapTarget *pMapTarget)
+{
+	return MapTarget(PID, pMapTarget, nullptr);
+}
+
+
+bool PIDMapManager::MapTarget(uint16_t PID, PIDMapTarget *pMapTarget, const void *pTypeID)
 {
 	if ((PID > PID_MAX) || (pMapTarget == nullptr))
 		return false;
@@ -94,6 +101,7 @@ bool PIDMapManager::MapTarget(uint16_t PID, PIDMapTarget *pMapTarget)
 	UnmapTarget(PID);
 
 	m_PIDMap[PID] = pMapTarget;
+	m_TypeIDMap[PID] = pTypeID;
 	m_MapCount++;
 
 	pMapTarget->OnPIDMapped(PID);
@@ -113,6 +121,7 @@ bool PIDMapManager::UnmapTarget(uint16_t PID)
 		return false;
 
 	m_PIDMap[PID] = nullptr;
+	m_TypeIDMap[PID] = nullptr;
 	m_MapCount--;
 
 	pTarget->OnPIDUnmapped(PID);
@@ -47,6 +47,12 @@ namespace LibISDB
 		virtual void OnPIDUnmapped(uint16_t PID) {}
 	};
 
+	/** PID マップ対象の型識別子 */
+	template<typename T> struct PIDMapTargetTypeID
+	{
+		static constexpr char ID = 0;
+	};
+
 	/** PID マップ管理クラス */
 	class PIDMapManager
 	{
@@ -58,15 +64,30 @@ namespace LibISDB
 		bool StorePacketStream(DataStream *pPacketStream);
 
 		bool MapTarget(uint16_t PID, PIDMapTarget *pMapTarget);
+		template<typename T> bool MapTarget(uint16_t PID, T *pMapTarget)
+		{
+			return MapTarget(PID, pMapTarget, &PIDMapTargetTypeID<T>::ID);
+		}
 		bool UnmapTarget(uint16_t PID);
 		void UnmapAllTargets();
 
 		PIDMapTarget * GetMapTarget(uint16_t PID) const;
-		template<typename T> T * GetMapTarget(uint16_t PID) const { return dynamic_cast<T *>(GetMapTarget(PID)); }
+		template<typename T> T * GetMapTarget(uint16_t PID) const
+		{
+			if (PID > PID_MAX)
+				return nullptr;
+			// マップ時の型と一致すれば RTTI を使わずに変換する
+			if (m_TypeIDMap[PID] == &PIDMapTargetTypeID<T>::ID)
+				return static_cast<T *>(m_PIDMap[PID]);
+			return dynamic_cast<T *>(m_PIDMap[PID]);
+		}
 		uint16_t GetMapCount() const;
 
 	protected:
+		bool MapTarget(uint16_t PID, PIDMapTarget *pMapTarget, const void *pTypeID);
+
 		std::array<PIDMapTarget *, PID_MAX + 1> m_PIDMap;
+		std::array<const void *, PID_MAX + 1> m_TypeIDMap;
 		uint16_t m_MapCount;
 	};
 
@@ -178,6 +178,151 @@ bool PSISection::PSIHeader::operator == (const PSIHeader &rhs) const noexcept
 
 
 
+PSISectionFilter::PSISectionFilter() noexcept
+{
+	Reset();
+}
+
+
+bool PSISectionFilter::operator == (const PSISectionFilter &rhs) const noexcept
+{
+	return (m_TableIDMask == rhs.m_TableIDMask)
+		&& (m_TableIDExtensionList == rhs.m_TableIDExtensionList)
+		&& (m_CurrentOnly == rhs.m_CurrentOnly);
+}
+
+
+void PSISectionFilter::Reset() noexcept
+{
+	m_TableIDMask.set();
+	m_TableIDExtensionList.clear();
+	m_CurrentOnly = false;
+}
+
+
+bool PSISectionFilter::IsMatch(const PSISection *pSection) const noexcept
+{
+	if (!m_TableIDMask[pSection->GetTableID()])
+		return false;
+
+	if (pSection->IsExtendedSection()) {
+		if (!IsTableIDExtensionPass(pSection->GetTableIDExtension()))
+			return false;
+		if (m_CurrentOnly && !pSection->GetCurrentNextIndicator())
+			return false;
+	}
+
+	return true;
+}
+
+
+bool PSISectionFilter::IsPassAll() const noexcept
+{
+	return m_TableIDMask.all() && m_TableIDExtensionList.empty() && !m_CurrentOnly;
+}
+
+
+void PSISectionFilter::SetTableID(uint8_t TableID, bool Pass) noexcept
+{
+	m_TableIDMask.set(TableID, Pass);
+}
+
+
+void PSISectionFilter::SetTableIDRange(uint8_t First, uint8_t Last, bool Pass) noexcept
+{
+	for (unsigned int TableID = First; TableID <= Last; TableID++)
+		m_TableIDMask.set(TableID, Pass);
+}
+
+
+void PSISectionFilter::SetAllTableIDs(bool Pass) noexcept
+{
+	if (Pass)
+		m_TableIDMask.set();
+	else
+		m_TableIDMask.reset();
+}
+
+
+void PSISectionFilter::AddTableIDExtension(uint16_t Extension)
+{
+	auto it = std::lower_bound(m_TableIDExtensionList.begin(), m_TableIDExtensionList.end(), Extension);
+	if ((it == m_TableIDExtensionList.end()) || (*it != Extension))
+		m_TableIDExtensionList.insert(it, Extension);
+}
+
+
+bool PSISectionFilter::RemoveTableIDExtension(uint16_t Extension)
+{
+	auto it = std::lower_bound(m_TableIDExtensionList.begin(), m_TableIDExtensionList.end(), Extension);
+	if ((it == m_TableIDExtensionList.end()) || (*it != Extension))
+		return false;
+	m_TableIDExtensionList.erase(it);
+	return true;
+}
+
+
+void PSISectionFilter::ClearTableIDExtensions() noexcept
+{
+	m_TableIDExtensionList.clear();
+}
+
+
+bool PSISectionFilter::IsTableIDExtensionPass(uint16_t Extension) const noexcept
+{
+	// リストが空の場合は全て通す
+	return m_TableIDExtensionList.empty()
+		|| std::binary_search(m_TableIDExtensionList.begin(), m_TableIDExtensionList.end(), Extension);
+}
+
+
+
+
+PSISectionView::~PSISectionView()
+{
+	// 基底クラスのデストラクタで解放されないようにする
+	m_pData = nullptr;
+}
+
+
+void PSISectionView::SetView(const uint8_t *pData, size_t Size) noexcept
+{
+	// 参照先は読み取り専用として扱う
+	m_pData = const_cast<uint8_t *>(pData);
+	m_DataSize = Size;
+	m_BufferSize = Size;
+}
+
+
+void PSISectionView::ResetView() noexcept
+{
+	m_pData = nullptr;
+	m_DataSize = 0;
+	m_BufferSize = 0;
+	m_Header = PSIHeader();
+}
+
+
+void * PSISectionView::Allocate(size_t Size)
+{
+	// 参照しているメモリの拡張はできない
+	return nullptr;
+}
+
+
+void PSISectionView::Free(void *pBuffer) noexcept
+{
+}
+
+
+void * PSISectionView::ReAllocate(void *pBuffer, size_t Size)
+{
+	return nullptr;
+}
+
+
+
+
 PSISectionParser::PSISectionParser(
 	PSISectionHandler *pPSISectionHandler, bool IsExtended, bool IgnoreSectionNumber)
 	: m_pPSISectionHandler(pPSISectionHandler)
@@ -185,8 +330,14 @@ PSISectionParser::PSISectionParser(
 	, m_IsExtended(IsExtended)
 	, m_IgnoreSectionNumber(IgnoreSectionNumber)
 	, m_IsPayloadStoring(false)
+	, m_IsPayloadSkipping(false)
 	, m_StoreSize(0)
+	, m_SkipRemain(0)
 	, m_CRCErrorCount(0)
+	, m_SectionCacheEnabled(false)
+	, m_SectionCacheHitCount(0)
+	, m_SectionFilterEnabled(false)
+	, m_FilteredSectionCount(0)
 {
 }
 
@@ -221,11 +372,21 @@ void PSISectionParser::StorePacket(const TSPacket *pPacket)
 
 		m_PSISection.Reset();
 		m_IsPayloadStoring = false;
+		m_IsPayloadSkipping = false;
 
 		Pos = UnitStartPos;
 		while (Pos < PayloadSize) {
 			Size = PayloadSize - Pos;
 			if (!m_IsPayloadStoring) {
+				if (IsCompleteSection(&pData[Pos], Size)) {
+					// パケット内で完結しているセクションはコピーせずに処理する
+					if (!StoreSectionView(&pData[Pos], &Size))
+						break;
+					Pos += Size;
+					if ((Pos >= PayloadSize) || (pData[Pos] == 0xFF))
+						break;
+					continue;
+				}
 				if (!StoreHeader(&pData[Pos], &Size))
 					break;
 				Pos += Size;
@@ -256,9 +417,14 @@ void PSISectionParser::StorePacket(const TSPacket *pPacket)
 void PSISectionParser::Reset() noexcept
 {
 	m_IsPayloadStoring = false;
+	m_IsPayloadSkipping = false;
 	m_StoreSize = 0;
+	m_SkipRemain = 0;
 	m_CRCErrorCount = 0;
 	m_PSISection.Reset();
+	ClearSectionCache();
+	m_SectionCacheHitCount = 0;
+	m_FilteredSectionCount = 0;
 }
 
 
@@ -274,6 +440,30 @@ unsigned long PSISectionParser::GetCRCErrorCount() const noexcept
 }
 
 
+void PSISectionParser::SetSectionCacheEnabled(bool Enabled)
+{
+	m_SectionCacheEnabled = Enabled;
+	if (!Enabled) {
+		m_SectionCache.clear();
+		m_SectionCache.shrink_to_fit();
+	}
+}
+
+
+void PSISectionParser::ClearSectionCache() noexcept
+{
+	for (SectionCacheEntry &Entry : m_SectionCache)
+		Entry.IsValid = false;
+}
+
+
+void PSISectionParser::SetSectionFilter(const PSISectionFilter &Filter)
+{
+	m_SectionFilter = Filter;
+	m_SectionFilterEnabled = !m_SectionFilter.IsPassAll();
+}
+
+
 bool PSISectionParser::StoreHeader(const uint8_t *pData, uint8_t *pRemain)
 {
 	if (m_IsPayloadStoring) {
@@ -295,6 +485,13 @@ bool PSISectionParser::StoreHeader(const uint8_t *pData, uint8_t *pRemain)
 	if (m_PSISection.ParseHeader(m_IsExtended, m_IgnoreSectionNumber)) {
 		m_StoreSize = 3 + m_PSISection.GetSectionLength();
 		m_IsPayloadStoring = true;
+		if (m_SectionFilterEnabled && !m_SectionFilter.IsMatch(&m_PSISection)) {
+			// 対象外のセクションはペイロードを読み飛ばす
+			m_IsPayloadSkipping = true;
+			m_SkipRemain = m_StoreSize - HeaderSize;
+			if (m_FilteredSectionCount < std::numeric_limits<unsigned long>::max())
+				m_FilteredSectionCount++;
+		}
 		return true;
 	} else {
 		LIBISDB_TRACE_WARNING(LIBISDB_STR("PSISection header format error\n"));
@@ -312,6 +509,20 @@ bool PSISectionParser::StorePayload(const uint8_t *pData, uint8_t *pRemain)
 	}
 
 	const uint8_t Remain = *pRemain;
+
+	if (m_IsPayloadSkipping) {
+		if (m_SkipRemain > Remain) {
+			m_SkipRemain -= Remain;
+			return false;
+		}
+
+		*pRemain = static_cast<uint8_t>(m_SkipRemain);
+		m_PSISection.Reset();
+		m_IsPayloadStoring = false;
+		m_IsPayloadSkipping = false;
+		return true;
+	}
+
 	const uint16_t StoreRemain = m_StoreSize - static_cast<uint16_t>(m_PSISection.GetSize());
 
 	if (StoreRemain > Remain) {
@@ -322,27 +533,115 @@ bool PSISectionParser::StorePayload(const uint8_t *pData, uint8_t *pRemain)
 
 	m_PSISection.AddData(pData, StoreRemain);
 
+	OnSectionStored(&m_PSISection);
+
+	m_PSISection.Reset();
+	m_IsPayloadStoring = false;
+
+	*pRemain = static_cast<uint8_t>(StoreRemain);
+
+	return true;
+}
+
+
+bool PSISectionParser::IsCompleteSection(const uint8_t *pData, uint8_t Remain) const noexcept
+{
+	if (Remain < 3)
+		return false;
+
+	const uint16_t SectionSize = 3 + (((pData[1] & 0x0F) << 8) | pData[2]);
+
+	return SectionSize <= Remain;
+}
+
+
+bool PSISectionParser::StoreSectionView(const uint8_t *pData, uint8_t *pRemain)
+{
+	const uint16_t SectionSize = 3 + (((pData[1] & 0x0F) << 8) | pData[2]);
+
+	m_PSISectionView.SetView(pData, SectionSize);
+
+	if (!m_PSISectionView.ParseHeader(m_IsExtended, m_IgnoreSectionNumber)) {
+		LIBISDB_TRACE_WARNING(LIBISDB_STR("PSISection header format error\n"));
+		m_PSISectionView.ResetView();
+		*pRemain = 0;
+		return false;
+	}
+
+	if (m_SectionFilterEnabled && !m_SectionFilter.IsMatch(&m_PSISectionView)) {
+		if (m_FilteredSectionCount < std::numeric_limits<unsigned long>::max())
+			m_FilteredSectionCount++;
+	} else {
+		OnSectionStored(&m_PSISectionView);
+	}
+
+	m_PSISectionView.ResetView();
+
+	*pRemain = static_cast<uint8_t>(SectionSize);
+
+	return true;
+}
+
+
+void PSISectionParser::OnSectionStored(const PSISection *pSection)
+{
+	SectionCacheEntry *pCacheEntry = nullptr;
+	uint32_t Key, CRC;
+
+	if (m_SectionCacheEnabled) {
+		pCacheEntry = GetSectionCacheEntry(pSection, &Key);
+		if (pCacheEntry != nullptr) {
+			// 前回と同じ CRC のセクションは処理しない
+			CRC = Load32(pSection->GetData() + pSection->GetSize() - 4);
+			if (pCacheEntry->IsValid && (pCacheEntry->Key == Key) && (pCacheEntry->CRC == CRC)) {
+				if (m_SectionCacheHitCount < std::numeric_limits<unsigned long>::max())
+					m_SectionCacheHitCount++;
+				return;
+			}
+		}
+	}
+
 	// CRC チェック
-	if (CRC32MPEG2::Calc(m_PSISection.GetData(), m_PSISection.GetSize()) == 0) {
+	if (CRC32MPEG2::Calc(pSection->GetData(), pSection->GetSize()) == 0) {
+		if (pCacheEntry != nullptr) {
+			pCacheEntry->Key = Key;
+			pCacheEntry->CRC = CRC;
+			pCacheEntry->IsValid = true;
+		}
 		if (m_pPSISectionHandler != nullptr)
-			m_pPSISectionHandler->OnPSISection(this, &m_PSISection);
+			m_pPSISectionHandler->OnPSISection(this, pSection);
 		LIBISDB_TRACE_VERBOSE(
-			LIBISDB_STR("PSISection Stored: table_id {:02X} | {} / {} bytes\n"),
-			m_PSISection.GetTableID(), m_PSISection.GetSize(), m_StoreSize);
+			LIBISDB_STR("PSISection Stored: table_id {:02X} | {} bytes\n"),
+			pSection->GetTableID(), pSection->GetSize());
 	} else {
 		if (m_CRCErrorCount < std::numeric_limits<unsigned long>::max())
 			m_CRCErrorCount++;
 		LIBISDB_TRACE_WARNING(
-			LIBISDB_STR("PSISection CRC Error: table_id {:02X} | {} / {} bytes\n"),
-			m_PSISection.GetTableID(), m_PSISection.GetSize(), m_StoreSize);
+			LIBISDB_STR("PSISection CRC Error: table_id {:02X} | {} bytes\n"),
+			pSection->GetTableID(), pSection->GetSize());
 	}
+}
 
-	m_PSISection.Reset();
-	m_IsPayloadStoring = false;
 
-	*pRemain = static_cast<uint8_t>(StoreRemain);
 
-	return true;
+PSISectionParser::SectionCacheEntry * PSISectionParser::GetSectionCacheEntry(
+	const PSISection *pSection, uint32_t *pKey)
+{
+	if (pSection->GetSize() < 3_z + 4)
+		return nullptr;
+
+	const uint32_t Key =
+		(static_cast<uint32_t>(pSection->GetTableID()) << 24) |
+		(pSection->IsExtendedSection() ?
+			((static_cast<uint32_t>(pSection->GetTableIDExtension()) << 8) | pSection->GetSectionNumber()) : 0);
+
+	if (m_SectionCache.empty())
+		m_SectionCache.resize(SECTION_CACHE_SIZE, SectionCacheEntry());
+
+	*pKey = Key;
+
+	static_assert(SECTION_CACHE_SIZE == 256);
+	return &m_SectionCache[(Key * 0x9E3779B1_u32) >> 24];
 }
 
 
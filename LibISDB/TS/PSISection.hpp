@@ -29,6 +29,8 @@
 
 
 #include "TSPacket.hpp"
+#include <vector>
+#include <bitset>
 
 
 namespace LibISDB
@@ -78,6 +80,58 @@ namespace LibISDB
 		PSIHeader m_Header;
 	};
 
+	/** 外部メモリ参照 PSI セクションクラス */
+	class PSISectionView
+		: public PSISection
+	{
+	public:
+		PSISectionView() = default;
+		~PSISectionView();
+
+		PSISectionView(const PSISectionView &) = delete;
+		PSISectionView & operator = (const PSISectionView &) = delete;
+
+		void SetView(const uint8_t *pData, size_t Size) noexcept;
+		void ResetView() noexcept;
+
+	protected:
+		void * Allocate(size_t Size) override;
+		void Free(void *pBuffer) noexcept override;
+		void * ReAllocate(void *pBuffer, size_t Size) override;
+	};
+
+	/** PSI セクションフィルタクラス */
+	class PSISectionFilter
+	{
+	public:
+		PSISectionFilter() noexcept;
+
+		bool operator == (const PSISectionFilter &rhs) const noexcept;
+		bool operator != (const PSISectionFilter &rhs) const noexcept { return !(*this == rhs); }
+
+		void Reset() noexcept;
+		bool IsMatch(const PSISection *pSection) const noexcept;
+		bool IsPassAll() const noexcept;
+
+		void SetTableID(uint8_t TableID, bool Pass = true) noexcept;
+		void SetTableIDRange(uint8_t First, uint8_t Last, bool Pass = true) noexcept;
+		void SetAllTableIDs(bool Pass) noexcept;
+		bool IsTableIDPass(uint8_t TableID) const noexcept { return m_TableIDMask[TableID]; }
+
+		void AddTableIDExtension(uint16_t Extension);
+		bool RemoveTableIDExtension(uint16_t Extension);
+		void ClearTableIDExtensions() noexcept;
+		bool IsTableIDExtensionPass(uint16_t Extension) const noexcept;
+
+		void SetCurrentOnly(bool CurrentOnly) noexcept { m_CurrentOnly = CurrentOnly; }
+		bool GetCurrentOnly() const noexcept { return m_CurrentOnly; }
+
+	private:
+		std::bitset<256> m_TableIDMask;
+		std::vector<uint16_t> m_TableIDExtensionList;
+		bool m_CurrentOnly;
+	};
+
 	/** PSI セクション解析クラス */
 	class PSISectionParser
 	{
@@ -98,18 +152,50 @@ namespace LibISDB
 
 		unsigned long GetCRCErrorCount() const noexcept;
 
+		void SetSectionCacheEnabled(bool Enabled);
+		bool IsSectionCacheEnabled() const noexcept { return m_SectionCacheEnabled; }
+		void ClearSectionCache() noexcept;
+		unsigned long GetSectionCacheHitCount() const noexcept { return m_SectionCacheHitCount; }
+
+		void SetSectionFilter(const PSISectionFilter &Filter);
+		const PSISectionFilter & GetSectionFilter() const noexcept { return m_SectionFilter; }
+		unsigned long GetFilteredSectionCount() const noexcept { return m_FilteredSectionCount; }
+
 	private:
+		static constexpr size_t SECTION_CACHE_SIZE = 256;
+
+		struct SectionCacheEntry {
+			uint32_t Key;
+			uint32_t CRC;
+			bool IsValid;
+		};
+
 		bool StoreHeader(const uint8_t *pData, uint8_t *pRemain);
 		bool StorePayload(const uint8_t *pData, uint8_t *pRemain);
+		bool IsCompleteSection(const uint8_t *pData, uint8_t Remain) const noexcept;
+		bool StoreSectionView(const uint8_t *pData, uint8_t *pRemain);
+		void OnSectionStored(const PSISection *pSection);
+		SectionCacheEntry * GetSectionCacheEntry(const PSISection *pSection, uint32_t *pKey);
 
 		PSISectionHandler *m_pPSISectionHandler;
 		PSISection m_PSISection;
+		PSISectionView m_PSISectionView;
 		bool m_IsExtended;
 		bool m_IgnoreSectionNumber;
 
 		bool m_IsPayloadStoring;
+		bool m_IsPayloadSkipping;
 		uint16_t m_StoreSize;
+		uint16_t m_SkipRemain;
 		unsigned long m_CRCErrorCount;
+
+		bool m_SectionCacheEnabled;
+		std::vector<SectionCacheEntry> m_SectionCache;
+		unsigned long m_SectionCacheHitCount;
+
+		PSISectionFilter m_SectionFilter;
+		bool m_SectionFilterEnabled;
+		unsigned long m_FilteredSectionCount;
 	};
 
 }	// namespace LibISDB
@@ -37,6 +37,8 @@ PSITableBase::PSITableBase(bool ExtendedSection, bool IgnoreSectionNumber)
 	: m_PSISectionParser(this, ExtendedSection, IgnoreSectionNumber)
 	, m_UniqueID(0)
 {
+	// 繰り返し送出される同じ内容のセクションは処理しない
+	m_PSISectionParser.SetSectionCacheEnabled(true);
 }
 
 
@@ -58,6 +60,46 @@ void PSITableBase::SetSectionHandler(const SectionHandler &Handler)
 }
 
 
+void PSITableBase::SetSectionCacheEnabled(bool Enabled)
+{
+	m_PSISectionParser.SetSectionCacheEnabled(Enabled);
+}
+
+
+bool PSITableBase::IsSectionCacheEnabled() const noexcept
+{
+	return m_PSISectionParser.IsSectionCacheEnabled();
+}
+
+
+void PSITableBase::ClearSectionCache() noexcept
+{
+	m_PSISectionParser.ClearSectionCache();
+}
+
+
+void PSITableBase::SetSectionFilter(const PSISectionFilter &Filter)
+{
+	m_PSISectionParser.SetSectionFilter(Filter);
+}
+
+
+const PSISectionFilter & PSITableBase::GetSectionFilter() const noexcept
+{
+	return m_PSISectionParser.GetSectionFilter();
+}
+
+
+bool PSITableBase::StoreSection(const PSISection *pSection)
+{
+	// パケットを経由せずにセクションを直接渡す
+	if (pSection == nullptr)
+		return false;
+
+	return OnPSISection(&m_PSISectionParser, pSection);
+}
+
+
 bool PSITableBase::StorePacket(const TSPacket *pPacket)
 {
 	if (pPacket == nullptr)
@@ -198,6 +240,8 @@ bool PSITable::ResetTable(int Index)
 		Section.IsUpdated = false;
 	}
 
+	ClearSectionCache();
+
 	return true;
 }
 
@@ -217,6 +261,8 @@ bool PSITable::ResetSection(int Index, uint16_t SectionNumber)
 	Section.Table.reset();
 	Section.IsUpdated = false;
 
+	ClearSectionCache();
+
 	return true;
 }
 
@@ -345,6 +391,8 @@ bool PSISingleTable::OnTableUpdate(const PSISection *pCurSection, const PSISecti
 PSIStreamTable::PSIStreamTable(bool ExtendedSection, bool IgnoreSectionNumber)
 	: PSITableBase(ExtendedSection, IgnoreSectionNumber)
 {
+	// 全てのセクションを処理する
+	SetSectionCacheEnabled(false);
 }
 
 
@@ -419,6 +467,9 @@ bool PSITableSet::MapTable(uint8_t TableID, PSITableBase *pTable)
 
 	m_TableMap.emplace(TableID, pTable);
 
+	UpdateTableIDFilter();
+	UpdateSectionCacheEnabled();
+
 	return true;
 }
 
@@ -432,6 +483,9 @@ bool PSITableSet::UnmapTable(uint8_t TableID)
 
 	m_TableMap.erase(it);
 
+	UpdateTableIDFilter();
+	UpdateSectionCacheEnabled();
+
 	return true;
 }
 
@@ -439,6 +493,9 @@ bool PSITableSet::UnmapTable(uint8_t TableID)
 void PSITableSet::UnmapAllTables()
 {
 	m_TableMap.clear();
+
+	UpdateTableIDFilter();
+	UpdateSectionCacheEnabled();
 }
 
 
@@ -496,4 +553,34 @@ bool PSITableSet::OnPSISection(const PSISectionParser *pSectionParser, const PSI
 }
 
 
+void PSITableSet::UpdateSectionCacheEnabled()
+{
+	// 全てのセクションを必要とするテーブルが無くなれば再び有効にする
+	bool Enabled = true;
+
+	for (const auto &e : m_TableMap) {
+		if (!e.second->IsSectionCacheEnabled()) {
+			Enabled = false;
+			break;
+		}
+	}
+
+	if (Enabled != IsSectionCacheEnabled())
+		SetSectionCacheEnabled(Enabled);
+}
+
+
+void PSITableSet::UpdateTableIDFilter()
+{
+	// 割り当てられていない table_id のセクションはヘッダの解析後に破棄する
+	PSISectionFilter Filter = m_PSISectionParser.GetSectionFilter();
+
+	Filter.SetAllTableIDs(false);
+	for (auto &e : m_TableMap)
+		Filter.SetTableID(e.first);
+
+	m_PSISectionParser.SetSectionFilter(Filter);
+}
+
+
 }	// namespace LibISDB
@@ -53,7 +53,7 @@ namespace LibISDB
 			return std::bind(pFunc, pObject, std::placeholders::_1, std::placeholders::_2);
 		}
 
-		template<typename TTable, typename THandler> static PSITableBase * CreateWithHandler(
+		template<typename TTable, typename THandler> static TTable * CreateWithHandler(
 			void (THandler::*pFunc)(const PSITableBase *, const PSISection *), THandler *pObject)
 		{
 			TTable *pTable = new TTable;
@@ -73,6 +73,15 @@ namespace LibISDB
 
 		void SetSectionHandler(const SectionHandler &Handler);
 
+		void SetSectionCacheEnabled(bool Enabled);
+		bool IsSectionCacheEnabled() const noexcept;
+		void ClearSectionCache() noexcept;
+
+		void SetSectionFilter(const PSISectionFilter &Filter);
+		const PSISectionFilter & GetSectionFilter() const noexcept;
+
+		bool StoreSection(const PSISection *pSection);
+
 	// PIDMapTarget
 		bool StorePacket(const TSPacket *pPacket) override;
 		void OnPIDUnmapped(uint16_t PID) override;
@@ -214,6 +223,9 @@ namespace LibISDB
 	// PSISectionParser::PSISectionHandler
 		bool OnPSISection(const PSISectionParser *pSectionParser, const PSISection *pSection) override;
 
+		void UpdateTableIDFilter();
+		void UpdateSectionCacheEnabled();
+
 		typedef std::map<uint8_t, std::unique_ptr<PSITableBase>> SectionTableMap;
 		SectionTableMap m_TableMap;
 
@@ -0,0 +1,314 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   SICache.cpp
+ @brief  SI キャッシュ
+ @author DBCTRADO
+*/
+
+
+#include "../LibISDBPrivate.hpp"
+#include "SICache.hpp"
+#include "../Base/FileStream.hpp"
+#include "../Utilities/CRC.hpp"
+#include "../Utilities/Utilities.hpp"
+#include <cstring>
+#include "../Base/DebugDef.hpp"
+
+
+namespace LibISDB
+{
+
+
+namespace
+{
+
+
+/*
+	ファイルの各ヘッダはホストのバイトオーダーに依らずビッグエンディアンで格納する
+
+	FileHeader    : Type[8] / Version(32) / StreamCount(32)
+	StreamHeader  : NetworkID(16) / TransportStreamID(16) / SectionCount(16) / Reserved(16)
+	SectionHeader : PID(16) / Size(16)
+*/
+
+constexpr uint8_t FileHeader_Type[8] = {'S', 'I', '-', 'C', 'A', 'C', 'H', 'E'};
+constexpr uint32_t FileHeader_Version = 1;
+constexpr size_t FileHeader_Size = 16;
+constexpr size_t StreamHeader_Size = 8;
+constexpr size_t SectionHeader_Size = 4;
+
+
+}
+
+
+
+
+SICache::SICache() noexcept
+	: m_IsUpdated(false)
+{
+}
+
+
+bool SICache::StoreSections(uint16_t NetworkID, uint16_t TransportStreamID, const SectionList &List)
+{
+	if ((NetworkID == NETWORK_ID_INVALID) || (TransportStreamID == TRANSPORT_STREAM_ID_INVALID)
+			|| List.empty())
+		return false;
+
+	BlockLock Lock(m_Lock);
+
+	SectionList &Sections = m_StreamMap[StreamKey(NetworkID, TransportStreamID)];
+
+	if (Sections.size() == List.size()) {
+		bool IsSame = true;
+		for (size_t i = 0; i < List.size(); i++) {
+			if ((Sections[i].PID != List[i].PID) || (Sections[i].Data != List[i].Data)) {
+				IsSame = false;
+				break;
+			}
+		}
+		if (IsSame)
+			return true;
+	}
+
+	Sections = List;
+	m_IsUpdated = true;
+
+	return true;
+}
+
+
+bool SICache::GetSections(uint16_t NetworkID, uint16_t TransportStreamID, ReturnArg<SectionList> List) const
+{
+	if (!List)
+		return false;
+
+	BlockLock Lock(m_Lock);
+
+	auto it = m_StreamMap.find(StreamKey(NetworkID, TransportStreamID));
+	if (it == m_StreamMap.end())
+		return false;
+
+	*List = it->second;
+
+	return true;
+}
+
+
+bool SICache::HasStream(uint16_t NetworkID, uint16_t TransportStreamID) const
+{
+	BlockLock Lock(m_Lock);
+
+	return m_StreamMap.find(StreamKey(NetworkID, TransportStreamID)) != m_StreamMap.end();
+}
+
+
+bool SICache::RemoveStream(uint16_t NetworkID, uint16_t TransportStreamID)
+{
+	BlockLock Lock(m_Lock);
+
+	auto it = m_StreamMap.find(StreamKey(NetworkID, TransportStreamID));
+	if (it == m_StreamMap.end())
+		return false;
+
+	m_StreamMap.erase(it);
+	m_IsUpdated = true;
+
+	return true;
+}
+
+
+size_t SICache::GetStreamCount() const
+{
+	BlockLock Lock(m_Lock);
+
+	return m_StreamMap.size();
+}
+
+
+void SICache::Clear()
+{
+	BlockLock Lock(m_Lock);
+
+	if (!m_StreamMap.empty()) {
+		m_StreamMap.clear();
+		m_IsUpdated = true;
+	}
+}
+
+
+bool SICache::IsUpdated() const
+{
+	BlockLock Lock(m_Lock);
+
+	return m_IsUpdated;
+}
+
+
+bool SICache::LoadFile(const String &FileName)
+{
+	if (LIBISDB_TRACE_ERROR_IF(FileName.empty()))
+		return false;
+
+	BufferedFileStream File;
+
+	if (!File.Open(
+				FileName,
+				FileStream::OpenFlag::Read |
+				FileStream::OpenFlag::ShareRead |
+				FileStream::OpenFlag::SequentialRead)) {
+		Log(Logger::LogType::Error, LIBISDB_STR("SIキャッシュファイルを開けません。"));
+		return false;
+	}
+
+	uint8_t Header[FileHeader_Size];
+
+	if ((File.Read(Header, sizeof(Header)) != sizeof(Header))
+			|| (std::memcmp(Header, FileHeader_Type, sizeof(FileHeader_Type)) != 0)
+			|| (Load32(&Header[8]) != FileHeader_Version)) {
+		Log(Logger::LogType::Error, LIBISDB_STR("SIキャッシュファイルが未知の形式のため読み込めません。"));
+		return false;
+	}
+
+	const uint32_t StreamCount = Load32(&Header[12]);
+	std::map<uint32_t, SectionList> StreamMap;
+
+	for (uint32_t i = 0; i < StreamCount; i++) {
+		uint8_t Stream[StreamHeader_Size];
+
+		if (File.Read(Stream, sizeof(Stream)) != sizeof(Stream))
+			break;
+
+		const uint16_t NetworkID = Load16(&Stream[0]);
+		const uint16_t TransportStreamID = Load16(&Stream[2]);
+		const uint16_t SectionCount = Load16(&Stream[4]);
+
+		SectionList Sections;
+		Sections.reserve(SectionCount);
+
+		for (uint16_t j = 0; j < SectionCount; j++) {
+			uint8_t Section[SectionHeader_Size];
+
+			if (File.Read(Section, sizeof(Section)) != sizeof(Section))
+				break;
+
+			const uint16_t Size = Load16(&Section[2]);
+			SectionData &Data = Sections.emplace_back();
+			Data.PID = Load16(&Section[0]);
+			Data.Data.resize(Size);
+			if (File.Read(Data.Data.data(), Size) != Size) {
+				Sections.pop_back();
+				break;
+			}
+
+			// 壊れたセクションは除外する
+			if (!IsValidSection(Data.Data.data(), Data.Data.size()))
+				Sections.pop_back();
+		}
+
+		if (Sections.size() != SectionCount) {
+			Log(Logger::LogType::Warning, LIBISDB_STR("SIキャッシュファイルのデータが壊れています。"));
+			if (File.IsEnd())
+				break;
+			continue;
+		}
+
+		StreamMap[StreamKey(NetworkID, TransportStreamID)] = std::move(Sections);
+	}
+
+	BlockLock Lock(m_Lock);
+
+	m_StreamMap = std::move(StreamMap);
+	m_IsUpdated = false;
+
+	return true;
+}
+
+
+bool SICache::SaveFile(const String &FileName)
+{
+	if (LIBISDB_TRACE_ERROR_IF(FileName.empty()))
+		return false;
+
+	BufferedFileStream File;
+
+	if (!File.Open(
+				FileName,
+				FileStream::OpenFlag::Write |
+				FileStream::OpenFlag::Create |
+				FileStream::OpenFlag::Truncate)) {
+		Log(Logger::LogType::Error, LIBISDB_STR("SIキャッシュファイルを開けません。"));
+		return false;
+	}
+
+	BlockLock Lock(m_Lock);
+
+	uint8_t Header[FileHeader_Size];
+	std::memcpy(Header, FileHeader_Type, sizeof(FileHeader_Type));
+	Store32(&Header[8], FileHeader_Version);
+	Store32(&Header[12], static_cast<uint32_t>(m_StreamMap.size()));
+
+	bool OK = File.Write(Header, sizeof(Header)) == sizeof(Header);
+
+	for (auto it = m_StreamMap.begin(); OK && (it != m_StreamMap.end()); ++it) {
+		uint8_t Stream[StreamHeader_Size];
+		Store16(&Stream[0], static_cast<uint16_t>(it->first >> 16));
+		Store16(&Stream[2], static_cast<uint16_t>(it->first & 0xFFFF));
+		Store16(&Stream[4], static_cast<uint16_t>(it->second.size()));
+		Store16(&Stream[6], 0);
+
+		OK = File.Write(Stream, sizeof(Stream)) == sizeof(Stream);
+
+		for (auto itSection = it->second.begin(); OK && (itSection != it->second.end()); ++itSection) {
+			uint8_t Section[SectionHeader_Size];
+			Store16(&Section[0], itSection->PID);
+			Store16(&Section[2], static_cast<uint16_t>(itSection->Data.size()));
+
+			OK = (File.Write(Section, sizeof(Section)) == sizeof(Section))
+				&& (File.Write(itSection->Data.data(), itSection->Data.size()) == itSection->Data.size());
+		}
+	}
+
+	if (!OK) {
+		Log(Logger::LogType::Error, LIBISDB_STR("SIキャッシュファイルの書き出しでエラーが発生しました。"));
+		return false;
+	}
+
+	m_IsUpdated = false;
+
+	return true;
+}
+
+
+bool SICache::IsValidSection(const uint8_t *pData, size_t Size)
+{
+	if ((pData == nullptr) || (Size < 3 + 5 + 4))
+		return false;
+
+	const size_t SectionLength = ((pData[1] & 0x0F) << 8) | pData[2];
+	if (SectionLength + 3 != Size)
+		return false;
+
+	return CRC32MPEG2::Calc(pData, Size) == 0;
+}
+
+
+}	// namespace LibISDB
@@ -0,0 +1,84 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   SICache.hpp
+ @brief  SI キャッシュ
+ @author DBCTRADO
+*/
+
+
+#ifndef LIBISDB_SI_CACHE_H
+#define LIBISDB_SI_CACHE_H
+
+
+#include "../Base/ObjectBase.hpp"
+#include "../Utilities/Lock.hpp"
+#include <vector>
+#include <map>
+
+
+namespace LibISDB
+{
+
+	/** SI キャッシュクラス */
+	class SICache
+		: public ObjectBase
+	{
+	public:
+		struct SectionData {
+			uint16_t PID;
+			std::vector<uint8_t> Data;
+		};
+
+		typedef std::vector<SectionData> SectionList;
+
+		static constexpr uint32_t StreamKey(uint16_t NetworkID, uint16_t TransportStreamID) {
+			return (static_cast<uint32_t>(NetworkID) << 16) | static_cast<uint32_t>(TransportStreamID);
+		}
+
+		SICache() noexcept;
+
+	// ObjectBase
+		const CharType * GetObjectName() const noexcept override { return LIBISDB_STR("SICache"); }
+
+	// SICache
+		bool StoreSections(uint16_t NetworkID, uint16_t TransportStreamID, const SectionList &List);
+		bool GetSections(uint16_t NetworkID, uint16_t TransportStreamID, ReturnArg<SectionList> List) const;
+		bool HasStream(uint16_t NetworkID, uint16_t TransportStreamID) const;
+		bool RemoveStream(uint16_t NetworkID, uint16_t TransportStreamID);
+		size_t GetStreamCount() const;
+		void Clear();
+		bool IsUpdated() const;
+
+		bool LoadFile(const String &FileName);
+		bool SaveFile(const String &FileName);
+
+		static bool IsValidSection(const uint8_t *pData, size_t Size);
+
+	protected:
+		std::map<uint32_t, SectionList> m_StreamMap;
+		bool m_IsUpdated;
+		mutable MutexLock m_Lock;
+	};
+
+}	// namespace LibISDB
+
+
+#endif	// ifndef LIBISDB_SI_CACHE_H
@@ -132,6 +132,34 @@ bool StreamSelector::SetTarget(uint16_t ServiceID, StreamFlag StreamFlags)
 }
 
 
+bool StreamSelector::GetTargetVideoPIDList(std::vector<uint16_t> *pList) const
+{
+	if (LIBISDB_TRACE_ERROR_IF(pList == nullptr))
+		return false;
+
+	pList->clear();
+
+	for (auto const &PMT : m_PMTPIDList) {
+		if ((m_TargetServiceID == SERVICE_ID_INVALID) || (m_TargetServiceID == PMT.ServiceID)) {
+			for (const ESInfo ES : PMT.ESList) {
+				switch (ES.StreamType) {
+				case STREAM_TYPE_MPEG1_VIDEO:
+				case STREAM_TYPE_MPEG2_VIDEO:
+				case STREAM_TYPE_MPEG4_VISUAL:
+				case STREAM_TYPE_H264:
+				case STREAM_TYPE_H265:
+					if (!m_TargetStreamTypeEnabled || m_TargetStreamType[ES.StreamType])
+						pList->push_back(ES.PID);
+					break;
+				}
+			}
+		}
+	}
+
+	return !pList->empty();
+}
+
+
 void StreamSelector::SetGeneratePAT(bool Generate)
 {
 	m_GeneratePAT = Generate;
@@ -95,6 +95,7 @@ namespace LibISDB
 		bool SetTarget(uint16_t ServiceID, StreamFlag StreamFlags);
 		uint16_t GetTargetServiceID() const noexcept { return m_TargetServiceID; }
 		const StreamTypeTable & GetTargetStreamType() const noexcept { return m_TargetStreamType; }
+		bool GetTargetVideoPIDList(std::vector<uint16_t> *pList) const;
 		void SetGeneratePAT(bool Generate);
 		bool GetGeneratePAT() const noexcept { return m_GeneratePAT; }
 
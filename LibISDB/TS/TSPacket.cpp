@@ -217,6 +217,22 @@ uint8_t TSPacket::GetPayloadSize() const
 }
 
 
+uint64_t TSPacket::GetPCR() const noexcept
+{
+	if (!GetPCRFlag() || (m_AdaptationField.OptionSize < 5))
+		return PCR_INVALID;
+
+	// program_clock_reference_base (33bit 90kHz)
+	const uint8_t *pOptionData = &m_pData[6];
+	return
+		(static_cast<uint64_t>(pOptionData[0]) << 25) |
+		(static_cast<uint64_t>(pOptionData[1]) << 17) |
+		(static_cast<uint64_t>(pOptionData[2]) <<  9) |
+		(static_cast<uint64_t>(pOptionData[3]) <<  1) |
+		(static_cast<uint64_t>(pOptionData[4]) >>  7);
+}
+
+
 void TSPacket::SetPID(uint16_t PID)
 {
 	Store16(&m_pData[1], ((m_pData[1] & 0xE0) << 8) | (PID & 0x1FFF));
@@ -116,6 +116,7 @@ namespace LibISDB
 		bool GetAdaptationFieldExtFlag() const noexcept { return (m_AdaptationField.Flags & AdaptationFieldFlag::AdaptationFieldExtFlag) != 0; }
 		const uint8_t * GetOptionData() const noexcept { return m_AdaptationField.OptionSize ? &m_pData[6] : nullptr; }
 		uint8_t GetOptionSize() const noexcept { return m_AdaptationField.OptionSize; }
+		uint64_t GetPCR() const noexcept;
 
 	private:
 	// DataBuffer
@@ -141,18 +141,10 @@ void CATTable::Reset()
 
 const CADescriptor * CATTable::GetCADescriptorBySystemID(uint16_t SystemID) const
 {
-	for (int i = 0; i < m_DescriptorBlock.GetDescriptorCount(); i++) {
-		const DescriptorBase *pDescriptor = m_DescriptorBlock.GetDescriptorByIndex(i);
-
-		if ((pDescriptor != nullptr) && (pDescriptor->GetTag() == CADescriptor::TAG)) {
-			const CADescriptor *pCADescriptor = dynamic_cast<const CADescriptor *>(pDescriptor);
-
-			if ((pCADescriptor != nullptr) && (pCADescriptor->GetCASystemID() == SystemID))
-				return pCADescriptor;
-		}
-	}
-
-	return nullptr;
+	return m_DescriptorBlock.FindDescriptor<CADescriptor>(
+		[SystemID](const CADescriptor *pCADescriptor) -> bool {
+			return pCADescriptor->GetCASystemID() == SystemID;
+		});
 }
 
 
@@ -250,18 +242,14 @@ uint16_t PMTTable::GetECMPID() const
 uint16_t PMTTable::GetECMPID(uint16_t CASystemID) const
 {
 	// 指定された CA_system_id に対応する ECM の PID を返す
-	for (int i = 0; i < m_DescriptorBlock.GetDescriptorCount(); i++) {
-		const DescriptorBase *pDescriptor = m_DescriptorBlock.GetDescriptorByIndex(i);
-
-		if ((pDescriptor != nullptr) && (pDescriptor->GetTag() == CADescriptor::TAG)) {
-			const CADescriptor *pCADescriptor = dynamic_cast<const CADescriptor *>(pDescriptor);
-
-			if ((pCADescriptor != nullptr) && (pCADescriptor->GetCASystemID() == CASystemID))
-				return pCADescriptor->GetCAPID();
-		}
-	}
+	const CADescriptor *pCADescriptor = m_DescriptorBlock.FindDescriptor<CADescriptor>(
+		[CASystemID](const CADescriptor *pDesc) -> bool {
+			return pDesc->GetCASystemID() == CASystemID;
+		});
+	if (pCADescriptor == nullptr)
+		return PID_INVALID;
 
-	return PID_INVALID;
+	return pCADescriptor->GetCAPID();
 }
 
 
@@ -1021,6 +1009,9 @@ bool EITPfScheduleTable::ResetScheduleService(
 		}
 	}
 
+	if (ResetPerformed)
+		ClearSectionCache();
+
 	return ResetPerformed;
 }
 
@@ -1492,16 +1483,10 @@ bool PCRTable::StorePacket(const TSPacket *pPacket)
 		return false;
 
 	if (pPacket->GetPCRFlag()) {
-		if (pPacket->GetOptionSize() < 5)
+		const uint64_t PCR = pPacket->GetPCR();
+		if (PCR == PCR_INVALID)
 			return false;
-
-		const uint8_t *pOptionData = pPacket->GetOptionData();
-		m_PCR =
-			(static_cast<uint64_t>(pOptionData[0]) << 25) |
-			(static_cast<uint64_t>(pOptionData[1]) << 17) |
-			(static_cast<uint64_t>(pOptionData[2]) <<  9) |
-			(static_cast<uint64_t>(pOptionData[3]) <<  1) |
-			(static_cast<uint64_t>(pOptionData[4]) >>  7);
+		m_PCR = PCR;
 	}
 
 	return true;
@@ -27,6 +27,18 @@
 #include "../LibISDBPrivate.hpp"
 #include "CRC.hpp"
 #include "Utilities.hpp"
+#include "../Base/SIMD.hpp"
+
+#if defined(LIBISDB_CRC_PCLMULQDQ) && defined(LIBISDB_SSE2_SUPPORT)
+#define LIBISDB_CRC_PCLMULQDQ_SUPPORT
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define LIBISDB_PCLMULQDQ_TARGET __attribute__((target("pclmul,ssse3")))
+#else
+#define LIBISDB_PCLMULQDQ_TARGET
+#endif
+#endif
 
 
 namespace LibISDB
@@ -173,7 +185,7 @@ CRC16CCITT::ValueType CRC16CCITT::Calc(const uint8_t *pData, size_t DataSize, Va
 
 
 
-CRC32::ValueType CRC32::Calc(const uint8_t *pData, size_t DataSize, ValueType CRC) noexcept
+CRC32::ValueType CRC32::CalcTable(const uint8_t *pData, size_t DataSize, ValueType CRC) noexcept
 {
 	static const uint32_t Table[256] = {
 		0x00000000_u32, 0x77073096_u32, 0xEE0E612C_u32, 0x990951BA_u32, 0x076DC419_u32, 0x706AF48F_u32, 0xE963A535_u32, 0x9E6495A3_u32,
@@ -264,11 +276,11 @@ static const uint32_t g_CRC32MPEG2Table[256] = {
 
 // Dilip V. Sarwate のアルゴリズム
 
-CRC32MPEG2::ValueType CRC32MPEG2::Calc(const uint8_t *pData, size_t DataSize, ValueType CRC) noexcept
+CRC32MPEG2::ValueType CRC32MPEG2::CalcTable(const uint8_t *pData, size_t DataSize, ValueType CRC) noexcept
 {
 	const uint8_t *pEnd = pData + DataSize;
 
-	while (const uint8_t *p = pData; p < pEnd; p++) {
+	for (const uint8_t *p = pData; p < pEnd; p++) {
 		CRC = (CRC << 8) ^ g_CRC32MPEG2Table[(CRC >> 24) ^ *p];
 	}
 
@@ -277,7 +289,7 @@ CRC32MPEG2::ValueType CRC32MPEG2::Calc(const uint8_t *pData, size_t DataSize, Va
 
 #else
 
-CRC32MPEG2::ValueType CRC32MPEG2::Calc(const uint8_t *pData, size_t DataSize, ValueType CRC) noexcept
+CRC32MPEG2::ValueType CRC32MPEG2::CalcTable(const uint8_t *pData, size_t DataSize, ValueType CRC) noexcept
 {
 	static CRC32SlicingTable Table(g_CRC32MPEG2Table);
 
@@ -347,4 +359,233 @@ CRC32MPEG2::ValueType CRC32MPEG2::Calc(const uint8_t *pData, size_t DataSize, Va
 #endif
 
 
+
+
+#ifdef LIBISDB_CRC_PCLMULQDQ_SUPPORT
+
+namespace
+{
+
+
+// PCLMULQDQ による畳み込みを行うサイズの下限
+constexpr size_t PCLMULQDQ_MIN_SIZE = 64;
+
+
+LIBISDB_PCLMULQDQ_TARGET
+inline __m128i FoldCRC128(__m128i Value, __m128i Constant, __m128i Data) noexcept
+{
+	return _mm_xor_si128(
+		_mm_xor_si128(
+			_mm_clmulepi64_si128(Value, Constant, 0x11),
+			_mm_clmulepi64_si128(Value, Constant, 0x00)),
+		Data);
+}
+
+
+/*
+	CRC-32 (ビット反転)
+	DataSize は 64 以上の 16 の倍数であること
+	CRC は反転された内部状態を渡し、内部状態が返される
+*/
+LIBISDB_PCLMULQDQ_TARGET
+uint32_t CalcCRC32PCLMULQDQ(const uint8_t *pData, size_t DataSize, uint32_t CRC) noexcept
+{
+	const __m128i *p = reinterpret_cast<const __m128i *>(pData);
+	__m128i x0, x1, x2, x3, k, Mask;
+
+	x0 = _mm_xor_si128(_mm_loadu_si128(p + 0), _mm_cvtsi32_si128(static_cast<int>(CRC)));
+	x1 = _mm_loadu_si128(p + 1);
+	x2 = _mm_loadu_si128(p + 2);
+	x3 = _mm_loadu_si128(p + 3);
+	p += 4;
+	DataSize -= 64;
+
+	// 512 ビットずつ 4 並列で畳み込む
+	k = _mm_set_epi64x(0x01C6E41596_i64, 0x0154442BD4_i64);
+	while (DataSize >= 64) {
+		x0 = FoldCRC128(x0, k, _mm_loadu_si128(p + 0));
+		x1 = FoldCRC128(x1, k, _mm_loadu_si128(p + 1));
+		x2 = FoldCRC128(x2, k, _mm_loadu_si128(p + 2));
+		x3 = FoldCRC128(x3, k, _mm_loadu_si128(p + 3));
+		p += 4;
+		DataSize -= 64;
+	}
+
+	// 128 ビットにまとめる
+	k = _mm_set_epi64x(0x00CCAA009E_i64, 0x01751997D0_i64);
+	x1 = FoldCRC128(x0, k, x1);
+	x2 = FoldCRC128(x1, k, x2);
+	x0 = FoldCRC128(x2, k, x3);
+	while (DataSize >= 16) {
+		x0 = FoldCRC128(x0, k, _mm_loadu_si128(p));
+		p++;
+		DataSize -= 16;
+	}
+
+	// 128 ビット -> 64 ビット
+	Mask = _mm_setr_epi32(-1, 0, -1, 0);
+	x1 = _mm_xor_si128(_mm_clmulepi64_si128(x0, k, 0x10), _mm_srli_si128(x0, 8));
+	k = _mm_set_epi64x(0, 0x0163CD6124_i64);
+	x0 = _mm_xor_si128(
+		_mm_clmulepi64_si128(_mm_and_si128(x1, Mask), k, 0x00),
+		_mm_srli_si128(x1, 4));
+
+	// Barrett reduction
+	k = _mm_set_epi64x(0x01F7011641_i64, 0x01DB710641_i64);
+	x1 = _mm_and_si128(_mm_clmulepi64_si128(_mm_and_si128(x0, Mask), k, 0x10), Mask);
+	x0 = _mm_xor_si128(x0, _mm_clmulepi64_si128(x1, k, 0x00));
+
+	return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(x0, 4)));
+}
+
+
+/*
+	CRC-32/MPEG-2 (ビット非反転)
+	DataSize は 64 以上の 16 の倍数であること
+*/
+LIBISDB_PCLMULQDQ_TARGET
+uint32_t CalcCRC32MPEG2PCLMULQDQ(const uint8_t *pData, size_t DataSize, uint32_t CRC) noexcept
+{
+	// 先頭のバイトが上位に来るようにバイト順を反転する
+	const __m128i Swap = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	const __m128i *p = reinterpret_cast<const __m128i *>(pData);
+	__m128i x0, x1, x2, x3, k;
+
+	x0 = _mm_shuffle_epi8(_mm_loadu_si128(p + 0), Swap);
+	x1 = _mm_shuffle_epi8(_mm_loadu_si128(p + 1), Swap);
+	x2 = _mm_shuffle_epi8(_mm_loadu_si128(p + 2), Swap);
+	x3 = _mm_shuffle_epi8(_mm_loadu_si128(p + 3), Swap);
+	x0 = _mm_xor_si128(x0, _mm_slli_si128(_mm_cvtsi32_si128(static_cast<int>(CRC)), 12));
+	p += 4;
+	DataSize -= 64;
+
+	// x^(512+64) mod P, x^512 mod P
+	k = _mm_set_epi64x(0x8833794C_i64, 0xE6228B11_i64);
+	while (DataSize >= 64) {
+		x0 = FoldCRC128(x0, k, _mm_shuffle_epi8(_mm_loadu_si128(p + 0), Swap));
+		x1 = FoldCRC128(x1, k, _mm_shuffle_epi8(_mm_loadu_si128(p + 1), Swap));
+		x2 = FoldCRC128(x2, k, _mm_shuffle_epi8(_mm_loadu_si128(p + 2), Swap));
+		x3 = FoldCRC128(x3, k, _mm_shuffle_epi8(_mm_loadu_si128(p + 3), Swap));
+		p += 4;
+		DataSize -= 64;
+	}
+
+	// x^(128+64) mod P, x^128 mod P
+	k = _mm_set_epi64x(0xC5B9CD4C_i64, 0xE8A45605_i64);
+	x1 = FoldCRC128(x0, k, x1);
+	x2 = FoldCRC128(x1, k, x2);
+	x0 = FoldCRC128(x2, k, x3);
+	while (DataSize >= 16) {
+		x0 = FoldCRC128(x0, k, _mm_shuffle_epi8(_mm_loadu_si128(p), Swap));
+		p++;
+		DataSize -= 16;
+	}
+
+	// x^32 を掛けて 64 ビットまで縮める (x^96 mod P, x^64 mod P)
+	k = _mm_set_epi64x(0xF200AA66_i64, 0x490D678D_i64);
+	x0 = _mm_xor_si128(_mm_clmulepi64_si128(x0, k, 0x11), _mm_slli_si128(_mm_move_epi64(x0), 4));
+	x0 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_srli_si128(x0, 8), k, 0x00), _mm_move_epi64(x0));
+
+	// Barrett reduction (P, x^64 / P)
+	k = _mm_set_epi64x(0x104C11DB7_i64, 0x104D101DF_i64);
+	x1 = _mm_srli_epi64(_mm_clmulepi64_si128(_mm_srli_epi64(x0, 32), k, 0x00), 32);
+	x0 = _mm_xor_si128(x0, _mm_clmulepi64_si128(x1, k, 0x10));
+
+	return static_cast<uint32_t>(_mm_cvtsi128_si32(x0));
+}
+
+
+}	// namespace
+
+#endif	// LIBISDB_CRC_PCLMULQDQ_SUPPORT
+
+
+CRC32::ValueType CRC32::Calc(const uint8_t *pData, size_t DataSize, ValueType CRC) noexcept
+{
+#ifdef LIBISDB_CRC_PCLMULQDQ_SUPPORT
+	if ((DataSize >= PCLMULQDQ_MIN_SIZE) && IsPCLMULQDQEnabled()) {
+		const size_t FoldSize = DataSize & ~15_z;
+		CRC = ~CalcCRC32PCLMULQDQ(pData, FoldSize, ~CRC);
+		pData += FoldSize;
+		DataSize -= FoldSize;
+	}
+#endif
+
+	return CalcTable(pData, DataSize, CRC);
+}
+
+
+void CRC32::CalcMultiple(
+	const uint8_t * const *ppDataList, const size_t *pSizeList, size_t Count,
+	ValueType *pCRCList, ValueType CRC) noexcept
+{
+#ifdef LIBISDB_CRC_PCLMULQDQ_SUPPORT
+	if (IsPCLMULQDQEnabled()) {
+		for (size_t i = 0; i < Count; i++) {
+			const uint8_t *pData = ppDataList[i];
+			size_t DataSize = pSizeList[i];
+			ValueType Value = CRC;
+
+			if (DataSize >= PCLMULQDQ_MIN_SIZE) {
+				const size_t FoldSize = DataSize & ~15_z;
+				Value = ~CalcCRC32PCLMULQDQ(pData, FoldSize, ~Value);
+				pData += FoldSize;
+				DataSize -= FoldSize;
+			}
+
+			pCRCList[i] = CalcTable(pData, DataSize, Value);
+		}
+		return;
+	}
+#endif
+
+	for (size_t i = 0; i < Count; i++)
+		pCRCList[i] = CalcTable(ppDataList[i], pSizeList[i], CRC);
+}
+
+
+CRC32MPEG2::ValueType CRC32MPEG2::Calc(const uint8_t *pData, size_t DataSize, ValueType CRC) noexcept
+{
+#ifdef LIBISDB_CRC_PCLMULQDQ_SUPPORT
+	if ((DataSize >= PCLMULQDQ_MIN_SIZE) && IsPCLMULQDQEnabled()) {
+		const size_t FoldSize = DataSize & ~15_z;
+		CRC = CalcCRC32MPEG2PCLMULQDQ(pData, FoldSize, CRC);
+		pData += FoldSize;
+		DataSize -= FoldSize;
+	}
+#endif
+
+	return CalcTable(pData, DataSize, CRC);
+}
+
+
+void CRC32MPEG2::CalcMultiple(
+	const uint8_t * const *ppDataList, const size_t *pSizeList, size_t Count,
+	ValueType *pCRCList, ValueType CRC) noexcept
+{
+#ifdef LIBISDB_CRC_PCLMULQDQ_SUPPORT
+	if (IsPCLMULQDQEnabled()) {
+		for (size_t i = 0; i < Count; i++) {
+			const uint8_t *pData = ppDataList[i];
+			size_t DataSize = pSizeList[i];
+			ValueType Value = CRC;
+
+			if (DataSize >= PCLMULQDQ_MIN_SIZE) {
+				const size_t FoldSize = DataSize & ~15_z;
+				Value = CalcCRC32MPEG2PCLMULQDQ(pData, FoldSize, Value);
+				pData += FoldSize;
+				DataSize -= FoldSize;
+			}
+
+			pCRCList[i] = CalcTable(pData, DataSize, Value);
+		}
+		return;
+	}
+#endif
+
+	for (size_t i = 0; i < Count; i++)
+		pCRCList[i] = CalcTable(ppDataList[i], pSizeList[i], CRC);
+}
+
+
 }	// namespace LibISDB
@@ -56,6 +56,10 @@ namespace LibISDB
 		static constexpr ValueType InitialValue = 0x00000000_u32;
 
 		static ValueType Calc(const uint8_t *pData, size_t DataSize, ValueType CRC = InitialValue) noexcept;
+		static ValueType CalcTable(const uint8_t *pData, size_t DataSize, ValueType CRC = InitialValue) noexcept;
+		static void CalcMultiple(
+			const uint8_t * const *ppDataList, const size_t *pSizeList, size_t Count,
+			ValueType *pCRCList, ValueType CRC = InitialValue) noexcept;
 	};
 
 	/**< CRC-32/MPEG-2 (ISO/IEC 13818-1) */
@@ -64,6 +68,10 @@ namespace LibISDB
 		static constexpr ValueType InitialValue = 0xFFFFFFFF_u32;
 
 		static ValueType Calc(const uint8_t *pData, size_t DataSize, ValueType CRC = InitialValue) noexcept;
+		static ValueType CalcTable(const uint8_t *pData, size_t DataSize, ValueType CRC = InitialValue) noexcept;
+		static void CalcMultiple(
+			const uint8_t * const *ppDataList, const size_t *pSizeList, size_t Count,
+			ValueType *pCRCList, ValueType CRC = InitialValue) noexcept;
 	};
 
 }	// namespace LibISDB
@@ -0,0 +1,114 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   LatencyHistogram.cpp
+ @brief  処理時間ヒストグラム
+ @author DBCTRADO
+*/
+
+
+#include "../LibISDBPrivate.hpp"
+#include "LatencyHistogram.hpp"
+#include <bit>
+#include "../Base/DebugDef.hpp"
+
+
+namespace LibISDB
+{
+
+
+LatencyHistogram::LatencyHistogram() noexcept
+{
+	Reset();
+}
+
+
+void LatencyHistogram::Add(const std::chrono::microseconds &Time) noexcept
+{
+	const unsigned long long Value = (Time.count() > 0) ? static_cast<unsigned long long>(Time.count()) : 0;
+
+	// 統計情報の取得はロックなしで行われるため、各値は個別に更新する
+	m_Count.fetch_add(1, std::memory_order_relaxed);
+	m_TotalTime.fetch_add(Value, std::memory_order_relaxed);
+	m_Buckets[GetBucketIndex(Time)].fetch_add(1, std::memory_order_relaxed);
+
+	unsigned long long Max = m_MaxTime.load(std::memory_order_relaxed);
+	while ((Value > Max)
+			&& !m_MaxTime.compare_exchange_weak(Max, Value, std::memory_order_relaxed));
+}
+
+
+void LatencyHistogram::Get(Snapshot *pSnapshot) const noexcept
+{
+	if (pSnapshot == nullptr)
+		return;
+
+	pSnapshot->Count = m_Count.load(std::memory_order_relaxed);
+	pSnapshot->TotalTime = std::chrono::microseconds(m_TotalTime.load(std::memory_order_relaxed));
+	pSnapshot->MaxTime = std::chrono::microseconds(m_MaxTime.load(std::memory_order_relaxed));
+	for (size_t i = 0; i < BUCKET_COUNT; i++)
+		pSnapshot->Buckets[i] = m_Buckets[i].load(std::memory_order_relaxed);
+}
+
+
+void LatencyHistogram::Reset() noexcept
+{
+	m_Count.store(0, std::memory_order_relaxed);
+	m_TotalTime.store(0, std::memory_order_relaxed);
+	m_MaxTime.store(0, std::memory_order_relaxed);
+	for (auto &e : m_Buckets)
+		e.store(0, std::memory_order_relaxed);
+}
+
+
+size_t LatencyHistogram::GetBucketIndex(const std::chrono::microseconds &Time) noexcept
+{
+	if (Time.count() < 2)
+		return 0;
+
+	const size_t Index = std::bit_width(static_cast<unsigned long long>(Time.count())) - 1;
+
+	return (Index < BUCKET_COUNT) ? Index : (BUCKET_COUNT - 1);
+}
+
+
+std::chrono::microseconds LatencyHistogram::GetBucketLowerBound(size_t Index) noexcept
+{
+	if (Index == 0)
+		return std::chrono::microseconds(0);
+	if (Index >= BUCKET_COUNT)
+		Index = BUCKET_COUNT - 1;
+
+	return std::chrono::microseconds(1LL << Index);
+}
+
+
+
+
+std::chrono::microseconds LatencyHistogram::Snapshot::GetAverageTime() const noexcept
+{
+	if (Count == 0)
+		return std::chrono::microseconds(0);
+
+	return TotalTime / static_cast<long long>(Count);
+}
+
+
+}	// namespace LibISDB
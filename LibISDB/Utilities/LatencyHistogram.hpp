@@ -0,0 +1,77 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   LatencyHistogram.hpp
+ @brief  処理時間ヒストグラム
+ @author DBCTRADO
+*/
+
+
+#ifndef LIBISDB_LATENCY_HISTOGRAM_H
+#define LIBISDB_LATENCY_HISTOGRAM_H
+
+
+#include <chrono>
+#include <atomic>
+#include <array>
+
+
+namespace LibISDB
+{
+
+	/** 処理時間ヒストグラムクラス */
+	class LatencyHistogram
+	{
+	public:
+		// 区間 i は 2^i 以上 2^(i+1) 未満マイクロ秒 (区間 0 は 2 マイクロ秒未満、最後の区間は上限なし)
+		static constexpr size_t BUCKET_COUNT = 24;
+
+		/** 集計値 */
+		struct Snapshot {
+			unsigned long long Count = 0;
+			std::chrono::microseconds TotalTime{0};
+			std::chrono::microseconds MaxTime{0};
+			std::array<unsigned long long, BUCKET_COUNT> Buckets{};
+
+			std::chrono::microseconds GetAverageTime() const noexcept;
+		};
+
+		LatencyHistogram() noexcept;
+		LatencyHistogram(const LatencyHistogram &) = delete;
+		LatencyHistogram & operator = (const LatencyHistogram &) = delete;
+
+		void Add(const std::chrono::microseconds &Time) noexcept;
+		void Get(Snapshot *pSnapshot) const noexcept;
+		void Reset() noexcept;
+
+		static size_t GetBucketIndex(const std::chrono::microseconds &Time) noexcept;
+		static std::chrono::microseconds GetBucketLowerBound(size_t Index) noexcept;
+
+	private:
+		std::atomic<unsigned long long> m_Count;
+		std::atomic<unsigned long long> m_TotalTime;
+		std::atomic<unsigned long long> m_MaxTime;
+		std::array<std::atomic<unsigned long long>, BUCKET_COUNT> m_Buckets;
+	};
+
+}	// namespace LibISDB
+
+
+#endif	// ifndef LIBISDB_LATENCY_HISTOGRAM_H
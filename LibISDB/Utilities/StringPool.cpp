@@ -0,0 +1,425 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   StringPool.cpp
+ @brief  文字列プール
+ @author DBCTRADO
+*/
+
+
+#include "../LibISDBPrivate.hpp"
+#include "StringPool.hpp"
+#include <new>
+#include <cstddef>
+#include <cstring>
+#include "../Base/DebugDef.hpp"
+
+
+namespace LibISDB
+{
+
+
+StringPool::~StringPool()
+{
+	// 参照が残っている文字列がある状態で破棄してはならない
+	for (Shard &e : m_ShardList) {
+		LIBISDB_ASSERT(e.Map.empty());
+		for (auto &Item : e.Map)
+			DeleteEntry(Item.second);
+	}
+}
+
+
+StringPool::Entry * StringPool::Intern(StringView Str)
+{
+	// 空文字列はプールしない
+	if (Str.empty())
+		return nullptr;
+
+	const size_t Hash = std::hash<StringView>()(Str);
+	Shard &Bucket = GetShard(Hash);
+
+	BlockLock Lock(Bucket.Lock);
+
+	const auto Range = Bucket.Map.equal_range(Hash);
+	for (auto it = Range.first; it != Range.second; ++it) {
+		Entry *pEntry = it->second;
+		if (!pEntry->IsRaw() && (pEntry->GetView() == Str)) {
+			// 参照カウントが 0 になるのはロック中のみなので、ここでは必ず 1 以上
+			pEntry->RefCount.fetch_add(1, std::memory_order_relaxed);
+			return pEntry;
+		}
+	}
+
+	Entry *pEntry = AllocEntry(Str.length() * sizeof(CharType), Hash);
+	pEntry->Length = static_cast<uint32_t>(Str.length());
+	std::memcpy(pEntry->Text, Str.data(), Str.length() * sizeof(CharType));
+	pEntry->Text[Str.length()] = LIBISDB_CHAR('\0');
+
+	try {
+		Bucket.Map.emplace(Hash, pEntry);
+	} catch (...) {
+		DeleteEntry(pEntry);
+		throw;
+	}
+
+	return pEntry;
+}
+
+
+StringPool::Entry * StringPool::InternRaw(const uint8_t *pData, size_t Size, DecodeFunc pDecode, uint32_t Param)
+{
+	LIBISDB_ASSERT(pDecode != nullptr);
+
+	if ((pData == nullptr) || (Size == 0))
+		return nullptr;
+
+	// デコード関数とパラメータが異なれば別の文字列として扱う
+	size_t Hash = std::hash<std::string_view>()(
+		std::string_view(reinterpret_cast<const char *>(pData), Size));
+	Hash ^= std::hash<uintptr_t>()(reinterpret_cast<uintptr_t>(pDecode) ^ Param)
+		+ 0x9E3779B9 + (Hash << 6) + (Hash >> 2);
+	Shard &Bucket = GetShard(Hash);
+
+	BlockLock Lock(Bucket.Lock);
+
+	const auto Range = Bucket.Map.equal_range(Hash);
+	for (auto it = Range.first; it != Range.second; ++it) {
+		Entry *pEntry = it->second;
+		if ((pEntry->pDecode == pDecode)
+				&& (pEntry->DecodeParam == Param)
+				&& (pEntry->Length == Size)
+				&& (std::memcmp(pEntry->GetRawData(), pData, Size) == 0)) {
+			pEntry->RefCount.fetch_add(1, std::memory_order_relaxed);
+			return pEntry;
+		}
+	}
+
+	Entry *pEntry = AllocEntry(Size, Hash);
+	pEntry->Length = static_cast<uint32_t>(Size);
+	pEntry->pDecode = pDecode;
+	pEntry->DecodeParam = Param;
+	std::memcpy(pEntry->Text, pData, Size);
+
+	try {
+		Bucket.Map.emplace(Hash, pEntry);
+	} catch (...) {
+		DeleteEntry(pEntry);
+		throw;
+	}
+
+	return pEntry;
+}
+
+
+size_t StringPool::GetStringCount() const
+{
+	size_t Count = 0;
+
+	for (const Shard &e : m_ShardList) {
+		BlockLock Lock(e.Lock);
+		Count += e.Map.size();
+	}
+
+	return Count;
+}
+
+
+size_t StringPool::GetTotalLength() const
+{
+	size_t Length = 0;
+
+	for (const Shard &e : m_ShardList) {
+		BlockLock Lock(e.Lock);
+		for (auto &Item : e.Map) {
+			if (!Item.second->IsRaw())
+				Length += Item.second->Length;
+		}
+	}
+
+	return Length;
+}
+
+
+void StringPool::AddRef(Entry *pEntry) noexcept
+{
+	if (pEntry != nullptr)
+		pEntry->RefCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void StringPool::Release(Entry *pEntry)
+{
+	if (pEntry == nullptr)
+		return;
+
+	// 最後の参照でなければロックせずに減らす
+	uint32_t Count = pEntry->RefCount.load(std::memory_order_relaxed);
+	while (Count > 1) {
+		if (pEntry->RefCount.compare_exchange_weak(Count, Count - 1, std::memory_order_acq_rel))
+			return;
+	}
+
+	pEntry->pPool->Free(pEntry);
+}
+
+
+const StringPool::Entry * StringPool::GetDecoded(Entry *pEntry)
+{
+	if ((pEntry == nullptr) || !pEntry->IsRaw())
+		return pEntry;
+
+	// デコード結果が空文字列の場合は自身を設定しておく
+	Entry *pDecoded = pEntry->pDecoded.load(std::memory_order_acquire);
+
+	if (pDecoded == nullptr) {
+		String Str;
+		pEntry->pDecode(pEntry->GetRawData(), pEntry->Length, pEntry->DecodeParam, &Str);
+
+		Entry *pNewEntry = Str.empty() ? pEntry : pEntry->pPool->Intern(Str);
+
+		// 他のスレッドが先にデコードした場合はその結果を使う
+		if (pEntry->pDecoded.compare_exchange_strong(
+					pDecoded, pNewEntry,
+					std::memory_order_acq_rel, std::memory_order_acquire)) {
+			pDecoded = pNewEntry;
+		} else if (pNewEntry != pEntry) {
+			Release(pNewEntry);
+		}
+	}
+
+	return (pDecoded != pEntry) ? pDecoded : nullptr;
+}
+
+
+StringPool & StringPool::GetDefault()
+{
+	// 静的オブジェクトの破棄順序に依存しないよう、破棄しない
+	static StringPool *pDefaultPool = new StringPool;
+
+	return *pDefaultPool;
+}
+
+
+StringPool::Entry * StringPool::AllocEntry(size_t Size, size_t Hash)
+{
+	Entry *pEntry = static_cast<Entry *>(
+		::operator new(offsetof(Entry, Text) + Size + sizeof(CharType)));
+	new(&pEntry->RefCount) std::atomic<uint32_t>(1);
+	pEntry->Hash = Hash;
+	pEntry->pPool = this;
+	pEntry->pDecode = nullptr;
+	new(&pEntry->pDecoded) std::atomic<Entry *>(nullptr);
+	pEntry->DecodeParam = 0;
+
+	return pEntry;
+}
+
+
+void StringPool::DeleteEntry(Entry *pEntry) noexcept
+{
+	pEntry->pDecoded.~atomic();
+	pEntry->RefCount.~atomic();
+	::operator delete(pEntry);
+}
+
+
+void StringPool::Free(Entry *pEntry)
+{
+	Entry *pDecoded;
+
+	{
+		Shard &Bucket = GetShard(pEntry->Hash);
+
+		BlockLock Lock(Bucket.Lock);
+
+		// ロック待ちの間に Intern() で参照が増えている可能性がある
+		if (pEntry->RefCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+
+		const auto Range = Bucket.Map.equal_range(pEntry->Hash);
+		for (auto it = Range.first; it != Range.second; ++it) {
+			if (it->second == pEntry) {
+				Bucket.Map.erase(it);
+				break;
+			}
+		}
+
+		pDecoded = pEntry->pDecoded.load(std::memory_order_acquire);
+		DeleteEntry(pEntry);
+	}
+
+	// デコード結果は別のシャードにある可能性があるため、ロックを解除してから解放する
+	if ((pDecoded != nullptr) && (pDecoded != pEntry))
+		Release(pDecoded);
+}
+
+
+
+
+PooledString::PooledString(StringView Str, StringPool &Pool)
+	: m_pEntry(Pool.Intern(Str))
+{
+}
+
+
+PooledString::PooledString(
+	const uint8_t *pData, size_t Size, StringPool::DecodeFunc pDecode, uint32_t Param,
+	StringPool &Pool)
+	: m_pEntry(Pool.InternRaw(pData, Size, pDecode, Param))
+{
+}
+
+
+PooledString::PooledString(const PooledString &Src) noexcept
+	: m_pEntry(Src.m_pEntry)
+{
+	StringPool::AddRef(m_pEntry);
+}
+
+
+PooledString::PooledString(PooledString &&Src) noexcept
+	: m_pEntry(Src.m_pEntry)
+{
+	Src.m_pEntry = nullptr;
+}
+
+
+PooledString::~PooledString()
+{
+	StringPool::Release(m_pEntry);
+}
+
+
+PooledString & PooledString::operator = (const PooledString &Src) noexcept
+{
+	if (m_pEntry != Src.m_pEntry) {
+		StringPool::AddRef(Src.m_pEntry);
+		StringPool::Release(m_pEntry);
+		m_pEntry = Src.m_pEntry;
+	}
+
+	return *this;
+}
+
+
+PooledString & PooledString::operator = (PooledString &&Src) noexcept
+{
+	if (&Src != this) {
+		StringPool::Release(m_pEntry);
+		m_pEntry = Src.m_pEntry;
+		Src.m_pEntry = nullptr;
+	}
+
+	return *this;
+}
+
+
+bool PooledString::operator == (const PooledString &rhs) const
+{
+	if (m_pEntry == rhs.m_pEntry)
+		return true;
+
+	// 未デコードのバイト列が同じであればデコードせずに済ませる
+	if (IsSameRaw(rhs))
+		return true;
+
+	const StringPool::Entry *pEntry1 = GetTextEntry();
+	const StringPool::Entry *pEntry2 = rhs.GetTextEntry();
+
+	if (pEntry1 == pEntry2)
+		return true;
+	if ((pEntry1 == nullptr) || (pEntry2 == nullptr))
+		return false;
+
+	// 同じプールであれば同じ内容の文字列は同じエントリになる
+	if (pEntry1->pPool == pEntry2->pPool)
+		return false;
+
+	return pEntry1->GetView() == pEntry2->GetView();
+}
+
+
+bool PooledString::IsSameRaw(const PooledString &rhs) const noexcept
+{
+	if (!IsRaw() || !rhs.IsRaw())
+		return false;
+	if (m_pEntry == rhs.m_pEntry)
+		return true;
+
+	return (m_pEntry->pDecode == rhs.m_pEntry->pDecode)
+		&& (m_pEntry->DecodeParam == rhs.m_pEntry->DecodeParam)
+		&& (m_pEntry->Length == rhs.m_pEntry->Length)
+		&& (std::memcmp(m_pEntry->GetRawData(), rhs.m_pEntry->GetRawData(), m_pEntry->Length) == 0);
+}
+
+
+void PooledString::Assign(StringView Str, StringPool &Pool)
+{
+	StringPool::Entry *pEntry = Pool.Intern(Str);
+	StringPool::Release(m_pEntry);
+	m_pEntry = pEntry;
+}
+
+
+void PooledString::AssignRaw(
+	const uint8_t *pData, size_t Size, StringPool::DecodeFunc pDecode, uint32_t Param,
+	StringPool &Pool)
+{
+	StringPool::Entry *pEntry = Pool.InternRaw(pData, Size, pDecode, Param);
+	StringPool::Release(m_pEntry);
+	m_pEntry = pEntry;
+}
+
+
+void PooledString::Clear() noexcept
+{
+	StringPool::Release(m_pEntry);
+	m_pEntry = nullptr;
+}
+
+
+StringView PooledString::GetView() const
+{
+	const StringPool::Entry *pEntry = GetTextEntry();
+
+	return (pEntry != nullptr) ? pEntry->GetView() : StringView();
+}
+
+
+void PooledString::Get(String *pStr) const
+{
+	const StringPool::Entry *pEntry = GetTextEntry();
+
+	if (pEntry != nullptr)
+		pStr->assign(pEntry->Text, pEntry->Length);
+	else
+		pStr->clear();
+}
+
+
+const StringPool::Entry * PooledString::GetTextEntry() const
+{
+	// 未デコードの文字列は最初のアクセス時にデコードする
+	return StringPool::GetDecoded(m_pEntry);
+}
+
+
+}	// namespace LibISDB
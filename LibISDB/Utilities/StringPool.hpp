@@ -0,0 +1,135 @@
+/*
+  LibISDB
+  Copyright(c) 2017-2020 DBCTRADO
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ @file   StringPool.hpp
+ @brief  文字列プール
+ @author DBCTRADO
+*/
+
+
+#ifndef LIBISDB_STRING_POOL_H
+#define LIBISDB_STRING_POOL_H
+
+
+#include "Lock.hpp"
+#include <unordered_map>
+#include <array>
+#include <atomic>
+
+
+namespace LibISDB
+{
+
+	/** 文字列プールクラス */
+	class StringPool
+	{
+	public:
+		/** 未デコードの文字列をデコードする関数 */
+		typedef void (*DecodeFunc)(const uint8_t *pData, size_t Size, uint32_t Param, String *pStr);
+
+		/** プールされた文字列 */
+		struct Entry {
+			std::atomic<uint32_t> RefCount;
+			uint32_t Length;
+			size_t Hash;
+			StringPool *pPool;
+			DecodeFunc pDecode;
+			std::atomic<Entry *> pDecoded;
+			uint32_t DecodeParam;
+			CharType Text[1];
+
+			bool IsRaw() const noexcept { return pDecode != nullptr; }
+			StringView GetView() const noexcept { return StringView(Text, Length); }
+			const uint8_t * GetRawData() const noexcept { return reinterpret_cast<const uint8_t *>(Text); }
+		};
+
+		StringPool() = default;
+		~StringPool();
+		StringPool(const StringPool &) = delete;
+		StringPool & operator = (const StringPool &) = delete;
+
+		Entry * Intern(StringView Str);
+		Entry * InternRaw(const uint8_t *pData, size_t Size, DecodeFunc pDecode, uint32_t Param);
+		size_t GetStringCount() const;
+		size_t GetTotalLength() const;
+
+		static void AddRef(Entry *pEntry) noexcept;
+		static void Release(Entry *pEntry);
+		static const Entry * GetDecoded(Entry *pEntry);
+		static StringPool & GetDefault();
+
+	private:
+		static constexpr size_t SHARD_COUNT = 16;
+
+		struct Shard {
+			std::unordered_multimap<size_t, Entry *> Map;
+			mutable MutexLock Lock;
+		};
+
+		std::array<Shard, SHARD_COUNT> m_ShardList;
+
+		Shard & GetShard(size_t Hash) noexcept { return m_ShardList[(Hash >> 8) % SHARD_COUNT]; }
+		Entry * AllocEntry(size_t Size, size_t Hash);
+		static void DeleteEntry(Entry *pEntry) noexcept;
+		void Free(Entry *pEntry);
+	};
+
+	/** プールされた文字列の参照クラス */
+	class PooledString
+	{
+	public:
+		PooledString() noexcept : m_pEntry(nullptr) {}
+		PooledString(StringView Str, StringPool &Pool = StringPool::GetDefault());
+		PooledString(
+			const uint8_t *pData, size_t Size, StringPool::DecodeFunc pDecode, uint32_t Param,
+			StringPool &Pool = StringPool::GetDefault());
+		PooledString(const PooledString &Src) noexcept;
+		PooledString(PooledString &&Src) noexcept;
+		~PooledString();
+
+		PooledString & operator = (const PooledString &Src) noexcept;
+		PooledString & operator = (PooledString &&Src) noexcept;
+
+		bool operator == (const PooledString &rhs) const;
+		bool operator == (StringView rhs) const { return GetView() == rhs; }
+
+		void Assign(StringView Str, StringPool &Pool = StringPool::GetDefault());
+		void AssignRaw(
+			const uint8_t *pData, size_t Size, StringPool::DecodeFunc pDecode, uint32_t Param,
+			StringPool &Pool = StringPool::GetDefault());
+		void Clear() noexcept;
+		bool IsEmpty() const { return GetTextEntry() == nullptr; }
+		bool IsRaw() const noexcept { return (m_pEntry != nullptr) && m_pEntry->IsRaw(); }
+		bool IsSameRaw(const PooledString &rhs) const noexcept;
+		size_t GetLength() const { return GetView().length(); }
+		StringView GetView() const;
+		void Get(String *pStr) const;
+		String ToString() const { return String(GetView()); }
+
+	private:
+		StringPool::Entry *m_pEntry;
+
+		const StringPool::Entry * GetTextEntry() const;
+	};
+
+}	// namespace LibISDB
+
+
+#endif	// ifndef LIBISDB_STRING_POOL_H
@@ -46,7 +46,7 @@ namespace
 {
 
 
-LibISDB::String EscapeString(const LibISDB::String &Src)
+LibISDB::String EscapeString(LibISDB::StringView Src)
 {
 	LibISDB::String Dst;
 
@@ -88,12 +88,17 @@ public:
 	{
 	}
 
-	void OutValue(const LibISDB::CharType *pKey, const LibISDB::String &Value)
+	void OutValue(const LibISDB::CharType *pKey, LibISDB::StringView Value)
 	{
 		PreValue();
 		m_Out << LIBISDB_STR("\"") << pKey << LIBISDB_STR("\":\"") << EscapeString(Value) << LIBISDB_STR("\"");
 	}
 
+	void OutValue(const LibISDB::CharType *pKey, const LibISDB::PooledString &Value)
+	{
+		OutValue(pKey, Value.GetView());
+	}
+
 	void OutValue(const LibISDB::CharType *pKey, const LibISDB::DateTime &Time)
 	{
 		PreValue();
@@ -243,15 +248,19 @@ int main(int argc, char **argv)
 		JSON.OutValue(LIBISDB_STR("networkId"), Service.NetworkID);
 		JSON.OutValue(LIBISDB_STR("transportStreamId"), Service.TransportStreamID);
 
-		LibISDB::EPGDatabase::EventList EventList;
+		// データベース内のリストを直接参照する
+		LibISDB::EPGDatabase::EventListView EventList;
 
-		Database.GetEventListSortedByTime(
+		Database.GetEventListView(
 			Service.NetworkID, Service.TransportStreamID, Service.ServiceID,
 			&EventList);
 
 		JSON.BeginArray(LIBISDB_STR("eventList"));
 
-		for (auto const &Event : EventList) {
+		for (auto const &Event : EventList.Events) {
+			if (!Event.IsValid())
+				continue;
+
 			JSON.BeginObject();
 
 			JSON.OutValue(LIBISDB_STR("eventId"), Event.EventID);
@@ -267,13 +276,18 @@ int main(int argc, char **argv)
 			}
 			JSON.EndArray();
 
-			JSON.OutValue(LIBISDB_STR("startTime"), Event.StartTime);
+			LibISDB::DateTime StartTime;
+			Event.GetStartTime(&StartTime);
+			JSON.OutValue(LIBISDB_STR("startTime"), StartTime);
 			JSON.OutValue(LIBISDB_STR("duration"), Event.Duration);
 			JSON.OutValue(LIBISDB_STR("freeCaMode"), Event.FreeCAMode);
 
-			if (!Event.VideoList.empty()) {
+			static const LibISDB::CompactEventInfo::DetailInfo EmptyDetail {};
+			const LibISDB::CompactEventInfo::DetailInfo &Detail = Event.Detail ? *Event.Detail : EmptyDetail;
+
+			if (!Detail.VideoList.empty()) {
 				JSON.BeginArray(LIBISDB_STR("videoList"));
-				for (auto const &Video : Event.VideoList) {
+				for (auto const &Video : Detail.VideoList) {
 					JSON.BeginObject();
 					JSON.OutValue(LIBISDB_STR("streamContent"), Video.StreamContent);
 					JSON.OutValue(LIBISDB_STR("componentType"), Video.ComponentType);
@@ -285,9 +299,9 @@ int main(int argc, char **argv)
 				JSON.EndArray();
 			}
 
-			if (!Event.AudioList.empty()) {
+			if (!Detail.AudioList.empty()) {
 				JSON.BeginArray(LIBISDB_STR("audioList"));
-				for (auto const &Audio : Event.AudioList) {
+				for (auto const &Audio : Detail.AudioList) {
 					JSON.BeginObject();
 					JSON.OutValue(LIBISDB_STR("streamContent"), Audio.StreamContent);
 					JSON.OutValue(LIBISDB_STR("componentType"), Audio.ComponentType);
@@ -302,22 +316,22 @@ int main(int argc, char **argv)
 				JSON.EndArray();
 			}
 
-			if (Event.ContentNibble.NibbleCount > 0) {
+			if (Detail.ContentNibble.NibbleCount > 0) {
 				JSON.BeginArray(LIBISDB_STR("contentNibble"));
-				for (int i = 0; i < Event.ContentNibble.NibbleCount; i++) {
+				for (int i = 0; i < Detail.ContentNibble.NibbleCount; i++) {
 					JSON.BeginObject();
-					JSON.OutValue(LIBISDB_STR("level1"), Event.ContentNibble.NibbleList[i].ContentNibbleLevel1);
-					JSON.OutValue(LIBISDB_STR("level2"), Event.ContentNibble.NibbleList[i].ContentNibbleLevel2);
-					JSON.OutValue(LIBISDB_STR("user1"), Event.ContentNibble.NibbleList[i].UserNibble1);
-					JSON.OutValue(LIBISDB_STR("user2"), Event.ContentNibble.NibbleList[i].UserNibble2);
+					JSON.OutValue(LIBISDB_STR("level1"), Detail.ContentNibble.NibbleList[i].ContentNibbleLevel1);
+					JSON.OutValue(LIBISDB_STR("level2"), Detail.ContentNibble.NibbleList[i].ContentNibbleLevel2);
+					JSON.OutValue(LIBISDB_STR("user1"), Detail.ContentNibble.NibbleList[i].UserNibble1);
+					JSON.OutValue(LIBISDB_STR("user2"), Detail.ContentNibble.NibbleList[i].UserNibble2);
 					JSON.EndObject();
 				}
 				JSON.EndArray();
 			}
 
-			if (!Event.EventGroupList.empty()) {
+			if (!Detail.EventGroupList.empty()) {
 				JSON.BeginArray(LIBISDB_STR("eventGroup"));
-				for (auto const &Group : Event.EventGroupList) {
+				for (auto const &Group : Detail.EventGroupList) {
 					JSON.BeginObject();
 					JSON.OutValue(LIBISDB_STR("groupType"), Group.GroupType);
 					if (!Group.EventList.empty()) {
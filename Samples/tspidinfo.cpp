@@ -22,8 +22,9 @@
  @brief  TS の PID 情報の出力
 
  TS ファイルの各 PID の情報を出力する。
+ ファイルは分割して並列に解析する。
 
- tspidinfo <filename>
+ tspidinfo [-j <threads>] <filename>
 
  @author DBCTRADO
 */
@@ -31,6 +32,7 @@
 
 #include "../LibISDB/LibISDB.hpp"
 #include "../LibISDB/Engine/StreamSourceEngine.hpp"
+#include "../LibISDB/Engine/ParallelTSFileAnalyzer.hpp"
 #include "../LibISDB/Filters/StreamSourceFilter.hpp"
 #include "../LibISDB/Filters/TSPacketParserFilter.hpp"
 #include "../LibISDB/Filters/AnalyzerFilter.hpp"
@@ -48,10 +50,11 @@ namespace
 {
 
 
-class PIDInfoEngine : public LibISDB::StreamSourceEngine
+class PIDInfoCollector : public LibISDB::AnalyzerFilter::EventListener
 {
 public:
 	LibISDB::String GetPIDDescription(std::uint16_t PID) const;
+	void SetMergedInfo(const LibISDB::ParallelTSFileAnalyzer &Analyzer);
 
 private:
 	void OnPMTUpdated(LibISDB::AnalyzerFilter *pAnalyzer, std::uint16_t ServiceID) override;
@@ -77,7 +80,7 @@ private:
 };
 
 
-LibISDB::String PIDInfoEngine::GetPIDDescription(std::uint16_t PID) const
+LibISDB::String PIDInfoCollector::GetPIDDescription(std::uint16_t PID) const
 {
 	LibISDB::String Text;
 
@@ -150,10 +153,30 @@ LibISDB::String PIDInfoEngine::GetPIDDescription(std::uint16_t PID) const
 }
 
 
-void PIDInfoEngine::OnPMTUpdated(LibISDB::AnalyzerFilter *pAnalyzer, std::uint16_t ServiceID)
+void PIDInfoCollector::SetMergedInfo(const LibISDB::ParallelTSFileAnalyzer &Analyzer)
 {
-	TSEngine::OnPMTUpdated(pAnalyzer, ServiceID);
+	m_ServiceList.clear();
 
+	for (const auto &Service : Analyzer.GetMergedServiceList()) {
+		ServicePIDInfo &Info = m_ServiceList.emplace_back();
+
+		Info.ServiceID = Service.ServiceID;
+		Info.PMTPID = Service.PMTPIDList;
+		Info.PCRPID = Service.PCRPIDList;
+		for (const auto &ECM : Service.ECMList) {
+			if (std::ranges::find(Info.ECMPID, ECM.PID) == Info.ECMPID.end())
+				Info.ECMPID.push_back(ECM.PID);
+		}
+		for (const auto &ES : Service.ESList)
+			Info.ESList.push_back(ESInfo{ES.PID, ES.StreamType});
+	}
+
+	m_EMMPIDList = Analyzer.GetMergedEMMPIDList();
+}
+
+
+void PIDInfoCollector::OnPMTUpdated(LibISDB::AnalyzerFilter *pAnalyzer, std::uint16_t ServiceID)
+{
 	LibISDB::AnalyzerFilter::ServiceInfo ServiceInfo;
 
 	pAnalyzer->GetServiceInfoByID(ServiceID, &ServiceInfo);
@@ -193,7 +216,7 @@ void PIDInfoEngine::OnPMTUpdated(LibISDB::AnalyzerFilter *pAnalyzer, std::uint16
 }
 
 
-void PIDInfoEngine::OnCATUpdated(LibISDB::AnalyzerFilter *pAnalyzer)
+void PIDInfoCollector::OnCATUpdated(LibISDB::AnalyzerFilter *pAnalyzer)
 {
 	LibISDB::AnalyzerFilter::EMMPIDList List;
 
@@ -222,53 +245,87 @@ int main(int argc, char **argv)
 	auto &ErrOut = std::cerr;
 #endif
 
-	if (argc < 2) {
+	int ThreadCount = 0;
+	int ArgIndex = 1;
+
+	if ((argc > 2) && (LibISDB::StringCompare(argv[1], LIBISDB_STR("-j")) == 0)) {
+		for (const LibISDB::CharType *p = argv[2]; *p >= LIBISDB_CHAR('0') && *p <= LIBISDB_CHAR('9'); p++)
+			ThreadCount = ThreadCount * 10 + (*p - LIBISDB_CHAR('0'));
+		ArgIndex = 3;
+	}
+
+	if (argc <= ArgIndex) {
 		ErrOut << LIBISDB_STR("Need filename.") << std::endl;
 		return 1;
 	}
 
-	LibISDB::StreamSourceFilter *pSource = new LibISDB::StreamSourceFilter;
-	LibISDB::TSPacketParserFilter *pParser = new LibISDB::TSPacketParserFilter;
-	LibISDB::AnalyzerFilter *pAnalyzer = new LibISDB::AnalyzerFilter;
+	const LibISDB::CharType *pFileName = argv[ArgIndex];
+
+	PIDInfoCollector Collector;
+	LibISDB::TSPacketParserFilter::PacketCountInfo TotalCount;
+	LibISDB::TSPacketParserFilter::PacketCountInfo PIDCount[LibISDB::PID_MAX + 1];
+	unsigned long long InputBytes;
+
+	if (LibISDB::StringCompare(pFileName, LIBISDB_STR("-")) != 0) {
+		// ファイルを分割して並列に解析する
+		LibISDB::ParallelTSFileAnalyzer Analyzer;
+
+		Analyzer.SetThreadCount(ThreadCount);
+
+		if (!Analyzer.Analyze(pFileName)) {
+			ErrOut << LIBISDB_STR("Failed to analyze file : ") << pFileName << std::endl;
+			return 1;
+		}
+
+		Collector.SetMergedInfo(Analyzer);
+
+		InputBytes = Analyzer.GetTotalInputBytes();
+		TotalCount = Analyzer.GetTotalPacketCount();
+		for (std::uint16_t i = 0; i <= LibISDB::PID_MAX; i++) {
+			PIDCount[i] = Analyzer.GetTotalPacketCount(i);
+		}
+	} else {
+		LibISDB::StreamSourceFilter *pSource = new LibISDB::StreamSourceFilter;
+		LibISDB::TSPacketParserFilter *pParser = new LibISDB::TSPacketParserFilter;
+		LibISDB::AnalyzerFilter *pAnalyzer = new LibISDB::AnalyzerFilter;
 
 #define ASYNC
 #ifdef ASYNC
-	pSource->SetSourceMode(LibISDB::SourceFilter::SourceMode::Pull);
-	LibISDB::AsyncStreamingFilter *pAsyncStreaming = new LibISDB::AsyncStreamingFilter;
-	pAsyncStreaming->SetSourceFilter(pSource);
-	pAsyncStreaming->CreateBuffer(pAsyncStreaming->GetOutputBufferSize(), 3, 3);
+		pSource->SetSourceMode(LibISDB::SourceFilter::SourceMode::Pull);
+		LibISDB::AsyncStreamingFilter *pAsyncStreaming = new LibISDB::AsyncStreamingFilter;
+		pAsyncStreaming->SetSourceFilter(pSource);
+		pAsyncStreaming->CreateBuffer(pAsyncStreaming->GetOutputBufferSize(), 3, 3);
 #endif
 
-	PIDInfoEngine Engine;
+		LibISDB::StreamSourceEngine Engine;
 
-	Engine.BuildEngine({
-		pSource,
+		Engine.BuildEngine({
+			pSource,
 #ifdef ASYNC
-		pAsyncStreaming,
+			pAsyncStreaming,
 #endif
-		pParser,
-		pAnalyzer
-		});
-	Engine.SetStartStreamingOnSourceOpen(true);
-
-	const LibISDB::CharType *pFileName = argv[1];
-	if (LibISDB::StringCompare(pFileName, LIBISDB_STR("-")) == 0)
-		pFileName = LibISDB::StandardInputStream::Name;
-	if (!Engine.OpenSource(pFileName)) {
-		ErrOut << LIBISDB_STR("Failed to open file : ") << pFileName << std::endl;
-		return 1;
-	}
+			pParser,
+			pAnalyzer
+			});
+		Engine.SetStartStreamingOnSourceOpen(true);
+		pAnalyzer->AddEventListener(&Collector);
+
+		if (!Engine.OpenSource(LibISDB::StandardInputStream::Name)) {
+			ErrOut << LIBISDB_STR("Failed to open file : ") << pFileName << std::endl;
+			return 1;
+		}
 
-	Engine.WaitForEndOfStream();
+		Engine.WaitForEndOfStream();
 #ifdef ASYNC
-	pAsyncStreaming->WaitForEndOfStream();
+		pAsyncStreaming->WaitForEndOfStream();
 #endif
-	Engine.CloseSource();
+		Engine.CloseSource();
 
-	LibISDB::TSPacketParserFilter::PacketCountInfo TotalCount = pParser->GetTotalPacketCount();
-	LibISDB::TSPacketParserFilter::PacketCountInfo PIDCount[LibISDB::PID_MAX + 1];
-	for (std::uint16_t i = 0; i <= LibISDB::PID_MAX; i++) {
-		PIDCount[i] = pParser->GetTotalPacketCount(i);
+		InputBytes = pParser->GetTotalInputBytes();
+		TotalCount = pParser->GetTotalPacketCount();
+		for (std::uint16_t i = 0; i <= LibISDB::PID_MAX; i++) {
+			PIDCount[i] = pParser->GetTotalPacketCount(i);
+		}
 	}
 
 #if defined(LIBISDB_WCHAR)
@@ -278,7 +335,7 @@ int main(int argc, char **argv)
 #endif
 	const int CountDigits = 9;
 
-	Out << LIBISDB_STR("Input Bytes     : ") << std::setw(CountDigits) << pParser->GetTotalInputBytes() << std::endl;
+	Out << LIBISDB_STR("Input Bytes     : ") << std::setw(CountDigits) << InputBytes << std::endl;
 	Out << LIBISDB_STR("Input Packets   : ") << std::setw(CountDigits) << TotalCount.Input           << std::endl;
 	Out << LIBISDB_STR("Format Error    : ") << std::setw(CountDigits) << TotalCount.FormatError     << std::endl;
 	Out << LIBISDB_STR("Transport Error : ") << std::setw(CountDigits) << TotalCount.TransportError  << std::endl;
@@ -300,7 +357,7 @@ int main(int argc, char **argv)
 			Out << std::setw(CountDigits) << PIDCount[i].Input           << LIBISDB_STR(" ");
 			Out << std::setw(CountDigits) << PIDCount[i].ContinuityError << LIBISDB_STR(" ");
 			Out << std::setw(CountDigits) << PIDCount[i].Scrambled       << LIBISDB_STR(" ");
-			Out << LIBISDB_STR(": ") << Engine.GetPIDDescription(i) << std::endl;
+			Out << LIBISDB_STR(": ") << Collector.GetPIDDescription(i) << std::endl;
 		}
 	}
 
@@ -160,6 +160,93 @@ TEST_CASE("CRC", "[utility][hash]")
 }
 
 
+#include "../LibISDB/Base/SIMD.hpp"
+#include <chrono>
+#include <random>
+
+namespace
+{
+
+	template<typename TCRC> void CheckCRCImplementation(const std::vector<uint8_t> &Data)
+	{
+		// 様々なサイズと位置でテーブル実装と比較する
+		for (size_t Offset = 0; Offset < 16; Offset += 3) {
+			for (size_t Size = 0; Size + Offset <= Data.size(); Size += (Size < 300) ? 1 : 97) {
+				const typename TCRC::ValueType Expected = TCRC::CalcTable(Data.data() + Offset, Size);
+				if (TCRC::Calc(Data.data() + Offset, Size) != Expected) {
+					FAIL("Offset " << Offset << " Size " << Size);
+				}
+			}
+		}
+
+		CHECK(TCRC::Calc(Data.data(), Data.size(), 0x12345678_u32) == TCRC::CalcTable(Data.data(), Data.size(), 0x12345678_u32));
+
+		// 分割して計算しても同じ結果になる
+		const typename TCRC::ValueType CRC = TCRC::Calc(Data.data(), 1000);
+		CHECK(TCRC::Calc(Data.data() + 1000, Data.size() - 1000, CRC) == TCRC::CalcTable(Data.data(), Data.size()));
+
+		// 複数バッファ
+		const uint8_t *DataList[5];
+		size_t SizeList[5];
+		typename TCRC::ValueType CRCList[5];
+		for (size_t i = 0; i < 5; i++) {
+			DataList[i] = Data.data() + i * 7;
+			SizeList[i] = i * 200 + 5;
+		}
+		TCRC::CalcMultiple(DataList, SizeList, 5, CRCList);
+		for (size_t i = 0; i < 5; i++)
+			CHECK(CRCList[i] == TCRC::CalcTable(DataList[i], SizeList[i]));
+	}
+
+	template<typename TCRC> double MeasureCRCSpeed(
+		typename TCRC::ValueType (*pCalc)(const uint8_t *, size_t, typename TCRC::ValueType) noexcept,
+		const std::vector<uint8_t> &Data, int Loops)
+	{
+		typename TCRC::ValueType CRC = TCRC::InitialValue;
+		const auto Start = std::chrono::steady_clock::now();
+		for (int i = 0; i < Loops; i++)
+			CRC = pCalc(Data.data(), Data.size(), CRC);
+		const std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now() - Start;
+		CHECK(CRC != TCRC::InitialValue);
+		return static_cast<double>(Data.size()) * Loops / Elapsed.count() / 1e9;
+	}
+
+}
+
+TEST_CASE("CRCImplementation", "[utility][hash]")
+{
+	std::mt19937 Random(12345);
+	std::vector<uint8_t> Data(4096 + 16);
+	for (uint8_t &e : Data)
+		e = static_cast<uint8_t>(Random());
+
+	CheckCRCImplementation<LibISDB::CRC32>(Data);
+	CheckCRCImplementation<LibISDB::CRC32MPEG2>(Data);
+
+#if defined(LIBISDB_X86) || defined(LIBISDB_X64)
+	if (LibISDB::IsPCLMULQDQAvailable()) {
+		LibISDB::SetPCLMULQDQEnabled(false);
+		CHECK_FALSE(LibISDB::IsPCLMULQDQEnabled());
+		CheckCRCImplementation<LibISDB::CRC32MPEG2>(Data);
+		LibISDB::SetPCLMULQDQEnabled(true);
+		CHECK(LibISDB::IsPCLMULQDQEnabled());
+	}
+#endif
+}
+
+TEST_CASE("CRCBenchmark", "[.][benchmark]")
+{
+	std::vector<uint8_t> Data(16 * 1024 * 1024);
+	for (size_t i = 0; i < Data.size(); i++)
+		Data[i] = static_cast<uint8_t>(i * 7);
+
+	WARN("CRC-32 table        : " << MeasureCRCSpeed<LibISDB::CRC32>(LibISDB::CRC32::CalcTable, Data, 8) << " GB/s");
+	WARN("CRC-32              : " << MeasureCRCSpeed<LibISDB::CRC32>(LibISDB::CRC32::Calc, Data, 8) << " GB/s");
+	WARN("CRC-32/MPEG-2 table : " << MeasureCRCSpeed<LibISDB::CRC32MPEG2>(LibISDB::CRC32MPEG2::CalcTable, Data, 8) << " GB/s");
+	WARN("CRC-32/MPEG-2       : " << MeasureCRCSpeed<LibISDB::CRC32MPEG2>(LibISDB::CRC32MPEG2::Calc, Data, 8) << " GB/s");
+}
+
+
 #include "../LibISDB/Utilities/Sort.hpp"
 
 TEST_CASE("Sort", "[utility][sort]")
@@ -253,6 +340,44 @@ TEST_CASE("Load", "[utility][load]")
 }
 
 
+#include "../LibISDB/Utilities/LatencyHistogram.hpp"
+
+TEST_CASE("LatencyHistogram", "[utility][time]")
+{
+	using namespace std::chrono_literals;
+
+	CHECK(LibISDB::LatencyHistogram::GetBucketIndex(0us) == 0);
+	CHECK(LibISDB::LatencyHistogram::GetBucketIndex(1us) == 0);
+	CHECK(LibISDB::LatencyHistogram::GetBucketIndex(2us) == 1);
+	CHECK(LibISDB::LatencyHistogram::GetBucketIndex(1023us) == 9);
+	CHECK(LibISDB::LatencyHistogram::GetBucketIndex(1024us) == 10);
+	CHECK(LibISDB::LatencyHistogram::GetBucketIndex(1h) == LibISDB::LatencyHistogram::BUCKET_COUNT - 1);
+	CHECK(LibISDB::LatencyHistogram::GetBucketLowerBound(10) == 1024us);
+
+	LibISDB::LatencyHistogram Histogram;
+	LibISDB::LatencyHistogram::Snapshot Snapshot;
+
+	Histogram.Add(10us);
+	Histogram.Add(30us);
+	Histogram.Add(1500us);
+	Histogram.Get(&Snapshot);
+
+	CHECK(Snapshot.Count == 3);
+	CHECK(Snapshot.TotalTime == 1540us);
+	CHECK(Snapshot.MaxTime == 1500us);
+	CHECK(Snapshot.GetAverageTime() == 513us);
+	CHECK(Snapshot.Buckets[3] == 1);
+	CHECK(Snapshot.Buckets[4] == 1);
+	CHECK(Snapshot.Buckets[10] == 1);
+
+	Histogram.Reset();
+	Histogram.Get(&Snapshot);
+
+	CHECK(Snapshot.Count == 0);
+	CHECK(Snapshot.MaxTime == 0us);
+}
+
+
 #include "../LibISDB/Base/ARIBString.hpp"
 
 TEST_CASE("ARIBString", "[base][string]")
@@ -349,9 +474,2003 @@ TEST_CASE("DateTime", "[base][time]")
 	CHECK(LinearMilliseconds == LinearSeconds * 1000ULL + 500ULL);
 	Time2.FromLinearMilliseconds(LinearMilliseconds);
 	CHECK(Time == Time2);
+
+	Time2.OffsetMilliseconds(700);
+	CHECK(Time2.Millisecond == 200);
+	CHECK(Time2.DiffMilliseconds(Time) == 700LL);
+	Time2.OffsetMilliseconds(-1300);
+	CHECK(Time2.Millisecond == 900);
+	CHECK(Time2.DiffMilliseconds(Time) == -600LL);
+	Time2.OffsetSeconds(1);
+	CHECK(Time2.Millisecond == 900);
+}
+
+
+#include "../LibISDB/Base/MappedFileStream.hpp"
+#include <filesystem>
+#include <fstream>
+
+TEST_CASE("MappedFileStream", "[base][file]")
+{
+	using OpenFlag = LibISDB::MappedFileStream::OpenFlag;
+	using SetPosType = LibISDB::MappedFileStream::SetPosType;
+
+	const std::filesystem::path Path = std::filesystem::temp_directory_path() / "libisdbtest_mapped.dat";
+	const LibISDB::String FileName = Path.string<LibISDB::CharType>();
+	std::vector<uint8_t> Data(3 * 65536 + 123);
+
+	for (size_t i = 0; i < Data.size(); i++)
+		Data[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+
+	{
+		std::ofstream File(Path, std::ios::binary | std::ios::trunc);
+		File.write(reinterpret_cast<const char *>(Data.data()), Data.size());
+	}
+
+	LibISDB::MappedFileStream Stream;
+
+	CHECK_FALSE(Stream.SetWindowSize(0));
+	REQUIRE(Stream.SetWindowSize(1));	// 最小 (アロケーション単位)
+	CHECK_FALSE(Stream.Open(FileName, OpenFlag::Read | OpenFlag::Write));
+	REQUIRE(Stream.Open(FileName, OpenFlag::Read | OpenFlag::ShareRead | OpenFlag::ShareWrite));
+	CHECK(Stream.GetSize() == Data.size());
+
+	// ウィンドウの境界を跨いで読み込む
+	std::vector<uint8_t> Buffer(Data.size() + 10);
+	CHECK(Stream.Read(Buffer.data(), Buffer.size()) == Data.size());
+	CHECK(std::equal(Data.begin(), Data.end(), Buffer.begin()));
+	CHECK(Stream.IsEnd());
+
+	// ビューはウィンドウの境界までになる
+	uint8_t *pView;
+	REQUIRE(Stream.SetPos(100, SetPosType::Begin));
+	const size_t ViewSize = Stream.ReadView(&pView, Data.size());
+	REQUIRE(ViewSize > 0);
+	CHECK(ViewSize <= 65536 - 100);
+	CHECK(std::memcmp(pView, &Data[100], ViewSize) == 0);
+	CHECK(Stream.GetPos() == static_cast<LibISDB::MappedFileStream::OffsetType>(100 + ViewSize));
+	REQUIRE(Stream.ReadView(&pView, 16) == 16);
+	CHECK(std::memcmp(pView, &Data[100 + ViewSize], 16) == 0);
+
+	CHECK_FALSE(Stream.SetPos(-1, SetPosType::Begin));
+	REQUIRE(Stream.SetPos(-10, SetPosType::End));
+	CHECK(Stream.Read(Buffer.data(), 20) == 10);
+	CHECK(std::memcmp(Buffer.data(), &Data[Data.size() - 10], 10) == 0);
+	CHECK(Stream.ReadView(&pView, 20) == 0);
+
+	// 書き込み中のファイルは追加された分を読み込める
+	{
+		std::ofstream File(Path, std::ios::binary | std::ios::app);
+		File.write(reinterpret_cast<const char *>(Data.data()), 1000);
+	}
+	REQUIRE(Stream.ReadView(&pView, 2000) == 1000);
+	CHECK(std::memcmp(pView, Data.data(), 1000) == 0);
+	CHECK(Stream.GetSize() == Data.size() + 1000);
+
+#ifndef LIBISDB_WINDOWS
+	// 切り詰められたファイルの末尾を超えて読み込まない
+	REQUIRE(Stream.SetPos(Data.size() - 500, SetPosType::Begin));
+	REQUIRE(Stream.ReadView(&pView, 100) == 100);
+	std::filesystem::resize_file(Path, Data.size() - 300);
+	REQUIRE(Stream.ReadView(&pView, 1000) == 100);
+	CHECK(std::memcmp(pView, &Data[Data.size() - 400], 100) == 0);
+	CHECK(Stream.GetSize() == Data.size() - 300);
+#endif
+
+	Stream.Close();
+	CHECK_FALSE(Stream.IsOpen());
+	std::filesystem::remove(Path);
+}
+
+
+#include "../LibISDB/TS/PSISection.hpp"
+
+namespace
+{
+
+	class SectionCollector
+		: public LibISDB::PSISectionParser::PSISectionHandler
+	{
+	public:
+		std::vector<LibISDB::PSISection> Sections;
+		const uint8_t *pPacketBegin = nullptr;
+		const uint8_t *pPacketEnd = nullptr;
+		int InPlaceCount = 0;
+
+		bool OnPSISection(const LibISDB::PSISectionParser *pParser, const LibISDB::PSISection *pSection) override
+		{
+			if ((pSection->GetData() >= pPacketBegin) && (pSection->GetData() < pPacketEnd))
+				InPlaceCount++;
+			Sections.push_back(*pSection);
+			return true;
+		}
+	};
+
+	std::vector<uint8_t> MakeSection(uint8_t TableID, uint16_t Extension, const std::vector<uint8_t> &Payload, uint8_t Version = 0)
+	{
+		const size_t PayloadSize = Payload.size();
+		const size_t SectionLength = 5 + PayloadSize + 4;
+		std::vector<uint8_t> Section(3 + SectionLength);
+
+		Section[0] = TableID;
+		Section[1] = 0xB0_u8 | static_cast<uint8_t>(SectionLength >> 8);
+		Section[2] = static_cast<uint8_t>(SectionLength & 0xFF);
+		Section[3] = static_cast<uint8_t>(Extension >> 8);
+		Section[4] = static_cast<uint8_t>(Extension & 0xFF);
+		Section[5] = 0xC1_u8 | static_cast<uint8_t>((Version & 0x1F) << 1);
+		Section[6] = 0x00_u8;
+		Section[7] = 0x00_u8;
+		std::copy(Payload.begin(), Payload.end(), Section.begin() + 8);
+		const uint32_t CRC = LibISDB::CRC32MPEG2::Calc(Section.data(), 8 + PayloadSize);
+		Section[8 + PayloadSize + 0] = static_cast<uint8_t>(CRC >> 24);
+		Section[8 + PayloadSize + 1] = static_cast<uint8_t>((CRC >> 16) & 0xFF);
+		Section[8 + PayloadSize + 2] = static_cast<uint8_t>((CRC >> 8) & 0xFF);
+		Section[8 + PayloadSize + 3] = static_cast<uint8_t>(CRC & 0xFF);
+
+		return Section;
+	}
+
+	std::vector<uint8_t> MakeSection(uint8_t TableID, uint16_t Extension, size_t PayloadSize)
+	{
+		std::vector<uint8_t> Payload(PayloadSize);
+
+		for (size_t i = 0; i < PayloadSize; i++)
+			Payload[i] = static_cast<uint8_t>(i);
+
+		return MakeSection(TableID, Extension, Payload);
+	}
+
+	void StoreSectionPacket(
+		LibISDB::PSISectionParser &Parser, SectionCollector &Collector,
+		bool UnitStart, uint8_t Counter, const uint8_t *pPayload, size_t Size)
+	{
+		uint8_t Data[LibISDB::TS_PACKET_SIZE];
+
+		Data[0] = 0x47_u8;
+		Data[1] = UnitStart ? 0x40_u8 : 0x00_u8;
+		Data[2] = 0x10_u8;
+		Data[3] = 0x10_u8 | Counter;
+		std::memcpy(&Data[4], pPayload, Size);
+		std::memset(&Data[4 + Size], 0xFF, LibISDB::TS_PACKET_SIZE - 4 - Size);
+
+		LibISDB::TSPacket Packet;
+		Packet.SetData(Data, sizeof(Data));
+		REQUIRE(Packet.ParsePacket() == LibISDB::TSPacket::ParseResult::OK);
+
+		Collector.pPacketBegin = Packet.GetData();
+		Collector.pPacketEnd = Packet.GetData() + Packet.GetSize();
+		Parser.StorePacket(&Packet);
+	}
+
+}
+
+TEST_CASE("PSISection", "[ts][psi]")
+{
+	SectionCollector Collector;
+	LibISDB::PSISectionParser Parser(&Collector);
+
+	// 1パケットに収まる複数のセクション
+	{
+		const std::vector<uint8_t> Section1 = MakeSection(0x42_u8, 0x0001_u16, 20);
+		const std::vector<uint8_t> Section2 = MakeSection(0x46_u8, 0x0002_u16, 30);
+		std::vector<uint8_t> Payload;
+
+		Payload.push_back(0x00_u8);
+		Payload.insert(Payload.end(), Section1.begin(), Section1.end());
+		Payload.insert(Payload.end(), Section2.begin(), Section2.end());
+		StoreSectionPacket(Parser, Collector, true, 0, Payload.data(), Payload.size());
+
+		REQUIRE(Collector.Sections.size() == 2);
+		CHECK(Collector.InPlaceCount == 2);
+		CHECK(Collector.Sections[0].GetTableID() == 0x42_u8);
+		CHECK(Collector.Sections[0].GetTableIDExtension() == 0x0001_u16);
+		CHECK(Collector.Sections[0].GetPayloadSize() == 20);
+		CHECK(Collector.Sections[0] == LibISDB::PSISection(Collector.Sections[0]));
+		CHECK(std::memcmp(Collector.Sections[0].GetData(), Section1.data(), Section1.size()) == 0);
+		CHECK(Collector.Sections[1].GetTableID() == 0x46_u8);
+		CHECK(Collector.Sections[1].GetPayloadSize() == 30);
+		CHECK(std::memcmp(Collector.Sections[1].GetData(), Section2.data(), Section2.size()) == 0);
+	}
+
+	// 複数パケットに跨るセクション
+	{
+		const std::vector<uint8_t> Section = MakeSection(0x40_u8, 0x0004_u16, 300);
+		std::vector<uint8_t> Payload;
+
+		Collector.Sections.clear();
+		Collector.InPlaceCount = 0;
+
+		Payload.push_back(0x00_u8);
+		Payload.insert(Payload.end(), Section.begin(), Section.begin() + 183);
+		StoreSectionPacket(Parser, Collector, true, 1, Payload.data(), Payload.size());
+		CHECK(Collector.Sections.empty());
+		StoreSectionPacket(Parser, Collector, false, 2, Section.data() + 183, Section.size() - 183);
+
+		REQUIRE(Collector.Sections.size() == 1);
+		CHECK(Collector.InPlaceCount == 0);
+		CHECK(Collector.Sections[0].GetPayloadSize() == 300);
+		CHECK(std::memcmp(Collector.Sections[0].GetData(), Section.data(), Section.size()) == 0);
+	}
+
+	// CRC エラー
+	{
+		std::vector<uint8_t> Payload;
+
+		Collector.Sections.clear();
+
+		Payload.push_back(0x00_u8);
+		const std::vector<uint8_t> Section = MakeSection(0x42_u8, 0x0001_u16, 20);
+		Payload.insert(Payload.end(), Section.begin(), Section.end());
+		Payload[10] ^= 0x01_u8;
+		StoreSectionPacket(Parser, Collector, true, 3, Payload.data(), Payload.size());
+
+		CHECK(Collector.Sections.empty());
+		CHECK(Parser.GetCRCErrorCount() == 1);
+	}
+
+	// 繰り返し送出されるセクションの除外
+	{
+		const std::vector<uint8_t> Section1 = MakeSection(0x42_u8, 0x0001_u16, 20);
+		const std::vector<uint8_t> Section2 = MakeSection(0x42_u8, 0x0001_u16, 21);
+		std::vector<uint8_t> Payload1, Payload2;
+
+		Payload1.push_back(0x00_u8);
+		Payload1.insert(Payload1.end(), Section1.begin(), Section1.end());
+		Payload2.push_back(0x00_u8);
+		Payload2.insert(Payload2.end(), Section2.begin(), Section2.end());
+
+		Collector.Sections.clear();
+		Parser.SetSectionCacheEnabled(true);
+
+		StoreSectionPacket(Parser, Collector, true, 4, Payload1.data(), Payload1.size());
+		StoreSectionPacket(Parser, Collector, true, 5, Payload1.data(), Payload1.size());
+		CHECK(Collector.Sections.size() == 1);
+		CHECK(Parser.GetSectionCacheHitCount() == 1);
+
+		StoreSectionPacket(Parser, Collector, true, 6, Payload2.data(), Payload2.size());
+		CHECK(Collector.Sections.size() == 2);
+
+		Parser.ClearSectionCache();
+		StoreSectionPacket(Parser, Collector, true, 7, Payload2.data(), Payload2.size());
+		CHECK(Collector.Sections.size() == 3);
+		CHECK(Parser.GetSectionCacheHitCount() == 1);
+	}
+
+	// セクションフィルタ
+	{
+		LibISDB::PSISectionFilter Filter;
+
+		CHECK(Filter.IsPassAll());
+		Filter.SetAllTableIDs(false);
+		Filter.SetTableID(0x40_u8);
+		Filter.SetTableIDRange(0x50_u8, 0x5F_u8);
+		Filter.AddTableIDExtension(0x0004_u16);
+		CHECK_FALSE(Filter.IsPassAll());
+		CHECK(Filter.IsTableIDPass(0x55_u8));
+		CHECK_FALSE(Filter.IsTableIDPass(0x42_u8));
+
+		Collector.Sections.clear();
+		Parser.SetSectionCacheEnabled(false);
+		Parser.SetSectionFilter(Filter);
+
+		// 複数パケットに跨る対象外のセクションと、それに続く対象のセクション
+		const std::vector<uint8_t> Section1 = MakeSection(0x50_u8, 0x0005_u16, 250);
+		const std::vector<uint8_t> Section2 = MakeSection(0x50_u8, 0x0004_u16, 20);
+		const std::vector<uint8_t> Section3 = MakeSection(0x42_u8, 0x0004_u16, 20);
+		std::vector<uint8_t> Payload;
+
+		Payload.push_back(0x00_u8);
+		Payload.insert(Payload.end(), Section1.begin(), Section1.begin() + 183);
+		StoreSectionPacket(Parser, Collector, true, 8, Payload.data(), Payload.size());
+
+		Payload.clear();
+		Payload.push_back(static_cast<uint8_t>(Section1.size() - 183));
+		Payload.insert(Payload.end(), Section1.begin() + 183, Section1.end());
+		Payload.insert(Payload.end(), Section2.begin(), Section2.end());
+		Payload.insert(Payload.end(), Section3.begin(), Section3.end());
+		StoreSectionPacket(Parser, Collector, true, 9, Payload.data(), Payload.size());
+
+		REQUIRE(Collector.Sections.size() == 1);
+		CHECK(Collector.Sections[0].GetTableIDExtension() == 0x0004_u16);
+		CHECK(Collector.Sections[0].GetTableID() == 0x50_u8);
+		CHECK(Parser.GetFilteredSectionCount() == 2);
+	}
+}
+
+
+#include "../LibISDB/TS/PSITable.hpp"
+
+TEST_CASE("PSITableSet", "[ts][psi]")
+{
+	LibISDB::PSITableSet TableSet;
+
+	CHECK(TableSet.IsSectionCacheEnabled());
+	TableSet.MapTable(0x40_u8, new LibISDB::PSISingleTable);
+	CHECK(TableSet.IsSectionCacheEnabled());
+
+	// 全てのセクションを必要とするテーブルがある間は無効
+	TableSet.MapTable(0x42_u8, new LibISDB::PSIStreamTable);
+	CHECK_FALSE(TableSet.IsSectionCacheEnabled());
+	TableSet.MapTable(0x46_u8, new LibISDB::PSIStreamTable);
+	TableSet.UnmapTable(0x42_u8);
+	CHECK_FALSE(TableSet.IsSectionCacheEnabled());
+	TableSet.MapTable(0x46_u8, new LibISDB::PSISingleTable);
+	CHECK(TableSet.IsSectionCacheEnabled());
+
+	TableSet.MapTable(0x42_u8, new LibISDB::PSIStreamTable);
+	TableSet.UnmapAllTables();
+	CHECK(TableSet.IsSectionCacheEnabled());
+}
+
+
+
+
+#include "../LibISDB/TS/DescriptorBlock.hpp"
+#include "../LibISDB/TS/Descriptors.hpp"
+
+TEST_CASE("DescriptorBlock", "[ts][descriptor]")
+{
+	// 2番目の記述子は長さが不正
+	static const uint8_t Data[] = {0x52, 0x01, 0x10, 0x52, 0x00, 0x52, 0x01, 0x20};
+	LibISDB::DescriptorBlock Block;
+
+	REQUIRE(Block.ParseBlock(Data, sizeof(Data)) == 3);
+	CHECK(Block.GetDescriptorCount() == 3);
+	CHECK(Block.GetDescriptorByIndex(1) == nullptr);
+
+	const LibISDB::StreamIDDescriptor *pStreamID = Block.GetDescriptor<LibISDB::StreamIDDescriptor>();
+	REQUIRE(pStreamID != nullptr);
+	CHECK(pStreamID->GetComponentTag() == 0x10_u8);
+
+	// コピーは解析済みの記述子を共有する
+	const LibISDB::DescriptorBlock Copy(Block);
+	CHECK(Copy.GetDescriptorByIndex(0) == pStreamID);
+	CHECK(Copy.GetDescriptorCount() == 3);
+
+	std::vector<uint8_t> ComponentTags;
+	Copy.EnumDescriptors<LibISDB::StreamIDDescriptor>(
+		[&](const LibISDB::StreamIDDescriptor *pDesc) {
+			ComponentTags.push_back(pDesc->GetComponentTag());
+		});
+	CHECK(ComponentTags == std::vector<uint8_t>{0x10_u8, 0x20_u8});
+
+	const LibISDB::StreamIDDescriptor *pFound = Copy.FindDescriptor<LibISDB::StreamIDDescriptor>(
+		[](const LibISDB::StreamIDDescriptor *pDesc) -> bool {
+			return pDesc->GetComponentTag() == 0x20_u8;
+		});
+	REQUIRE(pFound != nullptr);
+	CHECK(pFound == Copy.GetDescriptorByIndex(2));
+	CHECK(LibISDB::DescriptorRegistry::IsTagRegistered(LibISDB::StreamIDDescriptor::TAG));
+	CHECK_FALSE(LibISDB::DescriptorRegistry::IsTagRegistered(0x00_u8));
+
+	Block.Reset();
+	CHECK(Block.GetDescriptorCount() == 0);
+	CHECK(Copy.GetDescriptorByIndex(2) != nullptr);
+}
+
+
+
+
+
+#include "../LibISDB/Filters/RecorderFilter.hpp"
+
+namespace
+{
+
+	constexpr uint8_t ADAPTATION_DISCONTINUITY = 0x80_u8;
+	constexpr uint8_t ADAPTATION_RANDOM_ACCESS = 0x40_u8;
+	constexpr uint8_t ADAPTATION_PCR           = 0x10_u8;
+
+	void MakeTSPacket(
+		uint8_t *pData, uint16_t PID, uint8_t Counter, bool UnitStart,
+		uint8_t AdaptationFlags = 0, uint64_t PCR = 0)
+	{
+		pData[0] = 0x47_u8;
+		pData[1] = (UnitStart ? 0x40_u8 : 0x00_u8) | static_cast<uint8_t>(PID >> 8);
+		pData[2] = static_cast<uint8_t>(PID & 0xFF);
+		pData[3] = 0x10_u8 | (Counter & 0x0F_u8);
+
+		size_t Pos = 4;
+
+		if (AdaptationFlags != 0) {
+			const bool HasPCR = (AdaptationFlags & ADAPTATION_PCR) != 0;
+
+			pData[3] |= 0x20_u8;
+			pData[4] = HasPCR ? 7 : 1;
+			pData[5] = AdaptationFlags;
+			Pos = 6;
+			if (HasPCR) {
+				pData[6] = static_cast<uint8_t>(PCR >> 25);
+				pData[7] = static_cast<uint8_t>((PCR >> 17) & 0xFF);
+				pData[8] = static_cast<uint8_t>((PCR >> 9) & 0xFF);
+				pData[9] = static_cast<uint8_t>((PCR >> 1) & 0xFF);
+				pData[10] = static_cast<uint8_t>(((PCR & 1) << 7) | 0x7E);
+				pData[11] = 0x00_u8;
+				Pos = 12;
+			}
+		}
+
+		std::memset(&pData[Pos], 0xFF, LibISDB::TS_PACKET_SIZE - Pos);
+	}
+
+	class TestRecorderFilter
+		: public LibISDB::RecorderFilter
+	{
+	public:
+		using RecorderFilter::PreRollBuffer;
+	};
+
+}
+
+TEST_CASE("PreRollBuffer", "[filter][recorder]")
+{
+	using LibISDB::TSPacket;
+	using PreRollBuffer = TestRecorderFilter::PreRollBuffer;
+	constexpr uint8_t RAIFlag = ADAPTATION_RANDOM_ACCESS;
+	constexpr uint8_t PCRFlag = ADAPTATION_PCR;
+
+	PreRollBuffer Buffer;
+	uint8_t Data[LibISDB::TS_PACKET_SIZE];
+	TSPacket Packet;
+
+	const auto Input =
+		[&](uint16_t PID, uint8_t Flags, uint64_t PCR = 0) {
+			MakeTSPacket(Data, PID, 0, (Flags & RAIFlag) != 0, Flags, PCR);
+			Packet.SetData(Data, sizeof(Data));
+			REQUIRE(Packet.ParsePacket() == TSPacket::ParseResult::OK);
+			Buffer.InputPacket(&Packet);
+		};
+
+	CHECK_FALSE(Buffer.Allocate(LibISDB::TS_PACKET_SIZE - 1));
+	REQUIRE(Buffer.Allocate(100 * LibISDB::TS_PACKET_SIZE));
+	CHECK(Buffer.IsAllocated());
+
+	// 映像 PID 0x0111 に 10 パケット毎に PCR (0.1 秒間隔)、20 パケット目にランダムアクセスポイント
+	// 35 パケット目の音声 PID 0x0112 のランダムアクセスインジケータは映像の PID の指定により無視される
+	for (int i = 0; i < 50; i++) {
+		if (i % 10 == 0)
+			Input(0x0111_u16, PCRFlag | ((i == 20) ? RAIFlag : 0), (i / 10) * 9000);
+		else if (i == 35)
+			Input(0x0112_u16, RAIFlag);
+		else
+			Input(0x0111_u16, 0);
+	}
+
+	CHECK(Buffer.GetEndPos() == 50);
+	CHECK(Buffer.GetBeginPos() == 0);
+	CHECK(Buffer.GetDuration() == std::chrono::milliseconds(400));
+	const std::vector<uint16_t> VideoPIDList{0x0111_u16};
+	CHECK(Buffer.GetStartPos(std::chrono::milliseconds(100), VideoPIDList) == 20);
+	// 指定時間遡れない場合は最も古いランダムアクセスポイントから
+	CHECK(Buffer.GetStartPos(std::chrono::milliseconds(1000), VideoPIDList) == 20);
+	// 映像の PID が分からない場合は PCR の位置で切る
+	CHECK(Buffer.GetStartPos(std::chrono::milliseconds(100), {}) == 30);
+
+	// バッファを一周すると古いパケットは参照できなくなる
+	for (int i = 50; i < 120; i++)
+		Input(0x0111_u16, 0);
+	CHECK(Buffer.GetBeginPos() == 20);
+	CHECK(Buffer.GetPacketData(19) == nullptr);
+	REQUIRE(Buffer.GetPacketData(20) != nullptr);
+	CHECK((Buffer.GetPacketData(20)[5] & RAIFlag) != 0);
+
+	// PCR が不連続になるとそれ以前の時刻情報は破棄される
+	Input(0x0111_u16, PCRFlag | ADAPTATION_DISCONTINUITY, 1000000);
+	CHECK(Buffer.GetDuration() == std::chrono::milliseconds(0));
+	CHECK(Buffer.GetStartPos(std::chrono::milliseconds(100), VideoPIDList) == 120);
+
+	Buffer.Clear();
+	CHECK(Buffer.GetEndPos() == 0);
+	CHECK(Buffer.GetStartPos(std::chrono::milliseconds(100), VideoPIDList) == 0);
+
+	// PCR が映像とは別の PID (0x01FF) で送られる場合も映像のランダムアクセスポイントから開始する
+	LibISDB::StreamSelector Selector;
+	const auto InputSection =
+		[&](uint16_t PID, const std::vector<uint8_t> &Section) {
+			MakeTSPacket(Data, PID, 0, true);
+			Data[4] = 0x00_u8;
+			std::memcpy(&Data[5], Section.data(), Section.size());
+			Packet.SetData(Data, sizeof(Data));
+			REQUIRE(Packet.ParsePacket() == TSPacket::ParseResult::OK);
+			Buffer.InputPacket(&Packet);
+			Selector.InputPacket(&Packet);
+		};
+
+	InputSection(0x0000_u16, MakeSection(0x00_u8, 0x7FE0_u16, {0x01_u8, 0x01_u8, 0xE1_u8, 0x01_u8}));
+	InputSection(
+		0x0101_u16,
+		MakeSection(
+			0x02_u8, 0x0101_u16,
+			{0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8,
+			 0x02_u8, 0xE1_u8, 0x11_u8, 0xF0_u8, 0x00_u8,
+			 0x0F_u8, 0xE1_u8, 0x12_u8, 0xF0_u8, 0x00_u8}));
+	std::vector<uint16_t> VideoPIDList2;
+	REQUIRE(Selector.GetTargetVideoPIDList(&VideoPIDList2));
+	CHECK(VideoPIDList2 == VideoPIDList);
+
+	for (int i = 0; i < 50; i++) {
+		if (i % 10 == 0)
+			Input(0x01FF_u16, PCRFlag, (i / 10) * 9000);
+		else if (i == 25)
+			Input(0x0111_u16, RAIFlag);
+		else if (i == 35)
+			Input(0x0112_u16, RAIFlag);
+		else
+			Input(0x0111_u16, 0);
+	}
+
+	CHECK(Buffer.GetStartPos(std::chrono::milliseconds(100), VideoPIDList2) == 2 + 25);
+}
+
+
+
+
+
+#include "../LibISDB/Filters/AnalyzerFilter.hpp"
+#include "../LibISDB/TS/SICache.hpp"
+
+namespace
+{
+
+	class ServiceChangeCollector
+		: public LibISDB::AnalyzerFilter::EventListener
+	{
+	public:
+		LibISDB::AnalyzerFilter::ServiceChangeList ChangeList;
+		int CallCount = 0;
+
+		void OnServiceListChanged(LibISDB::AnalyzerFilter *pAnalyzer, const LibISDB::AnalyzerFilter::ServiceChangeList &List) override
+		{
+			ChangeList = List;
+			CallCount++;
+		}
+	};
+
+	class ScanCompletionCollector
+		: public LibISDB::AnalyzerFilter::EventListener
+	{
+	public:
+		LibISDB::AnalyzerFilter::ScanResult Result;
+		int CallCount = 0;
+
+		void OnScanCompleted(LibISDB::AnalyzerFilter *pAnalyzer, const LibISDB::AnalyzerFilter::ScanResult &ScanResult) override
+		{
+			Result = ScanResult;
+			CallCount++;
+		}
+	};
+
+	void SendSectionPacket(
+		LibISDB::AnalyzerFilter &Analyzer, uint16_t PID, const std::vector<uint8_t> &Section, uint8_t Counter = 0)
+	{
+		uint8_t Data[LibISDB::TS_PACKET_SIZE];
+
+		Data[0] = 0x47_u8;
+		Data[1] = 0x40_u8 | static_cast<uint8_t>(PID >> 8);
+		Data[2] = static_cast<uint8_t>(PID & 0xFF);
+		Data[3] = 0x10_u8 | (Counter & 0x0F_u8);
+		Data[4] = 0x00_u8;
+		std::memcpy(&Data[5], Section.data(), Section.size());
+		std::memset(&Data[5 + Section.size()], 0xFF, LibISDB::TS_PACKET_SIZE - 5 - Section.size());
+
+		LibISDB::TSPacket Packet;
+		Packet.SetData(Data, sizeof(Data));
+		REQUIRE(Packet.ParsePacket() == LibISDB::TSPacket::ParseResult::OK);
+		LibISDB::SingleDataStream<LibISDB::TSPacket> Stream(&Packet);
+		Analyzer.ReceiveData(&Stream);
+	}
+
+}
+
+TEST_CASE("AnalyzerSnapshot", "[filter][analyzer]")
+{
+	LibISDB::AnalyzerFilter Analyzer;
+	ServiceChangeCollector Collector;
+
+	Analyzer.AddEventListener(&Collector);
+
+	const LibISDB::AnalyzerFilter::SnapshotPtr Initial = Analyzer.GetSnapshot();
+	REQUIRE(Initial);
+	CHECK(Initial->Version == Analyzer.GetSnapshotVersion());
+	CHECK(Initial->Services->empty());
+	CHECK_FALSE(Initial->PATUpdated);
+
+	// PAT (service_id 0x0101, 0x0102)
+	const std::vector<uint8_t> Section = MakeSection(
+		0x00_u8, 0x7FE0_u16, {0x01_u8, 0x01_u8, 0xE1_u8, 0x01_u8, 0x01_u8, 0x02_u8, 0xE1_u8, 0x02_u8});
+	SendSectionPacket(Analyzer, 0x0000_u16, Section);
+
+	const LibISDB::AnalyzerFilter::SnapshotPtr Updated = Analyzer.GetSnapshot();
+	CHECK(Updated->Version > Initial->Version);
+	CHECK(Updated->PATUpdated);
+	CHECK(Updated->TransportStreamID == 0x7FE0_u16);
+	REQUIRE(Updated->Services->size() == 2);
+	CHECK((*Updated->Services)[1].ServiceID == 0x0102_u16);
+	CHECK((*Updated->Services)[1].PMTPID == 0x0102_u16);
+	// 古いスナップショットは変更されない
+	CHECK(Initial->Services->empty());
+	// 更新されていない部分は共有される
+	CHECK(Updated->NetworkStreams == Initial->NetworkStreams);
+
+	// 追加されたサービスが通知される
+	CHECK(Collector.CallCount == 1);
+	REQUIRE(Collector.ChangeList.size() == 2);
+	CHECK(Collector.ChangeList[0].ServiceID == 0x0101_u16);
+	CHECK(Collector.ChangeList[0].Flags == LibISDB::AnalyzerFilter::ServiceChangeFlag::Added);
+
+	// 同じ PAT では更新されない
+	SendSectionPacket(Analyzer, 0x0000_u16, Section, 1);
+	CHECK(Analyzer.GetSnapshot() == Updated);
+	CHECK(Collector.CallCount == 1);
+
+	// PMT (PCR PID 0x01FF, MPEG-2 Video PID 0x0111)
+	SendSectionPacket(
+		Analyzer, 0x0101_u16,
+		MakeSection(0x02_u8, 0x0101_u16, {0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8, 0x02_u8, 0xE1_u8, 0x11_u8, 0xF0_u8, 0x00_u8}));
+	CHECK(Collector.CallCount == 2);
+
+	// バージョンのみが異なる PMT では通知されない
+	SendSectionPacket(
+		Analyzer, 0x0101_u16,
+		MakeSection(0x02_u8, 0x0101_u16, {0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8, 0x02_u8, 0xE1_u8, 0x11_u8, 0xF0_u8, 0x00_u8}, 1),
+		1);
+	CHECK(Analyzer.GetSnapshotVersion() > Updated->Version);
+	CHECK(Collector.CallCount == 2);
+
+	// ES の変更のみが通知される
+	SendSectionPacket(
+		Analyzer, 0x0101_u16,
+		MakeSection(0x02_u8, 0x0101_u16, {0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8, 0x02_u8, 0xE1_u8, 0x12_u8, 0xF0_u8, 0x00_u8}, 2),
+		2);
+	CHECK(Collector.CallCount == 3);
+	REQUIRE(Collector.ChangeList.size() == 1);
+	CHECK(Collector.ChangeList[0].ServiceID == 0x0101_u16);
+	CHECK(Collector.ChangeList[0].Flags == LibISDB::AnalyzerFilter::ServiceChangeFlag::ES);
+
+	Analyzer.RemoveEventListener(&Collector);
+}
+
+
+#include <filesystem>
+
+TEST_CASE("SICache", "[filter][analyzer]")
+{
+	// PAT (service_id 0x0101) / PMT (PCR PID 0x01FF, MPEG-2 Video PID 0x0111)
+	const std::vector<uint8_t> PATSection = MakeSection(
+		0x00_u8, 0x7FE0_u16, {0x01_u8, 0x01_u8, 0xE1_u8, 0x01_u8});
+	const std::vector<uint8_t> PMTSection = MakeSection(
+		0x02_u8, 0x0101_u16, {0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8, 0x02_u8, 0xE1_u8, 0x11_u8, 0xF0_u8, 0x00_u8});
+
+	LibISDB::SICache Cache;
+
+	CHECK_FALSE(Cache.StoreSections(0x7FE8_u16, 0x7FE0_u16, {}));
+	REQUIRE(Cache.StoreSections(0x7FE8_u16, 0x7FE0_u16, {{0x0000_u16, PATSection}, {0x0101_u16, PMTSection}}));
+	CHECK(Cache.HasStream(0x7FE8_u16, 0x7FE0_u16));
+	CHECK_FALSE(Cache.HasStream(0x7FE8_u16, 0x7FE1_u16));
+	CHECK(Cache.IsUpdated());
+
+	// ファイルへの保存と読み込み
+	const std::filesystem::path Path = std::filesystem::temp_directory_path() / "libisdbtest_sicache.dat";
+	const LibISDB::String FileName = Path.string<LibISDB::CharType>();
+	REQUIRE(Cache.SaveFile(FileName));
+	CHECK_FALSE(Cache.IsUpdated());
+
+	// ヘッダはビッグエンディアンで格納される
+	{
+		std::ifstream File(Path, std::ios::binary);
+		uint8_t Header[16 + 8 + 4];
+		REQUIRE(File.read(reinterpret_cast<char *>(Header), sizeof(Header)));
+		CHECK(std::memcmp(Header, "SI-CACHE", 8) == 0);
+		CHECK(LibISDB::Load32(&Header[12]) == 1);
+		CHECK(LibISDB::Load16(&Header[16]) == 0x7FE8_u16);
+		CHECK(LibISDB::Load16(&Header[18]) == 0x7FE0_u16);
+		CHECK(LibISDB::Load16(&Header[20]) == 2);
+		CHECK(LibISDB::Load16(&Header[24]) == 0x0000_u16);
+		CHECK(LibISDB::Load16(&Header[26]) == PATSection.size());
+	}
+
+	LibISDB::SICache Loaded;
+	REQUIRE(Loaded.LoadFile(FileName));
+	std::filesystem::remove(Path);
+	CHECK(Loaded.GetStreamCount() == 1);
+
+	LibISDB::SICache::SectionList List;
+	REQUIRE(Loaded.GetSections(0x7FE8_u16, 0x7FE0_u16, &List));
+	REQUIRE(List.size() == 2);
+	CHECK(List[1].PID == 0x0101_u16);
+	CHECK(List[1].Data == PMTSection);
+
+	// キャッシュからサービス情報を構築する
+	LibISDB::AnalyzerFilter Analyzer;
+	ServiceChangeCollector Collector;
+
+	Analyzer.AddEventListener(&Collector);
+	Analyzer.SetSICache(&Loaded);
+	CHECK_FALSE(Analyzer.LoadSICache(0x7FE8_u16, 0x7FE1_u16));
+	REQUIRE(Analyzer.LoadSICache(0x7FE8_u16, 0x7FE0_u16));
+	CHECK(Analyzer.IsSICacheLoaded());
+
+	LibISDB::AnalyzerFilter::ServiceInfo Info;
+	REQUIRE(Analyzer.GetServiceInfoByID(0x0101_u16, &Info));
+	CHECK(Info.IsCached);
+	CHECK(Info.IsPMTAcquired);
+	CHECK(Info.PCRPID == 0x01FF_u16);
+	REQUIRE(Info.VideoESList.size() == 1);
+	CHECK(Info.VideoESList[0].PID == 0x0111_u16);
+	CHECK(Collector.CallCount == 2);
+
+	// 実際の PMT がキャッシュと異なる
+	SendSectionPacket(
+		Analyzer, 0x0101_u16,
+		MakeSection(0x02_u8, 0x0101_u16, {0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8, 0x02_u8, 0xE1_u8, 0x12_u8, 0xF0_u8, 0x00_u8}));
+
+	REQUIRE(Analyzer.GetServiceInfoByID(0x0101_u16, &Info));
+	CHECK_FALSE(Info.IsCached);
+	CHECK(Info.VideoESList[0].PID == 0x0112_u16);
+	CHECK(Collector.CallCount == 3);
+	REQUIRE(Collector.ChangeList.size() == 1);
+	CHECK(!!(Collector.ChangeList[0].Flags & LibISDB::AnalyzerFilter::ServiceChangeFlag::ES));
+	CHECK(!!(Collector.ChangeList[0].Flags & LibISDB::AnalyzerFilter::ServiceChangeFlag::CacheMismatch));
+
+	Analyzer.RemoveEventListener(&Collector);
+}
+
+
+
+TEST_CASE("AnalyzerScan", "[filter][analyzer]")
+{
+	using ScanTable = LibISDB::AnalyzerFilter::ScanTable;
+
+	LibISDB::AnalyzerFilter Analyzer;
+	ScanCompletionCollector Collector;
+
+	Analyzer.AddEventListener(&Collector);
+
+	CHECK_FALSE(Analyzer.StartScan(ScanTable::None));
+	REQUIRE(Analyzer.StartScan(ScanTable::PAT | ScanTable::PMT));
+	CHECK(Analyzer.IsScanning());
+
+	// PAT (service_id 0x0101)
+	SendSectionPacket(Analyzer, 0x0000_u16, MakeSection(0x00_u8, 0x7FE0_u16, {0x01_u8, 0x01_u8, 0xE1_u8, 0x01_u8}));
+	CHECK(Collector.CallCount == 0);
+	CHECK(Analyzer.IsScanning());
+
+	// リセットしてもスキャンは継続する
+	Analyzer.Reset();
+	CHECK(Analyzer.IsScanning());
+	{
+		LibISDB::AnalyzerFilter::ScanResult ResetResult;
+		REQUIRE(Analyzer.GetScanResult(&ResetResult));
+		CHECK(ResetResult.RequiredTables == (ScanTable::PAT | ScanTable::PMT));
+		CHECK(ResetResult.AcquiredTables == ScanTable::None);
+		CHECK(ResetResult.TableTimeList.empty());
+	}
+
+	SendSectionPacket(Analyzer, 0x0000_u16, MakeSection(0x00_u8, 0x7FE0_u16, {0x01_u8, 0x01_u8, 0xE1_u8, 0x01_u8}));
+	CHECK(Collector.CallCount == 0);
+
+	LibISDB::AnalyzerFilter::ScanResult Result;
+	REQUIRE(Analyzer.GetScanResult(&Result));
+	CHECK(Result.AcquiredTables == ScanTable::PAT);
+	REQUIRE(Result.TableTimeList.size() == 1);
+	CHECK(Result.TableTimeList[0].Table == ScanTable::PAT);
+
+	// PMT
+	SendSectionPacket(
+		Analyzer, 0x0101_u16,
+		MakeSection(0x02_u8, 0x0101_u16, {0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8, 0x02_u8, 0xE1_u8, 0x11_u8, 0xF0_u8, 0x00_u8}));
+	CHECK(Collector.CallCount == 1);
+	CHECK(Collector.Result.AcquiredTables == (ScanTable::PAT | ScanTable::PMT));
+	REQUIRE(Collector.Result.TableTimeList.size() == 2);
+	CHECK(Collector.Result.TableTimeList[1].Table == ScanTable::PMT);
+	CHECK(Collector.Result.TableTimeList[1].Time >= Collector.Result.TableTimeList[0].Time);
+	CHECK(Analyzer.IsScanCompleted());
+	CHECK_FALSE(Analyzer.IsScanning());
+
+	// 完了したスキャンはリセットで終了する
+	Analyzer.Reset();
+	CHECK_FALSE(Analyzer.IsScanCompleted());
+	CHECK_FALSE(Analyzer.IsScanning());
+
+	Analyzer.RemoveEventListener(&Collector);
 }
 
 
+#include "../LibISDB/Engine/TSEngine.hpp"
+
+namespace
+{
+
+	class ServiceSelectionCounter
+		: public LibISDB::SingleInputFilter
+	{
+	public:
+		int Count = 0;
+		uint16_t ServiceID = LibISDB::SERVICE_ID_INVALID;
+
+		const LibISDB::CharType * GetObjectName() const noexcept override { return LIBISDB_STR("ServiceSelectionCounter"); }
+
+		void SetActiveServiceID(uint16_t ID) override
+		{
+			ServiceID = ID;
+			Count++;
+		}
+	};
+
+}
+
+TEST_CASE("TSEngine service selection", "[engine]")
+{
+	LibISDB::TSEngine Engine;
+	LibISDB::AnalyzerFilter *pAnalyzer = new LibISDB::AnalyzerFilter;
+	ServiceSelectionCounter *pCounter = new ServiceSelectionCounter;
+
+	REQUIRE(Engine.BuildEngine({pAnalyzer, pCounter}));
+
+	const auto SendPMT =
+		[&](uint8_t Version, std::vector<uint8_t> Payload) {
+			SendSectionPacket(*pAnalyzer, 0x0101_u16, MakeSection(0x02_u8, 0x0101_u16, Payload, Version), Version);
+		};
+
+	// PAT (service_id 0x0101, 0x0102)
+	SendSectionPacket(
+		*pAnalyzer, 0x0000_u16,
+		MakeSection(0x00_u8, 0x7FE0_u16, {0x01_u8, 0x01_u8, 0xE1_u8, 0x01_u8, 0x01_u8, 0x02_u8, 0xE1_u8, 0x02_u8}));
+	CHECK(pCounter->Count == 0);
+
+	// PMT (PCR PID 0x01FF, MPEG-2 Video PID 0x0111)
+	SendPMT(0, {0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8, 0x02_u8, 0xE1_u8, 0x11_u8, 0xF0_u8, 0x00_u8});
+	CHECK(Engine.GetServiceID() == 0x0101_u16);
+	CHECK(pCounter->ServiceID == 0x0101_u16);
+	const int PMTCount = pCounter->Count;
+	CHECK(PMTCount == 1);
+
+	// 内容が変わらない PMT では選択し直さない
+	SendPMT(1, {0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8, 0x02_u8, 0xE1_u8, 0x11_u8, 0xF0_u8, 0x00_u8});
+	CHECK(pCounter->Count == PMTCount);
+
+	// ES のみの変更
+	SendPMT(2, {0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8, 0x02_u8, 0xE1_u8, 0x12_u8, 0xF0_u8, 0x00_u8});
+	CHECK(pCounter->Count == PMTCount + 1);
+
+	// ECM のみの変更
+	SendPMT(3, {
+		0xE1_u8, 0xFF_u8, 0xF0_u8, 0x06_u8, 0x09_u8, 0x04_u8, 0x00_u8, 0x05_u8, 0xE0_u8, 0x30_u8,
+		0x02_u8, 0xE1_u8, 0x12_u8, 0xF0_u8, 0x00_u8});
+	CHECK(pCounter->Count == PMTCount + 2);
+
+	// PAT の更新では一度だけ選択し直す
+	SendSectionPacket(
+		*pAnalyzer, 0x0000_u16,
+		MakeSection(0x00_u8, 0x7FE0_u16, {0x01_u8, 0x01_u8, 0xE1_u8, 0x01_u8}, 1),
+		1);
+	CHECK(pCounter->Count == PMTCount + 3);
+
+	Engine.CloseEngine();
+}
+
+
+#include "../LibISDB/Filters/StreamSourceFilter.hpp"
+
+TEST_CASE("TSEngine SI cache", "[engine]")
+{
+	// PAT (service_id 0x0101) / PMT (PCR PID 0x01FF, MPEG-2 Video PID 0x0111)
+	LibISDB::SICache Cache;
+	REQUIRE(Cache.StoreSections(0x7FE8_u16, 0x7FE0_u16, {
+		{0x0000_u16, MakeSection(0x00_u8, 0x7FE0_u16, {0x01_u8, 0x01_u8, 0xE1_u8, 0x01_u8})},
+		{0x0101_u16, MakeSection(0x02_u8, 0x0101_u16, {0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8, 0x02_u8, 0xE1_u8, 0x11_u8, 0xF0_u8, 0x00_u8})}}));
+
+	LibISDB::TSEngine Engine;
+	LibISDB::AnalyzerFilter *pAnalyzer = new LibISDB::AnalyzerFilter;
+	ServiceSelectionCounter *pCounter = new ServiceSelectionCounter;
+
+	REQUIRE(Engine.BuildEngine({new LibISDB::StreamSourceFilter, pAnalyzer, pCounter}));
+	pAnalyzer->SetSICache(&Cache);
+
+	// ストリームが指定されていなければ読み込まない
+	Engine.ResetEngine();
+	CHECK_FALSE(pAnalyzer->IsSICacheLoaded());
+
+	LibISDB::TSEngine::ServiceSelectInfo ServiceSel;
+	ServiceSel.NetworkID = 0x7FE8_u16;
+	ServiceSel.TransportStreamID = 0x7FE0_u16;
+	REQUIRE(Engine.SetService(ServiceSel));
+
+	// グラフのリセット後にキャッシュからサービスが選択される
+	Engine.ResetEngine();
+	CHECK(pAnalyzer->IsSICacheLoaded());
+	CHECK(Engine.GetTransportStreamID() == 0x7FE0_u16);
+	CHECK(Engine.GetServiceID() == 0x0101_u16);
+	CHECK(pCounter->ServiceID == 0x0101_u16);
+
+	Engine.CloseEngine();
+}
+
+
+#include "../LibISDB/Engine/ParallelTSFileAnalyzer.hpp"
+
+TEST_CASE("ParallelTSFileAnalyzer", "[engine][analyzer]")
+{
+	using PacketCountInfo = LibISDB::ParallelTSFileAnalyzer::PacketCountInfo;
+
+	const std::filesystem::path Path = std::filesystem::temp_directory_path() / "libisdbtest_parallel.ts";
+	const LibISDB::String FileName = Path.string<LibISDB::CharType>();
+	constexpr size_t PacketCount = 400;
+
+	// PID 0x0100-0x0102 を順に並べ、範囲の境界 (200 パケット目) と範囲内 (50 パケット目) で巡回カウンタを飛ばす
+	{
+		std::ofstream File(Path, std::ios::binary | std::ios::trunc);
+		uint8_t Counter[3] = {};
+		uint8_t Data[LibISDB::TS_PACKET_SIZE];
+
+		for (size_t i = 0; i < PacketCount; i++) {
+			const size_t Index = i % 3;
+			if ((i == 50) || (i == 200))
+				Counter[Index]++;
+			MakeTSPacket(Data, static_cast<uint16_t>(0x0100 + Index), Counter[Index]++, false);
+			File.write(reinterpret_cast<const char *>(Data), sizeof(Data));
+		}
+	}
+
+	LibISDB::ParallelTSFileAnalyzer Sequential, Parallel;
+
+	REQUIRE(Sequential.SetThreadCount(1));
+	REQUIRE(Sequential.Analyze(FileName));
+	CHECK(Sequential.GetRangeCount() == 1);
+
+	REQUIRE(Parallel.SetThreadCount(4));
+	REQUIRE(Parallel.SetMinRangeSize(LibISDB::TS_PACKET_SIZE * 10));
+	REQUIRE(Parallel.Analyze(FileName));
+	REQUIRE(Parallel.GetRangeCount() == 4);
+
+	LibISDB::ParallelTSFileAnalyzer::RangeInfo Range;
+	REQUIRE(Parallel.GetRangeInfo(2, &Range));
+	CHECK(Range.Begin == 200 * LibISDB::TS_PACKET_SIZE);
+
+	// 並列に解析した結果は順に解析した結果と一致する
+	const auto CheckCount =
+		[](const PacketCountInfo &Count, const PacketCountInfo &Expected) {
+			CHECK(Count.Input == Expected.Input);
+			CHECK(Count.Output == Expected.Output);
+			CHECK(Count.FormatError == Expected.FormatError);
+			CHECK(Count.ContinuityError == Expected.ContinuityError);
+		};
+
+	CHECK(Sequential.GetTotalInputBytes() == PacketCount * LibISDB::TS_PACKET_SIZE);
+	CHECK(Parallel.GetTotalInputBytes() == Sequential.GetTotalInputBytes());
+	CHECK(Sequential.GetTotalPacketCount().Input == PacketCount);
+	CHECK(Sequential.GetTotalPacketCount().ContinuityError == 2);
+	CheckCount(Parallel.GetTotalPacketCount(), Sequential.GetTotalPacketCount());
+	for (uint16_t PID = 0x0100; PID <= 0x0102; PID++)
+		CheckCount(Parallel.GetTotalPacketCount(PID), Sequential.GetTotalPacketCount(PID));
+
+	std::filesystem::remove(Path);
+}
+
+
+TEST_CASE("ParallelTSFileAnalyzer PSI merge", "[engine][analyzer]")
+{
+	const std::filesystem::path Path = std::filesystem::temp_directory_path() / "libisdbtest_parallel_psi.ts";
+	const LibISDB::String FileName = Path.string<LibISDB::CharType>();
+	constexpr size_t PacketCount = 400;
+
+	// 前半の範囲ではサービス 0x0101 (ES 0x0111) のみ、後半の範囲では 0x0101 (ES 0x0112) と 0x0102 (ES 0x0113) がある
+	{
+		const std::vector<uint8_t> PAT =
+			MakeSection(0x00_u8, 0x7FE0_u16, {0x01_u8, 0x01_u8, 0xE1_u8, 0x01_u8, 0x01_u8, 0x02_u8, 0xE1_u8, 0x02_u8});
+		const std::vector<uint8_t> PMT1 =
+			MakeSection(0x02_u8, 0x0101_u16, {0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8, 0x02_u8, 0xE1_u8, 0x11_u8, 0xF0_u8, 0x00_u8});
+		const std::vector<uint8_t> PMT2 =
+			MakeSection(0x02_u8, 0x0101_u16, {0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8, 0x0F_u8, 0xE1_u8, 0x12_u8, 0xF0_u8, 0x00_u8}, 1);
+		const std::vector<uint8_t> PMT3 =
+			MakeSection(0x02_u8, 0x0102_u16, {0xE1_u8, 0xFF_u8, 0xF0_u8, 0x00_u8, 0x1B_u8, 0xE1_u8, 0x13_u8, 0xF0_u8, 0x00_u8});
+		std::ofstream File(Path, std::ios::binary | std::ios::trunc);
+		uint8_t Counter[0x0103] = {};
+		uint8_t Data[LibISDB::TS_PACKET_SIZE];
+
+		const auto MakeSectionPacket =
+			[&](uint16_t PID, const std::vector<uint8_t> &Section) {
+				MakeTSPacket(Data, PID, Counter[PID]++, true);
+				Data[4] = 0x00_u8;
+				std::memcpy(&Data[5], Section.data(), Section.size());
+			};
+
+		for (size_t i = 0; i < PacketCount; i++) {
+			switch (i) {
+			case 10:  case 210: MakeSectionPacket(0x0000_u16, PAT);  break;
+			case 11:            MakeSectionPacket(0x0101_u16, PMT1); break;
+			case 211:           MakeSectionPacket(0x0101_u16, PMT2); break;
+			case 212:           MakeSectionPacket(0x0102_u16, PMT3); break;
+			default:            MakeTSPacket(Data, 0x0100_u16, Counter[0x0100]++, false); break;
+			}
+			File.write(reinterpret_cast<const char *>(Data), sizeof(Data));
+		}
+	}
+
+	LibISDB::ParallelTSFileAnalyzer Sequential, Parallel;
+
+	REQUIRE(Sequential.SetThreadCount(1));
+	REQUIRE(Sequential.Analyze(FileName));
+
+	REQUIRE(Parallel.SetThreadCount(4));
+	REQUIRE(Parallel.SetMinRangeSize(LibISDB::TS_PACKET_SIZE * 10));
+	REQUIRE(Parallel.Analyze(FileName));
+	REQUIRE(Parallel.GetRangeCount() == 4);
+
+	// サービスは service_id 順に、ES は全範囲の和集合になる
+	const auto &ServiceList = Parallel.GetMergedServiceList();
+	REQUIRE(ServiceList.size() == 2);
+	CHECK(ServiceList[0].ServiceID == 0x0101);
+	CHECK(ServiceList[1].ServiceID == 0x0102);
+	CHECK(ServiceList[0].PMTPIDList == std::vector<uint16_t>{0x0101});
+	CHECK(ServiceList[0].PCRPIDList == std::vector<uint16_t>{0x01FF});
+	REQUIRE(ServiceList[0].ESList.size() == 2);
+	CHECK(ServiceList[0].ESList[0].PID == 0x0111);
+	CHECK(ServiceList[0].ESList[1].PID == 0x0112);
+	REQUIRE(ServiceList[1].ESList.size() == 1);
+	CHECK(ServiceList[1].ESList[0].PID == 0x0113);
+
+	// 順に解析した結果と一致する
+	const auto &SequentialList = Sequential.GetMergedServiceList();
+	REQUIRE(SequentialList.size() == ServiceList.size());
+	for (size_t i = 0; i < ServiceList.size(); i++) {
+		CHECK(SequentialList[i].ServiceID == ServiceList[i].ServiceID);
+		CHECK(SequentialList[i].PMTPIDList == ServiceList[i].PMTPIDList);
+		CHECK(SequentialList[i].PCRPIDList == ServiceList[i].PCRPIDList);
+		CHECK(SequentialList[i].ESList == ServiceList[i].ESList);
+	}
+
+	std::filesystem::remove(Path);
+}
+
+
+#include "../LibISDB/Filters/StreamSourceFilter.hpp"
+
+namespace
+{
+
+	class TestStreamSourceFilter
+		: public LibISDB::StreamSourceFilter
+	{
+	public:
+		LibISDB::Stream::OffsetType GetStreamPos() { return m_Stream->GetPos(); }
+	};
+
+	/*
+		1 パケット 1 ミリ秒とし、PID 0x0111 に 10 パケット毎に PCR を、
+		1000 パケット毎 (+5) に 2030/1/1 0:00:00 からの経過秒の TOT を置いた TS ファイルを作成する
+	*/
+	void MakeSeekTestFile(
+		const std::filesystem::path &Path, size_t PacketCount,
+		uint64_t FirstPCR, size_t JumpPacket = 0, uint64_t JumpPCR = 0)
+	{
+		std::ofstream File(Path, std::ios::binary | std::ios::trunc);
+		uint8_t Data[LibISDB::TS_PACKET_SIZE];
+
+		for (size_t i = 0; i < PacketCount; i++) {
+			const uint8_t Counter = static_cast<uint8_t>(i & 0x0F);
+
+			if (i % 1000 == 5) {
+				const unsigned int Second = static_cast<unsigned int>(i / 1000);
+				uint8_t Section[14] = {
+					0x73_u8, 0x70_u8, 11,
+					static_cast<uint8_t>(62502 >> 8), static_cast<uint8_t>(62502 & 0xFF),	// MJD 2030/1/1
+					0x00_u8, 0x00_u8, static_cast<uint8_t>(((Second / 10) << 4) | (Second % 10)),
+					0xF0_u8, 0x00_u8};
+				const uint32_t CRC = LibISDB::CRC32MPEG2::Calc(Section, 10);
+				Section[10] = static_cast<uint8_t>(CRC >> 24);
+				Section[11] = static_cast<uint8_t>((CRC >> 16) & 0xFF);
+				Section[12] = static_cast<uint8_t>((CRC >> 8) & 0xFF);
+				Section[13] = static_cast<uint8_t>(CRC & 0xFF);
+
+				MakeTSPacket(Data, LibISDB::PID_TOT, Counter, true);
+				Data[4] = 0x00_u8;
+				std::memcpy(&Data[5], Section, sizeof(Section));
+			} else if (i % 10 == 0) {
+				uint64_t PCR = FirstPCR + i * 90;
+				if ((JumpPacket != 0) && (i >= JumpPacket))
+					PCR += JumpPCR;
+				MakeTSPacket(Data, 0x0111_u16, Counter, false, ADAPTATION_PCR, PCR & 0x1FFFFFFFF_u64);
+			} else {
+				MakeTSPacket(Data, 0x0111_u16, Counter, false);
+			}
+
+			File.write(reinterpret_cast<const char *>(Data), sizeof(Data));
+		}
+	}
+
+}
+
+TEST_CASE("StreamSourceFilter seek", "[filter][source]")
+{
+	using namespace std::chrono_literals;
+	constexpr LibISDB::Stream::OffsetType PacketSize = LibISDB::TS_PACKET_SIZE;
+
+	const std::filesystem::path Path = std::filesystem::temp_directory_path() / "libisdbtest_seek.ts";
+	const LibISDB::String FileName = Path.string<LibISDB::CharType>();
+
+	SECTION("PCR") {
+		// 5 秒後に PCR が折り返す
+		const uint64_t FirstPCR = 0x200000000_u64 - 5 * 90000;
+		MakeSeekTestFile(Path, 20000, FirstPCR);
+
+		TestStreamSourceFilter Source;
+		REQUIRE(Source.SetSourceMode(LibISDB::SourceFilter::SourceMode::Pull));
+		REQUIRE(Source.OpenSource(FileName));
+
+		REQUIRE(Source.SeekToTime(7000ms));
+		CHECK(Source.GetStreamPos() == 7000 * PacketSize);
+		REQUIRE(Source.SeekToPCR((FirstPCR + 15000 * 90) & 0x1FFFFFFFF_u64));
+		CHECK(Source.GetStreamPos() == 15000 * PacketSize);
+
+		// 範囲外の場合は位置が変わらない
+		CHECK_FALSE(Source.SeekToTime(30000ms));
+		CHECK(Source.GetStreamPos() == 15000 * PacketSize);
+
+		// PID を指定した後、PID_INVALID で自動検出に戻る
+		Source.SetSeekPCRPID(0x0222_u16);
+		CHECK_FALSE(Source.SeekToTime(1000ms));
+		Source.SetSeekPCRPID(LibISDB::PID_INVALID);
+		REQUIRE(Source.SeekToTime(1000ms));
+		CHECK(Source.GetStreamPos() == 1000 * PacketSize);
+
+		Source.CloseSource();
+	}
+
+	SECTION("TOT") {
+		// 10 秒後に PCR が 50 秒飛ぶ
+		MakeSeekTestFile(Path, 20000, 90000, 10000, 50 * 90000);
+
+		TestStreamSourceFilter Source;
+		REQUIRE(Source.SetSourceMode(LibISDB::SourceFilter::SourceMode::Pull));
+		REQUIRE(Source.OpenSource(FileName));
+
+		// PCR が不連続な位置は TOT から求める
+		REQUIRE(Source.SeekToTime(5000ms));
+		CHECK(Source.GetStreamPos() == 5000 * PacketSize);
+		REQUIRE(Source.SeekToTime(15000ms));
+		CHECK(Source.GetStreamPos() == 15000 * PacketSize);
+
+		LibISDB::DateTime Time;
+		Time.Year = 2030;
+		Time.Month = 1;
+		Time.Day = 1;
+		Time.Hour = 0;
+		Time.Minute = 0;
+		Time.Second = 3;
+		Time.Millisecond = 500;
+		Time.SetDayOfWeek();
+		REQUIRE(Source.SeekToTime(Time));
+		// TOT 直後の PCR を TOT の時刻とみなす
+		CHECK(Source.GetStreamPos() == 3510 * PacketSize);
+
+		Source.CloseSource();
+	}
+
+	std::filesystem::remove(Path);
+}
+
+
+#include "../LibISDB/Utilities/StringPool.hpp"
+
+TEST_CASE("StringPool", "[utility][string]")
+{
+	LibISDB::StringPool Pool;
+
+	{
+		LibISDB::PooledString Str1(LIBISDB_STR("ステレオ"), Pool);
+		LibISDB::PooledString Str2(LIBISDB_STR("ステレオ"), Pool);
+		LibISDB::PooledString Str3(LIBISDB_STR("二か国語"), Pool);
+		LibISDB::PooledString Empty(LIBISDB_STR(""), Pool);
+
+		CHECK(Pool.GetStringCount() == 2);
+		CHECK(Str1 == Str2);
+		CHECK_FALSE(Str1 == Str3);
+		CHECK(Str1.GetView() == LIBISDB_STR("ステレオ"));
+		CHECK(Str1.ToString() == LIBISDB_STR("ステレオ"));
+		CHECK(Empty.IsEmpty());
+		CHECK(Empty.GetLength() == 0);
+
+		// 別のプールの文字列とは内容で比較する
+		LibISDB::PooledString Other(LIBISDB_STR("ステレオ"));
+		CHECK(Other == Str1);
+
+		LibISDB::PooledString Copy(Str3);
+		Str3.Clear();
+		CHECK(Str3.IsEmpty());
+		CHECK(Pool.GetStringCount() == 2);
+		Copy = Str1;
+		CHECK(Pool.GetStringCount() == 1);
+
+		Str2.Assign(LIBISDB_STR("モノラル"), Pool);
+		CHECK(Pool.GetStringCount() == 2);
+	}
+
+	CHECK(Pool.GetStringCount() == 0);
+
+	// 未デコードの文字列は最初の参照時に一度だけデコードされる
+	static int DecodeCount;
+	DecodeCount = 0;
+	const LibISDB::StringPool::DecodeFunc pDecode =
+		[](const uint8_t *pData, size_t Size, uint32_t Param, LibISDB::String *pStr) {
+			DecodeCount++;
+			pStr->clear();
+			for (size_t i = 0; i < Size; i++)
+				pStr->push_back(static_cast<LibISDB::CharType>(pData[i] + Param));
+		};
+	const uint8_t RawData[] = {'A' - 1, 'B' - 1, 'C' - 1};
+
+	{
+		LibISDB::PooledString Raw1(RawData, sizeof(RawData), pDecode, 1, Pool);
+		LibISDB::PooledString Raw2(RawData, sizeof(RawData), pDecode, 1, Pool);
+		LibISDB::PooledString Raw3(RawData, sizeof(RawData), pDecode, 2, Pool);
+		LibISDB::PooledString Text(LIBISDB_STR("ABC"), Pool);
+
+		CHECK(Raw1.IsRaw());
+		CHECK(Pool.GetStringCount() == 3);
+		CHECK(Raw1 == Raw2);
+		CHECK(Raw1.IsSameRaw(Raw2));
+		CHECK_FALSE(Raw1.IsSameRaw(Raw3));
+
+		// 別のプールでもバイト列が同じであればデコードせずに比較する
+		LibISDB::PooledString Other(RawData, sizeof(RawData), pDecode, 1);
+		CHECK(Raw1 == Other);
+		CHECK(Raw1.IsSameRaw(Other));
+		CHECK(DecodeCount == 0);
+		CHECK(Raw1.GetView() == LIBISDB_STR("ABC"));
+		CHECK(Raw2.ToString() == LIBISDB_STR("ABC"));
+		CHECK(DecodeCount == 1);
+		CHECK(Raw1 == Text);
+		CHECK_FALSE(Raw1 == Raw3);
+		CHECK(DecodeCount == 2);
+		CHECK(Pool.GetStringCount() == 4);
+
+		Text.Clear();
+		CHECK(Pool.GetStringCount() == 4);
+	}
+
+	CHECK(Pool.GetStringCount() == 0);
+}
+
+
+#include "../LibISDB/EPG/EPGDatabase.hpp"
+#include <thread>
+
+namespace
+{
+	LibISDB::EventInfo MakeTestEvent(uint16_t ServiceID, uint16_t EventID, const LibISDB::String &Name)
+	{
+		LibISDB::EventInfo Event;
+
+		Event.NetworkID = 0x0004;
+		Event.TransportStreamID = 0x4010;
+		Event.ServiceID = ServiceID;
+		Event.EventID = EventID;
+		Event.StartTime.Year = 2030;
+		Event.StartTime.Month = 1;
+		Event.StartTime.Day = 1;
+		Event.StartTime.Hour = 0;
+		Event.StartTime.Minute = 0;
+		Event.StartTime.Second = 0;
+		Event.StartTime.Millisecond = 0;
+		Event.StartTime.SetDayOfWeek();
+		Event.StartTime.OffsetHours(EventID);
+		Event.Duration = 60 * 60;
+		Event.RunningStatus = 0;
+		Event.FreeCAMode = false;
+		Event.EventName = Name;
+		Event.Type = LibISDB::EventInfo::TypeFlag::Basic;
+
+		return Event;
+	}
+}
+
+TEST_CASE("EPGDatabase", "[epg][database]")
+{
+	using LibISDB::EPGDatabase;
+	using LibISDB::EventInfo;
+
+	EPGDatabase Database;
+
+	{
+		EPGDatabase::EventList List;
+		List.push_back(MakeTestEvent(0x0101, 1, LIBISDB_STR("Event 1")));
+		List.push_back(MakeTestEvent(0x0101, 2, LIBISDB_STR("Event 2")));
+		List.push_back(MakeTestEvent(0x0101, 3, LIBISDB_STR("Event 3")));
+		// 別サービスのイベント共有
+		List.push_back(MakeTestEvent(0x0101, 4, LIBISDB_STR("")));
+		List.back().IsCommonEvent = true;
+		List.back().CommonEvent.ServiceID = 0x0102;
+		List.back().CommonEvent.EventID = 1;
+		// 同じサービスのイベント共有
+		List.push_back(MakeTestEvent(0x0101, 5, LIBISDB_STR("")));
+		List.back().IsCommonEvent = true;
+		List.back().CommonEvent.ServiceID = 0x0101;
+		List.back().CommonEvent.EventID = 1;
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0101), std::move(List)));
+	}
+	{
+		EPGDatabase::EventList List;
+		List.push_back(MakeTestEvent(0x0102, 1, LIBISDB_STR("Common")));
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0102), std::move(List)));
+	}
+
+	CHECK(Database.GetServiceCount() == 2);
+
+	EventInfo Event;
+	REQUIRE(Database.GetEventInfo(0x0004, 0x4010, 0x0101, 4, &Event));
+	CHECK(Event.EventName == LIBISDB_STR("Common"));
+	REQUIRE(Database.GetEventInfo(0x0004, 0x4010, 0x0101, 5, &Event));
+	CHECK(Event.EventName == LIBISDB_STR("Event 1"));
+
+	// コールバックからデータベースを操作できる
+	{
+		std::vector<uint16_t> EventIDs;
+		REQUIRE(Database.EnumEventsSortedByTime(
+			0x0004, 0x4010, 0x0101,
+			[&](const EventInfo &Info) -> bool {
+				EventInfo Inner;
+				CHECK(Database.GetEventInfo(0x0004, 0x4010, 0x0101, Info.EventID, &Inner));
+				EventIDs.push_back(Info.EventID);
+				if (Info.EventID == 1) {
+					EPGDatabase::EventList List;
+					List.push_back(MakeTestEvent(0x0102, 1, LIBISDB_STR("Common")));
+					CHECK(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0102), std::move(List)));
+				}
+				return true;
+			}));
+		CHECK(EventIDs == std::vector<uint16_t>{1, 2, 3, 4, 5});
+	}
+
+	// 格納した番組情報がそのまま取得できる
+	{
+		EventInfo Info = MakeTestEvent(0x0104, 1, LIBISDB_STR("Detail"));
+		Info.EventText = LIBISDB_STR("Text");
+		Info.ExtendedText.push_back({LIBISDB_STR("出演者"), LIBISDB_STR("Cast")});
+		Info.VideoList.push_back({0x01, 0xB3, 0x00, LibISDB::LANGUAGE_CODE_JPN, LIBISDB_STR("HD")});
+		EventInfo::AudioInfo &Audio = Info.AudioList.emplace_back();
+		Audio.StreamContent = 0x02;
+		Audio.ComponentType = 0x03;
+		Audio.ComponentTag = 0x10;
+		Audio.SimulcastGroupTag = 0xFF;
+		Audio.ESMultiLingualFlag = false;
+		Audio.MainComponentFlag = true;
+		Audio.QualityIndicator = 1;
+		Audio.SamplingRate = 7;
+		Audio.LanguageCode = LibISDB::LANGUAGE_CODE_JPN;
+		Audio.LanguageCode2 = LibISDB::LANGUAGE_CODE_JPN;
+		Audio.Text = LIBISDB_STR("ステレオ");
+		Info.ContentNibble.NibbleCount = 1;
+		Info.ContentNibble.NibbleList[0] = {0x7, 0x0, 0xF, 0xF};
+		Info.UpdatedTime = 12345;
+		Info.SourceID = 2;
+
+		EPGDatabase::EventList List;
+		List.push_back(Info);
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0104), std::move(List)));
+		REQUIRE(Database.GetEventInfo(0x0004, 0x4010, 0x0104, 1, &Event));
+		CHECK(Event == Info);
+
+		// 複製は個別の情報を共有し、変更する時に分かれる
+		LibISDB::CompactEventInfo Compact(Info);
+		LibISDB::CompactEventInfo Copy(Compact);
+		CHECK(Copy.Detail == Compact.Detail);
+		Copy.GetDetail().ContentNibble.NibbleCount = 0;
+		CHECK(Copy.Detail != Compact.Detail);
+		CHECK(Compact.Detail->ContentNibble.NibbleCount == 1);
+	}
+
+	// 読み込みと更新を並行して行う
+	constexpr int MergeCount = 50;
+	std::atomic<bool> Stop(false);
+	std::atomic<int> ErrorCount(0);
+
+	std::vector<std::thread> Readers;
+	for (int i = 0; i < 2; i++) {
+		Readers.emplace_back(
+			[&]() {
+				EPGDatabase::EventList List;
+				while (!Stop.load()) {
+					if (!Database.GetEventListSortedByTime(0x0004, 0x4010, 0x0101, &List) || (List.size() != 5))
+						ErrorCount++;
+					EventInfo Info;
+					if (!Database.GetEventInfo(0x0004, 0x4010, 0x0101, 4, &Info)
+							|| (Info.EventName != LIBISDB_STR("Common")))
+						ErrorCount++;
+				}
+			});
+	}
+
+	for (int i = 0; i < MergeCount; i++) {
+		EPGDatabase Source;
+		EPGDatabase::EventList List;
+		List.push_back(MakeTestEvent(0x0103, static_cast<uint16_t>(i + 1), LIBISDB_STR("Merged")));
+		Source.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0103), std::move(List));
+		Database.Merge(&Source, EPGDatabase::MergeFlag::MergeBasicExtended);
+	}
+
+	Stop = true;
+	for (auto &Thread : Readers)
+		Thread.join();
+
+	CHECK(ErrorCount == 0);
+	CHECK(Database.GetServiceCount() == 4);
+
+	EPGDatabase::EventList List;
+	REQUIRE(Database.GetEventList(0x0004, 0x4010, 0x0103, &List));
+	CHECK(List.size() == MergeCount);
+	CHECK(Database.IsUpdated());
+}
+
+
+#include "../LibISDB/EPG/EPGDataFile.hpp"
+#include <fstream>
+
+TEST_CASE("EPGDataFile", "[epg][file]")
+{
+	using LibISDB::EPGDatabase;
+	using LibISDB::EPGDataFile;
+	using LibISDB::EventInfo;
+
+	EPGDatabase Database;
+
+	for (uint16_t ServiceID = 0x0101; ServiceID <= 0x0104; ServiceID++) {
+		EPGDatabase::EventList List;
+		for (uint16_t EventID = 1; EventID <= 3; EventID++)
+			List.push_back(MakeTestEvent(ServiceID, EventID, LIBISDB_STR("Event")));
+		List.front().EventText = LIBISDB_STR("Text");
+		List.front().ExtendedText.push_back({LIBISDB_STR("出演者"), LIBISDB_STR("Cast")});
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, ServiceID), std::move(List)));
+	}
+
+	const std::filesystem::path Path = std::filesystem::temp_directory_path() / "libisdbtest_epgdata.dat";
+	const std::filesystem::path OldPath = std::filesystem::temp_directory_path() / "libisdbtest_epgdata_v0.dat";
+	const LibISDB::String FileName = Path.string<LibISDB::CharType>();
+
+	{
+		EPGDataFile File;
+		REQUIRE(File.Open(&Database, FileName, EPGDataFile::OpenFlag::Write));
+		REQUIRE(File.Save());
+	}
+
+	const auto CheckService =
+		[](const EPGDatabase &Loaded, uint16_t ServiceID) {
+			EPGDatabase::EventList List;
+			REQUIRE(Loaded.GetEventListSortedByTime(0x0004, 0x4010, ServiceID, &List));
+			REQUIRE(List.size() == 3);
+			CHECK(List[0].EventID == 1);
+			CHECK(List[0].EventName == LIBISDB_STR("Event"));
+			CHECK(List[0].EventText == LIBISDB_STR("Text"));
+			REQUIRE(List[0].ExtendedText.size() == 1);
+			CHECK(List[0].ExtendedText[0].Text == LIBISDB_STR("Cast"));
+			CHECK(List[2].StartTime == MakeTestEvent(ServiceID, 3, LIBISDB_STR("")).StartTime);
+		};
+
+	// サービスディレクトリを使って並列に読み込む
+	{
+		EPGDatabase Loaded;
+		EPGDataFile File;
+		REQUIRE(File.Open(&Loaded, FileName, EPGDataFile::OpenFlag::Read));
+		File.SetLoadThreadCount(3);
+		REQUIRE(File.Load());
+		CHECK(File.GetUpdateCount() == 1);
+		CHECK(Loaded.GetServiceCount() == 4);
+		for (uint16_t ServiceID = 0x0101; ServiceID <= 0x0104; ServiceID++)
+			CheckService(Loaded, ServiceID);
+	}
+
+	// 指定したサービスのみ読み込む
+	{
+		EPGDatabase Loaded;
+		EPGDataFile File;
+		REQUIRE(File.Open(&Loaded, FileName, EPGDataFile::OpenFlag::Read));
+		REQUIRE(File.LoadService(0x0004, 0x4010, 0x0103));
+		CHECK_FALSE(File.LoadService(0x0004, 0x4010, 0x0105));
+		CHECK(Loaded.GetServiceCount() == 1);
+		CheckService(Loaded, 0x0103);
+	}
+
+	// バージョン 0 のファイル(ディレクトリなし)も読み込める
+	{
+		std::ifstream Src(Path, std::ios::binary);
+		std::vector<char> Data((std::istreambuf_iterator<char>(Src)), std::istreambuf_iterator<char>());
+		Src.close();
+		REQUIRE(Data.size() > 24 + 24);
+		uint64_t DirectoryOffset;
+		std::memcpy(&DirectoryOffset, &Data[Data.size() - 24], sizeof(DirectoryOffset));
+		REQUIRE(DirectoryOffset < Data.size());
+		Data.resize(static_cast<size_t>(DirectoryOffset));
+		std::memset(&Data[8], 0, 4);
+		std::ofstream Dst(OldPath, std::ios::binary);
+		Dst.write(Data.data(), Data.size());
+	}
+
+	{
+		EPGDatabase Loaded;
+		EPGDataFile File;
+		REQUIRE(File.Open(&Loaded, OldPath.string<LibISDB::CharType>(), EPGDataFile::OpenFlag::Read));
+		REQUIRE(File.Load());
+		CHECK(Loaded.GetServiceCount() == 4);
+		CheckService(Loaded, 0x0101);
+		CHECK_FALSE(File.LoadService(0x0004, 0x4010, 0x0101));
+	}
+
+	std::filesystem::remove(Path);
+	std::filesystem::remove(OldPath);
+}
+
+
+TEST_CASE("EPGDataFile journal", "[epg][file]")
+{
+	using LibISDB::EPGDatabase;
+	using LibISDB::EPGDataFile;
+
+	EPGDatabase Database;
+
+	for (uint16_t ServiceID = 0x0101; ServiceID <= 0x0104; ServiceID++) {
+		EPGDatabase::EventList List;
+		for (uint16_t EventID = 1; EventID <= 3; EventID++)
+			List.push_back(MakeTestEvent(ServiceID, EventID, LIBISDB_STR("Event")));
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, ServiceID), std::move(List)));
+	}
+
+	const std::filesystem::path Path = std::filesystem::temp_directory_path() / "libisdbtest_epgjournal.dat";
+	const LibISDB::String FileName = Path.string<LibISDB::CharType>();
+	std::filesystem::remove(Path);
+
+	EPGDataFile File;
+	REQUIRE(File.Open(&Database, FileName, EPGDataFile::OpenFlag::Write | EPGDataFile::OpenFlag::Journal));
+	const std::filesystem::path JournalPath(File.GetJournalFileName());
+	std::filesystem::remove(JournalPath);
+
+	// 最初はベースのファイルが作成される
+	REQUIRE(File.Save());
+	REQUIRE(std::filesystem::exists(Path));
+	CHECK_FALSE(std::filesystem::exists(JournalPath));
+	const auto BaseSize = std::filesystem::file_size(Path);
+
+	// 変更されたサービスのみジャーナルに追記される
+	{
+		EPGDatabase::EventList List;
+		List.push_back(MakeTestEvent(0x0102, 10, LIBISDB_STR("Changed")));
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0102), std::move(List)));
+	}
+	REQUIRE(File.Save());
+	REQUIRE(std::filesystem::exists(JournalPath));
+	CHECK(std::filesystem::file_size(Path) == BaseSize);
+	const auto JournalSize = std::filesystem::file_size(JournalPath);
+	CHECK(JournalSize < BaseSize);
+
+	// 変更が無ければ何も書かれない
+	REQUIRE(File.Save());
+	CHECK(std::filesystem::file_size(JournalPath) == JournalSize);
+
+	const auto CheckLoaded =
+		[&](const EPGDatabase &Loaded) {
+			EPGDatabase::EventList List;
+			REQUIRE(Loaded.GetEventListSortedByTime(0x0004, 0x4010, 0x0102, &List));
+			REQUIRE(List.size() == 1);
+			CHECK(List[0].EventID == 10);
+			CHECK(List[0].EventName == LIBISDB_STR("Changed"));
+			REQUIRE(Loaded.GetEventListSortedByTime(0x0004, 0x4010, 0x0101, &List));
+			CHECK(List.size() == 3);
+		};
+
+	{
+		EPGDatabase Loaded;
+		EPGDataFile LoadFile;
+		REQUIRE(LoadFile.Open(&Loaded, FileName, EPGDataFile::OpenFlag::Read));
+		REQUIRE(LoadFile.Load());
+		CHECK(Loaded.GetServiceCount() == 4);
+		CheckLoaded(Loaded);
+	}
+
+	{
+		EPGDatabase Loaded;
+		EPGDataFile LoadFile;
+		REQUIRE(LoadFile.Open(&Loaded, FileName, EPGDataFile::OpenFlag::Read));
+		REQUIRE(LoadFile.LoadService(0x0004, 0x4010, 0x0102));
+		REQUIRE(LoadFile.LoadService(0x0004, 0x4010, 0x0101));
+		CheckLoaded(Loaded);
+	}
+
+	// 統合するとジャーナルは削除される
+	REQUIRE(File.Compact());
+	CHECK_FALSE(std::filesystem::exists(JournalPath));
+	{
+		EPGDatabase Loaded;
+		EPGDataFile LoadFile;
+		REQUIRE(LoadFile.Open(&Loaded, FileName, EPGDataFile::OpenFlag::Read));
+		REQUIRE(LoadFile.Load());
+		CHECK(LoadFile.GetUpdateCount() == 2);
+		CheckLoaded(Loaded);
+	}
+
+	// ジャーナルが閾値を超えるとバックグラウンドで統合される
+	File.SetJournalCompactionThreshold(1);
+	{
+		EPGDatabase::EventList List;
+		List.push_back(MakeTestEvent(0x0103, 20, LIBISDB_STR("Compacted")));
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0103), std::move(List)));
+	}
+	REQUIRE(File.Save());
+	File.WaitCompaction();
+	CHECK_FALSE(File.IsCompacting());
+	CHECK_FALSE(std::filesystem::exists(JournalPath));
+	{
+		EPGDatabase Loaded;
+		EPGDataFile LoadFile;
+		REQUIRE(LoadFile.Open(&Loaded, FileName, EPGDataFile::OpenFlag::Read));
+		REQUIRE(LoadFile.Load());
+		CHECK(LoadFile.GetUpdateCount() == 3);
+		EPGDatabase::EventList List;
+		REQUIRE(Loaded.GetEventListSortedByTime(0x0004, 0x4010, 0x0103, &List));
+		REQUIRE(List.size() == 1);
+		CHECK(List[0].EventName == LIBISDB_STR("Compacted"));
+	}
+
+	// 統合中に保存しても追記した内容は失われない
+	{
+		// 統合に時間がかかるようにベースを大きくする
+		EPGDatabase::EventList List;
+		for (uint16_t EventID = 1; EventID <= 5000; EventID++)
+			List.push_back(MakeTestEvent(0x0105, EventID, LIBISDB_STR("Bulk")));
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0105), std::move(List)));
+	}
+	for (uint16_t EventID = 30; EventID < 50; EventID++) {
+		EPGDatabase::EventList List;
+		List.push_back(MakeTestEvent(0x0104, EventID, LIBISDB_STR("Racing")));
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0104), std::move(List)));
+		REQUIRE(File.Save());
+		// 統合のスナップショットが取得されてから次の変更を行う
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	File.WaitCompaction();
+	{
+		EPGDatabase Loaded;
+		EPGDataFile LoadFile;
+		REQUIRE(LoadFile.Open(&Loaded, FileName, EPGDataFile::OpenFlag::Read));
+		REQUIRE(LoadFile.Load());
+		EPGDatabase::EventList List;
+		REQUIRE(Loaded.GetEventListSortedByTime(0x0004, 0x4010, 0x0104, &List));
+		REQUIRE(List.size() == 1);
+		CHECK(List[0].EventID == 49);
+	}
+
+	// 消去された場合はベースが書き直される
+	File.SetJournalCompactionThreshold(0);
+	Database.Clear();
+	{
+		EPGDatabase::EventList List;
+		List.push_back(MakeTestEvent(0x0101, 60, LIBISDB_STR("Cleared")));
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0101), std::move(List)));
+	}
+	REQUIRE(File.Save());
+	CHECK_FALSE(std::filesystem::exists(JournalPath));
+	{
+		EPGDatabase Loaded;
+		EPGDataFile LoadFile;
+		REQUIRE(LoadFile.Open(&Loaded, FileName, EPGDataFile::OpenFlag::Read));
+		REQUIRE(LoadFile.Load());
+		CHECK(Loaded.GetServiceCount() == 1);
+	}
+
+	// 消去のみでも記録される
+	Database.Clear();
+	REQUIRE(File.Save());
+	{
+		EPGDatabase Loaded;
+		EPGDataFile LoadFile;
+		REQUIRE(LoadFile.Open(&Loaded, FileName, EPGDataFile::OpenFlag::Read));
+		REQUIRE(LoadFile.Load());
+		CHECK(Loaded.GetServiceCount() == 0);
+	}
+
+	File.Close();
+	std::filesystem::remove(Path);
+}
+
+
+TEST_CASE("EPGDataFile async save", "[epg][file]")
+{
+	using LibISDB::EPGDatabase;
+	using LibISDB::EPGDataFile;
+
+	EPGDatabase Database;
+
+	for (uint16_t ServiceID = 0x0101; ServiceID <= 0x0104; ServiceID++) {
+		EPGDatabase::EventList List;
+		for (uint16_t EventID = 1; EventID <= 3; EventID++)
+			List.push_back(MakeTestEvent(ServiceID, EventID, LIBISDB_STR("Event")));
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, ServiceID), std::move(List)));
+	}
+
+	// 変更の無いサービスのイベントリストはスナップショット間で共有される
+	EPGDatabase::Snapshot Snapshot1, Snapshot2;
+	REQUIRE(Database.GetSnapshot(&Snapshot1));
+	REQUIRE(Snapshot1.size() == 4);
+	REQUIRE(Snapshot1[1].EventList->size() == 3);
+	{
+		EPGDatabase::EventList List;
+		List.push_back(MakeTestEvent(0x0102, 10, LIBISDB_STR("Changed")));
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0102), std::move(List)));
+	}
+	REQUIRE(Database.GetSnapshot(&Snapshot2));
+	REQUIRE(Snapshot2.size() == 4);
+	CHECK(Snapshot2[0].EventList == Snapshot1[0].EventList);
+	CHECK(Snapshot2[1].EventList != Snapshot1[1].EventList);
+	CHECK(Snapshot1[1].EventList->size() == 3);
+	CHECK(Snapshot2[1].EventList->size() == 1);
+
+	// 参照されなくなったイベントリストはデータベースに残らない
+	{
+		const std::weak_ptr<const EPGDatabase::CompactEventList> Released = Snapshot1[0].EventList;
+		Snapshot1.clear();
+		Snapshot2.clear();
+		CHECK(Released.expired());
+	}
+
+	const std::filesystem::path Path = std::filesystem::temp_directory_path() / "libisdbtest_epgasync.dat";
+	const LibISDB::String FileName = Path.string<LibISDB::CharType>();
+
+	// 保存開始後の変更はファイルに含まれない
+	{
+		EPGDataFile File;
+		REQUIRE(File.Open(&Database, FileName, EPGDataFile::OpenFlag::Write));
+		REQUIRE(File.SaveAsync());
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0105), EPGDatabase::EventList{MakeTestEvent(0x0105, 1, LIBISDB_STR("Event"))}));
+		REQUIRE(File.WaitSave());
+		CHECK_FALSE(File.IsSaving());
+		size_t SavedCount, TotalCount;
+		CHECK_FALSE(File.GetSaveProgress(&SavedCount, &TotalCount));
+		CHECK(SavedCount == 4);
+		CHECK(TotalCount == 4);
+	}
+
+	{
+		EPGDatabase Loaded;
+		EPGDataFile File;
+		REQUIRE(File.Open(&Loaded, FileName, EPGDataFile::OpenFlag::Read));
+		REQUIRE(File.Load());
+		CHECK(Loaded.GetServiceCount() == 4);
+		EPGDatabase::EventList List;
+		REQUIRE(Loaded.GetEventListSortedByTime(0x0004, 0x4010, 0x0102, &List));
+		REQUIRE(List.size() == 1);
+		CHECK(List[0].EventName == LIBISDB_STR("Changed"));
+	}
+
+	std::filesystem::remove(Path);
+}
+
+
+TEST_CASE("EPGDatabase time range", "[epg]")
+{
+	using LibISDB::EPGDatabase;
+
+	EPGDatabase Database;
+
+	for (uint16_t ServiceID = 0x0101; ServiceID <= 0x0103; ServiceID++) {
+		EPGDatabase::EventList List;
+		for (uint16_t EventID = 1; EventID <= 5; EventID++)
+			List.push_back(MakeTestEvent(ServiceID, EventID, LIBISDB_STR("Event")));
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, ServiceID), std::move(List)));
+	}
+
+	LibISDB::DateTime Earliest = MakeTestEvent(0x0101, 1, LIBISDB_STR("")).StartTime;
+	Earliest.OffsetMinutes(30);
+	const LibISDB::DateTime Latest = MakeTestEvent(0x0101, 3, LIBISDB_STR("")).StartTime;
+
+	// 開始時刻に放送中のイベントを含み、終了時刻に開始するイベントは含まない
+	EPGDatabase::TimeRangeResult Result;
+	REQUIRE(Database.QueryTimeRange(&Earliest, &Latest, &Result));
+	REQUIRE(Result.size() == 3);
+	for (const auto &Service : Result) {
+		REQUIRE(Service.Events.size() == 2);
+		CHECK(Service.Events[0].EventID == 1);
+		CHECK(Service.Events[1].EventID == 2);
+		CHECK(Service.Events[0].ServiceID == Service.Info.ServiceID);
+	}
+
+	const EPGDatabase::ServiceList Services = {
+		EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0102),
+		EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0105),
+	};
+	REQUIRE(Database.QueryTimeRange(&Earliest, nullptr, &Result, &Services));
+	REQUIRE(Result.size() == 1);
+	CHECK(Result[0].Info.ServiceID == 0x0102);
+	CHECK(Result[0].Events.size() == 5);
+
+	// 結果はその後の変更の影響を受けない
+	REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0102), EPGDatabase::EventList()));
+	CHECK(Result[0].Events.size() == 5);
+	CHECK(Result[0].Events[4].EventID == 5);
+	REQUIRE(Database.QueryTimeRange(&Earliest, nullptr, &Result, &Services));
+	CHECK(Result.empty());
+}
+
+
+TEST_CASE("EPGDatabase event view", "[epg]")
+{
+	using LibISDB::EPGDatabase;
+
+	EPGDatabase Database;
+	const EPGDatabase::ServiceInfo Service(0x0004, 0x4010, 0x0101);
+
+	{
+		EPGDatabase::EventList List;
+		for (uint16_t EventID = 3; EventID >= 1; EventID--)
+			List.push_back(MakeTestEvent(0x0101, EventID, LIBISDB_STR("Event")));
+		REQUIRE(Database.SetServiceEventList(Service, std::move(List)));
+	}
+
+	EPGDatabase::EventListView View;
+	REQUIRE(Database.GetEventListView(0x0004, 0x4010, 0x0101, &View));
+	REQUIRE(View.Events.size() == 3);
+	CHECK(View.Events[0].EventID == 1);
+	CHECK(View.Events[2].EventID == 3);
+	CHECK_FALSE(Database.GetEventListView(0x0004, 0x4010, 0x0102, &View));
+	CHECK(View.Events.empty());
+	REQUIRE(Database.GetEventListView(0x0004, 0x4010, 0x0101, &View));
+
+	// 変更が無ければ同じリストを参照する
+	EPGDatabase::EventRef Ref;
+	REQUIRE(Database.GetEventRef(0x0004, 0x4010, 0x0101, 2, &Ref));
+	CHECK(Ref.get() == &View.Events[1]);
+	CHECK(Ref->EventName == LibISDB::StringView(LIBISDB_STR("Event")));
+	CHECK_FALSE(Database.GetEventRef(0x0004, 0x4010, 0x0101, 4, &Ref));
+	CHECK_FALSE(Ref);
+	REQUIRE(Database.GetEventRef(0x0004, 0x4010, 0x0101, 2, &Ref));
+
+	// 参照はその後の変更の影響を受けない
+	REQUIRE(Database.SetServiceEventList(Service, EPGDatabase::EventList()));
+	CHECK(View.Events.size() == 3);
+	CHECK(Ref->EventID == 2);
+	CHECK(Ref.get() == &View.Events[1]);
+
+	EPGDatabase::EventListView NewView;
+	REQUIRE(Database.GetEventListView(0x0004, 0x4010, 0x0101, &NewView));
+	CHECK(NewView.Events.empty());
+	CHECK(NewView.EventList != View.EventList);
+}
+
+
+TEST_CASE("EPGDatabase parallel merge", "[epg]")
+{
+	using LibISDB::EPGDatabase;
+
+	const auto SetBase =
+		[](EPGDatabase &Database) {
+			for (uint16_t ServiceID = 0x0101; ServiceID <= 0x0108; ServiceID++) {
+				EPGDatabase::EventList List;
+				for (uint16_t EventID = 1; EventID <= 6; EventID++)
+					List.push_back(MakeTestEvent(ServiceID, EventID, LIBISDB_STR("Old")));
+				REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, ServiceID), std::move(List)));
+			}
+		};
+	const auto SetSource =
+		[](EPGDatabase &Database) {
+			for (uint16_t ServiceID = 0x0104; ServiceID <= 0x010C; ServiceID++) {
+				EPGDatabase::EventList List;
+				for (uint16_t EventID = 4; EventID <= 9; EventID++)
+					List.push_back(MakeTestEvent(ServiceID, EventID, LIBISDB_STR("New")));
+				// 既存のイベントと時間が被るイベント
+				List.push_back(MakeTestEvent(ServiceID, 10, LIBISDB_STR("Overlap")));
+				List.back().StartTime.OffsetMinutes(-8 * 60 - 30);
+				REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, ServiceID), std::move(List)));
+			}
+		};
+
+	EPGDatabase Serial, Parallel;
+
+	REQUIRE(Serial.SetMergeThreadCount(1));
+	REQUIRE(Parallel.SetMergeThreadCount(4));
+	CHECK(Parallel.GetMergeThreadCount() == 4);
+	CHECK_FALSE(Parallel.SetMergeThreadCount(-1));
+
+	for (EPGDatabase *pDatabase : {&Serial, &Parallel}) {
+		EPGDatabase Source;
+		SetBase(*pDatabase);
+		SetSource(Source);
+		REQUIRE(pDatabase->Merge(&Source, EPGDatabase::MergeFlag::SetServiceUpdated, 2));
+	}
+
+	// 並列にマージした結果は順にマージした結果と一致する
+	EPGDatabase::ServiceList SerialServices, ParallelServices;
+	REQUIRE(Serial.GetServiceList(&SerialServices));
+	REQUIRE(Parallel.GetServiceList(&ParallelServices));
+	REQUIRE(SerialServices.size() == 12);
+	REQUIRE(ParallelServices == SerialServices);
+
+	for (const auto &Service : SerialServices) {
+		EPGDatabase::EventList SerialList, ParallelList;
+		REQUIRE(Serial.GetEventListSortedByTime(Service.NetworkID, Service.TransportStreamID, Service.ServiceID, &SerialList));
+		REQUIRE(Parallel.GetEventListSortedByTime(Service.NetworkID, Service.TransportStreamID, Service.ServiceID, &ParallelList));
+		CHECK(ParallelList == SerialList);
+		CHECK(Parallel.IsServiceUpdated(Service.NetworkID, Service.TransportStreamID, Service.ServiceID)
+			== Serial.IsServiceUpdated(Service.NetworkID, Service.TransportStreamID, Service.ServiceID));
+	}
+
+	LibISDB::EventInfo Event;
+	REQUIRE(Parallel.GetEventInfo(0x0004, 0x4010, 0x0105, 5, &Event));
+	CHECK(Event.EventName == LIBISDB_STR("New"));
+	CHECK(Event.SourceID == 2);
+	CHECK_FALSE(Parallel.GetEventInfo(0x0004, 0x4010, 0x0105, 1, &Event));
+	REQUIRE(Parallel.GetEventInfo(0x0004, 0x4010, 0x0102, 1, &Event));
+	CHECK(Event.EventName == LIBISDB_STR("Old"));
+}
+
+
+TEST_CASE("EPGDatabase search", "[epg]")
+{
+	using LibISDB::EPGDatabase;
+	using LibISDB::EventTextIndex;
+
+	EPGDatabase Database;
+
+	{
+		EPGDatabase::EventList List;
+		List.push_back(MakeTestEvent(0x0101, 1, LIBISDB_STR("ニュース７")));
+		List.push_back(MakeTestEvent(0x0101, 2, LIBISDB_STR("ＮＨＫスペシャル")));
+		List.back().EventText = LIBISDB_STR("宇宙の謎に迫る");
+		List.back().ContentNibble.NibbleCount = 1;
+		List.back().ContentNibble.NibbleList[0] = {0x8, 0x0, 0xF, 0xF};
+		List.push_back(MakeTestEvent(0x0101, 3, LIBISDB_STR("映画 宇宙戦争")));
+		List.back().ContentNibble.NibbleCount = 1;
+		List.back().ContentNibble.NibbleList[0] = {0x6, 0x1, 0xF, 0xF};
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0101), std::move(List)));
+	}
+	{
+		EPGDatabase::EventList List;
+		List.push_back(MakeTestEvent(0x0102, 1, LIBISDB_STR("宇宙ドキュメント")));
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0102), std::move(List)));
+	}
+
+	const auto Search =
+		[&](const LibISDB::String &Keyword, EPGDatabase::SearchCondition Condition = {}) {
+			Condition.Keyword = Keyword;
+			EPGDatabase::SearchResult Result;
+			REQUIRE(Database.SearchEvents(Condition, &Result));
+			std::vector<std::pair<uint16_t, uint16_t>> List;
+			for (const auto &e : Result)
+				List.emplace_back(e.ServiceID, e.EventID);
+			return List;
+		};
+	using ResultList = std::vector<std::pair<uint16_t, uint16_t>>;
+
+	// インデックスの有無で結果は変わらない
+	for (bool UseIndex : {false, true}) {
+		Database.SetTextIndex(UseIndex);
+
+		CHECK(Search(LIBISDB_STR("宇宙")) == ResultList{{0x0101, 2}, {0x0101, 3}, {0x0102, 1}});
+		CHECK(Search(LIBISDB_STR("nhk")) == ResultList{{0x0101, 2}});
+		CHECK(Search(LIBISDB_STR("7")) == ResultList{{0x0101, 1}});
+		CHECK(Search(LIBISDB_STR("宇宙　戦争")) == ResultList{{0x0101, 3}});
+		CHECK(Search(LIBISDB_STR("宙の")) == ResultList{{0x0101, 2}});
+
+		EPGDatabase::SearchCondition Condition;
+		Condition.Target = EventTextIndex::TargetFlag::EventName;
+		CHECK(Search(LIBISDB_STR("謎")).size() == 1);
+		CHECK(Search(LIBISDB_STR("謎"), Condition).empty());
+
+		Condition = {};
+		Condition.ContentNibbleLevel1 = 0x6;
+		CHECK(Search(LIBISDB_STR("宇宙"), Condition) == ResultList{{0x0101, 3}});
+		CHECK(Search(LIBISDB_STR(""), Condition) == ResultList{{0x0101, 3}});
+
+		Condition = {};
+		Condition.Earliest = MakeTestEvent(0x0101, 3, LIBISDB_STR("")).StartTime;
+		CHECK(Search(LIBISDB_STR("宇宙"), Condition) == ResultList{{0x0101, 3}});
+	}
+
+	// 変更されたサービスはインデックスが作り直される
+	{
+		EPGDatabase::EventList List;
+		List.push_back(MakeTestEvent(0x0102, 5, LIBISDB_STR("天気予報")));
+		REQUIRE(Database.SetServiceEventList(EPGDatabase::ServiceInfo(0x0004, 0x4010, 0x0102), std::move(List)));
+	}
+	CHECK(Search(LIBISDB_STR("宇宙")) == ResultList{{0x0101, 2}, {0x0101, 3}});
+	CHECK(Search(LIBISDB_STR("天気")) == ResultList{{0x0102, 5}});
+}
 
 
 #ifdef LIBISDB_TEST_WMAIN